@@ -38,12 +38,16 @@ THE SOFTWARE.
 #include "SPBase64.cc"
 #include "SPCharGroup.cc"
 #include "SPSha2.cc"
+#include "SPBlake2.cc"
+#include "SPArgon2.cc"
+#include "SPStringInterner.cc"
 #include "SPString.cc"
 #include "SPUnicode.cc"
 #include "SPHtmlParser.cc"
 
 #include "SPMemUserData.cc"
 #include "SPTime.cc"
+#include "SPRandom.cc"
 #include "SPRef.cc"
 #include "SPLog.cc"
 
@@ -54,6 +58,7 @@ THE SOFTWARE.
 
 #include "SPUrl.cc"
 #include "SPValid.cc"
+#include "SPBufferChain.cc"
 
 #ifdef MODULE_COMMON_IDN
 #include "SPIdn.cc"
@@ -63,4 +68,5 @@ THE SOFTWARE.
 #include "SPCrypto.cc"
 #include "SPCrypto-gnutls.cc"
 #include "SPCrypto-openssl.cc"
+#include "SPJsonWebToken.cc"
 #endif
@@ -64,12 +64,21 @@ using OutputStream = std::ostream;
 template <typename T>
 using Vector = stappler::memory::vector<T>;
 
+template <typename T, size_t N>
+using SmallVector = stappler::memory::small_vector<T, N>;
+
 template <typename K, typename V, typename Compare = std::less<void>>
 using Map = stappler::memory::map<K, V, Compare>;
 
 template <typename T, typename Compare = std::less<void>>
 using Set = stappler::memory::set<T, Compare>;
 
+template <typename T, typename V>
+using HashMap = stappler::memory::unordered_map<T, V>;
+
+template <typename T>
+using HashSet = stappler::memory::unordered_set<T>;
+
 template <typename T>
 using Function = stappler::memory::function<T>;
 
@@ -129,6 +138,9 @@ using OutputStream = std::ostream;
 template <typename T>
 using Vector = std::vector<T>;
 
+template <typename T, size_t N>
+using SmallVector = stappler::memory::small_vector<T, N, std::allocator<T>>;
+
 template <typename K, typename V, typename Compare = std::less<void>>
 using Map = std::map<K, V, Compare>;
 
@@ -138,6 +150,9 @@ using Set = std::set<T, Compare>;
 template <typename T, typename V>
 using HashMap = std::unordered_map<T, V>;
 
+template <typename T>
+using HashSet = std::unordered_set<T>;
+
 template <typename T>
 using Function = std::function<T>;
 
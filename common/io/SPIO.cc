@@ -24,8 +24,22 @@ THE SOFTWARE.
 #include "SPIO.h"
 #include "SPBuffer.h"
 
+#if LINUX
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#endif
+
 namespace stappler::io {
 
+// adaptive buffer starts with this size, and grows while producer fills it completely
+static constexpr size_t AdaptiveBufferMin = 64_KiB;
+static constexpr size_t AdaptiveBufferMax = 1_MiB;
+
+// max bytes for single copy syscall
+static constexpr size_t KernelCopyChunk = 1_GiB;
+static constexpr size_t KernelSpliceChunk = 256_KiB;
+
 size_t Producer::read(const Buffer &buf, size_t nbytes) const {
 	auto pbuf = buf.prepare(nbytes);
 	auto size = read_ptr(ptr, pbuf, nbytes);
@@ -37,8 +51,11 @@ size_t Consumer::write(const Buffer &buf) const {
 	return write_ptr(ptr, buf.data(), buf.size());
 }
 
-size_t read(const Producer &from, const Callback<void(const Buffer &)> &f) {
-	StackBuffer<(size_t)1_KiB> buf;
+template <typename Callback>
+static size_t readAdaptive(const Producer &from, const Callback &cb) {
+	BufferTemplate<memory::StandartInterface> data(AdaptiveBufferMin);
+	Buffer buf(data);
+
 	size_t ret = 0;
 	size_t cap = buf.capacity();
 	size_t c = cap;
@@ -46,14 +63,44 @@ size_t read(const Producer &from, const Callback<void(const Buffer &)> &f) {
 		c = from.read(buf, cap);
 		if (c > 0) {
 			ret += c;
-			if (f) {
-				f(buf);
-			}
+			cb(buf);
+		}
+		if (c == cap && cap < AdaptiveBufferMax) {
+			data = BufferTemplate<memory::StandartInterface>(cap * 2);
+			cap = c = buf.capacity();
 		}
 	}
 	return ret;
 }
 
+static size_t readKernel(const Producer &from, const Consumer &to) {
+	auto in = from.fd();
+	auto out = to.fd();
+	if (in < 0 || out < 0) {
+		return maxOf<size_t>();
+	}
+
+	// consumer can buffer data in user space, it should be written before kernel-side copy
+	to.flush();
+
+	int64_t offset = from.tell();
+	auto ret = copy(in, out, &offset);
+	if (ret != maxOf<size_t>()) {
+		from.seek(offset, Seek::Set);
+		// descriptor was written directly, consumer should update its position
+		to.flush();
+	}
+	return ret;
+}
+
+size_t read(const Producer &from, const Callback<void(const Buffer &)> &f) {
+	return readAdaptive(from, [&] (const Buffer &buf) {
+		if (f) {
+			f(buf);
+		}
+	});
+}
+
 size_t read(const Producer &from, const Buffer &buf, const Callback<void(const Buffer &)> &f) {
 	size_t ret = 0;
 	size_t cap = buf.capacity();
@@ -71,23 +118,25 @@ size_t read(const Producer &from, const Buffer &buf, const Callback<void(const B
 }
 
 size_t read(const Producer &from, const Consumer &to) {
-	StackBuffer<(size_t)1_KiB> buf;
-	size_t ret = 0;
-	size_t cap = buf.capacity();
-	size_t c = cap;
-	while (cap == c) {
-		c = from.read(buf, cap);
-		if (c > 0) {
-			ret += c;
-			to.write(buf);
-		}
+	auto ret = readKernel(from, to);
+	if (ret != maxOf<size_t>()) {
+		return ret;
 	}
-	return ret;
+
+	return readAdaptive(from, [&] (const Buffer &buf) {
+		to.write(buf);
+	});
 }
+
 size_t read(const Producer &from, const Consumer &to, const Callback<void(const Buffer &)> &f) {
-	StackBuffer<(size_t)1_KiB> buf;
-	return io::read(from, to, buf, f);
+	return readAdaptive(from, [&] (const Buffer &buf) {
+		if (f) {
+			f(buf);
+		}
+		to.write(buf);
+	});
 }
+
 size_t read(const Producer &from, const Consumer &to, const Buffer & buf) {
 	size_t ret = 0;
 	size_t cap = buf.capacity();
@@ -101,6 +150,7 @@ size_t read(const Producer &from, const Consumer &to, const Buffer & buf) {
 	}
 	return ret;
 }
+
 size_t read(const Producer &from, const Consumer &to, const Buffer & buf, const Callback<void(const Buffer &)> &f) {
 	size_t ret = 0;
 	size_t cap = buf.capacity();
@@ -118,4 +168,149 @@ size_t read(const Producer &from, const Consumer &to, const Buffer & buf, const
 	return ret;
 }
 
+#if LINUX
+
+// errors, that means, that this copy method is not supported for descriptors
+static bool isCopyUnsupported(int err) {
+	return err == EXDEV || err == EINVAL || err == ENOSYS || err == EOPNOTSUPP || err == EBADF || err == ESPIPE;
+}
+
+// writes data, left in intermediate pipe, through user space, returns number of bytes, that was not written
+static size_t drainPipe(int pipe, int to, size_t pending) {
+	uint8_t buf[16_KiB];
+	while (pending > 0) {
+		auto r = ::read(pipe, buf, std::min(pending, sizeof(buf)));
+		if (r < 0 && errno == EINTR) {
+			continue;
+		} else if (r <= 0) {
+			break;
+		}
+
+		size_t written = 0;
+		while (written < size_t(r)) {
+			auto w = ::write(to, buf + written, size_t(r) - written);
+			if (w > 0) {
+				written += size_t(w);
+			} else if (w < 0 && errno == EINTR) {
+				continue;
+			} else {
+				return pending - written;
+			}
+		}
+		pending -= written;
+	}
+	return pending;
+}
+
+size_t copy(int from, int to, int64_t *offset, size_t nbytes) {
+	loff_t off = offset ? loff_t(*offset) : 0;
+	loff_t *offPtr = offset ? &off : nullptr;
+	size_t ret = 0;
+	bool finished = false;
+	bool failed = false;
+
+	auto finalize = [&] () -> size_t {
+		if (ret == 0 && failed) {
+			return maxOf<size_t>();
+		}
+		if (offset) {
+			*offset = int64_t(off);
+		}
+		return ret;
+	};
+
+	// copy_file_range: file-to-file, can use reflinks and server-side copy
+	while (!finished && ret < nbytes) {
+		auto r = ::copy_file_range(from, offPtr, to, nullptr, std::min(nbytes - ret, KernelCopyChunk), 0);
+		if (r > 0) {
+			ret += size_t(r);
+		} else if (r == 0) {
+			finished = true;
+		} else if (errno != EINTR) {
+			if (ret > 0 || !isCopyUnsupported(errno)) {
+				failed = true;
+				return finalize();
+			}
+			break;
+		}
+	}
+
+	// sendfile: source should be a regular file, target can be any descriptor
+	while (!finished && ret < nbytes) {
+		auto r = ::sendfile(to, from, offPtr, std::min(nbytes - ret, KernelCopyChunk));
+		if (r > 0) {
+			ret += size_t(r);
+		} else if (r == 0) {
+			finished = true;
+		} else if (errno != EINTR) {
+			if (ret > 0 || !isCopyUnsupported(errno)) {
+				failed = true;
+				return finalize();
+			}
+			break;
+		}
+	}
+
+	if (finished || ret >= nbytes) {
+		return finalize();
+	}
+
+	// splice: one of the sides is a pipe or socket, so data moved through intermediate pipe
+	int p[2];
+	if (::pipe2(p, O_CLOEXEC) != 0) {
+		failed = true;
+		return finalize();
+	}
+
+	while (!finished && ret < nbytes) {
+		auto r = ::splice(from, offPtr, p[1], nullptr, std::min(nbytes - ret, KernelSpliceChunk), SPLICE_F_MOVE | SPLICE_F_MORE);
+		if (r == 0) {
+			finished = true;
+		} else if (r < 0) {
+			if (errno != EINTR) {
+				failed = true;
+				break;
+			}
+		} else {
+			size_t pending = size_t(r);
+			while (pending > 0) {
+				auto w = ::splice(p[0], nullptr, to, nullptr, pending, SPLICE_F_MOVE | SPLICE_F_MORE);
+				if (w > 0) {
+					pending -= size_t(w);
+				} else if (w < 0 && errno == EINTR) {
+					continue;
+				} else {
+					break;
+				}
+			}
+			if (pending > 0) {
+				// target rejects splice, bytes from pipe should not be lost
+				pending = drainPipe(p[0], to, pending);
+			}
+			ret += size_t(r) - pending;
+			if (pending > 0) {
+				// with explicit offset, unwritten bytes can be read from source again
+				if (offPtr) {
+					off -= loff_t(pending);
+				}
+				failed = true;
+				break;
+			}
+		}
+	}
+
+	::close(p[0]);
+	::close(p[1]);
+
+	return finalize();
+}
+
+#else
+
+size_t copy(int from, int to, int64_t *offset, size_t nbytes) {
+	return maxOf<size_t>();
+}
+
+#endif
+
 }
@@ -39,20 +39,14 @@ size_t read(const Producer &from, const Consumer &to, const Callback<void(const
 size_t read(const Producer &from, const Consumer &to, const Buffer &);
 size_t read(const Producer &from, const Consumer &to, const Buffer &, const Callback<void(const Buffer &)> &);
 
+// Copy data between native file descriptors within kernel (copy_file_range, sendfile or splice)
+// `offset` is an input offset, it will be updated with number of bytes copied; if null - current offset used
+// returns number of bytes copied or maxOf<size_t>() if descriptors can not be processed by kernel
+size_t copy(int from, int to, int64_t *offset = nullptr, size_t nbytes = maxOf<size_t>());
+
 template <typename T>
 inline size_t tread(const Producer &from, const T &f) {
-	StackBuffer<(size_t)1_KiB> buf;
-	size_t ret = 0;
-	size_t cap = buf.capacity();
-	size_t c = cap;
-	while (cap == c) {
-		c = from.read(buf, cap);
-		if (c > 0) {
-			ret += c;
-			f(buf);
-		}
-	}
-	return ret;
+	return io::read(from, Callback<void(const Buffer &)>(f));
 }
 
 template <typename T>
@@ -72,19 +66,7 @@ inline size_t tread(const Producer &from, const Buffer &buf, const T &f) {
 
 template <typename T>
 inline size_t tread(const Producer &from, const Consumer &to, const T &f) {
-	StackBuffer<(size_t)1_KiB> buf;
-	size_t ret = 0;
-	size_t cap = buf.capacity();
-	size_t c = cap;
-	while (cap == c) {
-		c = from.read(buf, cap);
-		if (c > 0) {
-			ret += c;
-			f(buf);
-			to.write(buf);
-		}
-	}
-	return ret;
+	return io::read(from, to, Callback<void(const Buffer &)>(f));
 }
 
 template <typename T>
@@ -45,6 +45,8 @@ using data_fn = uint8_t * (*) (void *);
 using prepare_fn = uint8_t * (*) (void *, size_t &);
 using save_fn = void (*) (void *, uint8_t *, size_t, size_t);
 
+using fd_fn = int (*) (void *);
+
 template <typename T> struct ProducerTraits;
 template <typename T> struct ConsumerTraits;
 template <typename T> struct BufferTraits;
@@ -53,6 +55,18 @@ struct Producer;
 struct Consumer;
 struct Buffer;
 
+// Traits can define `static int FdFn(void *)` to expose native file descriptor,
+// when both producer and consumer has one, io::read performs copy within kernel
+template <typename Traits, typename = void>
+struct FdTraits {
+	static constexpr fd_fn get() { return nullptr; }
+};
+
+template <typename Traits>
+struct FdTraits<Traits, std::void_t<decltype(&Traits::FdFn)>> {
+	static constexpr fd_fn get() { return &Traits::FdFn; }
+};
+
 }
 
 #endif /* COMMON_IO_SPIOCOMMON_H_ */
@@ -75,20 +75,27 @@ struct Consumer {
 	size_t write(const Buffer &) const;
 	void flush() const;
 
+	// native file descriptor or -1
+	int fd() const;
+
 	void *ptr = nullptr;
 	write_fn write_ptr = nullptr;
 	flush_fn flush_ptr = nullptr;
+	fd_fn fd_ptr = nullptr;
 };
 
 template <typename T, typename Traits>
 inline Consumer::Consumer(T &t)
 : ptr((void *)(&t))
 , write_ptr(&Traits::WriteFn)
-, flush_ptr(&Traits::FlushFn) { }
+, flush_ptr(&Traits::FlushFn)
+, fd_ptr(FdTraits<Traits>::get()) { }
 
 inline size_t Consumer::write(const uint8_t *buf, size_t nbytes) const { return write_ptr(ptr, buf, nbytes); }
 inline void Consumer::flush() const { flush_ptr(ptr); }
 
+inline int Consumer::fd() const { return fd_ptr ? fd_ptr(ptr) : -1; }
+
 }
 
 #endif /* COMMON_IO_SPIOCONSUMER_H_ */
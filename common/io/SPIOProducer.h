@@ -107,10 +107,14 @@ struct Producer {
 
 	size_t tell() const;
 
+	// native file descriptor or -1
+	int fd() const;
+
 	void *ptr = nullptr;
 	read_fn read_ptr = nullptr;
 	seek_fn seek_ptr = nullptr;
 	size_fn tell_ptr = nullptr;
+	fd_fn fd_ptr = nullptr;
 };
 
 template <typename T, typename Traits>
@@ -118,7 +122,8 @@ inline Producer::Producer(T &t)
 : ptr((void *)(&t))
 , read_ptr(&Traits::ReadFn)
 , seek_ptr(&Traits::SeekFn)
-, tell_ptr(&Traits::TellFn) { }
+, tell_ptr(&Traits::TellFn)
+, fd_ptr(FdTraits<Traits>::get()) { }
 
 inline size_t Producer::read(uint8_t *buf, size_t nbytes) const {
 	return read_ptr(ptr, buf, nbytes);
@@ -136,6 +141,8 @@ inline size_t Producer::seekAndRead(size_t offset, T && t, size_t nbytes) const
 
 inline size_t Producer::tell() const { return tell_ptr(ptr); }
 
+inline int Producer::fd() const { return fd_ptr ? fd_ptr(ptr) : -1; }
+
 }
 
 #endif /* COMMON_IO_SPIOPRODUCER_H_ */
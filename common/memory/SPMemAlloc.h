@@ -52,6 +52,24 @@ struct AllocPool {
 	static void registerCleanupDestructor(T *obj, pool_t *pool);
 };
 
+// Type can be moved into new location with memcpy, and old location can be discarded
+// without destructor call. Specialize it for types without pointers into itself
+// (memory::vector and memory::string are relocatable, std::string is not)
+template <typename T>
+struct is_trivially_relocatable {
+	static constexpr bool value = std::is_trivially_copyable<T>::value;
+};
+
+template <typename A, typename B>
+struct is_trivially_relocatable<std::pair<A, B>> {
+	static constexpr bool value = is_trivially_relocatable<A>::value && is_trivially_relocatable<B>::value;
+};
+
+template <typename T>
+struct is_trivially_relocatable<std::allocator<T>> {
+	static constexpr bool value = true;
+};
+
 namespace {
 template< class...Args> struct Allocator_SelectFirst;
 template< class A, class ...Args> struct Allocator_SelectFirst<A,Args...>{ using type = A; };
@@ -171,7 +189,7 @@ public:
 		if constexpr (!std::is_destructible<T>::value || std::is_scalar<T>::value) {
 			// do nothing
 		} else {
-			memory::pool::push(pool);
+			memory::pool::push(pool_ptr(pool));
 			for (size_t i = 0; i < size; ++i) {
 				(p + i)->~T();
 			}
@@ -230,9 +248,10 @@ public:
 		}
 	}
 
+	// moves objects into uninitialized memory, source objects are destroyed
 	void move(T *dest, T *source, size_t count) noexcept {
-		if constexpr (std::is_trivially_copyable<T>::value) {
-			memmove(dest, source, count * sizeof(T));
+		if constexpr (is_trivially_relocatable<T>::value) {
+			memmove((void *)dest, (const void *)source, count * sizeof(T));
 		} else {
 			if (dest == source) {
 				return;
@@ -0,0 +1,780 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_MEMORY_SPMEMBTREE_H_
+#define COMMON_MEMORY_SPMEMBTREE_H_
+
+#include "SPMemAlloc.h"
+
+/* B-tree with unique keys
+ *
+ * Every node stores sorted array of values inline, node size is tuned to TargetNodeSize
+ * (256 bytes by default), so one node covers a few cache lines and lookup or iteration
+ * touches much less memory than in rbtree, where every value is a separate node.
+ *
+ * Nodes are allocated from pool with Allocator. Values can be moved between nodes on
+ * insertion and erasure, so, unlike rbtree, iterators and references are invalidated
+ * by any modification.
+ */
+
+namespace stappler::memory::btree {
+
+template <typename Key, typename Value>
+struct KeyExtractor;
+
+template <typename Key>
+struct KeyExtractor<Key, Key> {
+	static inline const Key & getKey(const Key &k) noexcept { return k; }
+
+	template <typename A>
+	static inline void relocate(A &alloc, Key *target, Key *source) noexcept {
+		alloc.construct(target, std::move(*source));
+		alloc.destroy(source);
+	}
+};
+
+template <typename Key, typename Value>
+struct KeyExtractor<Key, Pair<const Key, Value>> {
+	static inline const Key & getKey(const Pair<const Key, Value> &v) noexcept { return v.first; }
+
+	// source is destroyed right after relocation, so key can be moved out
+	template <typename A>
+	static inline void relocate(A &alloc, Pair<const Key, Value> *target, Pair<const Key, Value> *source) noexcept {
+		alloc.construct(target, std::piecewise_construct,
+				std::forward_as_tuple(std::move(const_cast<Key &>(source->first))),
+				std::forward_as_tuple(std::move(source->second)));
+		alloc.destroy(source);
+	}
+};
+
+template <typename Value, size_t TargetNodeSize>
+struct NodeTraits {
+	static constexpr size_t HeaderSize = sizeof(void *) + sizeof(uint32_t) * 2;
+	static constexpr size_t TargetSlots = (TargetNodeSize > HeaderSize) ? (TargetNodeSize - HeaderSize) / sizeof(Value) : 0;
+
+	// at least 4 values per node, otherwise tree degrades into binary tree
+	static constexpr size_t Slots = std::max(TargetSlots, size_t(4));
+	static constexpr size_t MinCount = Slots / 2;
+	static constexpr size_t MidIndex = Slots / 2;
+};
+
+template <typename Value, size_t TargetNodeSize>
+struct InternalNode;
+
+// Value can be incomplete when tree type is declared (like in data::Value's dictionary),
+// so slot count is evaluated only when node itself is instantiated
+template <typename Value, size_t TargetNodeSize>
+struct Node {
+	static constexpr size_t Slots = NodeTraits<Value, TargetNodeSize>::Slots;
+
+	Node *parent;
+	uint32_t position; // index in parent's children array
+	uint16_t count;
+	uint16_t leaf;
+	Storage<Value> values[Slots];
+
+	Value *value(size_t i) { return values[i].ptr(); }
+
+	Node *&child(size_t i) { return static_cast<InternalNode<Value, TargetNodeSize> *>(this)->children[i]; }
+	Node *child(size_t i) const { return static_cast<const InternalNode<Value, TargetNodeSize> *>(this)->children[i]; }
+};
+
+template <typename Value, size_t TargetNodeSize>
+struct InternalNode : Node<Value, TargetNodeSize> {
+	Node<Value, TargetNodeSize> *children[Node<Value, TargetNodeSize>::Slots + 1];
+};
+
+template <typename NodeType, typename Value>
+struct TreeIterator {
+	using iterator_category = std::bidirectional_iterator_tag;
+	using value_type = Value;
+	using difference_type = std::ptrdiff_t;
+	using pointer = Value *;
+	using reference = Value &;
+
+	TreeIterator() noexcept = default;
+	TreeIterator(NodeType *n, size_t p) noexcept : node(n), position(p) { }
+
+	template <typename V, typename = std::enable_if_t<std::is_same_v<std::add_const_t<V>, Value>>>
+	TreeIterator(const TreeIterator<NodeType, V> &it) noexcept : node(it.node), position(it.position) { }
+
+	reference operator*() const noexcept { return *node->value(position); }
+	pointer operator->() const noexcept { return node->value(position); }
+
+	TreeIterator &operator++() noexcept { increment(); return *this; }
+	TreeIterator operator++(int) noexcept { auto tmp = *this; increment(); return tmp; }
+
+	TreeIterator &operator--() noexcept { decrement(); return *this; }
+	TreeIterator operator--(int) noexcept { auto tmp = *this; decrement(); return tmp; }
+
+	template <typename V>
+	bool operator==(const TreeIterator<NodeType, V> &it) const noexcept { return node == it.node && position == it.position; }
+
+	template <typename V>
+	bool operator!=(const TreeIterator<NodeType, V> &it) const noexcept { return node != it.node || position != it.position; }
+
+	void increment() {
+		if (node->leaf) {
+			if (++ position < node->count) {
+				return;
+			}
+
+			// end of leaf, find first parent with next value
+			auto n = node;
+			auto p = position;
+			while (p == n->count && n->parent) {
+				p = n->position;
+				n = n->parent;
+			}
+			if (p < n->count) {
+				node = n;
+				position = p;
+			} // else: last leaf, iterator is end()
+		} else {
+			node = node->child(position + 1);
+			while (!node->leaf) {
+				node = node->child(0);
+			}
+			position = 0;
+		}
+	}
+
+	void decrement() {
+		if (node->leaf) {
+			if (position > 0) {
+				-- position;
+				return;
+			}
+
+			auto n = node;
+			auto p = position;
+			while (p == 0 && n->parent) {
+				p = n->position;
+				n = n->parent;
+			}
+			if (p > 0) {
+				node = n;
+				position = p - 1;
+			}
+		} else {
+			node = node->child(position);
+			while (!node->leaf) {
+				node = node->child(node->count);
+			}
+			position = node->count - 1;
+		}
+	}
+
+	NodeType *node = nullptr;
+	size_t position = 0;
+};
+
+template <typename Key, typename Value, typename Comp = std::less<>, size_t TargetNodeSize = 256>
+class Tree : public AllocPool {
+public:
+	using traits = NodeTraits<Value, TargetNodeSize>;
+
+	using value_type = Value;
+	using node_type = Node<Value, TargetNodeSize>;
+	using internal_type = InternalNode<Value, TargetNodeSize>;
+	using extractor = KeyExtractor<Key, Value>;
+
+	using value_allocator_type = Allocator<Value>;
+	using comparator_type = Comp;
+
+	using iterator = TreeIterator<node_type, Value>;
+	using const_iterator = TreeIterator<node_type, const Value>;
+
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	Tree(const Comp &comp = Comp(), const value_allocator_type &alloc = value_allocator_type()) noexcept
+	: _comp(comp), _allocator(alloc) { }
+
+	Tree(const Tree &other, const value_allocator_type &alloc = value_allocator_type()) noexcept
+	: _comp(other._comp), _allocator(alloc) {
+		clone(other);
+	}
+
+	Tree(Tree &&other, const value_allocator_type &alloc = value_allocator_type()) noexcept
+	: _comp(other._comp), _allocator(alloc) {
+		if (other._allocator == _allocator) {
+			steal(other);
+		} else {
+			clone(other);
+		}
+	}
+
+	Tree & operator = (const Tree &other) noexcept {
+		if (&other != this) {
+			clone(other);
+		}
+		return *this;
+	}
+
+	Tree & operator = (Tree &&other) noexcept {
+		if (&other == this) {
+			return *this;
+		}
+		if (other._allocator == _allocator) {
+			clear();
+			_comp = std::move(other._comp);
+			steal(other);
+		} else {
+			clone(other);
+		}
+		return *this;
+	}
+
+	~Tree() noexcept {
+		clear();
+	}
+
+	const value_allocator_type & get_allocator() const noexcept { return _allocator; }
+
+	size_t size() const noexcept { return _size; }
+	bool empty() const noexcept { return _size == 0; }
+
+	iterator begin() noexcept { return _root ? iterator(_leftmost, 0) : end(); }
+	iterator end() noexcept { return iterator(_rightmost, _rightmost ? _rightmost->count : 0); }
+
+	const_iterator begin() const noexcept { return _root ? const_iterator(_leftmost, 0) : end(); }
+	const_iterator end() const noexcept { return const_iterator(_rightmost, _rightmost ? _rightmost->count : 0); }
+
+	void clear() noexcept {
+		if (_root) {
+			clear_visit(_root);
+		}
+		_root = _leftmost = _rightmost = nullptr;
+		_size = 0;
+	}
+
+	void swap(Tree &other) noexcept {
+		std::swap(_comp, other._comp);
+		std::swap(_allocator, other._allocator);
+		std::swap(_root, other._root);
+		std::swap(_leftmost, other._leftmost);
+		std::swap(_rightmost, other._rightmost);
+		std::swap(_size, other._size);
+	}
+
+	// constructs value with (key, args...), if there is no such key in tree
+	template <typename K, typename ... Args>
+	Pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		auto pos = getInsertPosition(key);
+		if (!pos.second) {
+			return pos;
+		}
+
+		auto it = prepareInsert(pos.first.node, pos.first.position);
+		if constexpr (std::is_same_v<Key, Value>) {
+			_allocator.construct(it.node->value(it.position), std::forward<K>(key), std::forward<Args>(args)...);
+		} else {
+			_allocator.construct(it.node->value(it.position), std::piecewise_construct,
+					std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+		return Pair<iterator, bool>(it, true);
+	}
+
+	// constructs value from args, then inserts it, if key is unique
+	template <typename ... Args>
+	Pair<iterator, bool> emplace(Args && ... args) {
+		Storage<Value> tmp;
+		_allocator.construct(tmp.ptr(), std::forward<Args>(args)...);
+
+		auto pos = getInsertPosition(extractor::getKey(tmp.ref()));
+		if (!pos.second) {
+			_allocator.destroy(tmp.ptr());
+			return pos;
+		}
+
+		auto it = prepareInsert(pos.first.node, pos.first.position);
+		relocate(it.node->value(it.position), tmp.ptr());
+		return Pair<iterator, bool>(it, true);
+	}
+
+	iterator erase(const_iterator pos) {
+		if (pos == end()) {
+			return end();
+		}
+
+		// value is moved out, so it can be used to find next position after tree rebalancing
+		Storage<Value> tmp;
+		relocate(tmp.ptr(), pos.node->value(pos.position));
+		eraseSlot(pos.node, pos.position);
+
+		auto ret = upper_bound(extractor::getKey(tmp.ref()));
+		_allocator.destroy(tmp.ptr());
+		return ret;
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		auto count = std::distance(first, last);
+		auto it = iterator(first.node, first.position);
+		while (count > 0) {
+			it = erase(it);
+			-- count;
+		}
+		return it;
+	}
+
+	template <typename K>
+	size_t erase_unique(const K &key) {
+		auto it = find(key);
+		if (it == end()) {
+			return 0;
+		}
+		_allocator.destroy(it.node->value(it.position));
+		eraseSlot(it.node, it.position);
+		return 1;
+	}
+
+	template <typename K>
+	iterator find(const K &key) {
+		auto node = _root;
+		while (node) {
+			auto pos = lowerIndex(node, key);
+			if (pos < node->count && !_comp(key, extractor::getKey(*node->value(pos)))) {
+				return iterator(node, pos);
+			}
+			if (node->leaf) {
+				break;
+			}
+			node = node->child(pos);
+		}
+		return end();
+	}
+
+	template <typename K>
+	const_iterator find(const K &key) const {
+		return const_cast<Tree *>(this)->find(key);
+	}
+
+	template <typename K>
+	iterator lower_bound(const K &key) {
+		auto ret = end();
+		auto node = _root;
+		while (node) {
+			auto pos = lowerIndex(node, key);
+			if (pos < node->count) {
+				ret = iterator(node, pos);
+			}
+			if (node->leaf) {
+				break;
+			}
+			node = node->child(pos);
+		}
+		return ret;
+	}
+
+	template <typename K>
+	const_iterator lower_bound(const K &key) const {
+		return const_cast<Tree *>(this)->lower_bound(key);
+	}
+
+	template <typename K>
+	iterator upper_bound(const K &key) {
+		auto ret = end();
+		auto node = _root;
+		while (node) {
+			auto pos = upperIndex(node, key);
+			if (pos < node->count) {
+				ret = iterator(node, pos);
+			}
+			if (node->leaf) {
+				break;
+			}
+			node = node->child(pos);
+		}
+		return ret;
+	}
+
+	template <typename K>
+	const_iterator upper_bound(const K &key) const {
+		return const_cast<Tree *>(this)->upper_bound(key);
+	}
+
+	template <typename K>
+	size_t count_unique(const K &key) const {
+		return find(key) != end() ? 1 : 0;
+	}
+
+	// number of bytes, used by nodes
+	size_t allocated() const noexcept {
+		return _root ? allocated_visit(_root) : 0;
+	}
+
+protected:
+	template <typename K>
+	size_t lowerIndex(const node_type *node, const K &key) const {
+		size_t first = 0;
+		size_t count = node->count;
+		while (count > 0) {
+			auto step = count / 2;
+			auto idx = first + step;
+			if (_comp(extractor::getKey(node->values[idx].ref()), key)) {
+				first = idx + 1;
+				count -= step + 1;
+			} else {
+				count = step;
+			}
+		}
+		return first;
+	}
+
+	template <typename K>
+	size_t upperIndex(const node_type *node, const K &key) const {
+		size_t first = 0;
+		size_t count = node->count;
+		while (count > 0) {
+			auto step = count / 2;
+			auto idx = first + step;
+			if (!_comp(key, extractor::getKey(node->values[idx].ref()))) {
+				first = idx + 1;
+				count -= step + 1;
+			} else {
+				count = step;
+			}
+		}
+		return first;
+	}
+
+	// returns existing value with false or leaf position for insertion with true
+	template <typename K>
+	Pair<iterator, bool> getInsertPosition(const K &key) {
+		auto node = _root;
+		while (node) {
+			auto pos = lowerIndex(node, key);
+			if (pos < node->count && !_comp(key, extractor::getKey(*node->value(pos)))) {
+				return Pair<iterator, bool>(iterator(node, pos), false);
+			}
+			if (node->leaf) {
+				return Pair<iterator, bool>(iterator(node, pos), true);
+			}
+			node = node->child(pos);
+		}
+		return Pair<iterator, bool>(iterator(nullptr, 0), true);
+	}
+
+	// makes empty slot in leaf at position, returns slot position for construction
+	iterator prepareInsert(node_type *node, size_t pos) {
+		if (!node) {
+			node = _root = _leftmost = _rightmost = allocateNode(true);
+			pos = 0;
+		}
+
+		if (node->count == traits::Slots) {
+			auto sibling = splitNode(node);
+			if (pos > traits::MidIndex) {
+				pos -= traits::MidIndex + 1;
+				node = sibling;
+			}
+		}
+
+		for (size_t i = node->count; i > pos; -- i) {
+			relocate(node->value(i), node->value(i - 1));
+		}
+		++ node->count;
+		++ _size;
+		return iterator(node, pos);
+	}
+
+	// splits full node by the middle value, that moved into parent; returns new right sibling
+	node_type *splitNode(node_type *node) {
+		auto parent = node->parent;
+		if (!parent) {
+			parent = _root = allocateNode(false);
+			parent->child(0) = node;
+			node->parent = parent;
+			node->position = 0;
+		} else if (parent->count == traits::Slots) {
+			splitNode(parent);
+			parent = node->parent;
+		}
+
+		auto sibling = allocateNode(node->leaf);
+		sibling->count = uint16_t(traits::Slots - traits::MidIndex - 1);
+		for (size_t i = 0; i < sibling->count; ++ i) {
+			relocate(sibling->value(i), node->value(traits::MidIndex + 1 + i));
+		}
+		if (!node->leaf) {
+			for (size_t i = 0; i <= sibling->count; ++ i) {
+				setChild(sibling, i, node->child(traits::MidIndex + 1 + i));
+			}
+		}
+
+		auto p = node->position;
+		for (size_t i = parent->count; i > p; -- i) {
+			relocate(parent->value(i), parent->value(i - 1));
+			setChild(parent, i + 1, parent->child(i));
+		}
+		relocate(parent->value(p), node->value(traits::MidIndex));
+		setChild(parent, p + 1, sibling);
+		++ parent->count;
+
+		node->count = uint16_t(traits::MidIndex);
+		if (node == _rightmost) {
+			_rightmost = sibling;
+		}
+		return sibling;
+	}
+
+	// removes slot from node, value in slot should be already destroyed or relocated
+	void eraseSlot(node_type *node, size_t pos) {
+		if (!node->leaf) {
+			// replace with predecessor from the leaf
+			auto leaf = node->child(pos);
+			while (!leaf->leaf) {
+				leaf = leaf->child(leaf->count);
+			}
+			relocate(node->value(pos), leaf->value(leaf->count - 1));
+			node = leaf;
+		} else {
+			for (size_t i = pos + 1; i < node->count; ++ i) {
+				relocate(node->value(i - 1), node->value(i));
+			}
+		}
+		-- node->count;
+		-- _size;
+		rebalance(node);
+	}
+
+	void rebalance(node_type *node) {
+		while (true) {
+			if (node == _root) {
+				if (node->count == 0) {
+					if (node->leaf) {
+						_root = _leftmost = _rightmost = nullptr;
+					} else {
+						_root = node->child(0);
+						_root->parent = nullptr;
+						_root->position = 0;
+					}
+					deallocateNode(node);
+				}
+				return;
+			}
+
+			if (node->count >= traits::MinCount) {
+				return;
+			}
+
+			auto parent = node->parent;
+			auto p = node->position;
+			auto left = (p > 0) ? parent->child(p - 1) : nullptr;
+			auto right = (p < parent->count) ? parent->child(p + 1) : nullptr;
+
+			if (left && left->count > traits::MinCount) {
+				rotateRight(left, node, p - 1);
+				return;
+			}
+			if (right && right->count > traits::MinCount) {
+				rotateLeft(node, right, p);
+				return;
+			}
+
+			if (left) {
+				merge(left, node, p - 1);
+			} else {
+				merge(node, right, p);
+			}
+			node = parent;
+		}
+	}
+
+	// moves last value from left sibling through parent into node
+	void rotateRight(node_type *left, node_type *node, size_t sep) {
+		auto parent = node->parent;
+		for (size_t i = node->count; i > 0; -- i) {
+			relocate(node->value(i), node->value(i - 1));
+		}
+		relocate(node->value(0), parent->value(sep));
+		relocate(parent->value(sep), left->value(left->count - 1));
+
+		if (!node->leaf) {
+			for (size_t i = node->count + 1; i > 0; -- i) {
+				setChild(node, i, node->child(i - 1));
+			}
+			setChild(node, 0, left->child(left->count));
+		}
+
+		-- left->count;
+		++ node->count;
+	}
+
+	// moves first value from right sibling through parent into node
+	void rotateLeft(node_type *node, node_type *right, size_t sep) {
+		auto parent = node->parent;
+		relocate(node->value(node->count), parent->value(sep));
+		relocate(parent->value(sep), right->value(0));
+		for (size_t i = 1; i < right->count; ++ i) {
+			relocate(right->value(i - 1), right->value(i));
+		}
+
+		if (!node->leaf) {
+			setChild(node, node->count + 1, right->child(0));
+			for (size_t i = 1; i <= right->count; ++ i) {
+				setChild(right, i - 1, right->child(i));
+			}
+		}
+
+		++ node->count;
+		-- right->count;
+	}
+
+	// moves separator and all values from right into left, removes right
+	void merge(node_type *left, node_type *right, size_t sep) {
+		auto parent = left->parent;
+		relocate(left->value(left->count), parent->value(sep));
+		for (size_t i = 0; i < right->count; ++ i) {
+			relocate(left->value(left->count + 1 + i), right->value(i));
+		}
+		if (!left->leaf) {
+			for (size_t i = 0; i <= right->count; ++ i) {
+				setChild(left, left->count + 1 + i, right->child(i));
+			}
+		}
+		left->count += 1 + right->count;
+
+		for (size_t i = sep + 1; i < parent->count; ++ i) {
+			relocate(parent->value(i - 1), parent->value(i));
+			setChild(parent, i, parent->child(i + 1));
+		}
+		-- parent->count;
+
+		if (right == _rightmost) {
+			_rightmost = left;
+		}
+		deallocateNode(right);
+	}
+
+	void setChild(node_type *node, size_t i, node_type *child) {
+		node->child(i) = child;
+		child->parent = node;
+		child->position = uint32_t(i);
+	}
+
+	void relocate(Value *target, Value *source) {
+		if constexpr (std::is_trivially_copyable_v<Value>) {
+			::memcpy((void *)target, (const void *)source, sizeof(Value));
+		} else {
+			extractor::relocate(_allocator, target, source);
+		}
+	}
+
+	node_type *allocateNode(bool leaf) {
+		node_type *ret = nullptr;
+		if (leaf) {
+			ret = Allocator<node_type>(_allocator).allocate(1);
+		} else {
+			ret = Allocator<internal_type>(_allocator).allocate(1);
+		}
+		ret->parent = nullptr;
+		ret->position = 0;
+		ret->count = 0;
+		ret->leaf = leaf ? 1 : 0;
+		return ret;
+	}
+
+	void deallocateNode(node_type *node) {
+		if (node->leaf) {
+			Allocator<node_type>(_allocator).deallocate(node, 1);
+		} else {
+			Allocator<internal_type>(_allocator).deallocate(static_cast<internal_type *>(node), 1);
+		}
+	}
+
+	void clear_visit(node_type *node) {
+		if (!node->leaf) {
+			for (size_t i = 0; i <= node->count; ++ i) {
+				clear_visit(node->child(i));
+			}
+		}
+		if constexpr (!std::is_trivially_destructible_v<Value>) {
+			for (size_t i = 0; i < node->count; ++ i) {
+				_allocator.destroy(node->value(i));
+			}
+		}
+		deallocateNode(node);
+	}
+
+	node_type *clone_visit(const node_type *source, node_type *parent) {
+		auto node = allocateNode(source->leaf);
+		node->parent = parent;
+		node->position = source->position;
+		node->count = source->count;
+		for (size_t i = 0; i < source->count; ++ i) {
+			_allocator.construct(node->value(i), source->values[i].ref());
+		}
+		if (source->leaf) {
+			if (!_leftmost) {
+				_leftmost = node;
+			}
+			_rightmost = node;
+		} else {
+			for (size_t i = 0; i <= source->count; ++ i) {
+				node->child(i) = clone_visit(source->child(i), node);
+			}
+		}
+		return node;
+	}
+
+	void clone(const Tree &other) {
+		clear();
+		_comp = other._comp;
+		if (other._root) {
+			_root = clone_visit(other._root, nullptr);
+			_size = other._size;
+		}
+	}
+
+	void steal(Tree &other) {
+		_root = other._root;
+		_leftmost = other._leftmost;
+		_rightmost = other._rightmost;
+		_size = other._size;
+		other._root = other._leftmost = other._rightmost = nullptr;
+		other._size = 0;
+	}
+
+	size_t allocated_visit(const node_type *node) const {
+		if (node->leaf) {
+			return sizeof(node_type);
+		}
+		size_t ret = sizeof(internal_type);
+		for (size_t i = 0; i <= node->count; ++ i) {
+			ret += allocated_visit(node->child(i));
+		}
+		return ret;
+	}
+
+	comparator_type _comp;
+	value_allocator_type _allocator;
+	node_type *_root = nullptr;
+	node_type *_leftmost = nullptr;
+	node_type *_rightmost = nullptr;
+	size_t _size = 0;
+};
+
+}
+
+#endif /* COMMON_MEMORY_SPMEMBTREE_H_ */
@@ -0,0 +1,217 @@
+/**
+Copyright (c) 2017-2022 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_MEMORY_SPMEMBTREESET_H_
+#define COMMON_MEMORY_SPMEMBTREESET_H_
+
+#include "SPMemBtree.h"
+
+namespace stappler::memory {
+
+// Ordered set on B-tree, see SPMemBtree.h
+template <typename Value, typename Comp = std::less<>, size_t TargetNodeSize = 256>
+class btree_set : public AllocPool {
+public:
+	using key_type = Value;
+	using value_type = Value;
+	using key_compare = Comp;
+	using value_compare = Comp;
+	using allocator_type = Allocator<Value>;
+
+	using pointer = Value *;
+	using const_pointer = const Value *;
+	using reference = Value &;
+	using const_reference = const Value &;
+
+	using tree_type = btree::Tree<Value, Value, Comp, TargetNodeSize>;
+
+	using iterator = typename tree_type::const_iterator;
+	using const_iterator = typename tree_type::const_iterator;
+	using reverse_iterator = typename tree_type::const_reverse_iterator;
+	using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+
+public:
+	btree_set() noexcept : _tree() { }
+	explicit btree_set (const key_compare & comp, const allocator_type & alloc = allocator_type()) noexcept : _tree(comp, alloc) { }
+	explicit btree_set (const allocator_type & alloc) noexcept : _tree(key_compare(), alloc) { }
+
+	template <class InputIterator>
+	btree_set (InputIterator first, InputIterator last,
+			const key_compare & comp = key_compare(), const allocator_type & alloc = allocator_type())
+	: _tree(comp, alloc) {
+		for (auto it = first; it != last; it ++) {
+			emplace(*it);
+		}
+	}
+
+	template <class InputIterator>
+	btree_set (InputIterator first, InputIterator last, const allocator_type & alloc)
+	: _tree(key_compare(), alloc) {
+		for (auto it = first; it != last; it ++) {
+			emplace(*it);
+		}
+	}
+
+	btree_set (const btree_set& x) noexcept : _tree(x._tree) { }
+	btree_set (const btree_set& x, const allocator_type& alloc) noexcept : _tree(x._tree, alloc) { }
+
+	btree_set (btree_set&& x) noexcept : _tree(std::move(x._tree)) { }
+	btree_set (btree_set&& x, const allocator_type& alloc) noexcept : _tree(std::move(x._tree), alloc) { }
+
+	btree_set (InitializerList<value_type> il,
+			const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) noexcept
+	: _tree(comp, alloc) {
+		for (auto &it : il) {
+			emplace(std::move(it));
+		}
+	}
+	btree_set (InitializerList<value_type> il, const allocator_type& alloc) noexcept
+	: _tree(key_compare(), alloc) {
+		for (auto &it : il) {
+			emplace(std::move(it));
+		}
+	}
+
+	btree_set& operator= (const btree_set& other) noexcept {
+		_tree = other._tree;
+		return *this;
+	}
+	btree_set& operator= (btree_set&& other) noexcept {
+		_tree = std::move(other._tree);
+		return *this;
+	}
+	btree_set& operator= (InitializerList<value_type> ilist) noexcept {
+		_tree.clear();
+		for (auto &it : ilist) {
+			emplace(std::move(it));
+		}
+		return *this;
+	}
+
+	allocator_type get_allocator() const noexcept { return _tree.get_allocator(); }
+	bool empty() const noexcept { return _tree.empty(); }
+	size_t size() const noexcept { return _tree.size(); }
+	size_t capacity() const noexcept { return _tree.size(); }
+	void clear() { _tree.clear(); }
+	void shrink_to_fit() { }
+	void reserve(size_t c) { }
+
+	// number of bytes, used by tree nodes
+	size_t allocated() const noexcept { return _tree.allocated(); }
+
+	Pair<iterator,bool> insert( const value_type& value ) {
+		return emplace(value);
+	}
+
+	Pair<iterator,bool> insert( value_type&& value ) {
+		return emplace(std::move(value));
+	}
+
+	iterator insert( const_iterator hint, const value_type& value ) {
+		return emplace(value).first;
+	}
+
+	iterator insert( const_iterator hint, value_type&& value ) {
+		return emplace(std::move(value)).first;
+	}
+
+	template< class InputIt > void insert( InputIt first, InputIt last ) {
+		for (auto it = first; it != last; it ++) {
+			emplace(*it);
+		}
+	}
+
+	void insert( InitializerList<value_type> ilist ) {
+		for (auto &it : ilist) {
+			emplace(std::move(it));
+		}
+	}
+
+	template< class... Args >
+	Pair<iterator,bool> emplace( Args && ... args ) {
+		return _tree.emplace(std::forward<Args>(args)...);
+	}
+
+	template <class... Args>
+	iterator emplace_hint( const_iterator hint, Args&&... args ) {
+		return _tree.emplace(std::forward<Args>(args)...).first;
+	}
+
+	iterator erase( const_iterator pos ) { return _tree.erase(pos); }
+	iterator erase( const_iterator first, const_iterator last ) { return _tree.erase(first, last); }
+	size_type erase( const key_type& key ) { return _tree.erase_unique(key); }
+
+	iterator begin() noexcept { return _tree.begin(); }
+	iterator end() noexcept { return _tree.end(); }
+
+	const_iterator begin() const noexcept { return _tree.begin(); }
+	const_iterator end() const noexcept { return _tree.end(); }
+
+	const_iterator cbegin() const noexcept { return _tree.begin(); }
+	const_iterator cend() const noexcept { return _tree.end(); }
+
+	reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+	reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+
+	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+	const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend()); }
+	const_reverse_iterator crend() const noexcept { return const_reverse_iterator(cbegin()); }
+
+	void swap(btree_set &other) noexcept {
+		_tree.swap(other._tree);
+	}
+
+	template< class K > const_iterator find( const K& x ) const { return _tree.find(x); }
+
+	template< class K > const_iterator lower_bound(const K& x) const { return _tree.lower_bound(x); }
+	template< class K > const_iterator upper_bound( const K& x ) const { return _tree.upper_bound(x); }
+
+	template< class K > Pair<const_iterator,const_iterator> equal_range( const K& x ) const { return pair(lower_bound(x), upper_bound(x)); }
+
+	template< class K > size_t count( const K& x ) const { return _tree.count_unique(x); }
+
+protected:
+	tree_type _tree;
+};
+
+template<typename Value, typename Comp, size_t S> inline bool
+operator==(const btree_set<Value, Comp, S>& __x, const btree_set<Value, Comp, S>& __y) {
+	return (__x.size() == __y.size() && std::equal(__x.begin(), __x.end(), __y.begin()));
+}
+
+template<typename Value, typename Comp, size_t S> inline bool
+operator<(const btree_set<Value, Comp, S>& __x, const btree_set<Value, Comp, S>& __y) {
+	return std::lexicographical_compare(__x.begin(), __x.end(), __y.begin(), __y.end());
+}
+
+template<typename Value, typename Comp, size_t S> inline bool
+operator!=(const btree_set<Value, Comp, S>& __x, const btree_set<Value, Comp, S>& __y) {
+	return !(__x == __y);
+}
+
+}
+
+#endif /* COMMON_MEMORY_SPMEMBTREESET_H_ */
@@ -0,0 +1,667 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_MEMORY_SPMEMHASHTABLE_H_
+#define COMMON_MEMORY_SPMEMHASHTABLE_H_
+
+#include "SPMemAlloc.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Open-addressing hash table (SwissTable layout)
+ *
+ * Table stores values inline in flat slot array, every slot has one control byte:
+ * - Empty (0x80), Deleted (0xFE) or 7 lower bits of the hash (H2) for a full slot
+ *
+ * Lookups scans control bytes by groups (16 bytes with SSE2, 8 bytes with portable SWAR),
+ * so most of the misses are resolved without touching slots at all.
+ * Capacity is always power of 2, first group of control bytes is mirrored after the end of
+ * control array, so group can be loaded from any position without wrapping.
+ *
+ * Memory for slots and control bytes allocated as single block from pool with Allocator
+ *
+ * Unlike rbtree-based containers, references and iterators are invalidated on rehash
+ */
+
+namespace stappler::memory::hashtable {
+
+using ctrl_t = int8_t;
+
+enum Ctrl : ctrl_t {
+	Empty = -128,
+	Deleted = -2,
+};
+
+inline bool isFull(ctrl_t c) { return c >= 0; }
+
+// lookups with foreign key types only allowed, when both hasher and comparator allows it
+template <typename T, typename = void>
+struct IsTransparent : std::false_type { };
+
+template <typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type { };
+
+template <typename T, int Shift>
+struct BitMask {
+	T mask;
+
+	explicit operator bool() const { return mask != 0; }
+
+	uint32_t lowest() const {
+		if constexpr (sizeof(T) == 8) {
+			return uint32_t(__builtin_ctzll(mask)) >> Shift;
+		} else {
+			return uint32_t(__builtin_ctz(mask)) >> Shift;
+		}
+	}
+
+	BitMask &operator++() {
+		mask &= (mask - 1);
+		return *this;
+	}
+};
+
+#if __SSE2__
+
+struct Group {
+	static constexpr size_t Width = 16;
+
+	using Mask = BitMask<uint32_t, 0>;
+
+	explicit Group(const ctrl_t *pos) {
+		ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+	}
+
+	Mask match(ctrl_t h2) const {
+		return Mask{uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)))};
+	}
+
+	Mask matchEmpty() const {
+		return match(Ctrl::Empty);
+	}
+
+	// Empty and Deleted are the only negative values below -1
+	Mask matchEmptyOrDeleted() const {
+		return Mask{uint32_t(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)))};
+	}
+
+	__m128i ctrl;
+};
+
+#else
+
+// Portable fallback: byte-parallel tests on 64-bit word
+struct Group {
+	static constexpr size_t Width = 8;
+
+	static constexpr uint64_t Lsbs = 0x0101010101010101ULL;
+	static constexpr uint64_t Msbs = 0x8080808080808080ULL;
+
+	using Mask = BitMask<uint64_t, 3>;
+
+	explicit Group(const ctrl_t *pos) {
+		::memcpy(&ctrl, pos, sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		ctrl = __builtin_bswap64(ctrl);
+#endif
+	}
+
+	// can produce false positives for bytes above the true match, keys are compared anyway
+	Mask match(ctrl_t h2) const {
+		auto x = ctrl ^ (Lsbs * uint8_t(h2));
+		return Mask{(x - Lsbs) & ~x & Msbs};
+	}
+
+	// high bit set and bit 1 not set - only Empty
+	Mask matchEmpty() const {
+		return Mask{(ctrl & (~ctrl << 6)) & Msbs};
+	}
+
+	// high bit set and bit 0 not set - Empty and Deleted
+	Mask matchEmptyOrDeleted() const {
+		return Mask{(ctrl & (~ctrl << 7)) & Msbs};
+	}
+
+	uint64_t ctrl;
+};
+
+#endif
+
+// Hash results from std::hash can be weak (identity for integers), so mix all bits
+// before splitting hash into H1 (probe position) and H2 (control byte)
+inline size_t mix(size_t h) {
+#if __SIZEOF_INT128__
+	if constexpr (sizeof(size_t) == 8) {
+		auto m = __uint128_t(h) * 0x9E37'79B9'7F4A'7C15ULL;
+		return size_t(m) ^ size_t(m >> 64);
+	} else
+#endif
+	{
+		auto m = uint64_t(h) * 0x9E37'79B9ULL;
+		return size_t(m) ^ size_t(m >> 32);
+	}
+}
+
+template <typename Key, typename Value>
+struct KeyExtractor;
+
+template <typename Key>
+struct KeyExtractor<Key, Key> {
+	static inline const Key & getKey(const Key &k) { return k; }
+};
+
+template <typename Key, typename Value>
+struct KeyExtractor<Key, Pair<const Key, Value>> {
+	static inline const Key & getKey(const Pair<const Key, Value> &v) { return v.first; }
+};
+
+template <typename Value>
+struct TableIterator {
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = Value;
+	using difference_type = std::ptrdiff_t;
+	using pointer = Value *;
+	using reference = Value &;
+
+	using storage_type = Storage<std::remove_const_t<Value>>;
+
+	TableIterator() noexcept = default;
+	TableIterator(const ctrl_t *c, const ctrl_t *e, const storage_type *s) noexcept
+	: ctrl(c), end(e), slot(const_cast<storage_type *>(s)) {
+		skipEmpty();
+	}
+
+	template <typename V, typename = std::enable_if_t<std::is_same_v<std::add_const_t<V>, Value>>>
+	TableIterator(const TableIterator<V> &it) noexcept : ctrl(it.ctrl), end(it.end), slot(it.slot) { }
+
+	reference operator*() const noexcept { return slot->ref(); }
+	pointer operator->() const noexcept { return slot->ptr(); }
+
+	TableIterator &operator++() noexcept {
+		++ ctrl; ++ slot;
+		skipEmpty();
+		return *this;
+	}
+
+	TableIterator operator++(int) noexcept {
+		auto tmp = *this;
+		++ *this;
+		return tmp;
+	}
+
+	template <typename V>
+	bool operator==(const TableIterator<V> &it) const noexcept { return ctrl == it.ctrl; }
+
+	template <typename V>
+	bool operator!=(const TableIterator<V> &it) const noexcept { return ctrl != it.ctrl; }
+
+	void skipEmpty() {
+		while (ctrl != end && !isFull(*ctrl)) {
+			++ ctrl; ++ slot;
+		}
+	}
+
+	const ctrl_t *ctrl = nullptr;
+	const ctrl_t *end = nullptr;
+	storage_type *slot = nullptr;
+};
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+class Table : public AllocPool {
+public:
+	using value_type = Value;
+	using allocator_type = Allocator<Value>;
+	using storage_type = Storage<Value>;
+	using extractor = KeyExtractor<Key, Value>;
+	using size_type = size_t;
+
+	using iterator = TableIterator<Value>;
+	using const_iterator = TableIterator<const Value>;
+
+	static constexpr size_t npos = maxOf<size_t>();
+
+	Table(const Hash &hash = Hash(), const Equal &eq = Equal(), const allocator_type &alloc = allocator_type()) noexcept
+	: _hash(hash), _eq(eq), _allocator(alloc) { }
+
+	Table(const Table &other, const allocator_type &alloc = allocator_type()) noexcept
+	: _hash(other._hash), _eq(other._eq), _allocator(alloc) {
+		copyFrom(other);
+	}
+
+	Table(Table &&other, const allocator_type &alloc = allocator_type()) noexcept
+	: _hash(std::move(other._hash)), _eq(std::move(other._eq)), _allocator(alloc) {
+		if (other._allocator == _allocator) {
+			stealFrom(other);
+		} else {
+			moveFrom(other);
+		}
+	}
+
+	Table &operator=(const Table &other) noexcept {
+		if (&other != this) {
+			clear();
+			copyFrom(other);
+		}
+		return *this;
+	}
+
+	Table &operator=(Table &&other) noexcept {
+		if (&other == this) {
+			return *this;
+		}
+		if (other._allocator == _allocator) {
+			destroyAll();
+			deallocate();
+			stealFrom(other);
+		} else {
+			clear();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	~Table() noexcept {
+		destroyAll();
+		deallocate();
+	}
+
+	const allocator_type &get_allocator() const noexcept { return _allocator; }
+
+	size_t size() const noexcept { return _size; }
+	size_t capacity() const noexcept { return _capacity; }
+	bool empty() const noexcept { return _size == 0; }
+
+	float load_factor() const noexcept { return _capacity ? float(_size) / float(_capacity) : 0.0f; }
+	float max_load_factor() const noexcept { return float(MaxLoadNumerator) / float(MaxLoadDenominator); }
+
+	const Hash &hash_function() const noexcept { return _hash; }
+	const Equal &key_eq() const noexcept { return _eq; }
+
+	iterator begin() noexcept { return iterator(_ctrl, _ctrl + _capacity, slots()); }
+	iterator end() noexcept { return iterator(_ctrl + _capacity, _ctrl + _capacity, slots() + _capacity); }
+
+	const_iterator begin() const noexcept { return const_iterator(_ctrl, _ctrl + _capacity, slots()); }
+	const_iterator end() const noexcept { return const_iterator(_ctrl + _capacity, _ctrl + _capacity, slots() + _capacity); }
+
+	// removes all elements, but keeps allocated memory
+	void clear() noexcept {
+		if (_capacity) {
+			destroyAll();
+			resetCtrl();
+			_size = 0;
+			_growthLeft = growthForCapacity(_capacity);
+		}
+	}
+
+	// removes all elements and returns memory into pool
+	void shrink_to_fit() noexcept {
+		if (_size == 0) {
+			destroyAll();
+			deallocate();
+		} else {
+			rehash(capacityForSize(_size));
+		}
+	}
+
+	void reserve(size_t count) {
+		auto c = capacityForSize(count);
+		if (c > _capacity) {
+			rehash(c);
+		}
+	}
+
+	void swap(Table &other) noexcept {
+		std::swap(_hash, other._hash);
+		std::swap(_eq, other._eq);
+		std::swap(_allocator, other._allocator);
+		std::swap(_ctrl, other._ctrl);
+		std::swap(_capacity, other._capacity);
+		std::swap(_size, other._size);
+		std::swap(_growthLeft, other._growthLeft);
+		std::swap(_allocated, other._allocated);
+	}
+
+	template <typename K>
+	iterator find(const K &key) noexcept {
+		auto idx = findIndex(key, hashOf(key));
+		return (idx == npos) ? end() : iteratorAt(idx);
+	}
+
+	template <typename K>
+	const_iterator find(const K &key) const noexcept {
+		auto idx = findIndex(key, hashOf(key));
+		return (idx == npos) ? end() : const_iterator(iteratorAt(idx));
+	}
+
+	template <typename K>
+	bool contains(const K &key) const noexcept {
+		return findIndex(key, hashOf(key)) != npos;
+	}
+
+	// constructs value with (key, args...), if there is no such key in table
+	template <typename K, typename ... Args>
+	Pair<iterator, bool> try_emplace(K &&key, Args && ... args) {
+		auto hash = hashOf(key);
+		auto idx = findIndex(key, hash);
+		if (idx != npos) {
+			return Pair<iterator, bool>(iteratorAt(idx), false);
+		}
+
+		idx = prepareInsert(hash);
+		if constexpr (std::is_same_v<Key, Value>) {
+			_allocator.construct(slots()[idx].ptr(), std::forward<K>(key), std::forward<Args>(args)...);
+		} else {
+			_allocator.construct(slots()[idx].ptr(), std::piecewise_construct,
+					std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+		return Pair<iterator, bool>(iteratorAt(idx), true);
+	}
+
+	template <typename K>
+	size_t erase_unique(const K &key) {
+		auto idx = findIndex(key, hashOf(key));
+		if (idx == npos) {
+			return 0;
+		}
+		eraseAt(idx);
+		return 1;
+	}
+
+	iterator erase(const_iterator pos) {
+		auto idx = size_t(pos.ctrl - _ctrl);
+		eraseAt(idx);
+		return iteratorAt(idx + 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		while (first != last) {
+			first = erase(first);
+		}
+		return iteratorAt(size_t(last.ctrl - _ctrl));
+	}
+
+	// number of bytes, allocated from pool
+	size_t allocated() const noexcept { return _allocated; }
+
+protected:
+	// max load factor = 7/8
+	static constexpr size_t MaxLoadNumerator = 7;
+	static constexpr size_t MaxLoadDenominator = 8;
+
+	static size_t growthForCapacity(size_t c) {
+		return c - c / MaxLoadDenominator;
+	}
+
+	static size_t capacityForSize(size_t size) {
+		if (size == 0) {
+			return 0;
+		}
+		size_t c = Group::Width;
+		while (growthForCapacity(c) < size) {
+			c *= 2;
+		}
+		return c;
+	}
+
+	static ctrl_t getH2(size_t hash) { return ctrl_t(hash & 0x7F); }
+	static size_t getH1(size_t hash) { return hash >> 7; }
+
+	template <typename K>
+	size_t hashOf(const K &key) const { return mix(_hash(key)); }
+
+	storage_type *slots() const noexcept {
+		// slots placed before control bytes
+		return _ctrl ? reinterpret_cast<storage_type *>(const_cast<ctrl_t *>(_ctrl) - slotsOffset(_capacity)) : nullptr;
+	}
+
+	static size_t slotsOffset(size_t capacity) {
+		return ((sizeof(storage_type) * capacity + alignof(Group) - 1) / alignof(Group)) * alignof(Group);
+	}
+
+	iterator iteratorAt(size_t idx) const noexcept {
+		return iterator(_ctrl + idx, _ctrl + _capacity, slots() + idx);
+	}
+
+	void setCtrl(size_t idx, ctrl_t c) {
+		_ctrl[idx] = c;
+		if (idx < Group::Width) {
+			_ctrl[_capacity + idx] = c;
+		}
+	}
+
+	template <typename K>
+	size_t findIndex(const K &key, size_t hash) const {
+		if (!_capacity) {
+			return npos;
+		}
+
+		const auto h2 = getH2(hash);
+		const auto mask = _capacity - 1;
+		auto s = slots();
+		size_t pos = getH1(hash) & mask;
+		size_t step = 0;
+		while (true) {
+			Group g(_ctrl + pos);
+			for (auto m = g.match(h2); m; ++ m) {
+				auto idx = (pos + m.lowest()) & mask;
+				if (_eq(extractor::getKey(s[idx].ref()), key)) {
+					return idx;
+				}
+			}
+			if (g.matchEmpty()) {
+				return npos;
+			}
+			step += Group::Width;
+			pos = (pos + step) & mask;
+		}
+		return npos;
+	}
+
+	size_t findInsertSlot(size_t hash) const {
+		const auto mask = _capacity - 1;
+		size_t pos = getH1(hash) & mask;
+		size_t step = 0;
+		while (true) {
+			Group g(_ctrl + pos);
+			if (auto m = g.matchEmptyOrDeleted()) {
+				return (pos + m.lowest()) & mask;
+			}
+			step += Group::Width;
+			pos = (pos + step) & mask;
+		}
+		return npos;
+	}
+
+	// returns index of slot, prepared for construction
+	size_t prepareInsert(size_t hash) {
+		if (!_capacity) {
+			rehash(Group::Width);
+		}
+
+		auto idx = findInsertSlot(hash);
+		if (_growthLeft == 0 && _ctrl[idx] != Ctrl::Deleted) {
+			// if table contains mostly tombstones - cleanup with same capacity
+			rehash((_size * 2 <= growthForCapacity(_capacity)) ? _capacity : _capacity * 2);
+			idx = findInsertSlot(hash);
+		}
+
+		if (_ctrl[idx] == Ctrl::Empty) {
+			-- _growthLeft;
+		}
+		setCtrl(idx, getH2(hash));
+		++ _size;
+		return idx;
+	}
+
+	void eraseAt(size_t idx) {
+		_allocator.destroy(slots()[idx].ptr());
+		-- _size;
+
+		// slot can be marked empty, if no probe sequence can pass through it:
+		// it is true when there is no full group around it
+		const auto mask = _capacity - 1;
+		auto before = Group(_ctrl + ((idx - Group::Width) & mask)).matchEmpty();
+		auto after = Group(_ctrl + idx).matchEmpty();
+		if (before && after) {
+			auto emptyAfter = after.lowest();
+			auto emptyBefore = Group::Width - 1;
+			for (auto m = before; m; ++ m) { emptyBefore = m.lowest(); }
+			if ((Group::Width - 1 - emptyBefore) + emptyAfter < Group::Width) {
+				setCtrl(idx, Ctrl::Empty);
+				++ _growthLeft;
+				return;
+			}
+		}
+		setCtrl(idx, Ctrl::Deleted);
+	}
+
+	void rehash(size_t newCapacity) {
+		auto oldCtrl = _ctrl;
+		auto oldSlots = slots();
+		auto oldCapacity = _capacity;
+		auto oldAllocated = _allocated;
+
+		allocate(newCapacity);
+
+		if (oldCtrl) {
+			auto s = slots();
+			for (size_t i = 0; i < oldCapacity; ++ i) {
+				if (isFull(oldCtrl[i])) {
+					auto &v = oldSlots[i].ref();
+					auto hash = hashOf(extractor::getKey(v));
+					auto idx = findInsertSlot(hash);
+					setCtrl(idx, getH2(hash));
+					relocate(s[idx].ptr(), oldSlots[i].ptr());
+				}
+			}
+			_growthLeft -= _size;
+			Allocator<uint8_t>(_allocator).__deallocate((uint8_t *)oldSlots, oldAllocated, oldAllocated);
+		}
+	}
+
+	void relocate(Value *dest, Value *source) {
+		if constexpr (std::is_trivially_copyable_v<Value>) {
+			::memcpy((void *)dest, (const void *)source, sizeof(Value));
+		} else if constexpr (std::is_same_v<Key, Value>) {
+			_allocator.construct(dest, std::move(*source));
+			_allocator.destroy(source);
+		} else {
+			// key in slot is const only for the outside world, table owns it and can move it out
+			_allocator.construct(dest, std::piecewise_construct,
+					std::forward_as_tuple(std::move(const_cast<Key &>(source->first))),
+					std::forward_as_tuple(std::move(source->second)));
+			_allocator.destroy(source);
+		}
+	}
+
+	void allocate(size_t capacity) {
+		auto offset = slotsOffset(capacity);
+		size_t bytes = 0;
+		auto mem = Allocator<uint8_t>(_allocator).__allocate(offset + capacity + Group::Width, bytes);
+
+		_ctrl = (ctrl_t *)(mem + offset);
+		_capacity = capacity;
+		_growthLeft = growthForCapacity(capacity);
+		_allocated = bytes;
+		resetCtrl();
+	}
+
+	void deallocate() {
+		if (_ctrl) {
+			Allocator<uint8_t>(_allocator).__deallocate((uint8_t *)slots(), _allocated, _allocated);
+		}
+		_ctrl = nullptr;
+		_capacity = 0;
+		_size = 0;
+		_growthLeft = 0;
+		_allocated = 0;
+	}
+
+	void resetCtrl() {
+		::memset((void *)_ctrl, Ctrl::Empty, _capacity + Group::Width);
+	}
+
+	void destroyAll() {
+		if constexpr (!std::is_trivially_destructible_v<Value>) {
+			if (_size > 0) {
+				auto s = slots();
+				for (size_t i = 0; i < _capacity; ++ i) {
+					if (isFull(_ctrl[i])) {
+						_allocator.destroy(s[i].ptr());
+					}
+				}
+			}
+		}
+	}
+
+	void copyFrom(const Table &other) {
+		reserve(other.size());
+		auto s = slots();
+		for (auto &it : other) {
+			auto hash = hashOf(extractor::getKey(it));
+			auto idx = prepareInsert(hash);
+			_allocator.construct(s[idx].ptr(), it);
+		}
+	}
+
+	void moveFrom(Table &other) {
+		reserve(other.size());
+		auto s = slots();
+		for (auto &it : other) {
+			auto hash = hashOf(extractor::getKey(it));
+			auto idx = prepareInsert(hash);
+			relocate(s[idx].ptr(), const_cast<Value *>(&it));
+		}
+		// values was relocated, only memory should be released
+		other.deallocate();
+	}
+
+	void stealFrom(Table &other) {
+		_ctrl = other._ctrl;
+		_capacity = other._capacity;
+		_size = other._size;
+		_growthLeft = other._growthLeft;
+		_allocated = other._allocated;
+
+		other._ctrl = nullptr;
+		other._capacity = 0;
+		other._size = 0;
+		other._growthLeft = 0;
+		other._allocated = 0;
+	}
+
+	Hash _hash;
+	Equal _eq;
+	allocator_type _allocator;
+
+	ctrl_t *_ctrl = nullptr;
+	size_t _capacity = 0;
+	size_t _size = 0;
+	size_t _growthLeft = 0;
+	size_t _allocated = 0;
+};
+
+}
+
+#endif /* COMMON_MEMORY_SPMEMHASHTABLE_H_ */
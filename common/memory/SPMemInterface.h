@@ -32,6 +32,11 @@ THE SOFTWARE.
 #include "SPMemSet.h"
 #include "SPMemMap.h"
 #include "SPMemDict.h"
+#include "SPMemUnorderedMap.h"
+#include "SPMemUnorderedSet.h"
+#include "SPMemBtreeMap.h"
+#include "SPMemBtreeSet.h"
+#include "SPMemSmallVector.h"
 
 namespace stappler::memory {
 
@@ -45,6 +50,7 @@ struct PoolInterface : public memory::AllocPool {
 	template <typename Value> using ArrayType = memory::vector<Value>;
 	template <typename Value> using DictionaryType = memory::map<StringType, Value, std::less<>>;
 	template <typename Value> using VectorType = memory::vector<Value>;
+	template <typename Value, size_t N> using SmallVectorType = memory::small_vector<Value, N>;
 
 	template <typename K, typename V, typename Compare = std::less<>>
 	using MapType = memory::map<K, V, Compare>;
@@ -52,6 +58,12 @@ struct PoolInterface : public memory::AllocPool {
 	template <typename T, typename Compare = std::less<>>
 	using SetType = memory::set<T, Compare>;
 
+	template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+	using HashMapType = memory::unordered_map<K, V, Hash, Equal>;
+
+	template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+	using HashSetType = memory::unordered_set<T, Hash, Equal>;
+
 	template <typename T>
 	using FunctionType = memory::function<T>;
 
@@ -60,6 +72,20 @@ struct PoolInterface : public memory::AllocPool {
 	static constexpr bool usesMemoryPool() { return true; }
 };
 
+// PoolInterface with B-tree based ordered containers
+// Dictionaries have better locality and lower memory overhead, but any modification
+// invalidates iterators and references into dictionary. Unlike map-based interfaces,
+// reference from data::Value::getValue(key) is not valid after setValue or erase on the same dictionary
+struct PoolBtreeInterface : public PoolInterface {
+	template <typename Value> using DictionaryType = memory::btree_map<StringType, Value, std::less<>>;
+
+	template <typename K, typename V, typename Compare = std::less<>>
+	using MapType = memory::btree_map<K, V, Compare>;
+
+	template <typename T, typename Compare = std::less<>>
+	using SetType = memory::btree_set<T, Compare>;
+};
+
 struct StandartInterface : public memory::AllocBase {
 	using AllocBaseType = memory::AllocBase;
 	using StringType = std::string;
@@ -70,6 +96,7 @@ struct StandartInterface : public memory::AllocBase {
 	template <typename Value> using ArrayType = std::vector<Value>;
 	template <typename Value> using DictionaryType = std::map<StringType, Value, std::less<>>;
 	template <typename Value> using VectorType = std::vector<Value>;
+	template <typename Value, size_t N> using SmallVectorType = memory::small_vector<Value, N, std::allocator<Value>>;
 
 	template <typename K, typename V, typename Compare = std::less<>>
 	using MapType = std::map<K, V, Compare>;
@@ -77,6 +104,12 @@ struct StandartInterface : public memory::AllocBase {
 	template <typename T, typename Compare = std::less<>>
 	using SetType = std::set<T, Compare>;
 
+	template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+	using HashMapType = std::unordered_map<K, V, Hash, Equal>;
+
+	template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+	using HashSetType = std::unordered_set<T, Hash, Equal>;
+
 	template <typename T>
 	using FunctionType = std::function<T>;
 
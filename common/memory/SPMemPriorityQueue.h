@@ -109,10 +109,11 @@ public:
 
 		auto n = _queue.first;
 		while (n) {
+			auto next = n->next;
 			Value * val = (Value *)(n->storage.buffer);
 			val->~Value();
 			freeNode(n);
-			n = n->next;
+			n = next;
 		}
 	}
 
@@ -382,28 +383,21 @@ protected:
 			-- node->block->used;
 			if (node->block->used == 0) {
 				auto blockToRemove = node->block;
-				// remove all nodes from this block from free list
+				// remove all nodes from this block from free list, last free node can be in this block too
 				Node *n = _free.first;
+				Node *last = nullptr;
 				auto target = &_free.first;
-
-				// skip preallocated nodes, that should be first in free list
-				while (n && !n->block) {
-					target = &n->next;
-					n = n->next;
-				}
-
-				do {
-					while (n && n->block == blockToRemove) {
+				while (n) {
+					if (n->block == blockToRemove) {
 						n = n->next;
-					}
-					*target = n;
-					if (n) {
+						*target = n;
+					} else {
+						last = n;
 						target = &n->next;
 						n = n->next;
-					} else {
-						break;
 					}
-				} while (1);
+				}
+				_free.last = last;
 
 				deallocateBlock(lock, blockToRemove);
 			}
@@ -202,6 +202,12 @@ struct TreeKeyExtractor<Key, Key> {
 	static inline void construct(A &alloc, Node<Key> *node, Key &&key, Args && ... args) noexcept {
 		alloc.construct(node->value.ptr(), std::move(key));
 	}
+
+	template <typename A>
+	static inline void relocate(A &alloc, Node<Key> *target, Node<Key> *source) noexcept {
+		alloc.construct(target->value.ptr(), std::move(source->value.ref()));
+		alloc.destroy(source->value.ptr());
+	}
 };
 
 template <typename Key, typename Value>
@@ -223,6 +229,12 @@ struct TreeKeyExtractor<Key, Pair<Key, Value>> {
 				std::forward_as_tuple(std::move(k)),
 				std::forward_as_tuple(std::forward<Args>(args)...));
 	}
+
+	template <typename A>
+	static inline void relocate(A &alloc, Node<Pair<Key, Value>> *target, Node<Pair<Key, Value>> *source) noexcept {
+		alloc.construct(target->value.ptr(), std::move(source->value.ref()));
+		alloc.destroy(source->value.ptr());
+	}
 };
 
 template <typename Key, typename Value>
@@ -244,6 +256,16 @@ struct TreeKeyExtractor<Key, Pair<const Key, Value>> {
 				std::forward_as_tuple(std::move(k)),
 				std::forward_as_tuple(std::forward<Args>(args)...));
 	}
+
+	// source node is destroyed right after relocation, so key can be moved out
+	template <typename A>
+	static inline void relocate(A &alloc, Node<Pair<const Key, Value>> *target, Node<Pair<const Key, Value>> *source) noexcept {
+		alloc.construct(target->value.ptr(),
+				std::piecewise_construct,
+				std::forward_as_tuple(std::move(const_cast<Key &>(source->value.ref().first))),
+				std::forward_as_tuple(std::move(source->value.ref().second)));
+		alloc.destroy(source->value.ptr());
+	}
 };
 
 template <typename Key, typename Comp, typename Transparent = void>
@@ -451,6 +473,104 @@ public:
 		return _header.flag.prealloc;
 	}
 
+	// In slab mode nodes are allocated in contiguous blocks (see SlabSize) instead of one by one,
+	// so nodes, inserted one after another, are placed near each other in memory.
+	// Slab nodes are preallocated nodes: they are released only when tree is empty (or compacted)
+	void set_memory_slab(bool value) noexcept {
+		if (value) {
+			_allocator.set(SlabFlag);
+		} else {
+			_allocator.reset(SlabFlag);
+		}
+	}
+
+	bool memory_slab() const noexcept {
+		return _allocator.test(SlabFlag);
+	}
+
+	// Rebuilds tree into single contiguous block of nodes, placed in iteration order,
+	// tree becomes perfectly balanced; all other nodes (including reserved) are released
+	// Intended for trees, that are built once and iterated many times
+	void compact() {
+		if (_size == 0) {
+			releaseTmp();
+			return;
+		}
+
+		auto size = _size;
+		size_t bytes = 0;
+		auto block = allocateBlock(size, bytes);
+
+		auto n = block;
+		auto current = static_cast<NodeBase *>(left());
+		while (current != &_header) {
+			TreeKeyExtractor<Key, Value>::relocate(_allocator, n, static_cast<Node<Value> *>(current));
+			current = NodeBase::increment(current);
+			++ n;
+		}
+
+		// old nodes now are empty, hold them in chain, so they can be released with releaseTmp
+		compact_visit(root());
+
+		_size = 0;
+		releaseTmp();
+
+		// all previous blocks was released, so new block is the only one
+		_header.flag.index = 1;
+		for (size_t i = 0; i < size; ++ i) {
+			block[i].setIndex(1);
+		}
+
+		linkSorted(block, size);
+	}
+
+	// Replaces tree content with values from [first, last) in O(n), if range is sorted by key;
+	// values are placed in single contiguous block in iteration order.
+	// Unsorted ranges and ranges with duplicates are also accepted, but inserted one by one
+	// (only first value for every key is preserved)
+	template <typename ForwardIt>
+	void assign_sorted(ForwardIt first, ForwardIt last) {
+		clear();
+
+		auto size = size_t(std::distance(first, last));
+		if (size == 0) {
+			return;
+		}
+
+		size_t bytes = 0;
+		auto block = allocateBlock(size, bytes);
+		block[0].setIndex(++ _header.flag.index);
+
+		bool sorted = true;
+		auto n = block;
+		for (auto it = first; it != last; ++ it, ++ n) {
+			n->setIndex(block[0].getIndex());
+			_allocator.construct(n->value.ptr(), *it);
+			if (sorted && n != block && !compareLtKey(extract(n - 1), extract(n))) {
+				sorted = false;
+			}
+		}
+
+		if (sorted) {
+			linkSorted(block, size);
+		} else {
+			for (size_t i = 0; i < size; ++ i) {
+				auto node = block + i;
+				node->parent = nullptr;
+				node->left = nullptr;
+				node->right = nullptr;
+				node->setColor(NodeColor::Red);
+
+				InsertData d{&extract(node), node, nullptr, nullptr, false};
+				if (!getInsertPositionUnique(d)) {
+					destroyNode(node);
+				} else {
+					makeInsert(node, d.parent, d.isLeft);
+				}
+			}
+		}
+	}
+
 	void swap(Tree &other) noexcept {
 		std::swap(_header, other._header);
 		std::swap(_allocator, other._allocator);
@@ -531,6 +651,14 @@ protected:
 	// _header.index - count of preallocated blocks in use
 	// _header.prealloc - flag of persistent mode (enabled if 1, disabled by default)
 
+	// slab mode flag is stored in allocator's pool pointer
+	static constexpr auto SlabFlag = value_allocator_type::FirstFlag;
+
+	// slabs are multiples of cache line, grows with tree from SlabSize to SlabMaxSize
+	static constexpr size_t SlabCacheLine = 64;
+	static constexpr size_t SlabSize = 1_KiB;
+	static constexpr size_t SlabMaxSize = 16_KiB;
+
 	NodeBase _header; // root is _header.left
 	comparator_type _comp;
 	value_allocator_type _allocator;
@@ -909,6 +1037,18 @@ protected:
 		destroyNode(target);
 	}
 
+	void compact_visit(Node<Value> *target) {
+		if (target->left) {
+			compact_visit(static_cast<Node<Value> *>(target->left));
+		}
+		if (target->right) {
+			compact_visit(static_cast<Node<Value> *>(target->right));
+		}
+		target->parent = _tmp;
+		_tmp = target;
+		++ _header.flag.size;
+	}
+
 	void clone_visit(const Node<Value> *source, Node<Value> *target) {
 		_allocator.construct(target->value.ptr(), source->value.ref());
 		target->setColor(source->getColor());
@@ -1051,6 +1191,10 @@ protected:
 	}
 
 	Node<Value> * allocateNode() {
+		if (!_tmp && memory_slab()) {
+			allocateTmp(getSlabNodes());
+		}
+
 		if (_tmp) {
 			auto ret = _tmp;
 			_tmp = (Node<Value> *)ret->parent;
@@ -1065,6 +1209,31 @@ protected:
 		}
 	}
 
+	size_t getSlabNodes() const {
+		auto bytes = std::min(std::max(_size * sizeof(Node<Value>), SlabSize), SlabMaxSize);
+		bytes = ((bytes + SlabCacheLine - 1) / SlabCacheLine) * SlabCacheLine;
+		return std::max(bytes / sizeof(Node<Value>), size_t(1));
+	}
+
+	// allocates contiguous block of preallocated nodes, that can be released only as a whole,
+	// sum of node sizes in block is equal to the size of allocation
+	Node<Value> * allocateBlock(size_t count, size_t &s) {
+		auto ret = node_allocator_type(_allocator).__allocate(count, s);
+		auto n = ret;
+		for (size_t i = 0; i < count; ++ i) {
+			n->setPrealloc(true);
+			n->setColor(NodeColor::Red);
+			if (i < count - 1) {
+				n->setSize(sizeof(Node<Value>));
+				s -= sizeof(Node<Value>);
+			} else {
+				n->setSize(s);
+			}
+			++ n;
+		}
+		return ret;
+	}
+
 	void allocateTmp(size_t count) {
 		// preallocate new n nodes
 
@@ -1072,27 +1241,46 @@ protected:
 		_header.flag.size += count; // increment capacity counter
 
 		size_t s;
-		auto ret = node_allocator_type(_allocator).__allocate(count, s);
+		auto ret = allocateBlock(count, s);
 		auto n = ret;
 
 		for (size_t i = 0; i < count; ++ i) {
-			NodeBase *tmpN = n;
-			tmpN->parent = n + 1;
-			tmpN->setPrealloc(true);
-			tmpN->setIndex(preallocIdx);
-			if (i < count - 1) {
-				tmpN->parent = n + 1;
-				tmpN->setSize(sizeof(Node<Value>));
-				s -= sizeof(Node<Value>);
-			} else {
-				tmpN->parent = _tmp;
-				n->setSize(s);
-			}
+			n->setIndex(preallocIdx);
+			n->parent = (i < count - 1) ? n + 1 : _tmp;
 			++ n;
 		}
 		_tmp = ret;
 	}
 
+	// links array of nodes, sorted by key, into balanced tree: with split by the middle
+	// all leaves are on the last two levels, so nodes on the deepest level are red, and all others are black
+	NodeBase * linkSorted_visit(Node<Value> *nodes, size_t first, size_t last, size_t depth, size_t redDepth) {
+		if (first >= last) {
+			return nullptr;
+		}
+
+		auto mid = first + (last - first) / 2;
+		auto n = nodes + mid;
+		n->setColor((depth == redDepth && depth != 0) ? NodeColor::Red : NodeColor::Black);
+		n->left = linkSorted_visit(nodes, first, mid, depth + 1, redDepth);
+		n->right = linkSorted_visit(nodes, mid + 1, last, depth + 1, redDepth);
+		if (n->left) { n->left->parent = n; }
+		if (n->right) { n->right->parent = n; }
+		return n;
+	}
+
+	void linkSorted(Node<Value> *nodes, size_t count) {
+		size_t redDepth = 0;
+		while ((size_t(2) << redDepth) <= count) {
+			++ redDepth;
+		}
+
+		setroot(linkSorted_visit(nodes, 0, count, 0, redDepth));
+		setleft(nodes);
+		setright(nodes + count - 1);
+		_size = count;
+	}
+
 	void releaseTmp() {
 		// release any tmp nodes if possible
 		// preallocated nodes released in batch as acquired, only if tree is empty
@@ -1152,9 +1340,13 @@ protected:
 			}
 		} else {
 			// multiple preallocated blocks make things complicated
-			// VLA, compilers should support C99,
-			// MSVC - fuck off, use new[] or std::vector=)
-			PreallocatedData data[_header.flag.index];
+			// slab mode can produce a lot of blocks, so use pool memory for block info
+			size_t dataSize = 0;
+			auto dataCount = size_t(_header.flag.index);
+			auto data = Allocator<PreallocatedData>(_allocator).__allocate(dataCount, dataSize);
+			for (size_t i = 0; i < dataCount; ++ i) {
+				new (data + i) PreallocatedData();
+			}
 
 			while (_tmp) {
 				auto ptr = _tmp;
@@ -1171,14 +1363,16 @@ protected:
 					-- _header.flag.size;
 				}
 			}
-			for (size_t i = 0; i < _header.flag.index; ++ i) {
+			for (size_t i = 0; i < dataCount; ++ i) {
 				if (data[i].head != (Node<Value> *)maxOf<uintptr_t>()) {
 					_header.flag.size -= data[i].count;
 					node_allocator_type(_allocator).__deallocate(data[i].head, data[i].count, data[i].size);
 				}
 			}
+			Allocator<PreallocatedData>(_allocator).__deallocate(data, dataCount, dataSize);
 		}
 		_tmp = nullptr;
+		_header.flag.index = 0; // no preallocated blocks left
 	}
 };
 
@@ -118,6 +118,15 @@ public:
 	void set_memory_persistent(bool value) noexcept { _tree.set_memory_persistent(value); }
 	bool memory_persistent() const noexcept { return _tree.memory_persistent(); }
 
+	void set_memory_slab(bool value) noexcept { _tree.set_memory_slab(value); }
+	bool memory_slab() const noexcept { return _tree.memory_slab(); }
+
+	// see rbtree::Tree::compact and rbtree::Tree::assign_sorted
+	void compact() { _tree.compact(); }
+
+	template <class ForwardIt>
+	void assign_sorted(ForwardIt first, ForwardIt last) { _tree.assign_sorted(first, last); }
+
 	Pair<iterator,bool> insert( const value_type& value ) {
 		return emplace(value);
 	}
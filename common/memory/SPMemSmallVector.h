@@ -0,0 +1,376 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_MEMORY_SPMEMSMALLVECTOR_H_
+#define COMMON_MEMORY_SPMEMSMALLVECTOR_H_
+
+#include "SPMemPointerIterator.h"
+#include "SPMemAlloc.h"
+
+/* Vector with inline capacity
+ *
+ * First N elements are stored within object itself, heap (or pool) memory is used
+ * only when size exceeds N. Type should be trivially relocatable (see is_trivially_relocatable),
+ * so elements are moved between inline and allocated storage with memcpy.
+ *
+ * With memory::Allocator (default) memory is allocated from pool, use std::allocator
+ * for malloc-based allocation (see StandartInterface::SmallVectorType)
+ *
+ * Unlike std::vector, move of inline storage invalidates iterators
+ */
+
+namespace stappler::memory {
+
+template <typename Type, size_t N, typename Alloc = Allocator<Type>>
+class small_vector : public std::conditional_t<std::is_same_v<Alloc, Allocator<Type>>, AllocPool, AllocBase> {
+public:
+	static_assert(is_trivially_relocatable<Type>::value, "small_vector requires trivially relocatable type");
+	static_assert(N > 0, "small_vector requires inline capacity");
+
+	using allocator_type = Alloc;
+	using alloc_traits = std::allocator_traits<Alloc>;
+
+	using pointer = Type *;
+	using const_pointer = const Type *;
+	using reference = Type &;
+	using const_reference = const Type &;
+
+	using size_type = size_t;
+	using value_type = Type;
+	using self = small_vector<Type, N, Alloc>;
+
+	using iterator = pointer_iterator<Type, pointer, reference>;
+	using const_iterator = pointer_iterator<Type, const_pointer, const_reference>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	static constexpr size_type inline_capacity() { return N; }
+
+	small_vector() noexcept { }
+	explicit small_vector(const allocator_type &alloc) noexcept : _allocator(alloc) { }
+
+	explicit small_vector(size_type count, const Type &value, const allocator_type &alloc = allocator_type()) noexcept
+	: _allocator(alloc) {
+		resize(count, value);
+	}
+
+	explicit small_vector(size_type count, const allocator_type &alloc = allocator_type()) noexcept
+	: _allocator(alloc) {
+		resize(count);
+	}
+
+	template< class InputIt >
+	small_vector(InputIt first, InputIt last, const allocator_type &alloc = allocator_type()) : _allocator(alloc) {
+		assign(first, last);
+	}
+
+	small_vector(InitializerList<Type> init, const allocator_type &alloc = allocator_type()) noexcept : _allocator(alloc) {
+		assign(init.begin(), init.end());
+	}
+
+	small_vector(const small_vector &other) noexcept : _allocator(other._allocator) {
+		assign(other.begin(), other.end());
+	}
+
+	small_vector(const small_vector &other, const allocator_type &alloc) noexcept : _allocator(alloc) {
+		assign(other.begin(), other.end());
+	}
+
+	small_vector(small_vector &&other) noexcept : _allocator(other._allocator) {
+		perform_move(std::move(other));
+	}
+
+	small_vector(small_vector &&other, const allocator_type &alloc) noexcept : _allocator(alloc) {
+		perform_move(std::move(other));
+	}
+
+	~small_vector() noexcept {
+		clear();
+		deallocate();
+	}
+
+	small_vector &operator=(const small_vector &other) noexcept {
+		if (&other != this) {
+			assign(other.begin(), other.end());
+		}
+		return *this;
+	}
+
+	small_vector &operator=(small_vector &&other) noexcept {
+		if (&other != this) {
+			clear();
+			deallocate();
+			perform_move(std::move(other));
+		}
+		return *this;
+	}
+
+	small_vector &operator=(InitializerList<Type> init) noexcept {
+		assign(init.begin(), init.end());
+		return *this;
+	}
+
+	template< class InputIt >
+	void assign(InputIt first, InputIt last) {
+		clear();
+		if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>) {
+			reserve(std::distance(first, last));
+		}
+		for (auto it = first; it != last; ++ it) {
+			emplace_back(*it);
+		}
+	}
+
+	allocator_type get_allocator() const noexcept { return _allocator; }
+
+	reference operator[](size_type pos) noexcept { return data()[pos]; }
+	const_reference operator[](size_type pos) const noexcept { return data()[pos]; }
+
+	reference at(size_type pos) noexcept { return data()[pos]; }
+	const_reference at(size_type pos) const noexcept { return data()[pos]; }
+
+	reference front() noexcept { return *data(); }
+	const_reference front() const noexcept { return *data(); }
+
+	reference back() noexcept { return data()[_size - 1]; }
+	const_reference back() const noexcept { return data()[_size - 1]; }
+
+	pointer data() noexcept { return _heap ? _heap : inline_data(); }
+	const_pointer data() const noexcept { return _heap ? _heap : inline_data(); }
+
+	iterator begin() noexcept { return iterator(data()); }
+	iterator end() noexcept { return iterator(data() + _size); }
+
+	const_iterator begin() const noexcept { return const_iterator(data()); }
+	const_iterator end() const noexcept { return const_iterator(data() + _size); }
+
+	const_iterator cbegin() const noexcept { return const_iterator(data()); }
+	const_iterator cend() const noexcept { return const_iterator(data() + _size); }
+
+	reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+	reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+
+	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+	const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend()); }
+	const_reverse_iterator crend() const noexcept { return const_reverse_iterator(cbegin()); }
+
+	bool empty() const noexcept { return _size == 0; }
+	size_type size() const noexcept { return _size; }
+	size_type capacity() const noexcept { return _heap ? _capacity : N; }
+
+	// true if elements are stored within object
+	bool is_inline() const noexcept { return _heap == nullptr; }
+
+	void reserve(size_type s) {
+		if (s > capacity()) {
+			reallocate(s);
+		}
+	}
+
+	// moves elements back to inline storage, if possible
+	void shrink_to_fit() noexcept {
+		if (_heap) {
+			if (_size <= N) {
+				auto heap = _heap;
+				auto cap = _capacity;
+				memcpy((void *)inline_data(), (const void *)heap, _size * sizeof(Type));
+				_heap = nullptr;
+				_capacity = 0;
+				alloc_traits::deallocate(_allocator, heap, cap);
+			} else if (_size < _capacity) {
+				reallocate(_size);
+			}
+		}
+	}
+
+	void clear() noexcept {
+		destroy(data(), _size);
+		_size = 0;
+	}
+
+	template< class... Args >
+	reference emplace_back(Args && ... args) {
+		if (_size == capacity()) {
+			return grow_emplace(std::forward<Args>(args)...);
+		}
+		auto ptr = data() + _size;
+		alloc_traits::construct(_allocator, ptr, std::forward<Args>(args)...);
+		++ _size;
+		return *ptr;
+	}
+
+	void push_back(const Type &value) { emplace_back(value); }
+	void push_back(Type &&value) { emplace_back(std::move(value)); }
+
+	void pop_back() noexcept {
+		if (_size > 0) {
+			-- _size;
+			destroy(data() + _size, 1);
+		}
+	}
+
+	template< class... Args >
+	iterator emplace(const_iterator pos, Args && ... args) {
+		auto idx = size_type(pos - cbegin());
+		if (idx == _size) {
+			emplace_back(std::forward<Args>(args)...);
+		} else {
+			// construct value before shift, args can refer to vector's elements
+			Storage<Type> tmp;
+			alloc_traits::construct(_allocator, tmp.ptr(), std::forward<Args>(args)...);
+			reserve(_size + 1 > capacity() ? capacity() * 2 : 0);
+			auto ptr = data();
+			memmove((void *)(ptr + idx + 1), (const void *)(ptr + idx), (_size - idx) * sizeof(Type));
+			memcpy((void *)(ptr + idx), (const void *)tmp.ptr(), sizeof(Type));
+			++ _size;
+		}
+		return iterator(data() + idx);
+	}
+
+	iterator insert(const_iterator pos, const Type &value) { return emplace(pos, value); }
+	iterator insert(const_iterator pos, Type &&value) { return emplace(pos, std::move(value)); }
+
+	iterator erase(const_iterator pos) {
+		return erase(pos, pos + 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		auto ptr = data();
+		auto idx = size_type(first - cbegin());
+		auto len = size_type(last - first);
+		if (len > 0) {
+			destroy(ptr + idx, len);
+			memmove((void *)(ptr + idx), (const void *)(ptr + idx + len), (_size - idx - len) * sizeof(Type));
+			_size -= len;
+		}
+		return iterator(ptr + idx);
+	}
+
+	template< class... Args >
+	void resize(size_type n, Args && ... args) {
+		if (n < _size) {
+			destroy(data() + n, _size - n);
+			_size = n;
+		} else if (n > _size) {
+			reserve(n);
+			auto ptr = data();
+			for (size_type i = _size; i < n; ++ i) {
+				alloc_traits::construct(_allocator, ptr + i, std::forward<Args>(args)...);
+			}
+			_size = n;
+		}
+	}
+
+	void swap(small_vector &other) noexcept {
+		small_vector tmp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+protected:
+	pointer inline_data() noexcept { return (pointer)_inline; }
+	const_pointer inline_data() const noexcept { return (const_pointer)_inline; }
+
+	void destroy(pointer ptr, size_type count) noexcept {
+		if constexpr (!std::is_trivially_destructible<Type>::value) {
+			for (size_type i = 0; i < count; ++ i) {
+				alloc_traits::destroy(_allocator, ptr + i);
+			}
+		}
+	}
+
+	void deallocate() noexcept {
+		if (_heap) {
+			alloc_traits::deallocate(_allocator, _heap, _capacity);
+			_heap = nullptr;
+			_capacity = 0;
+		}
+	}
+
+	void reallocate(size_type cap) {
+		auto ptr = alloc_traits::allocate(_allocator, cap);
+		memcpy((void *)ptr, (const void *)data(), _size * sizeof(Type));
+		deallocate();
+		_heap = ptr;
+		_capacity = cap;
+	}
+
+	template< class... Args >
+	reference grow_emplace(Args && ... args) {
+		// new element should be constructed before old storage is released
+		const auto cap = capacity() * 2;
+		auto ptr = alloc_traits::allocate(_allocator, cap);
+		alloc_traits::construct(_allocator, ptr + _size, std::forward<Args>(args)...);
+		memcpy((void *)ptr, (const void *)data(), _size * sizeof(Type));
+		deallocate();
+		_heap = ptr;
+		_capacity = cap;
+		return ptr[_size ++];
+	}
+
+	void perform_move(small_vector &&other) noexcept {
+		if (other._heap && other._allocator == _allocator) {
+			_heap = other._heap;
+			_capacity = other._capacity;
+			other._heap = nullptr;
+			other._capacity = 0;
+		} else {
+			reserve(other._size);
+			memcpy((void *)data(), (const void *)other.data(), other._size * sizeof(Type));
+			other.deallocate();
+		}
+		_size = other._size;
+		other._size = 0;
+	}
+
+	allocator_type _allocator;
+	pointer _heap = nullptr;
+	size_type _size = 0;
+	size_type _capacity = 0; // capacity of heap block
+	alignas(Type) uint8_t _inline[sizeof(Type) * N];
+};
+
+template <typename Type, size_t N, typename Alloc>
+struct is_trivially_relocatable<small_vector<Type, N, Alloc>> {
+	static constexpr bool value = is_trivially_relocatable<Alloc>::value;
+};
+
+template <typename Type, size_t N, typename Alloc>
+inline bool operator==(const small_vector<Type, N, Alloc> &l, const small_vector<Type, N, Alloc> &r) {
+	return l.size() == r.size() && std::equal(l.begin(), l.end(), r.begin());
+}
+
+template <typename Type, size_t N, typename Alloc>
+inline bool operator!=(const small_vector<Type, N, Alloc> &l, const small_vector<Type, N, Alloc> &r) {
+	return !(l == r);
+}
+
+template <typename Type, size_t N, typename Alloc>
+inline bool operator<(const small_vector<Type, N, Alloc> &l, const small_vector<Type, N, Alloc> &r) {
+	return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+}
+
+}
+
+#endif /* COMMON_MEMORY_SPMEMSMALLVECTOR_H_ */
@@ -925,6 +925,12 @@ using u32string = basic_string<char32_t>;
 
 using weak_string = const string;
 
+// storage has no pointers into itself, small strings are addressed from object's start
+template <typename CharType>
+struct is_trivially_relocatable<basic_string<CharType>> {
+	static constexpr bool value = true;
+};
+
 }
 
 inline stappler::memory::basic_string<char> operator"" _weak ( const char* str, size_t len) {
@@ -0,0 +1,272 @@
+/**
+Copyright (c) 2017-2022 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_MEMORY_SPMEMUNORDEREDMAP_H_
+#define COMMON_MEMORY_SPMEMUNORDEREDMAP_H_
+
+#include "SPMemHashTable.h"
+
+namespace stappler::memory {
+
+// Pool-based hash map with open addressing, see SPMemHashTable.h
+// Values are stored inline, so references and iterators are invalidated on insertion, that causes rehash
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class unordered_map : public AllocPool {
+public:
+	using key_type = Key;
+	using mapped_type = Value;
+	using value_type = Pair<const Key, Value>;
+	using hasher = Hash;
+	using key_equal = Equal;
+	using allocator_type = Allocator<value_type>;
+
+	using pointer = value_type *;
+	using const_pointer = const value_type *;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+
+	using table_type = hashtable::Table<Key, value_type, Hash, Equal>;
+
+	using iterator = typename table_type::iterator;
+	using const_iterator = typename table_type::const_iterator;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+
+	// lookups with foreign key types only allowed, when both hasher and comparator allows it
+	template <typename K>
+	using enable_if_transparent = std::enable_if_t<
+		hashtable::IsTransparent<Hash>::value && hashtable::IsTransparent<Equal>::value
+		&& !std::is_same_v<std::decay_t<K>, Key>>;
+
+public:
+	unordered_map() noexcept : _table() { }
+
+	explicit unordered_map(size_type bucket_count, const Hash &hash = Hash(), const Equal &equal = Equal(),
+			const allocator_type &alloc = allocator_type()) noexcept
+	: _table(hash, equal, alloc) {
+		_table.reserve(bucket_count);
+	}
+
+	explicit unordered_map(const allocator_type &alloc) noexcept : _table(Hash(), Equal(), alloc) { }
+
+	template<class InputIterator>
+	unordered_map(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+	: _table(Hash(), Equal(), alloc) {
+		for (auto it = first; it != last; it ++) {
+			do_insert(*it);
+		}
+	}
+
+	unordered_map(const unordered_map &x) noexcept : _table(x._table) { }
+	unordered_map(const unordered_map &x, const allocator_type &alloc) noexcept : _table(x._table, alloc) { }
+
+	unordered_map(unordered_map &&x) noexcept : _table(std::move(x._table), x.get_allocator()) { }
+	unordered_map(unordered_map &&x, const allocator_type &alloc) noexcept : _table(std::move(x._table), alloc) { }
+
+	unordered_map(InitializerList<value_type> il, const allocator_type &alloc = allocator_type()) noexcept
+	: _table(Hash(), Equal(), alloc) {
+		_table.reserve(il.size());
+		for (auto &it : il) {
+			do_insert(std::move(const_cast<reference>(it)));
+		}
+	}
+
+	unordered_map &operator=(const unordered_map &other) noexcept {
+		_table = other._table;
+		return *this;
+	}
+
+	unordered_map &operator=(unordered_map &&other) noexcept {
+		_table = std::move(other._table);
+		return *this;
+	}
+
+	unordered_map &operator=(InitializerList<value_type> ilist) noexcept {
+		_table.clear();
+		for (auto &it : ilist) {
+			do_insert(std::move(const_cast<reference>(it)));
+		}
+		return *this;
+	}
+
+	allocator_type get_allocator() const noexcept { return _table.get_allocator(); }
+	bool empty() const noexcept { return _table.empty(); }
+	size_t size() const noexcept { return _table.size(); }
+	size_t capacity() const noexcept { return _table.capacity(); }
+	size_t bucket_count() const noexcept { return _table.capacity(); }
+	float load_factor() const noexcept { return _table.load_factor(); }
+	float max_load_factor() const noexcept { return _table.max_load_factor(); }
+	void clear() { _table.clear(); }
+	void shrink_to_fit() { _table.shrink_to_fit(); }
+	void reserve(size_t c) { _table.reserve(c); }
+
+	hasher hash_function() const { return _table.hash_function(); }
+	key_equal key_eq() const { return _table.key_eq(); }
+
+	// missing key is a fatal error, like std::out_of_range without exceptions
+	Value& at(const Key& key) {
+		auto it = find(key);
+		if (it == end()) {
+			abort();
+		}
+		return it->second;
+	}
+	const Value& at(const Key& key) const {
+		auto it = find(key);
+		if (it == end()) {
+			abort();
+		}
+		return it->second;
+	}
+
+	Value& operator[] ( const Key& key ) {
+		return this->try_emplace(key).first->second;
+	}
+	Value& operator[] ( Key&& key ) {
+		return this->try_emplace(std::move(key)).first->second;
+	}
+
+	iterator begin() noexcept { return _table.begin(); }
+	iterator end() noexcept { return _table.end(); }
+
+	const_iterator begin() const noexcept { return _table.begin(); }
+	const_iterator end() const noexcept { return _table.end(); }
+
+	const_iterator cbegin() const noexcept { return _table.begin(); }
+	const_iterator cend() const noexcept { return _table.end(); }
+
+	void swap(unordered_map &other) noexcept { _table.swap(other._table); }
+
+	template< class P >
+	Pair<iterator,bool> insert( P&& value ) {
+		return do_insert(std::forward<P>(value));
+	}
+
+	template< class InputIt >
+	void insert( InputIt first, InputIt last ) {
+		for (auto it = first; it != last; it ++) {
+			do_insert(*it);
+		}
+	}
+
+	void insert( InitializerList<value_type> ilist ) {
+		for (auto &it : ilist) {
+			do_insert(std::move(const_cast<reference>(it)));
+		}
+	}
+
+	template <class M>
+	Pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj) {
+		auto ret = try_emplace(k, std::forward<M>(obj));
+		if (!ret.second) {
+			ret.first->second = std::forward<M>(obj);
+		}
+		return ret;
+	}
+
+	template <class M>
+	Pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj) {
+		auto ret = try_emplace(std::move(k), std::forward<M>(obj));
+		if (!ret.second) {
+			ret.first->second = std::forward<M>(obj);
+		}
+		return ret;
+	}
+
+	// same as memory::map::emplace: existing value is replaced
+	template< class... Args >
+	Pair<iterator,bool> emplace( Args&&... args ) {
+		auto ret = try_emplace(std::forward<Args>(args)...);
+		if (!ret.second) {
+			do_assign(ret.first, std::forward<Args>(args)...);
+		}
+		return ret;
+	}
+
+	template <class... Args>
+	Pair<iterator, bool> try_emplace(const key_type& k, Args&&... args) {
+		return _table.try_emplace(k, std::forward<Args>(args)...);
+	}
+
+	template <class... Args>
+	Pair<iterator, bool> try_emplace(key_type&& k, Args&&... args) {
+		return _table.try_emplace(std::move(k), std::forward<Args>(args)...);
+	}
+
+	iterator erase( const_iterator pos ) { return _table.erase(pos); }
+	iterator erase( const_iterator first, const_iterator last ) { return _table.erase(first, last); }
+	size_type erase( const key_type& key ) { return _table.erase_unique(key); }
+
+	iterator find( const Key& x ) { return _table.find(x); }
+	const_iterator find( const Key& x ) const { return _table.find(x); }
+	bool contains( const Key& x ) const { return _table.contains(x); }
+	size_t count( const Key& x ) const { return _table.contains(x) ? 1 : 0; }
+
+	template< class K, typename = enable_if_transparent<K> > iterator find( const K& x ) { return _table.find(x); }
+	template< class K, typename = enable_if_transparent<K> > const_iterator find( const K& x ) const { return _table.find(x); }
+	template< class K, typename = enable_if_transparent<K> > bool contains( const K& x ) const { return _table.contains(x); }
+	template< class K, typename = enable_if_transparent<K> > size_t count( const K& x ) const { return _table.contains(x) ? 1 : 0; }
+
+	// number of bytes, allocated from pool
+	size_t allocated() const noexcept { return _table.allocated(); }
+
+protected:
+	template <class A, class B>
+	Pair<iterator,bool> do_insert( const Pair<A, B> & value ) {
+		return emplace(value.first, value.second);
+	}
+
+	template <class A, class B>
+	Pair<iterator,bool> do_insert( Pair<A, B> && value ) {
+		return emplace(std::move(value.first), std::move(value.second));
+	}
+
+	template <class T, class ... Args>
+	void do_assign( iterator it, T &&, Args && ... args) {
+		it->second = Value(std::forward<Args>(args)...);
+	}
+
+	table_type _table;
+};
+
+template<typename Key, typename Value, typename Hash, typename Equal> inline bool
+operator==(const unordered_map<Key, Value, Hash, Equal>& __x, const unordered_map<Key, Value, Hash, Equal>& __y) {
+	if (__x.size() != __y.size()) {
+		return false;
+	}
+	for (auto &it : __x) {
+		auto iit = __y.find(it.first);
+		if (iit == __y.end() || !(iit->second == it.second)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal> inline bool
+operator!=(const unordered_map<Key, Value, Hash, Equal>& __x, const unordered_map<Key, Value, Hash, Equal>& __y) {
+	return !(__x == __y);
+}
+
+}
+
+#endif /* COMMON_MEMORY_SPMEMUNORDEREDMAP_H_ */
@@ -23,6 +23,7 @@ THE SOFTWARE.
 #include "SPMemUuid.h"
 #include "SPString.h"
 #include "SPTime.h"
+#include "SPRandom.h"
 
 #if SPAPR
 #include "apr_uuid.h"
@@ -114,69 +115,119 @@ uuid uuid::generate() {
 	return uuid(d);
 }
 
-void uuid::format(char *buf, const uuid_t &d) {
-	sprintf(buf, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-		d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8], d[9], d[10], d[11], d[12], d[13], d[14], d[15]);
+uuid uuid::generateV4() {
+	uuid_t d;
+	random::fill(d.data(), d.size());
+	d[6] = (d[6] & 0x0F) | 0x40;
+	d[8] = (d[8] & 0x3F) | 0x80;
+	return uuid(d);
 }
 
-static uint8_t parse_hexpair(const char *s) {
-	int result;
-	int temp;
-
-	result = s[0] - '0';
-	if (result > 48) {
-		result = (result - 39) << 4;
-	} else if (result > 16) {
-		result = (result - 7) << 4;
-	} else {
-		result = result << 4;
-	}
+uuid uuid::generateV7() {
+	// 48-bit unix milliseconds + 12-bit sub-millisecond fraction (RFC 9562, 6.2, method 3);
+	// when clock does not advance, previous value is incremented to keep ordering
+	thread_local uint64_t tl_last = 0;
 
-	temp = s[1] - '0';
-	if (temp > 48) {
-		result |= temp - 39;
-	} else if (temp > 16) {
-		result |= temp - 7;
-	} else {
-		result |= temp;
+	auto t = Time::now().toMicros();
+	uint64_t value = ((t / 1000) << 12) | (((t % 1000) << 12) / 1000);
+	if (value <= tl_last) {
+		value = tl_last + 1;
 	}
+	tl_last = value;
 
-	return (uint8_t)result;
+	uuid_t d;
+	random::fill(d.data() + 8, 8);
+
+	const uint64_t ms = value >> 12;
+	d[0] = uint8_t(ms >> 40);
+	d[1] = uint8_t(ms >> 32);
+	d[2] = uint8_t(ms >> 24);
+	d[3] = uint8_t(ms >> 16);
+	d[4] = uint8_t(ms >> 8);
+	d[5] = uint8_t(ms);
+	d[6] = uint8_t(0x70 | ((value >> 8) & 0x0F));
+	d[7] = uint8_t(value);
+	d[8] = (d[8] & 0x3F) | 0x80;
+	return uuid(d);
 }
 
-bool uuid::parse(uuid_t &d, const char *uuid_str) {
-	int i;
+// byte -> two lowercase hex chars
+struct UuidHexTable {
+	char table[256][2];
 
-	for (i = 0; i < 36; ++i) {
-		char c = uuid_str[i];
-		if (!isxdigit(c) && !(c == '-' && (i == 8 || i == 13 || i == 18 || i == 23))) {
-			return false;
+	constexpr UuidHexTable() : table() {
+		constexpr char digits[] = "0123456789abcdef";
+		for (size_t i = 0; i < 256; ++ i) {
+			table[i][0] = digits[i >> 4];
+			table[i][1] = digits[i & 0xF];
 		}
 	}
+};
 
-	if (uuid_str[36] != '\0') {
-		return false;
+// char -> nibble value, 0x100 for non-hex chars
+struct UuidNibbleTable {
+	uint16_t table[256];
+
+	constexpr UuidNibbleTable() : table() {
+		for (size_t i = 0; i < 256; ++ i) {
+			if (i >= '0' && i <= '9') {
+				table[i] = i - '0';
+			} else if (i >= 'a' && i <= 'f') {
+				table[i] = i - 'a' + 10;
+			} else if (i >= 'A' && i <= 'F') {
+				table[i] = i - 'A' + 10;
+			} else {
+				table[i] = 0x100;
+			}
+		}
 	}
+};
 
-	d[0] = base16::hexToChar(uuid_str[0], uuid_str[1]);
-	d[1] = base16::hexToChar(uuid_str[2], uuid_str[3]);
-	d[2] = base16::hexToChar(uuid_str[4], uuid_str[5]);
-	d[3] = base16::hexToChar(uuid_str[6], uuid_str[7]);
+static constexpr UuidHexTable s_uuidHexTable;
+static constexpr UuidNibbleTable s_uuidNibbleTable;
 
-	d[4] = base16::hexToChar(uuid_str[9], uuid_str[10]);
-	d[5] = base16::hexToChar(uuid_str[11], uuid_str[12]);
+// offsets of the hex pairs in the formatted string
+static constexpr uint8_t s_uuidOffsets[16] = { 0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34 };
 
-	d[6] = base16::hexToChar(uuid_str[14], uuid_str[15]);
-	d[7] = base16::hexToChar(uuid_str[16], uuid_str[17]);
+void uuid::format(char *buf, const uuid_t &d) {
+	for (size_t i = 0; i < 16; ++ i) {
+		memcpy(buf + s_uuidOffsets[i], s_uuidHexTable.table[d[i]], 2);
+	}
+	buf[8] = buf[13] = buf[18] = buf[23] = '-';
+}
 
-	d[8] = base16::hexToChar(uuid_str[19], uuid_str[20]);
-	d[9] = base16::hexToChar(uuid_str[21], uuid_str[22]);
+static bool parse_uuid(uuid::uuid_t &d, const char *str) {
+	// no early exits: errors are accumulated in one mask, so parsing is branch-free
+	uint32_t invalid = (str[8] ^ '-') | (str[13] ^ '-') | (str[18] ^ '-') | (str[23] ^ '-');
 
-	for (i = 6; i--;) {
-		d[10 + i] = parse_hexpair(&uuid_str[i*2+24]);
+	uuid::uuid_t ret;
+	for (size_t i = 0; i < 16; ++ i) {
+		auto hi = s_uuidNibbleTable.table[uint8_t(str[s_uuidOffsets[i]])];
+		auto lo = s_uuidNibbleTable.table[uint8_t(str[s_uuidOffsets[i] + 1])];
+		invalid |= (hi | lo) & 0x100;
+		ret[i] = uint8_t((hi << 4) | lo);
 	}
 
+	if (invalid) {
+		return false;
+	}
+
+	d = ret;
 	return true;
 }
 
+bool uuid::parse(uuid_t &d, const char *uuid_str) {
+	if (strnlen(uuid_str, FormattedLength + 1) != FormattedLength) {
+		return false;
+	}
+	return parse_uuid(d, uuid_str);
+}
+
+bool uuid::parse(uuid_t &d, StringView str) {
+	if (str.size() != FormattedLength) {
+		return false;
+	}
+	return parse_uuid(d, str.data());
+}
+
 }
@@ -36,15 +36,24 @@ struct uuid : AllocPool {
 	using uuid_t = std::array<uint8_t, 16>;
 
 	static bool parse(uuid_t &, const char *);
+	static bool parse(uuid_t &, StringView);
 	static void format(char *, const uuid_t &);
+
+	// time-based uuid with hashed node id (version 5 bits, compatible with previous releases)
 	static uuid generate();
 
+	// random uuid (RFC 9562, version 4)
+	static uuid generateV4();
+
+	// unix time ordered uuid (RFC 9562, version 7), monotonic within a thread
+	static uuid generateV7();
+
 	uuid() {
 		memset(_uuid.data(), 0, 16);
 	}
 
 	uuid(StringView str) {
-		parse(_uuid, str.data());
+		parse(_uuid, str);
 	}
 
 	uuid(BytesView b) {
@@ -295,6 +295,11 @@ operator>=(const vector<_Tp>& __x, const vector<_Tp>& __y) {
 	return !(__x < __y);
 }
 
+template <typename Type>
+struct is_trivially_relocatable<vector<Type>> {
+	static constexpr bool value = true;
+};
+
 }
 
 #endif /* COMMON_MEMORY_SPMEMVECTOR_H_ */
@@ -0,0 +1,352 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPSha.h"
+
+// Argon2id implementation after RFC 9106, version 0x13
+
+namespace stappler::crypto {
+
+static constexpr uint32_t ARGON2_VERSION = 0x13;
+static constexpr uint32_t ARGON2_TYPE_ID = 2; // Argon2id
+static constexpr uint32_t ARGON2_SYNC_POINTS = 4;
+static constexpr uint32_t ARGON2_BLOCK_WORDS = 128;
+static constexpr uint32_t ARGON2_BLOCK_SIZE = ARGON2_BLOCK_WORDS * sizeof(uint64_t);
+static constexpr uint32_t ARGON2_PREHASH_LENGTH = 64;
+
+struct Argon2Block {
+	uint64_t v[ARGON2_BLOCK_WORDS];
+};
+
+struct Argon2Instance {
+	Argon2Block *memory = nullptr;
+	uint32_t passes = 0;
+	uint32_t lanes = 0;
+	uint32_t memoryBlocks = 0;
+	uint32_t segmentLength = 0;
+	uint32_t laneLength = 0;
+};
+
+static void argon2_store32(uint32_t x, uint8_t *y) {
+	for (int i = 0; i < 4; ++ i) {
+		y[i] = uint8_t(x >> (8 * i));
+	}
+}
+
+static void argon2_loadBlock(Argon2Block &block, const uint8_t *data) {
+	for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+		uint64_t w = 0;
+		for (int j = 7; j >= 0; --j) {
+			w = (w << 8) | data[i * 8 + j];
+		}
+		block.v[i] = w;
+	}
+}
+
+static void argon2_storeBlock(uint8_t *data, const Argon2Block &block) {
+	for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+		for (int j = 0; j < 8; ++ j) {
+			data[i * 8 + j] = uint8_t(block.v[i] >> (8 * j));
+		}
+	}
+}
+
+// variable-length hash function H'
+static void argon2_hashLong(uint8_t *out, uint32_t outlen, const uint8_t *in, size_t inlen) {
+	uint8_t outlenBytes[4];
+	argon2_store32(outlen, outlenBytes);
+
+	if (outlen <= Blake2b::Length) {
+		Blake2b(outlen).update(outlenBytes, 4).update(in, inlen).final(out);
+		return;
+	}
+
+	uint8_t v[Blake2b::Length];
+	Blake2b(Blake2b::Length).update(outlenBytes, 4).update(in, inlen).final(v);
+	memcpy(out, v, Blake2b::Length / 2);
+	out += Blake2b::Length / 2;
+
+	uint32_t remains = outlen - Blake2b::Length / 2;
+	while (remains > Blake2b::Length) {
+		Blake2b(Blake2b::Length).update(v, Blake2b::Length).final(v);
+		memcpy(out, v, Blake2b::Length / 2);
+		out += Blake2b::Length / 2;
+		remains -= Blake2b::Length / 2;
+	}
+
+	Blake2b(remains).update(v, Blake2b::Length).final(out);
+}
+
+static inline uint64_t argon2_rotr64(uint64_t x, uint64_t n) { return (x >> n) | (x << (64 - n)); }
+
+static inline uint64_t argon2_fBlaMka(uint64_t x, uint64_t y) {
+	const uint64_t m = 0xFFFFFFFFULL;
+	return x + y + 2 * ((x & m) * (y & m));
+}
+
+static inline void argon2_G(uint64_t &a, uint64_t &b, uint64_t &c, uint64_t &d) {
+	a = argon2_fBlaMka(a, b); d = argon2_rotr64(d ^ a, 32);
+	c = argon2_fBlaMka(c, d); b = argon2_rotr64(b ^ c, 24);
+	a = argon2_fBlaMka(a, b); d = argon2_rotr64(d ^ a, 16);
+	c = argon2_fBlaMka(c, d); b = argon2_rotr64(b ^ c, 63);
+}
+
+// permutation P on 16 words, defined by word indexes
+static inline void argon2_round(uint64_t *v, const uint32_t (&i)[16]) {
+	argon2_G(v[i[0]], v[i[4]], v[i[8]], v[i[12]]);
+	argon2_G(v[i[1]], v[i[5]], v[i[9]], v[i[13]]);
+	argon2_G(v[i[2]], v[i[6]], v[i[10]], v[i[14]]);
+	argon2_G(v[i[3]], v[i[7]], v[i[11]], v[i[15]]);
+	argon2_G(v[i[0]], v[i[5]], v[i[10]], v[i[15]]);
+	argon2_G(v[i[1]], v[i[6]], v[i[11]], v[i[12]]);
+	argon2_G(v[i[2]], v[i[7]], v[i[8]], v[i[13]]);
+	argon2_G(v[i[3]], v[i[4]], v[i[9]], v[i[14]]);
+}
+
+// compression function G, result is written (or XORed on later passes) into next
+static void argon2_fillBlock(const Argon2Block &prev, const Argon2Block &ref, Argon2Block &next, bool withXor) {
+	Argon2Block r, tmp;
+	for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+		r.v[i] = ref.v[i] ^ prev.v[i];
+	}
+
+	tmp = r;
+	if (withXor) {
+		for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+			tmp.v[i] ^= next.v[i];
+		}
+	}
+
+	// rows of 16 consecutive words
+	for (uint32_t i = 0; i < 8; ++ i) {
+		const uint32_t b = 16 * i;
+		const uint32_t idx[16] = { b, b + 1, b + 2, b + 3, b + 4, b + 5, b + 6, b + 7,
+				b + 8, b + 9, b + 10, b + 11, b + 12, b + 13, b + 14, b + 15 };
+		argon2_round(r.v, idx);
+	}
+
+	// columns of 8 pairs of words
+	for (uint32_t i = 0; i < 8; ++ i) {
+		const uint32_t b = 2 * i;
+		const uint32_t idx[16] = { b, b + 1, b + 16, b + 17, b + 32, b + 33, b + 48, b + 49,
+				b + 64, b + 65, b + 80, b + 81, b + 96, b + 97, b + 112, b + 113 };
+		argon2_round(r.v, idx);
+	}
+
+	for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+		next.v[i] = tmp.v[i] ^ r.v[i];
+	}
+}
+
+static void argon2_nextAddresses(Argon2Block &address, Argon2Block &input, const Argon2Block &zero) {
+	++ input.v[6];
+	argon2_fillBlock(zero, input, address, false);
+	argon2_fillBlock(zero, address, address, false);
+}
+
+static uint32_t argon2_indexAlpha(const Argon2Instance &inst, uint32_t pass, uint32_t slice, uint32_t index,
+		uint32_t pseudoRand, bool sameLane) {
+	// number of blocks, available for reference; unsigned overflow for index 0 is intended
+	uint32_t areaSize = 0;
+	if (pass == 0) {
+		if (slice == 0) {
+			areaSize = index - 1;
+		} else if (sameLane) {
+			areaSize = slice * inst.segmentLength + index - 1;
+		} else {
+			areaSize = slice * inst.segmentLength + ((index == 0) ? uint32_t(-1) : 0);
+		}
+	} else {
+		if (sameLane) {
+			areaSize = inst.laneLength - inst.segmentLength + index - 1;
+		} else {
+			areaSize = inst.laneLength - inst.segmentLength + ((index == 0) ? uint32_t(-1) : 0);
+		}
+	}
+
+	uint64_t relative = pseudoRand;
+	relative = (relative * relative) >> 32;
+	relative = areaSize - 1 - ((areaSize * relative) >> 32);
+
+	uint32_t start = 0;
+	if (pass != 0) {
+		start = (slice == ARGON2_SYNC_POINTS - 1) ? 0 : (slice + 1) * inst.segmentLength;
+	}
+
+	return uint32_t((start + relative) % inst.laneLength);
+}
+
+static void argon2_fillSegment(const Argon2Instance &inst, uint32_t pass, uint32_t lane, uint32_t slice) {
+	// Argon2id uses data-independent addressing for the first half of the first pass
+	const bool dataIndependent = (pass == 0 && slice < ARGON2_SYNC_POINTS / 2);
+
+	Argon2Block zeroBlock, inputBlock, addressBlock;
+	if (dataIndependent) {
+		memset(&zeroBlock, 0, sizeof(Argon2Block));
+		memset(&inputBlock, 0, sizeof(Argon2Block));
+		inputBlock.v[0] = pass;
+		inputBlock.v[1] = lane;
+		inputBlock.v[2] = slice;
+		inputBlock.v[3] = inst.memoryBlocks;
+		inputBlock.v[4] = inst.passes;
+		inputBlock.v[5] = ARGON2_TYPE_ID;
+	}
+
+	uint32_t startingIndex = 0;
+	if (pass == 0 && slice == 0) {
+		// first two blocks are already filled
+		startingIndex = 2;
+		if (dataIndependent) {
+			argon2_nextAddresses(addressBlock, inputBlock, zeroBlock);
+		}
+	}
+
+	uint32_t currOffset = lane * inst.laneLength + slice * inst.segmentLength + startingIndex;
+	uint32_t prevOffset = (currOffset % inst.laneLength == 0) ? currOffset + inst.laneLength - 1 : currOffset - 1;
+
+	for (uint32_t i = startingIndex; i < inst.segmentLength; ++ i, ++ currOffset, ++ prevOffset) {
+		if (currOffset % inst.laneLength == 1) {
+			prevOffset = currOffset - 1;
+		}
+
+		uint64_t pseudoRand = 0;
+		if (dataIndependent) {
+			if (i % ARGON2_BLOCK_WORDS == 0) {
+				argon2_nextAddresses(addressBlock, inputBlock, zeroBlock);
+			}
+			pseudoRand = addressBlock.v[i % ARGON2_BLOCK_WORDS];
+		} else {
+			pseudoRand = inst.memory[prevOffset].v[0];
+		}
+
+		uint32_t refLane = uint32_t((pseudoRand >> 32) % inst.lanes);
+		if (pass == 0 && slice == 0) {
+			refLane = lane;
+		}
+
+		auto refIndex = argon2_indexAlpha(inst, pass, slice, i, uint32_t(pseudoRand & 0xFFFFFFFF), refLane == lane);
+
+		argon2_fillBlock(inst.memory[prevOffset], inst.memory[inst.laneLength * refLane + refIndex],
+				inst.memory[currOffset], pass != 0);
+	}
+}
+
+bool argon2id(uint8_t *out, size_t outlen, const CoderSource &password, const CoderSource &salt,
+		const Argon2Params &params, const CoderSource &secret, const CoderSource &ad) {
+	if (!out || outlen < 4 || outlen > std::numeric_limits<uint32_t>::max() || salt.size() < 8
+			|| params.lanes == 0 || params.lanes > 0xFFFFFF || params.iterations == 0
+			|| params.memory < 8 * params.lanes) {
+		return false;
+	}
+
+	Argon2Instance inst;
+	inst.passes = params.iterations;
+	inst.lanes = params.lanes;
+	inst.segmentLength = params.memory / (params.lanes * ARGON2_SYNC_POINTS);
+	inst.laneLength = inst.segmentLength * ARGON2_SYNC_POINTS;
+	inst.memoryBlocks = inst.laneLength * params.lanes;
+
+	std::unique_ptr<Argon2Block[]> memory(new (std::nothrow) Argon2Block[inst.memoryBlocks]);
+	if (!memory) {
+		return false;
+	}
+	inst.memory = memory.get();
+
+	// initial hash H0, with space for block and lane indexes
+	uint8_t h0[ARGON2_PREHASH_LENGTH + 8];
+	Blake2b ctx(ARGON2_PREHASH_LENGTH);
+	auto update32 = [&] (uint32_t value) {
+		uint8_t buf[4];
+		argon2_store32(value, buf);
+		ctx.update(buf, 4);
+	};
+	auto updateData = [&] (const CoderSource &data) {
+		update32(uint32_t(data.size()));
+		ctx.update(data);
+	};
+
+	update32(params.lanes);
+	update32(uint32_t(outlen));
+	update32(params.memory);
+	update32(params.iterations);
+	update32(ARGON2_VERSION);
+	update32(ARGON2_TYPE_ID);
+	updateData(password);
+	updateData(salt);
+	updateData(secret);
+	updateData(ad);
+	ctx.final(h0);
+
+	uint8_t blockBytes[ARGON2_BLOCK_SIZE];
+	for (uint32_t lane = 0; lane < inst.lanes; ++ lane) {
+		for (uint32_t j = 0; j < 2; ++ j) {
+			argon2_store32(j, h0 + ARGON2_PREHASH_LENGTH);
+			argon2_store32(lane, h0 + ARGON2_PREHASH_LENGTH + 4);
+			argon2_hashLong(blockBytes, ARGON2_BLOCK_SIZE, h0, sizeof(h0));
+			argon2_loadBlock(inst.memory[lane * inst.laneLength + j], blockBytes);
+		}
+	}
+
+	// lanes within one slice are independent, so they can be filled in parallel
+	const uint32_t nthreads = std::min(std::max(params.threads, uint32_t(1)), inst.lanes);
+	for (uint32_t pass = 0; pass < inst.passes; ++ pass) {
+		for (uint32_t slice = 0; slice < ARGON2_SYNC_POINTS; ++ slice) {
+			if (nthreads == 1) {
+				for (uint32_t lane = 0; lane < inst.lanes; ++ lane) {
+					argon2_fillSegment(inst, pass, lane, slice);
+				}
+			} else {
+				auto fillLanes = [&, pass, slice] (uint32_t first) {
+					for (uint32_t lane = first; lane < inst.lanes; lane += nthreads) {
+						argon2_fillSegment(inst, pass, lane, slice);
+					}
+				};
+
+				std::vector<std::thread> threads;
+				threads.reserve(nthreads - 1);
+				for (uint32_t t = 1; t < nthreads; ++ t) {
+					threads.emplace_back(fillLanes, t);
+				}
+				fillLanes(0);
+				for (auto &it : threads) {
+					it.join();
+				}
+			}
+		}
+	}
+
+	// final block is XOR of last blocks of all lanes
+	Argon2Block finalBlock = inst.memory[inst.laneLength - 1];
+	for (uint32_t lane = 1; lane < inst.lanes; ++ lane) {
+		auto &last = inst.memory[lane * inst.laneLength + inst.laneLength - 1];
+		for (uint32_t i = 0; i < ARGON2_BLOCK_WORDS; ++ i) {
+			finalBlock.v[i] ^= last.v[i];
+		}
+	}
+
+	argon2_storeBlock(blockBytes, finalBlock);
+	argon2_hashLong(out, uint32_t(outlen), blockBytes, ARGON2_BLOCK_SIZE);
+	return true;
+}
+
+}
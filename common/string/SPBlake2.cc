@@ -0,0 +1,194 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPSha.h"
+
+// BLAKE2b implementation after RFC 7693
+
+namespace blake2b {
+
+using blake2b_state = stappler::crypto::Blake2b::_Ctx;
+
+typedef uint64_t u64;
+
+static const u64 IV[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t Sigma[12][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+	{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+	{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+	{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+	{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+	{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+	{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+	{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+	{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+static u64 load64(const uint8_t *y) {
+	u64 ret = 0;
+	for (int i = 7; i >= 0; --i) {
+		ret = (ret << 8) | y[i];
+	}
+	return ret;
+}
+
+static void store64(u64 x, uint8_t *y) {
+	for (int i = 0; i < 8; ++ i) {
+		y[i] = uint8_t(x >> (8 * i));
+	}
+}
+
+static u64 rotr64(u64 x, u64 n) { return (x >> n) | (x << (64 - n)); }
+
+static void mix(u64 *v, int a, int b, int c, int d, u64 x, u64 y) {
+	v[a] = v[a] + v[b] + x;
+	v[d] = rotr64(v[d] ^ v[a], 32);
+	v[c] = v[c] + v[d];
+	v[b] = rotr64(v[b] ^ v[c], 24);
+	v[a] = v[a] + v[b] + y;
+	v[d] = rotr64(v[d] ^ v[a], 16);
+	v[c] = v[c] + v[d];
+	v[b] = rotr64(v[b] ^ v[c], 63);
+}
+
+static void compress(blake2b_state &md, bool last) {
+	u64 v[16], m[16];
+	for (int i = 0; i < 8; ++ i) {
+		v[i] = md.h[i];
+		v[i + 8] = IV[i];
+	}
+
+	v[12] ^= md.t[0];
+	v[13] ^= md.t[1];
+	if (last) {
+		v[14] = ~v[14];
+	}
+
+	for (int i = 0; i < 16; ++ i) {
+		m[i] = load64(md.buf + 8 * i);
+	}
+
+	for (int i = 0; i < 12; ++ i) {
+		mix(v, 0, 4,  8, 12, m[Sigma[i][ 0]], m[Sigma[i][ 1]]);
+		mix(v, 1, 5,  9, 13, m[Sigma[i][ 2]], m[Sigma[i][ 3]]);
+		mix(v, 2, 6, 10, 14, m[Sigma[i][ 4]], m[Sigma[i][ 5]]);
+		mix(v, 3, 7, 11, 15, m[Sigma[i][ 6]], m[Sigma[i][ 7]]);
+		mix(v, 0, 5, 10, 15, m[Sigma[i][ 8]], m[Sigma[i][ 9]]);
+		mix(v, 1, 6, 11, 12, m[Sigma[i][10]], m[Sigma[i][11]]);
+		mix(v, 2, 7,  8, 13, m[Sigma[i][12]], m[Sigma[i][13]]);
+		mix(v, 3, 4,  9, 14, m[Sigma[i][14]], m[Sigma[i][15]]);
+	}
+
+	for (int i = 0; i < 8; ++ i) {
+		md.h[i] ^= v[i] ^ v[i + 8];
+	}
+}
+
+static void init(blake2b_state &md, uint32_t outlen) {
+	if (outlen == 0 || outlen > 64) {
+		outlen = 64;
+	}
+
+	for (int i = 0; i < 8; ++ i) {
+		md.h[i] = IV[i];
+	}
+
+	// parameter block: digest length, no key, fanout = 1, depth = 1
+	md.h[0] ^= 0x01010000ULL ^ outlen;
+	md.t[0] = md.t[1] = 0;
+	md.curlen = 0;
+	md.outlen = outlen;
+}
+
+static void process(blake2b_state &md, const uint8_t *in, size_t inlen) {
+	while (inlen > 0) {
+		// last block should be processed in final step, so buffer is compressed only when more data is available
+		if (md.curlen == 128) {
+			md.t[0] += 128;
+			if (md.t[0] < 128) {
+				++ md.t[1];
+			}
+			compress(md, false);
+			md.curlen = 0;
+		}
+
+		auto n = std::min(inlen, size_t(128 - md.curlen));
+		memcpy(md.buf + md.curlen, in, n);
+		md.curlen += uint32_t(n);
+		in += n;
+		inlen -= n;
+	}
+}
+
+static void done(blake2b_state &md, uint8_t *out) {
+	md.t[0] += md.curlen;
+	if (md.t[0] < md.curlen) {
+		++ md.t[1];
+	}
+
+	memset(md.buf + md.curlen, 0, 128 - md.curlen);
+	compress(md, true);
+
+	uint8_t buf[64];
+	for (int i = 0; i < 8; ++ i) {
+		store64(md.h[i], buf + 8 * i);
+	}
+	memcpy(out, buf, md.outlen);
+}
+
+}
+
+namespace stappler::crypto {
+
+Blake2b::Blake2b(uint32_t outlen) { blake2b::init(ctx, outlen); }
+Blake2b & Blake2b::init(uint32_t outlen) { blake2b::init(ctx, outlen); return *this; }
+
+Blake2b & Blake2b::update(const uint8_t *ptr, size_t len) {
+	if (len) {
+		blake2b::process(ctx, ptr, len);
+	}
+	return *this;
+}
+
+Blake2b & Blake2b::update(const CoderSource &source) {
+	return update(source.data(), source.size());
+}
+
+Blake2b::Buf Blake2b::final() {
+	Blake2b::Buf ret = { 0 };
+	blake2b::done(ctx, ret.data());
+	return ret;
+}
+
+void Blake2b::final(uint8_t *buf) {
+	blake2b::done(ctx, buf);
+}
+
+}
@@ -506,4 +506,13 @@ inline bool operator>= (const BytesViewTemplate<Endianess> &l, const memory::Sta
 
 }
 
+namespace stappler::memory {
+
+template <Endian Endianess>
+struct is_trivially_relocatable<BytesViewTemplate<Endianess>> {
+	static constexpr bool value = true;
+};
+
+}
+
 #endif /* COMMON_UTILS_SPDATAREADER_H_ */
@@ -200,6 +200,55 @@ struct Sha256 {
 	_Ctx ctx;
 };
 
+/* BLAKE2b context with variable digest length (1-64 bytes)
+ * designed for chain use: Blake2b().update(input).final() */
+struct Blake2b {
+	struct _Ctx {
+		uint64_t h[8];
+		uint64_t t[2];
+		uint32_t curlen;
+		uint32_t outlen;
+		uint8_t buf[128];
+	};
+
+	constexpr static uint32_t Length = 64;
+	using Buf = std::array<uint8_t, Length>;
+
+	template <typename ... Args>
+	static Buf perform(Args && ... args);
+
+	Blake2b(uint32_t outlen = Length);
+	Blake2b & init(uint32_t outlen = Length);
+
+	Blake2b & update(const uint8_t *, size_t);
+	Blake2b & update(const CoderSource &);
+
+	template  <typename T, typename ... Args>
+	void _update(T && t, Args && ... args);
+
+	template  <typename T>
+	void _update(T && t);
+
+	// for digests, shorter than Length, only first outlen bytes are meaningful
+	Buf final();
+	void final(uint8_t *);
+
+	_Ctx ctx;
+};
+
+/* Argon2id (RFC 9106) memory-hard key derivation parameters */
+struct Argon2Params {
+	uint32_t memory = 19 * 1024; // in KiB
+	uint32_t iterations = 2;
+	uint32_t lanes = 1;
+	uint32_t threads = 1; // lanes are filled in parallel with up to this number of threads, result does not depend on it
+};
+
+/* Writes outlen (>= 4) bytes of Argon2id tag into out; salt should be at least 8 bytes long
+ * secret and ad are optional secret key and associated data */
+bool argon2id(uint8_t *out, size_t outlen, const CoderSource &password, const CoderSource &salt,
+		const Argon2Params &, const CoderSource &secret = CoderSource(), const CoderSource &ad = CoderSource());
+
 template <typename ... Args>
 inline Sha512::Buf Sha512::perform(Args && ... args) {
 	Sha512 ctx;
@@ -236,6 +285,24 @@ inline void Sha256::_update(T && t) {
 	update(std::forward<T>(t));
 }
 
+template <typename ... Args>
+inline Blake2b::Buf Blake2b::perform(Args && ... args) {
+	Blake2b ctx;
+	ctx._update(std::forward<Args>(args)...);
+	return ctx.final();
+}
+
+template  <typename T, typename ... Args>
+inline void Blake2b::_update(T && t, Args && ... args) {
+	update(std::forward<T>(t));
+	_update(std::forward<Args>(args)...);
+}
+
+template  <typename T>
+inline void Blake2b::_update(T && t) {
+	update(std::forward<T>(t));
+}
+
 
 }
 
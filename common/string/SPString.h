@@ -277,6 +277,9 @@ struct ToStringTraits<memory::PoolInterface> {
 	}
 };
 
+template <>
+struct ToStringTraits<memory::PoolBtreeInterface> : ToStringTraits<memory::PoolInterface> { };
+
 }
 
 
@@ -284,6 +287,7 @@ namespace stappler::string {
 
 using Sha256 = crypto::Sha256;
 using Sha512 = crypto::Sha512;
+using Blake2b = crypto::Blake2b;
 
 /* Very simple and quick hasher, do NOT use it in collision-sensative cases */
 inline uint32_t hash32(const StringView &key) { return hash::hash32(key.data(), uint32_t(key.size())); }
@@ -321,6 +325,23 @@ auto decode(const CoderSource &source) -> typename Interface::BytesType;
 void decode(std::basic_ostream<char> &stream, const CoderSource &source);
 size_t decode(uint8_t *, size_t bsize, const CoderSource &source);
 
+template <>
+auto encode<memory::PoolInterface>(const CoderSource &source) -> typename memory::PoolInterface::StringType;
+
+template <>
+auto decode<memory::PoolInterface>(const CoderSource &source) -> typename memory::PoolInterface::BytesType;
+
+// PoolBtreeInterface uses the same string types, as PoolInterface
+template <>
+inline auto encode<memory::PoolBtreeInterface>(const CoderSource &source) -> typename memory::PoolBtreeInterface::StringType {
+	return encode<memory::PoolInterface>(source);
+}
+
+template <>
+inline auto decode<memory::PoolBtreeInterface>(const CoderSource &source) -> typename memory::PoolBtreeInterface::BytesType {
+	return decode<memory::PoolInterface>(source);
+}
+
 }
 
 
@@ -920,6 +941,16 @@ inline auto decode<memory::StandartInterface>(const CoderSource &source) -> type
 	return __decode_std(source);
 }
 
+template <>
+inline auto encode<memory::PoolBtreeInterface>(const CoderSource &source) -> typename memory::PoolBtreeInterface::StringType {
+	return __encode_pool(source);
+}
+
+template <>
+inline auto decode<memory::PoolBtreeInterface>(const CoderSource &source) -> typename memory::PoolBtreeInterface::BytesType {
+	return __decode_pool(source);
+}
+
 }
 
 namespace stappler::base64url {
@@ -940,6 +971,11 @@ inline auto encode<memory::StandartInterface>(const CoderSource &source) -> type
 	return __encode_std(source);
 }
 
+template <>
+inline auto encode<memory::PoolBtreeInterface>(const CoderSource &source) -> typename memory::PoolBtreeInterface::StringType {
+	return __encode_pool(source);
+}
+
 template <typename Interface>
 inline auto decode(const CoderSource &source) -> typename Interface::BytesType {
 	return base64::decode<Interface>(source);
@@ -0,0 +1,288 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPStringInterner.h"
+
+namespace stappler::string {
+
+static constexpr char s_emptyInternedString[1] = { 0 };
+
+InternerStats &InternerStats::operator+=(const InternerStats &other) {
+	strings += other.strings;
+	requests += other.requests;
+	requestedBytes += other.requestedBytes;
+	storedBytes += other.storedBytes;
+	allocatedBytes += other.allocatedBytes;
+	return *this;
+}
+
+InternTable::InternTable(memory::pool_t *pool, size_t chunkSize) : _pool(pool), _chunkSize(chunkSize) { }
+
+InternTable::~InternTable() {
+	clear();
+}
+
+StringView InternTable::find(StringView str, uint64_t hash) const {
+	if (!_slots) {
+		return StringView();
+	}
+
+	const auto tag = getTag(hash);
+	auto idx = size_t(hash) & _mask;
+	while (true) {
+		auto &slot = _slots[idx];
+		if (!slot.data) {
+			return StringView();
+		}
+		if (slot.tag == tag && slot.size == str.size() && memcmp(slot.data, str.data(), str.size()) == 0) {
+			return StringView(slot.data, slot.size);
+		}
+		idx = (idx + 1) & _mask;
+	}
+	return StringView();
+}
+
+StringView InternTable::emplace(StringView str, uint64_t hash) {
+	if (str.size() > size_t(maxOf<uint32_t>())) {
+		return StringView();
+	}
+
+	if (!_slots) {
+		rehash(InitialCapacity);
+	} else if ((_count + 1) * MaxLoadDenominator > capacity() * MaxLoadNumerator) {
+		rehash(capacity() * 2);
+	}
+
+	const auto tag = getTag(hash);
+	auto idx = size_t(hash) & _mask;
+	while (true) {
+		auto &slot = _slots[idx];
+		if (!slot.data) {
+			slot.data = store(str);
+			slot.size = uint32_t(str.size());
+			slot.tag = tag;
+			++ _count;
+			return StringView(slot.data, slot.size);
+		}
+		if (slot.tag == tag && slot.size == str.size() && memcmp(slot.data, str.data(), str.size()) == 0) {
+			return StringView(slot.data, slot.size);
+		}
+		idx = (idx + 1) & _mask;
+	}
+	return StringView();
+}
+
+InternerStats InternTable::getStats() const {
+	InternerStats ret;
+	ret.strings = _count;
+	ret.storedBytes = _storedBytes;
+	ret.allocatedBytes = _allocatedBytes;
+	return ret;
+}
+
+void InternTable::clear() {
+	auto c = _chunks;
+	while (c) {
+		auto next = c->next;
+		deallocate(c, c->size);
+		c = next;
+	}
+
+	if (_slots) {
+		deallocate(_slots, sizeof(Slot) * capacity());
+	}
+
+	_chunks = nullptr;
+	_slots = nullptr;
+	_mask = 0;
+	_count = 0;
+	_storedBytes = 0;
+	_allocatedBytes = 0;
+}
+
+void *InternTable::allocate(size_t size) {
+	_allocatedBytes += size;
+	if (_pool) {
+		return memory::pool::palloc(_pool, size);
+	} else {
+		return ::malloc(size);
+	}
+}
+
+void InternTable::deallocate(void *ptr, size_t size) {
+	_allocatedBytes -= size;
+	if (_pool) {
+		memory::pool::free(_pool, ptr, size);
+	} else {
+		::free(ptr);
+	}
+}
+
+const char *InternTable::store(StringView str) {
+	if (str.empty()) {
+		return s_emptyInternedString;
+	}
+
+	const size_t required = str.size() + 1;
+	char *target = nullptr;
+
+	if (required > _chunkSize / 4) {
+		// large string, use dedicated chunk, place it after current one to keep it in use
+		auto size = sizeof(Chunk) + required;
+		auto chunk = (Chunk *)allocate(size);
+		chunk->size = size;
+		chunk->offset = size;
+		if (_chunks) {
+			chunk->next = _chunks->next;
+			_chunks->next = chunk;
+		} else {
+			chunk->next = nullptr;
+			_chunks = chunk;
+		}
+		target = (char *)(chunk + 1);
+	} else {
+		if (!_chunks || _chunks->size - _chunks->offset < required) {
+			auto chunk = (Chunk *)allocate(_chunkSize);
+			chunk->size = _chunkSize;
+			chunk->offset = sizeof(Chunk);
+			chunk->next = _chunks;
+			_chunks = chunk;
+		}
+		target = (char *)_chunks + _chunks->offset;
+		_chunks->offset += required;
+	}
+
+	memcpy(target, str.data(), str.size());
+	target[str.size()] = 0;
+	_storedBytes += required;
+	return target;
+}
+
+void InternTable::rehash(size_t newCapacity) {
+	auto slots = (Slot *)allocate(sizeof(Slot) * newCapacity);
+	memset((void *)slots, 0, sizeof(Slot) * newCapacity);
+
+	const size_t mask = newCapacity - 1;
+	if (_slots) {
+		for (size_t i = 0; i <= _mask; ++ i) {
+			auto &slot = _slots[i];
+			if (slot.data) {
+				// hash is not stored, so recalculate it for the relocation
+				auto idx = size_t(hash::hash64(slot.data, slot.size)) & mask;
+				while (slots[idx].data) {
+					idx = (idx + 1) & mask;
+				}
+				slots[idx] = slot;
+			}
+		}
+		deallocate(_slots, sizeof(Slot) * capacity());
+	}
+
+	_slots = slots;
+	_mask = mask;
+}
+
+StringInterner *StringInterner::getInstance() {
+	static StringInterner *s_instance = new StringInterner();
+	return s_instance;
+}
+
+StringInterner::StringInterner(size_t chunkSize) {
+	for (auto &it : _shards) {
+		it = new Shard(chunkSize);
+	}
+}
+
+StringInterner::~StringInterner() {
+	for (auto &it : _shards) {
+		delete it;
+	}
+}
+
+StringView StringInterner::intern(StringView str) {
+	const auto hash = hash::hash64(str.data(), str.size());
+	auto &shard = getShard(hash);
+
+	shard.requests.fetch_add(1, std::memory_order_relaxed);
+	shard.requestedBytes.fetch_add(str.size(), std::memory_order_relaxed);
+
+	do {
+		std::shared_lock lock(shard.mutex);
+		auto ret = shard.table.find(str, hash);
+		if (ret.data()) {
+			return ret;
+		}
+	} while (0);
+
+	std::unique_lock lock(shard.mutex);
+	return shard.table.emplace(str, hash);
+}
+
+StringView StringInterner::find(StringView str) const {
+	const auto hash = hash::hash64(str.data(), str.size());
+	auto &shard = getShard(hash);
+
+	std::shared_lock lock(shard.mutex);
+	return shard.table.find(str, hash);
+}
+
+InternerStats StringInterner::getStats() const {
+	InternerStats ret;
+	for (auto &it : _shards) {
+		std::shared_lock lock(it->mutex);
+		ret += it->table.getStats();
+		ret.requests += it->requests.load(std::memory_order_relaxed);
+		ret.requestedBytes += it->requestedBytes.load(std::memory_order_relaxed);
+	}
+	return ret;
+}
+
+size_t StringInterner::size() const {
+	size_t ret = 0;
+	for (auto &it : _shards) {
+		std::shared_lock lock(it->mutex);
+		ret += it->table.size();
+	}
+	return ret;
+}
+
+PoolInterner::PoolInterner(memory::pool_t *pool, size_t chunkSize)
+: _pool(pool ? pool : memory::pool::acquire()), _table(_pool, chunkSize) { }
+
+StringView PoolInterner::intern(StringView str) {
+	++ _requests;
+	_requestedBytes += str.size();
+	return _table.emplace(str, hash::hash64(str.data(), str.size()));
+}
+
+StringView PoolInterner::find(StringView str) const {
+	return _table.find(str, hash::hash64(str.data(), str.size()));
+}
+
+InternerStats PoolInterner::getStats() const {
+	auto ret = _table.getStats();
+	ret.requests = _requests;
+	ret.requestedBytes = _requestedBytes;
+	return ret;
+}
+
+}
@@ -0,0 +1,189 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_STRING_SPSTRINGINTERNER_H_
+#define COMMON_STRING_SPSTRINGINTERNER_H_
+
+#include "SPStringView.h"
+#include <shared_mutex>
+
+/* String interning
+ *
+ * Interner stores single copy of every string, passed into `intern`, and returns
+ * StringView for this copy. Returned views are stable: they remains valid until
+ * interner itself is destroyed (or its pool is cleared), and equal strings always
+ * produce views with the same data pointer, so they can be compared by pointer.
+ *
+ * Interned data is always null-terminated, so views can be used as C-strings
+ * and as weak memory::string (see `memory::string::assign_weak`)
+ *
+ * - StringInterner - thread-safe interner, sharded by hash, allocates with malloc
+ * - PoolInterner - single-thread interner, that allocates everything from memory::pool_t
+ */
+
+namespace stappler::string {
+
+struct InternerStats {
+	size_t strings = 0; // unique strings stored
+	size_t requests = 0; // number of `intern` calls
+	size_t requestedBytes = 0; // total size of strings, passed into `intern`
+	size_t storedBytes = 0; // total size of unique strings, including null-terminators
+	size_t allocatedBytes = 0; // memory, used for string chunks and hash tables
+
+	InternerStats &operator+=(const InternerStats &);
+};
+
+class Interner {
+public:
+	virtual ~Interner() = default;
+
+	// returns stable view for the string; equal strings share the same storage
+	virtual StringView intern(StringView) = 0;
+
+	// returns stable view for the string, if it was interned before, empty view otherwise
+	virtual StringView find(StringView) const = 0;
+
+	virtual InternerStats getStats() const = 0;
+};
+
+// Open-addressing hash table with arena-allocated string storage
+// Not thread-safe, used as building block for interners
+class InternTable {
+public:
+	static constexpr size_t InitialCapacity = 64; // should be power of 2
+	static constexpr size_t MaxLoadNumerator = 3; // max load factor = 3/4
+	static constexpr size_t MaxLoadDenominator = 4;
+
+	InternTable(memory::pool_t * = nullptr, size_t chunkSize = 16_KiB);
+	~InternTable();
+
+	InternTable(const InternTable &) = delete;
+	InternTable &operator=(const InternTable &) = delete;
+
+	// hash should be the result of hash::hash64 for the string
+	StringView find(StringView, uint64_t hash) const;
+	StringView emplace(StringView, uint64_t hash);
+
+	size_t size() const { return _count; }
+	size_t capacity() const { return _mask + 1; }
+
+	InternerStats getStats() const;
+
+	void clear();
+
+protected:
+	struct Slot {
+		const char *data;
+		uint32_t size;
+		uint32_t tag;
+	};
+
+	struct Chunk {
+		Chunk *next;
+		size_t size;
+		size_t offset;
+	};
+
+	static uint32_t getTag(uint64_t hash) { return uint32_t(hash >> 24); }
+
+	void *allocate(size_t);
+	void deallocate(void *, size_t);
+
+	const char *store(StringView);
+	void rehash(size_t);
+
+	memory::pool_t *_pool = nullptr;
+	size_t _chunkSize = 0;
+
+	Slot *_slots = nullptr;
+	size_t _mask = 0;
+	size_t _count = 0;
+
+	Chunk *_chunks = nullptr;
+	size_t _storedBytes = 0;
+	size_t _allocatedBytes = 0;
+};
+
+// Thread-safe interner: table is split into shards by upper bits of hash,
+// every shard protected by its own shared_mutex, so lookups of already interned strings
+// only takes a shared lock
+class StringInterner : public Interner {
+public:
+	static constexpr size_t ShardBits = 4;
+	static constexpr size_t ShardCount = 1 << ShardBits;
+
+	// process-wide interner, never destroyed
+	static StringInterner *getInstance();
+
+	StringInterner(size_t chunkSize = 16_KiB);
+	virtual ~StringInterner();
+
+	virtual StringView intern(StringView) override;
+	virtual StringView find(StringView) const override;
+
+	virtual InternerStats getStats() const override;
+
+	size_t size() const;
+
+protected:
+	struct alignas(64) Shard {
+		Shard(size_t chunkSize) : table(nullptr, chunkSize) { }
+
+		mutable std::shared_mutex mutex;
+		InternTable table;
+		std::atomic<size_t> requests = 0;
+		std::atomic<size_t> requestedBytes = 0;
+	};
+
+	Shard &getShard(uint64_t hash) { return *_shards[hash >> (64 - ShardBits)]; }
+	const Shard &getShard(uint64_t hash) const { return *_shards[hash >> (64 - ShardBits)]; }
+
+	std::array<Shard *, ShardCount> _shards;
+};
+
+// Interner with all data allocated from memory pool, not thread-safe
+// Intended to deduplicate strings for pool-based objects (like data::Value from PoolInterface),
+// interned strings lives as long as the pool
+class PoolInterner : public Interner, public memory::AllocPool {
+public:
+	PoolInterner(memory::pool_t * = nullptr, size_t chunkSize = 4_KiB);
+	virtual ~PoolInterner() = default;
+
+	virtual StringView intern(StringView) override;
+	virtual StringView find(StringView) const override;
+
+	virtual InternerStats getStats() const override;
+
+	size_t size() const { return _table.size(); }
+
+	memory::pool_t *getPool() const { return _pool; }
+
+protected:
+	memory::pool_t *_pool = nullptr;
+	InternTable _table;
+	size_t _requests = 0;
+	size_t _requestedBytes = 0;
+};
+
+}
+
+#endif /* COMMON_STRING_SPSTRINGINTERNER_H_ */
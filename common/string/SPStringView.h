@@ -1643,6 +1643,21 @@ inline int compareCaseInsensivive(const L &l, const R &r) {
 
 }
 
+namespace stappler::memory {
+
+// views are plain pointer + size pairs
+template <typename CharType>
+struct is_trivially_relocatable<StringViewBase<CharType>> {
+	static constexpr bool value = true;
+};
+
+template <>
+struct is_trivially_relocatable<StringViewUtf8> {
+	static constexpr bool value = true;
+};
+
+}
+
 
 namespace std {
 
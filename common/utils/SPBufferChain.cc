@@ -0,0 +1,359 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPBufferChain.h"
+
+namespace stappler {
+
+BufferChunkPool *BufferChunkPool::getDefault() {
+	static BufferChunkPool *s_default = new BufferChunkPool();
+	return s_default;
+}
+
+BufferChunkPool::BufferChunkPool(size_t chunkSize, size_t maxFree)
+: _chunkSize(std::min(chunkSize, size_t(maxOf<uint32_t>()))), _maxFree(maxFree) { }
+
+BufferChunkPool::~BufferChunkPool() {
+	while (_freeList) {
+		auto next = _freeList->next;
+		::free(_freeList);
+		_freeList = next;
+	}
+}
+
+BufferChunk *BufferChunkPool::acquire() {
+	BufferChunk *ret = nullptr;
+	do {
+		std::unique_lock lock(_mutex);
+		if (_freeList) {
+			ret = _freeList;
+			_freeList = ret->next;
+			-- _free;
+		}
+	} while (0);
+
+	if (!ret) {
+		ret = (BufferChunk *)::malloc(sizeof(BufferChunk) + _chunkSize);
+		ret->capacity = uint32_t(_chunkSize);
+	}
+
+	ret->next = nullptr;
+	ret->start = 0;
+	ret->end = 0;
+	return ret;
+}
+
+void BufferChunkPool::release(BufferChunk *chunk) {
+	do {
+		std::unique_lock lock(_mutex);
+		if (_free < _maxFree) {
+			chunk->next = _freeList;
+			_freeList = chunk;
+			++ _free;
+			return;
+		}
+	} while (0);
+
+	::free(chunk);
+}
+
+size_t BufferChunkPool::getFreeChunks() const {
+	std::unique_lock lock(_mutex);
+	return _free;
+}
+
+BufferChain::BufferChain(BufferChunkPool *pool) : _pool(pool ? pool : BufferChunkPool::getDefault()) { }
+
+BufferChain::~BufferChain() {
+	clear();
+}
+
+BufferChain::BufferChain(BufferChain &&other)
+: _pool(other._pool), _head(other._head), _tail(other._tail), _size(other._size), _consumed(other._consumed) {
+	other._head = other._tail = nullptr;
+	other._size = 0;
+}
+
+BufferChain &BufferChain::operator=(BufferChain &&other) {
+	if (&other == this) {
+		return *this;
+	}
+
+	clear();
+	_pool = other._pool;
+	_head = other._head;
+	_tail = other._tail;
+	_size = other._size;
+	_consumed = other._consumed;
+	other._head = other._tail = nullptr;
+	other._size = 0;
+	return *this;
+}
+
+size_t BufferChain::put(const uint8_t *ptr, size_t len) {
+	size_t ret = 0;
+	while (ret < len) {
+		if (!_tail || _tail->remains() == 0) {
+			allocate();
+		}
+
+		auto n = std::min(len - ret, _tail->remains());
+		memcpy(_tail->data() + _tail->end, ptr + ret, n);
+		_tail->end += n;
+		ret += n;
+	}
+	_size += ret;
+	return ret;
+}
+
+void BufferChain::splice(BufferChain &&other) {
+	if (!other._head) {
+		return;
+	}
+
+	if (other._pool != _pool) {
+		// chunks should be returned to their own pool, so data is copied
+		other.foreach([&] (BytesView b) {
+			put(b.data(), b.size());
+		});
+		other.clear();
+		return;
+	}
+
+	if (_tail) {
+		_tail->next = other._head;
+	} else {
+		_head = other._head;
+	}
+	_tail = other._tail;
+	_size += other._size;
+
+	other._head = other._tail = nullptr;
+	other._size = 0;
+}
+
+uint8_t *BufferChain::prepare(size_t &size) {
+	if (!_tail || _tail->remains() == 0) {
+		allocate();
+	}
+
+	size = std::min(size, _tail->remains());
+	return _tail->data() + _tail->end;
+}
+
+void BufferChain::save(uint8_t *, size_t nbytes) {
+	if (_tail) {
+		nbytes = std::min(nbytes, _tail->remains());
+		_tail->end += nbytes;
+		_size += nbytes;
+	}
+}
+
+size_t BufferChain::segments(BytesView *out, size_t count) const {
+	size_t ret = 0;
+	auto c = _head;
+	while (c && ret < count) {
+		if (c->size() > 0) {
+			out[ret ++] = BytesView(c->data() + c->start, c->size());
+		}
+		c = c->next;
+	}
+	return ret;
+}
+
+BytesView BufferChain::front() const {
+	auto c = _head;
+	while (c) {
+		if (c->size() > 0) {
+			return BytesView(c->data() + c->start, c->size());
+		}
+		c = c->next;
+	}
+	return BytesView();
+}
+
+size_t BufferChain::read(uint8_t *buf, size_t nbytes) {
+	size_t ret = 0;
+	auto c = _head;
+	while (c && ret < nbytes) {
+		auto n = std::min(nbytes - ret, c->size());
+		memcpy(buf + ret, c->data() + c->start, n);
+		ret += n;
+		c = c->next;
+	}
+	return consume(ret);
+}
+
+size_t BufferChain::consume(size_t nbytes) {
+	size_t ret = 0;
+	while (_head && ret < nbytes) {
+		auto n = std::min(nbytes - ret, _head->size());
+		_head->start += n;
+		ret += n;
+		if (_head->size() == 0) {
+			if (_head != _tail) {
+				releaseFront();
+			} else {
+				// last chunk is kept for the next writes
+				_head->start = _head->end = 0;
+				break;
+			}
+		}
+	}
+	_size -= ret;
+	_consumed += ret;
+	return ret;
+}
+
+void BufferChain::clear() {
+	while (_head) {
+		releaseFront();
+	}
+	_size = 0;
+}
+
+size_t BufferChain::chunks() const {
+	size_t ret = 0;
+	auto c = _head;
+	while (c) {
+		++ ret;
+		c = c->next;
+	}
+	return ret;
+}
+
+void BufferChain::copyTo(uint8_t *buf) const {
+	foreach([&] (BytesView b) {
+		memcpy(buf, b.data(), b.size());
+		buf += b.size();
+	});
+}
+
+uint8_t *BufferChain::prepareBuffer(size_t &size) {
+	clear();
+	return prepare(size);
+}
+
+BufferChunk *BufferChain::allocate() {
+	auto chunk = _pool->acquire();
+	if (_tail) {
+		_tail->next = chunk;
+	} else {
+		_head = chunk;
+	}
+	_tail = chunk;
+	return chunk;
+}
+
+void BufferChain::releaseFront() {
+	auto c = _head;
+	_head = c->next;
+	if (!_head) {
+		_tail = nullptr;
+	}
+	_pool->release(c);
+}
+
+BufferRing::BufferRing(size_t capacity) {
+	capacity = math::npot(uint64_t(std::max(capacity, size_t(64))));
+	_data = (uint8_t *)::malloc(capacity);
+	_mask = capacity - 1;
+}
+
+BufferRing::~BufferRing() {
+	::free(_data);
+}
+
+size_t BufferRing::put(const uint8_t *buf, size_t nbytes) {
+	size_t ret = 0;
+	while (ret < nbytes) {
+		size_t size = nbytes - ret;
+		auto target = prepare(size);
+		if (size == 0) {
+			break;
+		}
+		memcpy(target, buf + ret, size);
+		save(target, size);
+		ret += size;
+	}
+	return ret;
+}
+
+uint8_t *BufferRing::prepare(size_t &size) {
+	auto head = _head.load(std::memory_order_relaxed);
+	auto tail = _tail.load(std::memory_order_acquire);
+
+	auto offset = head & _mask;
+	auto available = capacity() - (head - tail);
+	size = std::min(size, std::min(available, capacity() - offset));
+	return _data + offset;
+}
+
+void BufferRing::save(uint8_t *, size_t nbytes) {
+	_head.store(_head.load(std::memory_order_relaxed) + nbytes, std::memory_order_release);
+}
+
+size_t BufferRing::segments(BytesView out[2]) const {
+	auto tail = _tail.load(std::memory_order_relaxed);
+	auto head = _head.load(std::memory_order_acquire);
+
+	auto size = head - tail;
+	if (size == 0) {
+		return 0;
+	}
+
+	auto offset = tail & _mask;
+	auto first = std::min(size, capacity() - offset);
+	out[0] = BytesView(_data + offset, first);
+	if (first == size) {
+		return 1;
+	}
+	out[1] = BytesView(_data, size - first);
+	return 2;
+}
+
+size_t BufferRing::read(uint8_t *buf, size_t nbytes) {
+	BytesView segs[2];
+	auto count = segments(segs);
+
+	size_t ret = 0;
+	for (size_t i = 0; i < count && ret < nbytes; ++ i) {
+		auto n = std::min(nbytes - ret, segs[i].size());
+		memcpy(buf + ret, segs[i].data(), n);
+		ret += n;
+	}
+	_tail.store(_tail.load(std::memory_order_relaxed) + ret, std::memory_order_release);
+	return ret;
+}
+
+size_t BufferRing::consume(size_t nbytes) {
+	auto tail = _tail.load(std::memory_order_relaxed);
+	nbytes = std::min(nbytes, _head.load(std::memory_order_acquire) - tail);
+	_tail.store(tail + nbytes, std::memory_order_release);
+	return nbytes;
+}
+
+size_t BufferRing::size() const {
+	return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+}
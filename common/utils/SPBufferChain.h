@@ -0,0 +1,303 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_UTILS_SPBUFFERCHAIN_H_
+#define COMMON_UTILS_SPBUFFERCHAIN_H_
+
+#include "SPIOBuffer.h"
+#include "SPIOProducer.h"
+#include "SPIOConsumer.h"
+#include "SPBytesView.h"
+#include "SPStringView.h"
+
+namespace stappler {
+
+struct BufferChunk {
+	BufferChunk *next;
+	uint32_t capacity;
+	uint32_t start; // first unread byte
+	uint32_t end; // first unwritten byte
+
+	uint8_t *data() { return (uint8_t *)(this + 1); }
+	const uint8_t *data() const { return (const uint8_t *)(this + 1); }
+
+	size_t size() const { return end - start; }
+	size_t remains() const { return capacity - end; }
+};
+
+// Thread-safe source of fixed-size chunks, keeps up to `maxFree` released chunks for reuse
+class BufferChunkPool {
+public:
+	static constexpr size_t DefaultChunkSize = 16_KiB;
+	static constexpr size_t DefaultMaxFree = 256;
+
+	static BufferChunkPool *getDefault();
+
+	BufferChunkPool(size_t chunkSize = DefaultChunkSize, size_t maxFree = DefaultMaxFree);
+	~BufferChunkPool();
+
+	BufferChunkPool(const BufferChunkPool &) = delete;
+	BufferChunkPool &operator=(const BufferChunkPool &) = delete;
+
+	BufferChunk *acquire();
+	void release(BufferChunk *);
+
+	// payload size of single chunk
+	size_t getChunkSize() const { return _chunkSize; }
+	size_t getFreeChunks() const;
+
+protected:
+	size_t _chunkSize = 0;
+	size_t _maxFree = 0;
+	size_t _free = 0;
+	BufferChunk *_freeList = nullptr;
+	mutable std::mutex _mutex;
+};
+
+// Chain of fixed-size chunks: appending never moves data already written,
+// data can be read as sequence of contiguous segments (see `segments` and `foreach`)
+class BufferChain : public memory::AllocBase {
+public:
+	using byte_type = uint8_t;
+
+	BufferChain(BufferChunkPool * = nullptr);
+	~BufferChain();
+
+	BufferChain(const BufferChain &) = delete;
+	BufferChain &operator=(const BufferChain &) = delete;
+
+	BufferChain(BufferChain &&);
+	BufferChain &operator=(BufferChain &&);
+
+	size_t put(const uint8_t *, size_t);
+
+	template <typename CharType, typename std::enable_if<sizeof(CharType) == 1 && !std::is_same<CharType, uint8_t>::value>::type * = nullptr>
+	size_t put(const CharType *ptr, size_t len) {
+		return put((const uint8_t *)ptr, len);
+	}
+
+	size_t put(BytesView b) { return put(b.data(), b.size()); }
+	size_t put(StringView s) { return put((const uint8_t *)s.data(), s.size()); }
+
+	size_t putc(char c) { return put((const uint8_t *)&c, 1); }
+
+	// move all chunks from other chain to the end of this chain without copying
+	void splice(BufferChain &&);
+
+	// writable block in the last chunk, `size` is updated to the available space
+	uint8_t *prepare(size_t &size);
+	void save(uint8_t *, size_t nbytes);
+
+	// fills up to `count` segments, returns number of segments written
+	size_t segments(BytesView *, size_t count) const;
+
+	template <typename Callback>
+	void foreach(const Callback &cb) const {
+		auto c = _head;
+		while (c) {
+			if (c->size() > 0) {
+				cb(BytesView(c->data() + c->start, c->size()));
+			}
+			c = c->next;
+		}
+	}
+
+	// first contiguous segment
+	BytesView front() const;
+
+	// copy and consume up to nbytes
+	size_t read(uint8_t *, size_t nbytes);
+
+	// drop up to nbytes from the beginning, returns bytes dropped
+	size_t consume(size_t nbytes);
+
+	void clear();
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	// total bytes consumed since creation
+	size_t consumed() const { return _consumed; }
+
+	size_t chunks() const;
+	size_t getChunkSize() const { return _pool->getChunkSize(); }
+
+	template <typename Interface>
+	auto bytes() const -> typename Interface::BytesType {
+		typename Interface::BytesType ret; ret.resize(_size);
+		copyTo(ret.data());
+		return ret;
+	}
+
+	template <typename Interface>
+	auto str() const -> typename Interface::StringType {
+		typename Interface::StringType ret; ret.resize(_size);
+		copyTo((uint8_t *)ret.data());
+		return ret;
+	}
+
+	void copyTo(uint8_t *) const;
+
+	// io::Buffer interface: single reusable chunk
+	uint8_t *prepareBuffer(size_t &size);
+	uint8_t *data() { return _head ? _head->data() + _head->start : nullptr; }
+
+protected:
+	BufferChunk *allocate();
+	void releaseFront();
+
+	BufferChunkPool *_pool = nullptr;
+	BufferChunk *_head = nullptr;
+	BufferChunk *_tail = nullptr;
+	size_t _size = 0;
+	size_t _consumed = 0;
+};
+
+// Fixed-capacity single-producer/single-consumer byte ring, all operations are non-blocking;
+// `put`, `prepare` and `save` should be called only from producer thread,
+// `segments`, `read` and `consume` - only from consumer thread
+class BufferRing : public memory::AllocBase {
+public:
+	// capacity is rounded up to power of two
+	BufferRing(size_t capacity);
+	~BufferRing();
+
+	BufferRing(const BufferRing &) = delete;
+	BufferRing &operator=(const BufferRing &) = delete;
+
+	// writes as much as possible, returns bytes written
+	size_t put(const uint8_t *, size_t);
+	size_t put(BytesView b) { return put(b.data(), b.size()); }
+
+	// contiguous writable block, `size` is updated to the available space (can be 0)
+	uint8_t *prepare(size_t &size);
+	void save(uint8_t *, size_t nbytes);
+
+	// readable data as up to two segments, returns number of segments
+	size_t segments(BytesView out[2]) const;
+
+	size_t read(uint8_t *, size_t nbytes);
+	size_t consume(size_t nbytes);
+
+	size_t size() const;
+	size_t capacity() const { return _mask + 1; }
+	bool empty() const { return size() == 0; }
+
+protected:
+	uint8_t *_data = nullptr;
+	size_t _mask = 0;
+
+	// separate cache lines for producer and consumer positions
+	alignas(64) std::atomic<size_t> _head = 0; // written by producer
+	alignas(64) std::atomic<size_t> _tail = 0; // written by consumer
+};
+
+}
+
+namespace stappler::io {
+
+template <>
+struct BufferTraits<BufferChain> {
+	using type = BufferChain;
+
+	static uint8_t * PrepareFn(void *ptr, size_t & size) {
+		return ((type *)ptr)->prepareBuffer(size);
+	}
+
+	static void SaveFn(void *ptr, uint8_t *buf, size_t prepared, size_t nbytes) {
+		((type *)ptr)->save(buf, nbytes);
+	}
+
+	static size_t SizeFn(void *ptr) { return ((type *)ptr)->size(); }
+	static size_t CapacityFn(void *ptr) { return ((type *)ptr)->getChunkSize(); }
+	static uint8_t *DataFn(void *ptr) { return ((type *)ptr)->data(); }
+	static void ClearFn(void *ptr) { ((type *)ptr)->clear(); }
+};
+
+template <>
+struct ProducerTraits<BufferChain> {
+	using type = BufferChain;
+
+	static size_t ReadFn(void *ptr, uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->read(buf, nbytes);
+	}
+
+	// only forward seek is supported
+	static size_t SeekFn(void *ptr, int64_t offset, Seek s) {
+		auto chain = (type *)ptr;
+		if (s == Seek::Current && offset >= 0) {
+			chain->consume(size_t(offset));
+			return chain->consumed();
+		} else if (s == Seek::Set && offset >= int64_t(chain->consumed())) {
+			chain->consume(size_t(offset) - chain->consumed());
+			return chain->consumed();
+		}
+		return maxOf<size_t>();
+	}
+
+	static size_t TellFn(void *ptr) {
+		return ((type *)ptr)->consumed();
+	}
+};
+
+template <>
+struct ConsumerTraits<BufferChain> {
+	using type = BufferChain;
+
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->put(buf, nbytes);
+	}
+
+	static void FlushFn(void *ptr) { }
+};
+
+template <>
+struct ProducerTraits<BufferRing> {
+	using type = BufferRing;
+
+	static size_t ReadFn(void *ptr, uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->read(buf, nbytes);
+	}
+
+	static size_t SeekFn(void *ptr, int64_t offset, Seek s) {
+		return maxOf<size_t>();
+	}
+
+	static size_t TellFn(void *ptr) {
+		return maxOf<size_t>();
+	}
+};
+
+template <>
+struct ConsumerTraits<BufferRing> {
+	using type = BufferRing;
+
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->put(buf, nbytes);
+	}
+
+	static void FlushFn(void *ptr) { }
+};
+
+}
+
+#endif /* COMMON_UTILS_SPBUFFERCHAIN_H_ */
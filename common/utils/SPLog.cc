@@ -22,6 +22,9 @@ THE SOFTWARE.
 
 #include "SPCommon.h"
 #include "SPLog.h"
+#include "SPLogRecord.h"
+
+#include <charconv>
 
 namespace stappler::log {
 
@@ -101,6 +104,636 @@ static void CustomLog_remove(CustomLog::log_fn fn) {
 	s_logFuncMutex.unlock();
 }
 
+static std::atomic<bool> s_asyncEnabled = false;
+
+// Single-producer single-consumer ring of preformatted records
+// Producer is the owner thread, consumer is the one, who holds AsyncLog drain lock
+struct AsyncLogRing {
+	struct Header {
+		uint32_t size; // full record size, aligned to 8
+		uint16_t tag;
+		uint16_t flags;
+	};
+
+	static constexpr uint16_t FlagPadding = 1;
+	static constexpr uint16_t FlagBinary = 2; // RecordFormat pointer and serialized arguments
+	static constexpr size_t MaxTagSize = 256;
+
+	AsyncLogRing(size_t cap)
+	: capacity(size_t(math::npot(uint64_t(std::max(cap, size_t(4_KiB)))))), mask(capacity - 1), data(new uint8_t[capacity]) { }
+
+	~AsyncLogRing() {
+		delete [] data;
+	}
+
+	size_t used() const {
+		return size_t(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed));
+	}
+
+	bool empty() const {
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+	}
+
+	bool push(StringView tag, StringView text) {
+		// limit size of single record, so it can not block the whole buffer
+		tag = tag.sub(0, std::min(tag.size(), MaxTagSize));
+		text = text.sub(0, std::min(text.size(), capacity / 4 - sizeof(Header) - MaxTagSize));
+
+		return emplace(tag.size() + text.size(), uint16_t(tag.size()), 0, [&] (uint8_t *target) {
+			memcpy(target, tag.data(), tag.size());
+			memcpy(target + tag.size(), text.data(), text.size());
+		});
+	}
+
+	bool push(const RecordFormat *format, BytesView args) {
+		return emplace(sizeof(format) + args.size(), 0, FlagBinary, [&] (uint8_t *target) {
+			memcpy(target, &format, sizeof(format));
+			memcpy(target + sizeof(format), args.data(), args.size());
+		});
+	}
+
+	template <typename Writer>
+	bool emplace(size_t payload, uint16_t tag, uint16_t flags, const Writer &writer) {
+		const size_t size = math::align<size_t>(sizeof(Header) + payload, 8);
+		if (size > capacity / 2) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		auto h = head.load(std::memory_order_relaxed);
+		auto t = tail.load(std::memory_order_acquire);
+
+		auto offset = size_t(h & mask);
+		auto contiguous = capacity - offset;
+		auto required = (contiguous < size) ? size + contiguous : size;
+
+		if (h + required - t > capacity) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		if (contiguous < size) {
+			// fill the end of buffer with padding record, write from the beginning
+			auto pad = (Header *)(data + offset);
+			pad->size = uint32_t(contiguous);
+			pad->tag = 0;
+			pad->flags = FlagPadding;
+			h += contiguous;
+			offset = 0;
+		}
+
+		auto header = (Header *)(data + offset);
+		header->size = uint32_t(sizeof(Header) + payload);
+		header->tag = tag;
+		header->flags = flags;
+		writer(data + offset + sizeof(Header));
+
+		head.store(h + size, std::memory_order_release);
+		return true;
+	}
+
+	// callback receives record header and payload
+	template <typename Callback>
+	size_t drain(const Callback &cb) {
+		auto t = tail.load(std::memory_order_relaxed);
+		auto h = head.load(std::memory_order_acquire);
+		size_t ret = 0;
+		while (t < h) {
+			auto offset = size_t(t & mask);
+			auto header = (const Header *)(data + offset);
+			if ((header->flags & FlagPadding) == 0) {
+				cb(header, data + offset + sizeof(Header));
+				t += math::align<size_t>(header->size, 8);
+				++ ret;
+			} else {
+				t += header->size;
+			}
+		}
+		tail.store(t, std::memory_order_release);
+		return ret;
+	}
+
+	const size_t capacity;
+	const size_t mask;
+	uint8_t *data;
+
+	alignas(64) std::atomic<uint64_t> head = 0;
+	alignas(64) std::atomic<uint64_t> tail = 0;
+
+	std::atomic<uint64_t> dropped = 0;
+	std::atomic<bool> abandoned = false;
+};
+
+struct AsyncLogThread {
+	AsyncLogRing *ring = nullptr;
+	bool finalized = false;
+
+	~AsyncLogThread() {
+		if (ring) {
+			ring->abandoned.store(true);
+			ring = nullptr;
+		}
+		finalized = true;
+	}
+};
+
+static thread_local AsyncLogThread tl_asyncLogThread;
+
+// Binary log: magic, then sequence of entries: <kind:u8><size:varint><payload>
+// Format: <id:varint><tagSize:varint><tag><format>
+// Record: <id:varint><arguments>
+// Text: <tagSize:varint><tag><text>
+static constexpr char s_binaryLogMagic[8] = "SPLOGB1";
+
+enum class BinaryLogEntry : uint8_t {
+	Format = 1,
+	Record,
+	Text,
+};
+
+static size_t BinaryLog_varintSize(uint64_t val) {
+	size_t ret = 1;
+	while (val >= 0x80) {
+		val >>= 7;
+		++ ret;
+	}
+	return ret;
+}
+
+static uint8_t *BinaryLog_writeVarint(uint8_t *target, uint64_t val) {
+	while (val >= 0x80) {
+		*target++ = uint8_t(val) | 0x80;
+		val >>= 7;
+	}
+	*target++ = uint8_t(val);
+	return target;
+}
+
+static void BinaryLog_writeVarint(std::string &out, uint64_t val) {
+	uint8_t buf[10];
+	auto end = BinaryLog_writeVarint(buf, val);
+	out.append((const char *)buf, end - buf);
+}
+
+static bool BinaryLog_readVarint(BytesView &data, uint64_t &val) {
+	val = 0;
+	for (size_t shift = 0; shift < 64 && !data.empty(); shift += 7) {
+		auto b = data[0];
+		data.offset(1);
+		val |= uint64_t(b & 0x7F) << shift;
+		if ((b & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename T>
+static void BinaryLog_writeNumber(std::string &out, T val, int base = 10) {
+	char buf[32];
+	std::to_chars_result res;
+	if constexpr (std::is_floating_point_v<T>) {
+		res = std::to_chars(buf, buf + sizeof(buf), val);
+	} else {
+		res = std::to_chars(buf, buf + sizeof(buf), val, base);
+	}
+	out.append(buf, res.ptr - buf);
+}
+
+// appends next argument from data to out
+static bool BinaryLog_formatArg(std::string &out, BytesView &data) {
+	if (data.empty()) {
+		return false;
+	}
+
+	auto type = RecordArg(data[0]);
+	data.offset(1);
+
+	uint64_t val = 0;
+	switch (type) {
+	case RecordArg::Int:
+		if (!BinaryLog_readVarint(data, val)) { return false; }
+		BinaryLog_writeNumber(out, int64_t(val >> 1) ^ -int64_t(val & 1));
+		break;
+	case RecordArg::Uint:
+		if (!BinaryLog_readVarint(data, val)) { return false; }
+		BinaryLog_writeNumber(out, val);
+		break;
+	case RecordArg::Double:
+		if (data.size() < sizeof(double)) {
+			return false;
+		} else {
+			double d;
+			memcpy(&d, data.data(), sizeof(double));
+			data.offset(sizeof(double));
+			BinaryLog_writeNumber(out, d);
+		}
+		break;
+	case RecordArg::Bool:
+		if (data.empty()) { return false; }
+		out.append(data[0] ? "true" : "false");
+		data.offset(1);
+		break;
+	case RecordArg::Char:
+		if (data.empty()) { return false; }
+		out.push_back(char(data[0]));
+		data.offset(1);
+		break;
+	case RecordArg::String:
+		if (!BinaryLog_readVarint(data, val) || val > data.size()) { return false; }
+		out.append((const char *)data.data(), size_t(val));
+		data.offset(size_t(val));
+		break;
+	case RecordArg::Pointer:
+		if (!BinaryLog_readVarint(data, val)) { return false; }
+		out.append("0x");
+		BinaryLog_writeNumber(out, val, 16);
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+struct BinaryLogFile {
+	FILE *file = nullptr;
+	std::vector<bool> defined;
+	std::string buf;
+
+	BinaryLogFile(FILE *f) : file(f) {
+		buf.append(s_binaryLogMagic, sizeof(s_binaryLogMagic));
+	}
+
+	~BinaryLogFile() {
+		flush();
+		::fclose(file);
+	}
+
+	void writeHeader(BinaryLogEntry kind, size_t size) {
+		buf.push_back(char(toInt(kind)));
+		BinaryLog_writeVarint(buf, size);
+	}
+
+	void writeRecord(const RecordFormat *format, BytesView args) {
+		if (format->id >= defined.size()) {
+			defined.resize(format->id + 1);
+		}
+
+		if (!defined[format->id]) {
+			// format is written once, before first record
+			writeHeader(BinaryLogEntry::Format, BinaryLog_varintSize(format->id) + BinaryLog_varintSize(format->tag.size())
+					+ format->tag.size() + format->format.size());
+			BinaryLog_writeVarint(buf, format->id);
+			BinaryLog_writeVarint(buf, format->tag.size());
+			buf.append(format->tag.data(), format->tag.size());
+			buf.append(format->format.data(), format->format.size());
+			defined[format->id] = true;
+		}
+
+		writeHeader(BinaryLogEntry::Record, BinaryLog_varintSize(format->id) + args.size());
+		BinaryLog_writeVarint(buf, format->id);
+		buf.append((const char *)args.data(), args.size());
+		if (buf.size() > 64_KiB) {
+			flush();
+		}
+	}
+
+	void writeText(StringView tag, StringView text) {
+		writeHeader(BinaryLogEntry::Text, BinaryLog_varintSize(tag.size()) + tag.size() + text.size());
+		BinaryLog_writeVarint(buf, tag.size());
+		buf.append(tag.data(), tag.size());
+		buf.append(text.data(), text.size());
+		if (buf.size() > 64_KiB) {
+			flush();
+		}
+	}
+
+	void flush() {
+		if (!buf.empty()) {
+			::fwrite(buf.data(), 1, buf.size(), file);
+			::fflush(file);
+			buf.clear();
+		}
+	}
+};
+
+class AsyncLog {
+public:
+	// Instance is never destroyed, so it can be used from static destructors,
+	// async mode is finalized by atexit handler instead
+	static AsyncLog *getInstance() {
+		static AsyncLog *s_instance = [] {
+			auto ret = new AsyncLog;
+			std::atexit([] {
+				getInstance()->finalize();
+			});
+			return ret;
+		}();
+		return s_instance;
+	}
+
+	void finalize() {
+		disable();
+		setBinaryLog(StringView());
+	}
+
+	bool enable(const AsyncConfig &cfg) {
+		std::unique_lock lock(_controlMutex);
+		if (_thread.joinable()) {
+			return false;
+		}
+
+		_bufferSize.store(cfg.bufferSize);
+		_interval = std::chrono::milliseconds(std::max(cfg.flushIntervalMs, uint32_t(1)));
+		_stop = false;
+		_thread = std::thread([this] {
+			threadMain();
+		});
+		s_asyncEnabled.store(true);
+		return true;
+	}
+
+	void disable() {
+		std::unique_lock lock(_controlMutex);
+		if (!_thread.joinable()) {
+			return;
+		}
+
+		s_asyncEnabled.store(false);
+		// pairs with fence in onPushed: record, pushed after that, is drained by its producer
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		do {
+			std::unique_lock lock(_waitMutex);
+			_stop = true;
+		} while (0);
+		_cond.notify_all();
+		_thread.join();
+		drain();
+	}
+
+	void push(StringView tag, StringView text) {
+		auto ring = getRing();
+		if (!ring) {
+			// thread is finalizing, its buffer is no longer available
+			CustomLog::VA va;
+			va.text = text;
+			__log3(tag, CustomLog::Text, va);
+			return;
+		}
+
+		onPushed(ring, ring->push(tag, text));
+	}
+
+	void push(const RecordFormat &format, BytesView args) {
+		auto ring = getRing();
+		if (!ring) {
+			std::string str;
+			formatRecord(str, format.format, args);
+			CustomLog::VA va;
+			va.text = StringView(str);
+			__log3(format.tag, CustomLog::Text, va);
+			return;
+		}
+
+		onPushed(ring, ring->push(&format, args));
+	}
+
+	void drain() {
+		std::unique_lock drainLock(_drainMutex);
+
+		std::vector<AsyncLogRing *> rings;
+		do {
+			std::unique_lock lock(_registryMutex);
+			rings = _rings;
+		} while (0);
+
+		uint64_t records = 0;
+		uint64_t dropped = _retiredDropped;
+		std::vector<AsyncLogRing *> retired;
+
+		auto drainRings = [&] (const auto &cb) {
+			for (auto &it : rings) {
+				if (it->abandoned.load()) {
+					retired.emplace_back(it);
+				}
+				records += it->drain(cb);
+				dropped += it->dropped.load(std::memory_order_relaxed);
+			}
+		};
+
+		// formats binary records for text sinks
+		std::string scratch;
+		auto drainText = [&] (const auto &cb) {
+			drainRings([&] (const AsyncLogRing::Header *h, const uint8_t *payload) {
+				if (h->flags & AsyncLogRing::FlagBinary) {
+					const RecordFormat *format = nullptr;
+					memcpy(&format, payload, sizeof(format));
+					scratch.clear();
+					formatRecord(scratch, format->format, BytesView(payload + sizeof(format), h->size - sizeof(AsyncLogRing::Header) - sizeof(format)));
+					cb(format->tag, StringView(scratch));
+				} else {
+					auto tagPtr = (const char *)payload;
+					cb(StringView(tagPtr, h->tag), StringView(tagPtr + h->tag, h->size - sizeof(AsyncLogRing::Header) - h->tag));
+				}
+			});
+		};
+
+		if (_binaryLog) {
+			drainRings([&] (const AsyncLogRing::Header *h, const uint8_t *payload) {
+				auto size = h->size - sizeof(AsyncLogRing::Header);
+				if (h->flags & AsyncLogRing::FlagBinary) {
+					const RecordFormat *format = nullptr;
+					memcpy(&format, payload, sizeof(format));
+					_binaryLog->writeRecord(format, BytesView(payload + sizeof(format), size - sizeof(format)));
+				} else {
+					auto tagPtr = (const char *)payload;
+					_binaryLog->writeText(StringView(tagPtr, h->tag), StringView(tagPtr + h->tag, size - h->tag));
+				}
+			});
+
+			reportDropped(dropped, [&] (StringView text) { _binaryLog->writeText("Log", text); });
+			_binaryLog->flush();
+		} else if (s_logFuncCount.load() == 0) {
+			// default sink: one write and one flush for the whole batch
+			std::string buf;
+			auto write = [&] {
+				if (!buf.empty()) {
+#if MSYS
+					std::cout.write(buf.data(), buf.size());
+					std::cout.flush();
+#else
+					std::cerr.write(buf.data(), buf.size());
+					std::cerr.flush();
+#endif
+					buf.clear();
+				}
+			};
+
+			auto cb = [&] (StringView tag, StringView text) {
+				buf.append("[").append(tag.data(), tag.size()).append("] ").append(text.data(), text.size()).append("\n");
+				if (buf.size() > 64_KiB) {
+					write();
+				}
+			};
+
+			drainText(cb);
+			reportDropped(dropped, [&] (StringView text) { cb("Log", text); });
+			write();
+		} else {
+			std::unique_lock lock(s_logFuncMutex);
+			auto cb = [&] (StringView tag, StringView text) {
+				CustomLog::VA va;
+				va.text = text;
+				auto count = s_logFuncCount.load();
+				for (int i = 0; i < count; i++) {
+					s_logFuncArr[i](tag, CustomLog::Text, va);
+				}
+			};
+
+			drainText(cb);
+			reportDropped(dropped, [&] (StringView text) { cb("Log", text); });
+		}
+
+		_records.fetch_add(records);
+
+		if (!retired.empty()) {
+			// owner threads are finished, and buffers are drained after abandoned flag was set
+			std::unique_lock lock(_registryMutex);
+			for (auto &it : retired) {
+				_retiredDropped += it->dropped.load();
+				_rings.erase(std::find(_rings.begin(), _rings.end(), it));
+				delete it;
+			}
+		}
+	}
+
+	bool setBinaryLog(StringView path) {
+		std::unique_lock drainLock(_drainMutex);
+		if (_binaryLog) {
+			delete _binaryLog;
+			_binaryLog = nullptr;
+		}
+
+		if (path.empty()) {
+			return true;
+		}
+
+		auto file = ::fopen(path.str<memory::StandartInterface>().data(), "wb");
+		if (!file) {
+			return false;
+		}
+
+		_binaryLog = new BinaryLogFile(file);
+		return true;
+	}
+
+	AsyncStats getStats() {
+		AsyncStats ret;
+		ret.records = _records.load();
+
+		std::unique_lock lock(_registryMutex);
+		ret.dropped = _retiredDropped;
+		for (auto &it : _rings) {
+			ret.dropped += it->dropped.load(std::memory_order_relaxed);
+		}
+		ret.buffers = _rings.size();
+		return ret;
+	}
+
+protected:
+	void onPushed(AsyncLogRing *ring, bool pushed) {
+		if (!pushed) {
+			return;
+		}
+
+		// async mode can be disabled after producer checked it, so final drain can miss this record
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!s_asyncEnabled.load(std::memory_order_relaxed)) {
+			drain();
+		} else if (ring->used() > ring->capacity / 2 && !_pending.exchange(true)) {
+			_cond.notify_one();
+		}
+	}
+
+	AsyncLogRing *getRing() {
+		auto &th = tl_asyncLogThread;
+		if (th.finalized) {
+			return nullptr;
+		}
+
+		if (!th.ring) {
+			th.ring = new AsyncLogRing(_bufferSize.load());
+			std::unique_lock lock(_registryMutex);
+			_rings.emplace_back(th.ring);
+		}
+		return th.ring;
+	}
+
+	template <typename Callback>
+	uint64_t reportDropped(uint64_t dropped, const Callback &cb) {
+		if (dropped > _reportedDropped) {
+			auto str = toString(dropped - _reportedDropped, " records dropped: log buffer overflow");
+			cb(StringView(str));
+			_reportedDropped = dropped;
+		}
+		return dropped;
+	}
+
+	void threadMain() {
+		std::unique_lock lock(_waitMutex);
+		while (!_stop) {
+			_cond.wait_for(lock, _interval, [&] {
+				return _stop || _pending.load();
+			});
+			_pending.store(false);
+			lock.unlock();
+			drain();
+			lock.lock();
+		}
+	}
+
+	std::mutex _controlMutex;
+	std::thread _thread;
+
+	std::mutex _waitMutex;
+	std::condition_variable _cond;
+	std::chrono::milliseconds _interval = std::chrono::milliseconds(20);
+	bool _stop = false;
+	std::atomic<bool> _pending = false;
+	std::atomic<size_t> _bufferSize = 256_KiB;
+
+	std::mutex _registryMutex;
+	std::vector<AsyncLogRing *> _rings;
+
+	std::mutex _drainMutex; // protects consumer side of rings and binary log
+	BinaryLogFile *_binaryLog = nullptr;
+	std::atomic<uint64_t> _records = 0;
+	uint64_t _retiredDropped = 0;
+	uint64_t _reportedDropped = 0;
+};
+
+static void AsyncLog_push(const StringView &tag, const StringView &text) {
+	AsyncLog::getInstance()->push(tag, text);
+}
+
+static void AsyncLog_format(const StringView &tag, CustomLog::VA &va) {
+	char stackBuf[1_KiB];
+	va_list tmpList;
+	va_copy(tmpList, va.format.args);
+	int size = vsnprintf(stackBuf, size_t(1_KiB - 1), va.format.format, tmpList);
+	va_end(tmpList);
+	if (size > int(1_KiB - 1)) {
+		char *buf = new char[size + 1];
+		size = vsnprintf(buf, size_t(size + 1), va.format.format, va.format.args);
+		AsyncLog_push(tag, StringView(buf, size));
+		delete [] buf;
+	} else if (size >= 0) {
+		AsyncLog_push(tag, StringView(stackBuf, size));
+	} else {
+		AsyncLog_push(tag, "Log error");
+	}
+}
+
 CustomLog::CustomLog(log_fn fn) : fn(fn) {
 	if (fn) {
 		CustomLog_insert(fn);
@@ -127,15 +760,186 @@ void format(const StringView &tag, const char *fmt, ...) {
     va_start(va.format.args, fmt);
     va.format.format = fmt;
 
-	__log3(tag, CustomLog::Format, va);
+	if (s_asyncEnabled.load(std::memory_order_relaxed)) {
+		AsyncLog_format(tag, va);
+	} else {
+		__log3(tag, CustomLog::Format, va);
+	}
 
     va_end(va.format.args);
 }
 
 void text(const StringView &tag, const StringView &text) {
+	if (s_asyncEnabled.load(std::memory_order_relaxed)) {
+		AsyncLog_push(tag, text);
+		return;
+	}
+
 	CustomLog::VA va;
 	va.text = text;
 	__log3(tag, CustomLog::Text, va);
 }
 
+bool enableAsync(const AsyncConfig &cfg) {
+	return AsyncLog::getInstance()->enable(cfg);
+}
+
+void disableAsync() {
+	AsyncLog::getInstance()->disable();
+}
+
+bool isAsync() {
+	return s_asyncEnabled.load();
+}
+
+void flush() {
+	AsyncLog::getInstance()->drain();
+}
+
+AsyncStats getAsyncStats() {
+	return AsyncLog::getInstance()->getStats();
+}
+
+static std::atomic<uint32_t> s_recordFormatId = 1;
+
+RecordFormat::RecordFormat(StringView t, StringView f) : tag(t), format(f), id(s_recordFormatId.fetch_add(1)) { }
+
+void RecordBuffer::writeInt(int64_t val) {
+	if (_offset + 11 <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Int);
+		// zigzag encoding, so small negative values are short too
+		_offset = BinaryLog_writeVarint(_data + _offset, (uint64_t(val) << 1) ^ uint64_t(val >> 63)) - _data;
+	}
+}
+
+void RecordBuffer::writeUint(uint64_t val) {
+	if (_offset + 11 <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Uint);
+		_offset = BinaryLog_writeVarint(_data + _offset, val) - _data;
+	}
+}
+
+void RecordBuffer::writeDouble(double val) {
+	if (_offset + 1 + sizeof(double) <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Double);
+		memcpy(_data + _offset, &val, sizeof(double));
+		_offset += sizeof(double);
+	}
+}
+
+void RecordBuffer::writeBool(bool val) {
+	if (_offset + 2 <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Bool);
+		_data[_offset ++] = val ? 1 : 0;
+	}
+}
+
+void RecordBuffer::writeChar(char val) {
+	if (_offset + 2 <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Char);
+		_data[_offset ++] = uint8_t(val);
+	}
+}
+
+void RecordBuffer::writeString(StringView val) {
+	if (_offset + 11 <= Size) {
+		auto size = std::min(val.size(), Size - _offset - 11);
+		_data[_offset ++] = toInt(RecordArg::String);
+		_offset = BinaryLog_writeVarint(_data + _offset, size) - _data;
+		memcpy(_data + _offset, val.data(), size);
+		_offset += size;
+	}
+}
+
+void RecordBuffer::writePointer(const void *val) {
+	if (_offset + 11 <= Size) {
+		_data[_offset ++] = toInt(RecordArg::Pointer);
+		_offset = BinaryLog_writeVarint(_data + _offset, uint64_t(uintptr_t(val))) - _data;
+	}
+}
+
+void record(const RecordFormat &format, BytesView args) {
+	if (s_asyncEnabled.load(std::memory_order_relaxed)) {
+		AsyncLog::getInstance()->push(format, args);
+		return;
+	}
+
+	std::string str;
+	formatRecord(str, format.format, args);
+	text(format.tag, StringView(str));
+}
+
+void formatRecord(std::string &out, StringView format, BytesView args) {
+	while (!format.empty()) {
+		auto str = format.readUntilString("{}");
+		out.append(str.data(), str.size());
+		if (format.is("{}")) {
+			if (!BinaryLog_formatArg(out, args)) {
+				// missed or truncated argument
+				out.append("{}");
+			}
+			format += 2;
+		}
+	}
+}
+
+bool setBinaryLog(StringView path) {
+	return AsyncLog::getInstance()->setBinaryLog(path);
+}
+
+bool readBinaryLog(BytesView data, const Callback<void(StringView, StringView)> &cb) {
+	if (data.size() < sizeof(s_binaryLogMagic) || memcmp(data.data(), s_binaryLogMagic, sizeof(s_binaryLogMagic)) != 0) {
+		return false;
+	}
+
+	data.offset(sizeof(s_binaryLogMagic));
+
+	std::vector<std::pair<StringView, StringView>> formats;
+	std::string scratch;
+
+	uint64_t size = 0;
+	uint64_t val = 0;
+	while (!data.empty()) {
+		auto kind = BinaryLogEntry(data[0]);
+		data.offset(1);
+		if (!BinaryLog_readVarint(data, size) || size > data.size()) {
+			return false;
+		}
+
+		BytesView entry(data.data(), size_t(size));
+		data.offset(size_t(size));
+
+		switch (kind) {
+		case BinaryLogEntry::Format:
+			if (!BinaryLog_readVarint(entry, val) || !BinaryLog_readVarint(entry, size) || size > entry.size() || val > maxOf<uint32_t>()) {
+				return false;
+			}
+			if (val >= formats.size()) {
+				formats.resize(val + 1);
+			}
+			formats[val] = pair(StringView((const char *)entry.data(), size_t(size)),
+					StringView((const char *)entry.data() + size, entry.size() - size_t(size)));
+			break;
+		case BinaryLogEntry::Record:
+			if (!BinaryLog_readVarint(entry, val) || val >= formats.size()) {
+				return false;
+			}
+			scratch.clear();
+			formatRecord(scratch, formats[val].second, entry);
+			cb(formats[val].first, StringView(scratch));
+			break;
+		case BinaryLogEntry::Text:
+			if (!BinaryLog_readVarint(entry, size) || size > entry.size()) {
+				return false;
+			}
+			cb(StringView((const char *)entry.data(), size_t(size)),
+					StringView((const char *)entry.data() + size, entry.size() - size_t(size)));
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
 }
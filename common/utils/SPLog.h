@@ -62,6 +62,35 @@ struct CustomLog {
 void format(const StringView &tag, const char *, ...) SPPRINTF(2, 3);
 void text(const StringView &tag, const StringView &);
 
+struct AsyncConfig {
+	// per-thread ring buffer capacity, rounded up to power of two
+	size_t bufferSize = 256_KiB;
+
+	// flusher wakes up at least with this interval, or when one of buffers is half-full
+	uint32_t flushIntervalMs = 20;
+};
+
+struct AsyncStats {
+	uint64_t records = 0; // records written to sinks
+	uint64_t dropped = 0; // records dropped because of buffer overflow
+	uint64_t buffers = 0; // active thread buffers
+};
+
+// In async mode records are formatted on the calling thread into per-thread lock-free ring buffer,
+// and written to sinks in batches from background thread. When buffer is full, record is dropped.
+// Custom sinks are called from flusher thread with CustomLog::Text records.
+bool enableAsync(const AsyncConfig & = AsyncConfig());
+
+// flush pending records and return to synchronous mode
+void disableAsync();
+
+bool isAsync();
+
+// write all pending records from calling thread, use it in crash handlers before exit
+void flush();
+
+AsyncStats getAsyncStats();
+
 template <typename ... Args>
 void vtext(const StringView &tag, Args && ... args) {
 	text(tag, StringView(toString(std::forward<Args>(args)...)));
@@ -0,0 +1,166 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_UTILS_SPLOGRECORD_H_
+#define COMMON_UTILS_SPLOGRECORD_H_
+
+#include "SPLog.h"
+#include "SPMetastring.h"
+#include "SPBytesView.h"
+
+// Structured log records with deferred formatting
+//
+// log::record("Tag"_meta, "loaded {} items from {}"_meta, count, path);
+//
+// Format and tag are compile-time constants, only arguments are serialized on the calling thread.
+// In async mode record is stored in binary form and formatted by flusher, or written as is
+// into binary log (see setBinaryLog), that can be decoded later with readBinaryLog.
+// In sync mode record is formatted immediately and passed to log::text.
+
+namespace stappler::log {
+
+enum class RecordArg : uint8_t {
+	Int = 1,
+	Uint,
+	Double,
+	Bool,
+	Char,
+	String,
+	Pointer,
+};
+
+struct RecordFormat {
+	StringView tag;
+	StringView format;
+	uint32_t id; // process-wide, assigned in construction order
+
+	RecordFormat(StringView tag, StringView format);
+};
+
+// Argument serializer, uses fixed buffer on the calling thread's stack,
+// strings that does not fit into buffer are truncated
+class RecordBuffer {
+public:
+	static constexpr size_t Size = 1_KiB;
+
+	template <typename T>
+	void write(const T &);
+
+	void writeInt(int64_t);
+	void writeUint(uint64_t);
+	void writeDouble(double);
+	void writeBool(bool);
+	void writeChar(char);
+	void writeString(StringView);
+	void writePointer(const void *);
+
+	BytesView data() const { return BytesView(_data, _offset); }
+
+protected:
+	size_t _offset = 0;
+	uint8_t _data[Size];
+};
+
+// Stores serialized record, format should have static storage duration
+void record(const RecordFormat &, BytesView args);
+
+// Substitutes {} placeholders in format with serialized arguments
+void formatRecord(std::string &out, StringView format, BytesView args);
+
+// Writes all records, processed by async flusher, into binary file instead of sinks,
+// empty path closes current binary log. Binary log is used only in async mode.
+bool setBinaryLog(StringView path);
+
+// Decodes binary log, callback called with tag and formatted text for every record
+bool readBinaryLog(BytesView, const Callback<void(StringView, StringView)> &);
+
+namespace detail {
+
+template <char ... Chars>
+constexpr size_t countPlaceholders() {
+	constexpr char str[] = { Chars ..., 0 };
+	size_t ret = 0;
+	for (size_t i = 0; i + 1 < sizeof ... (Chars); ++ i) {
+		if (str[i] == '{' && str[i + 1] == '}') {
+			++ ret;
+			++ i;
+		}
+	}
+	return ret;
+}
+
+template <typename Tag, typename Format>
+struct RecordFormatStorage {
+	static constexpr auto tag = Tag::array();
+	static constexpr auto format = Format::array();
+
+	static const RecordFormat &get() {
+		static RecordFormat s_format(StringView(tag.data(), tag.size()), StringView(format.data(), format.size()));
+		return s_format;
+	}
+};
+
+template <typename T>
+struct RecordArgFalse : std::false_type { };
+
+}
+
+template <typename T>
+inline void RecordBuffer::write(const T &val) {
+	if constexpr (std::is_same_v<T, bool>) {
+		writeBool(val);
+	} else if constexpr (std::is_same_v<T, char>) {
+		writeChar(val);
+	} else if constexpr (std::is_enum_v<T>) {
+		write(std::underlying_type_t<T>(val));
+	} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+		writeInt(val);
+	} else if constexpr (std::is_integral_v<T>) {
+		writeUint(val);
+	} else if constexpr (std::is_floating_point_v<T>) {
+		writeDouble(val);
+	} else if constexpr (std::is_same_v<std::decay_t<T>, const char *> || std::is_same_v<std::decay_t<T>, char *>) {
+		writeString(StringView(val));
+	} else if constexpr (std::is_pointer_v<T>) {
+		writePointer(val);
+	} else if constexpr (std::is_convertible_v<const T &, StringView>) {
+		writeString(StringView(val));
+	} else {
+		static_assert(detail::RecordArgFalse<T>::value, "Unsupported log record argument type");
+	}
+}
+
+template <char ... TagChars, char ... FormatChars, typename ... Args>
+inline void record(metastring::metastring<TagChars ...>, metastring::metastring<FormatChars ...>, const Args & ... args) {
+	static_assert(detail::countPlaceholders<FormatChars ...>() == sizeof ... (Args),
+			"Number of {} placeholders in log record format should match number of arguments");
+
+	using Storage = detail::RecordFormatStorage<metastring::metastring<TagChars ...>, metastring::metastring<FormatChars ...>>;
+
+	RecordBuffer buf;
+	(buf.write(args), ...);
+	record(Storage::get(), buf.data());
+}
+
+}
+
+#endif /* COMMON_UTILS_SPLOGRECORD_H_ */
@@ -0,0 +1,260 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPRandom.h"
+
+#if LINUX || ANDROID
+#include <sys/random.h>
+#endif
+
+#if !WIN32
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace stappler::random {
+
+static constexpr size_t ChaChaBlocks = 16; // blocks per refill
+static constexpr size_t ChaChaBufferSize = ChaChaBlocks * 64;
+static constexpr size_t ChaChaReseedInterval = 16384; // refills, ~16 MiB of output
+
+static inline uint32_t chacha20_rotl(uint32_t v, int c) {
+	return (v << c) | (v >> (32 - c));
+}
+
+#define CHACHA20_QR(a, b, c, d) \
+	a += b; d ^= a; d = chacha20_rotl(d, 16); \
+	c += d; b ^= c; b = chacha20_rotl(b, 12); \
+	a += b; d ^= a; d = chacha20_rotl(d, 8); \
+	c += d; b ^= c; b = chacha20_rotl(b, 7);
+
+static inline uint32_t chacha20_load(const uint8_t *p) {
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static inline void chacha20_store(uint8_t *p, uint32_t v) {
+	p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); p[2] = uint8_t(v >> 16); p[3] = uint8_t(v >> 24);
+}
+
+static void chacha20_block(uint8_t *out, const uint32_t input[16]) {
+	uint32_t x[16];
+	memcpy(x, input, sizeof(x));
+
+	for (size_t i = 0; i < 10; ++ i) {
+		CHACHA20_QR(x[0], x[4], x[ 8], x[12])
+		CHACHA20_QR(x[1], x[5], x[ 9], x[13])
+		CHACHA20_QR(x[2], x[6], x[10], x[14])
+		CHACHA20_QR(x[3], x[7], x[11], x[15])
+		CHACHA20_QR(x[0], x[5], x[10], x[15])
+		CHACHA20_QR(x[1], x[6], x[11], x[12])
+		CHACHA20_QR(x[2], x[7], x[ 8], x[13])
+		CHACHA20_QR(x[3], x[4], x[ 9], x[14])
+	}
+
+	for (size_t i = 0; i < 16; ++ i) {
+		chacha20_store(out + i * 4, x[i] + input[i]);
+	}
+}
+
+#undef CHACHA20_QR
+
+static void chacha20_init(uint32_t state[16], const uint8_t key[32], uint32_t counter, const uint8_t nonce[12]) {
+	// "expand 32-byte k"
+	state[0] = 0x61707865; state[1] = 0x3320646e; state[2] = 0x79622d32; state[3] = 0x6b206574;
+	for (size_t i = 0; i < 8; ++ i) {
+		state[4 + i] = chacha20_load(key + i * 4);
+	}
+	state[12] = counter;
+	for (size_t i = 0; i < 3; ++ i) {
+		state[13 + i] = chacha20_load(nonce + i * 4);
+	}
+}
+
+void chacha20Block(uint8_t out[64], const uint8_t key[32], uint32_t counter, const uint8_t nonce[12]) {
+	uint32_t state[16];
+	chacha20_init(state, key, counter, nonce);
+	chacha20_block(out, state);
+}
+
+static bool readSystemEntropy(uint8_t *buf, size_t count) {
+#if LINUX || ANDROID
+	while (count > 0) {
+		auto ret = ::getrandom(buf, count, 0);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		buf += ret;
+		count -= ret;
+	}
+	if (count == 0) {
+		return true;
+	}
+#elif WIN32
+	while (count > 0) {
+		unsigned int val = 0;
+		if (rand_s(&val) != 0) {
+			return false;
+		}
+		auto n = std::min(count, sizeof(val));
+		memcpy(buf, &val, n);
+		buf += n;
+		count -= n;
+	}
+	return true;
+#elif MACOS
+	arc4random_buf(buf, count);
+	return true;
+#endif
+
+#if !WIN32
+	// fallback for old kernels without getrandom
+	auto fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+	if (fd >= 0) {
+		while (count > 0) {
+			auto ret = ::read(fd, buf, count);
+			if (ret <= 0) {
+				break;
+			}
+			buf += ret;
+			count -= ret;
+		}
+		::close(fd);
+	}
+#endif
+	return count == 0;
+}
+
+// incremented in child process after fork, so all threads will reseed
+static std::atomic<uint32_t> s_forkGeneration = 0;
+
+struct RandomState {
+	uint32_t input[16];
+	uint8_t buffer[ChaChaBufferSize];
+	size_t offset = ChaChaBufferSize;
+	size_t refills = 0;
+	uint32_t generation = maxOf<uint32_t>();
+
+	RandomState() {
+#if !WIN32
+		static std::once_flag s_atfork;
+		std::call_once(s_atfork, [] {
+			::pthread_atfork(nullptr, nullptr, [] {
+				s_forkGeneration.fetch_add(1);
+			});
+		});
+#endif
+	}
+
+	~RandomState() {
+		secure_clear();
+	}
+
+	void secure_clear() {
+		volatile uint8_t *ptr = (volatile uint8_t *)buffer;
+		for (size_t i = 0; i < sizeof(buffer); ++ i) {
+			ptr[i] = 0;
+		}
+		volatile uint32_t *in = input;
+		for (size_t i = 0; i < 16; ++ i) {
+			in[i] = 0;
+		}
+	}
+
+	void seed() {
+		uint8_t key[32 + 12];
+		if (!readSystemEntropy(key, sizeof(key))) {
+			// last resort, should never happen on supported platforms
+			auto t = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+			auto tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+			memcpy(key, &t, sizeof(t));
+			memcpy(key + sizeof(t), &tid, sizeof(tid));
+		}
+		chacha20_init(input, key, 0, key + 32);
+		memset(key, 0, sizeof(key));
+		generation = s_forkGeneration.load();
+		refills = 0;
+	}
+
+	void refill() {
+		if (generation != s_forkGeneration.load(std::memory_order_relaxed) || refills >= ChaChaReseedInterval) {
+			seed();
+		}
+
+		for (size_t i = 0; i < ChaChaBlocks; ++ i) {
+			chacha20_block(buffer + i * 64, input);
+			++ input[12];
+		}
+
+		// rekey from the first 32 bytes of output, then wipe them
+		for (size_t i = 0; i < 8; ++ i) {
+			input[4 + i] = chacha20_load(buffer + i * 4);
+		}
+		input[12] = 0;
+		memset(buffer, 0, 32);
+		offset = 32;
+		++ refills;
+	}
+
+	void fill(uint8_t *buf, size_t count) {
+		if (generation != s_forkGeneration.load(std::memory_order_relaxed)) {
+			// state was copied from parent process, its buffered output should not be reused
+			refill();
+		}
+
+		while (count > 0) {
+			if (offset == ChaChaBufferSize) {
+				refill();
+			}
+
+			auto n = std::min(count, ChaChaBufferSize - offset);
+			memcpy(buf, buffer + offset, n);
+			memset(buffer + offset, 0, n);
+			offset += n;
+			buf += n;
+			count -= n;
+		}
+	}
+};
+
+static thread_local RandomState tl_randomState;
+
+void fill(uint8_t *buf, size_t count) {
+	tl_randomState.fill(buf, count);
+}
+
+uint32_t next32() {
+	uint32_t ret;
+	tl_randomState.fill((uint8_t *)&ret, sizeof(ret));
+	return ret;
+}
+
+uint64_t next64() {
+	uint64_t ret;
+	tl_randomState.fill((uint8_t *)&ret, sizeof(ret));
+	return ret;
+}
+
+}
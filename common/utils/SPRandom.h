@@ -0,0 +1,47 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef COMMON_UTILS_SPRANDOM_H_
+#define COMMON_UTILS_SPRANDOM_H_
+
+#include "SPCommon.h"
+
+// Cryptographically secure pseudo-random generator
+//
+// Every thread owns ChaCha20 stream, keyed from OS entropy source (getrandom on Linux).
+// Output is generated in 1 KiB batches, key for the next batch is taken from the batch itself
+// and the served bytes are wiped ("fast key erasure"), so previous output can not be recovered
+// from the state. Generator is reseeded from OS after fork and periodically.
+
+namespace stappler::random {
+
+void fill(uint8_t *, size_t);
+
+uint32_t next32();
+uint64_t next64();
+
+// ChaCha20 block function (RFC 8439, 2.3)
+void chacha20Block(uint8_t out[64], const uint8_t key[32], uint32_t counter, const uint8_t nonce[12]);
+
+}
+
+#endif /* COMMON_UTILS_SPRANDOM_H_ */
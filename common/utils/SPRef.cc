@@ -126,6 +126,27 @@ struct BacktraceState {
 		::backtrace_full(_backtraceState, 2 + offset, debug_backtrace_full_callback, debug_backtrace_error, (void *)&cb);
 	}
 
+	size_t capture(uintptr_t *pcs, size_t count, size_t offset) {
+		struct CaptureData {
+			uintptr_t *pcs;
+			size_t count;
+			size_t captured;
+		} data{pcs, count, 0};
+
+		::backtrace_simple(_backtraceState, 2 + offset, [] (void *ptr, uintptr_t pc) -> int {
+			auto data = (CaptureData *)ptr;
+			if (pc != 0xffffffffffffffffLLU) {
+				data->pcs[data->captured ++] = pc;
+			}
+			return data->captured < data->count ? 0 : 1;
+		}, debug_backtrace_error, &data);
+		return data.captured;
+	}
+
+	void symbolize(uintptr_t pc, const Callback<void(StringView)> &cb) {
+		::backtrace_pcinfo(_backtraceState, pc, debug_backtrace_full_callback, debug_backtrace_error, (void *)&cb);
+	}
+
 	::backtrace_state *_backtraceState;
 };
 
@@ -133,6 +154,14 @@ void getBacktrace(size_t offset, const Callback<void(StringView)> &cb) {
 	BacktraceState::getInstance()->getBacktrace(offset, cb);
 }
 
+static size_t captureBacktrace(uintptr_t *pcs, size_t count, size_t offset) {
+	return BacktraceState::getInstance()->capture(pcs, count, offset);
+}
+
+static void symbolizeBacktrace(uintptr_t pc, const Callback<void(StringView)> &cb) {
+	BacktraceState::getInstance()->symbolize(pc, cb);
+}
+
 }
 
 #elif LINUX
@@ -167,6 +196,37 @@ void getBacktrace(size_t offset, const Callback<void(StringView)> &cb) {
 	::free(bt_syms);
 }
 
+static size_t captureBacktrace(uintptr_t *pcs, size_t count, size_t offset) {
+	void *bt[LinuxBacktraceSize];
+	auto bt_size = ::backtrace(bt, std::min(int(count + offset + 1), LinuxBacktraceSize));
+
+	size_t ret = 0;
+	for (int i = offset + 1; i < bt_size && ret < count; ++ i) {
+		pcs[ret ++] = uintptr_t(bt[i]);
+	}
+	return ret;
+}
+
+static void symbolizeBacktrace(uintptr_t pc, const Callback<void(StringView)> &cb) {
+	void *bt = (void *)pc;
+	auto bt_syms = ::backtrace_symbols(&bt, 1);
+	if (!bt_syms) {
+		return;
+	}
+
+	StringView str(bt_syms[0]);
+
+	auto first = str.find('(');
+	auto second = str.rfind('+');
+
+	char buf[1024] = { 0 };
+	auto size = backtrace::print(buf, 1024, pc, StringView(str, first), -1, StringView(str, first + 1, second - first - 1));
+
+	cb(StringView(buf, size));
+
+	::free(bt_syms);
+}
+
 }
 
 #else
@@ -175,6 +235,10 @@ namespace stappler {
 
 void getBacktrace(size_t offset, const Callback<void(StringView)> &cb) { }
 
+static size_t captureBacktrace(uintptr_t *pcs, size_t count, size_t offset) { return 0; }
+
+static void symbolizeBacktrace(uintptr_t pc, const Callback<void(StringView)> &cb) { }
+
 }
 
 #endif
@@ -182,133 +246,176 @@ void getBacktrace(size_t offset, const Callback<void(StringView)> &cb) { }
 
 namespace stappler::memleak {
 
-static std::mutex s_mutex;
-static std::atomic<uint64_t> s_refId = 1;
-
-struct BackraceInfo {
-	Time t;
-	std::vector<std::string> backtrace;
+// Retain tracker: ids are distributed across shards and slots by value, so
+// sequential ids from different threads rarely touch the same cache lines.
+// Slots are claimed with CAS, only raw PCs are stored, symbolization is performed in foreachBacktrace
+static constexpr size_t TrackerShards = 64;
+static constexpr size_t TrackerShardSlots = 4096;
+static constexpr size_t TrackerProbes = 64;
+static constexpr size_t TrackerFrames = 24;
+
+static constexpr uint64_t SlotEmpty = 0;
+static constexpr uint64_t SlotTombstone = maxOf<uint64_t>();
+
+struct RetainSlot {
+	std::atomic<uint64_t> id;
+	std::atomic<const void *> ptr; // published after slot data is written
+	Time time;
+	uint32_t nframes;
+	uintptr_t frames[TrackerFrames];
 };
 
-static std::map<const RefBase<memory::StandartInterface> *, std::map<uint64_t, BackraceInfo>> s_retainStdMap;
-static std::map<const RefBase<memory::PoolInterface> *, std::map<uint64_t, BackraceInfo>> s_retainPoolMap;
+struct RetainShard {
+	RetainSlot slots[TrackerShardSlots];
+};
 
-uint64_t getNextRefId() {
-	return s_refId.fetch_add(1);
+static std::atomic<uint64_t> s_refId = 1;
+static std::atomic<uint64_t> s_tracked = 0;
+static std::atomic<uint64_t> s_overflow = 0;
+static std::atomic<RetainShard *> s_shards[TrackerShards];
+
+static RetainShard *getShard(uint64_t id, bool create) {
+	auto &target = s_shards[id % TrackerShards];
+	auto shard = target.load(std::memory_order_acquire);
+	if (!shard && create) {
+		auto newShard = new RetainShard(); // value-initialization, all slots are empty
+		if (target.compare_exchange_strong(shard, newShard, std::memory_order_acq_rel)) {
+			shard = newShard;
+		} else {
+			delete newShard;
+		}
+	}
+	return shard;
 }
 
-uint64_t retainBacktrace(const RefBase<memory::StandartInterface> *ptr) {
+static uint64_t trackRetain(const void *ptr) {
 	auto id = getNextRefId();
-	std::vector<std::string> bt;
-	getBacktrace(0, [&] (StringView str) {
-		bt.emplace_back(str.str<memory::StandartInterface>());
-	});
-	s_mutex.lock();
-
-	auto it = s_retainStdMap.find(ptr);
-	if (it == s_retainStdMap.end()) {
-		it = s_retainStdMap.emplace(ptr, std::map<uint64_t, BackraceInfo>()).first;
-	}
-
-	auto iit = it->second.find(id);
-	if (iit == it->second.end()) {
-		it->second.emplace(id, BackraceInfo{Time::now(), move(bt)});
+	auto shard = getShard(id, true);
+	auto idx = id / TrackerShards;
+	for (size_t i = 0; i < TrackerProbes; ++ i) {
+		auto &slot = shard->slots[(idx + i) % TrackerShardSlots];
+		auto current = slot.id.load(std::memory_order_relaxed);
+		if ((current == SlotEmpty || current == SlotTombstone)
+				&& slot.id.compare_exchange_strong(current, id, std::memory_order_acquire)) {
+			slot.time = Time::now();
+			slot.nframes = uint32_t(captureBacktrace(slot.frames, TrackerFrames, 2));
+			slot.ptr.store(ptr, std::memory_order_release);
+			s_tracked.fetch_add(1, std::memory_order_relaxed);
+			return id;
+		}
 	}
 
-	s_mutex.unlock();
+	// id is still valid, but release for it will not find the slot
+	s_overflow.fetch_add(1, std::memory_order_relaxed);
 	return id;
 }
 
-void releaseBacktrace(const RefBase<memory::StandartInterface> *ptr, uint64_t id) {
+static void trackRelease(uint64_t id) {
 	if (!id) {
 		return;
 	}
 
-	s_mutex.lock();
+	auto shard = getShard(id, false);
+	if (!shard) {
+		return;
+	}
 
-	auto it = s_retainStdMap.find(ptr);
-	if (it != s_retainStdMap.end()) {
-		auto iit = it->second.find(id);
-		if (iit != it->second.end()) {
-			it->second.erase(iit);
-		}
-		if (it->second.size() == 0) {
-			s_retainStdMap.erase(it);
+	auto idx = id / TrackerShards;
+	for (size_t i = 0; i < TrackerProbes; ++ i) {
+		auto &slot = shard->slots[(idx + i) % TrackerShardSlots];
+		auto current = slot.id.load(std::memory_order_acquire);
+		if (current == id) {
+			slot.ptr.store(nullptr, std::memory_order_relaxed);
+			slot.id.store(SlotTombstone, std::memory_order_release);
+			s_tracked.fetch_sub(1, std::memory_order_relaxed);
+			return;
+		} else if (current == SlotEmpty) {
+			return;
 		}
 	}
-
-	s_mutex.unlock();
 }
 
-void foreachBacktrace(const RefBase<memory::StandartInterface> *ptr,
-		const Callback<void(uint64_t, Time, const std::vector<std::string> &)> &cb) {
-	s_mutex.lock();
+static void foreachTracked(const void *ptr, const Callback<void(uint64_t, Time, const std::vector<std::string> &)> &cb) {
+	struct Entry {
+		uint64_t id;
+		Time time;
+		uint32_t nframes;
+		uintptr_t frames[TrackerFrames];
+	};
+
+	std::vector<Entry> entries;
+	for (auto &it : s_shards) {
+		auto shard = it.load(std::memory_order_acquire);
+		if (!shard) {
+			continue;
+		}
 
-	auto it = s_retainStdMap.find(ptr);
-	if (it != s_retainStdMap.end()) {
-		for (auto &iit : it->second) {
-			cb(iit.first, iit.second.t, iit.second.backtrace);
+		for (auto &slot : shard->slots) {
+			if (slot.ptr.load(std::memory_order_acquire) != ptr) {
+				continue;
+			}
+
+			Entry entry;
+			entry.id = slot.id.load(std::memory_order_acquire);
+			entry.time = slot.time;
+			entry.nframes = std::min(slot.nframes, uint32_t(TrackerFrames));
+			memcpy(entry.frames, slot.frames, sizeof(uintptr_t) * entry.nframes);
+
+			// slot can be released and reused while we read it
+			if (slot.ptr.load(std::memory_order_acquire) == ptr && slot.id.load(std::memory_order_acquire) == entry.id) {
+				entries.emplace_back(entry);
+			}
 		}
 	}
 
-	s_mutex.unlock();
-}
-
-uint64_t retainBacktrace(const RefBase<memory::PoolInterface> *ptr) {
-	auto id = getNextRefId();
-	std::vector<std::string> bt;
-	getBacktrace(0, [&] (StringView str) {
-		bt.emplace_back(str.str<memory::StandartInterface>());
+	std::sort(entries.begin(), entries.end(), [] (const Entry &l, const Entry &r) {
+		return l.id < r.id;
 	});
-	s_mutex.lock();
 
-	auto it = s_retainPoolMap.find(ptr);
-	if (it == s_retainPoolMap.end()) {
-		it = s_retainPoolMap.emplace(ptr, std::map<uint64_t, BackraceInfo>()).first;
+	std::vector<std::string> bt;
+	for (auto &it : entries) {
+		bt.clear();
+		for (uint32_t i = 0; i < it.nframes; ++ i) {
+			symbolizeBacktrace(it.frames[i], [&] (StringView str) {
+				bt.emplace_back(str.str<memory::StandartInterface>());
+			});
+		}
+		cb(it.id, it.time, bt);
 	}
+}
 
-	auto iit = it->second.find(id);
-	if (iit == it->second.end()) {
-		it->second.emplace(id, BackraceInfo{Time::now(), move(bt)});
-	}
+uint64_t getNextRefId() {
+	return s_refId.fetch_add(1);
+}
 
-	s_mutex.unlock();
-	return id;
+TrackerStats getTrackerStats() {
+	return TrackerStats{s_tracked.load(), s_overflow.load()};
 }
 
-void releaseBacktrace(const RefBase<memory::PoolInterface> *ptr, uint64_t id) {
-	if (!id) {
-		return;
-	}
+uint64_t retainBacktrace(const RefBase<memory::StandartInterface> *ptr) {
+	return trackRetain(ptr);
+}
 
-	s_mutex.lock();
+void releaseBacktrace(const RefBase<memory::StandartInterface> *ptr, uint64_t id) {
+	trackRelease(id);
+}
 
-	auto it = s_retainPoolMap.find(ptr);
-	if (it != s_retainPoolMap.end()) {
-		auto iit = it->second.find(id);
-		if (iit != it->second.end()) {
-			it->second.erase(iit);
-		}
-		if (it->second.size() == 0) {
-			s_retainPoolMap.erase(it);
-		}
-	}
+void foreachBacktrace(const RefBase<memory::StandartInterface> *ptr,
+		const Callback<void(uint64_t, Time, const std::vector<std::string> &)> &cb) {
+	foreachTracked(ptr, cb);
+}
+
+uint64_t retainBacktrace(const RefBase<memory::PoolInterface> *ptr) {
+	return trackRetain(ptr);
+}
 
-	s_mutex.unlock();
+void releaseBacktrace(const RefBase<memory::PoolInterface> *ptr, uint64_t id) {
+	trackRelease(id);
 }
 
 void foreachBacktrace(const RefBase<memory::PoolInterface> *ptr,
 		const Callback<void(uint64_t, Time, const std::vector<std::string> &)> &cb) {
-	s_mutex.lock();
-
-	auto it = s_retainPoolMap.find(ptr);
-	if (it != s_retainPoolMap.end()) {
-		for (auto &iit : it->second) {
-			cb(iit.first, iit.second.t, iit.second.backtrace);
-		}
-	}
-
-	s_mutex.unlock();
+	foreachTracked(ptr, cb);
 }
 
 }
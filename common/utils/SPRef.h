@@ -26,17 +26,30 @@ THE SOFTWARE.
 #include "SPTime.h"
 #include "SPCommon.h"
 
-// enable Ref debug mode to track retain/release sources
-#define SP_REF_DEBUG 1
+// Ref debug mode makes retain/release virtual and allows to track retain/release sources
+// for classes, that overrides isRetainTrackerEnabled; enable it with `make SP_REF_DEBUG=1`
+#ifndef SP_REF_DEBUG
+#define SP_REF_DEBUG 0
+#endif
 
 namespace stappler {
 
 struct AtomicCounter {
-	AtomicCounter() { _count.store(1); }
+	AtomicCounter() { _count.store(1, std::memory_order_relaxed); }
+
+	// new reference can only be created from existing one, no ordering required
+	void increment() { _count.fetch_add(1, std::memory_order_relaxed); }
 
-	void increment() { ++ _count; }
-	bool decrement() { if (_count.fetch_sub(1) == 1) { return true; } return false; }
-	uint32_t get() const { return _count.load(); }
+	// all writes to object should be visible to the thread, that deletes it
+	bool decrement() {
+		if (_count.fetch_sub(1, std::memory_order_release) == 1) {
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t get() const { return _count.load(std::memory_order_relaxed); }
 
 	std::atomic<uint32_t> _count;
 };
@@ -52,7 +65,7 @@ public:
 
 #else
 	uint64_t retain() { _counter.increment(); return 0; }
-	void release(uint64_t id) { if (_counter.decrement()) { delete this; } }
+	void release(uint64_t id = 0) { if (_counter.decrement()) { delete this; } }
 #endif
 
 	uint32_t getReferenceCount() const { return _counter.get(); }
@@ -71,7 +84,14 @@ protected:
 
 namespace memleak {
 
+struct TrackerStats {
+	uint64_t tracked = 0; // currently tracked references
+	uint64_t overflow = 0; // references, that was not tracked, because of table overflow
+};
+
 uint64_t getNextRefId();
+TrackerStats getTrackerStats();
+
 uint64_t retainBacktrace(const RefBase<memory::StandartInterface> *);
 void releaseBacktrace(const RefBase<memory::StandartInterface> *, uint64_t);
 void foreachBacktrace(const RefBase<memory::StandartInterface> *,
@@ -220,7 +240,7 @@ private:
 #if SP_REF_DEBUG
 		if (_ptr) { _ptr->release(_id); }
 #else
-		if (_ptr) { _ptr->release(); }
+		if (_ptr) { _ptr->release(0); }
 #endif
 	}
 
@@ -233,7 +253,7 @@ private:
 		return value;
 #else
 		if (value) { value->retain(); }
-		if (_ptr) { _ptr->release(); }
+		if (_ptr) { _ptr->release(0); }
 		return value;
 #endif
 	}
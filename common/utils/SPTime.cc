@@ -38,6 +38,66 @@ static constexpr uint64_t SP_USEC_PER_SEC(1000000);
 
 using sp_time_t = uint32_t;
 
+// Civil calendar conversions from days since 1970-01-01, proleptic Gregorian calendar,
+// see http://howardhinnant.github.io/date_algorithms.html
+// Only integer arithmetic without table lookups and data-dependent branches
+struct sp_civil_t {
+	int64_t year;
+	uint32_t month; // [1, 12]
+	uint32_t day; // [1, 31]
+};
+
+static constexpr int64_t sp_days_from_civil(int64_t y, uint32_t m, uint32_t d) {
+	y -= (m <= 2);
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const uint32_t yoe = uint32_t(y - era * 400);
+	const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + int64_t(doe) - 719468;
+}
+
+static constexpr sp_civil_t sp_civil_from_days(int64_t z) {
+	z += 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const uint32_t doe = uint32_t(z - era * 146097);
+	const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const uint32_t mp = (5 * doy + 2) / 153;
+	const uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+	const uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+	return sp_civil_t{int64_t(yoe) + era * 400 + (m <= 2), m, d};
+}
+
+// 0 - Sunday, 1970-01-01 was Thursday
+static constexpr uint32_t sp_weekday_from_days(int64_t z) {
+	return uint32_t(z >= -4 ? (z + 4) % 7 : (z + 5) % 7 + 6);
+}
+
+static constexpr bool sp_is_leap(int64_t y) {
+	return (y % 4 == 0) && (y % 100 != 0 || y % 400 == 0);
+}
+
+static constexpr uint32_t sp_last_day_of_month(int64_t y, uint32_t m) {
+	return (m != 2) ? ((m ^ (m >> 3)) | 30) : (sp_is_leap(y) ? 29 : 28);
+}
+
+static_assert(sp_days_from_civil(1970, 1, 1) == 0);
+static_assert(sp_days_from_civil(2000, 3, 1) == 11017);
+static_assert(sp_civil_from_days(11017).year == 2000 && sp_civil_from_days(11017).month == 3);
+static_assert(sp_weekday_from_days(0) == 4);
+static_assert(sp_last_day_of_month(2023, 4) == 30 && sp_last_day_of_month(2023, 7) == 31 && sp_last_day_of_month(2024, 2) == 29);
+
+// split microseconds into days since epoch and microseconds within day
+static inline void sp_split_time(int64_t t, int64_t &days, int64_t &usec) {
+	static constexpr int64_t UsecPerDay = int64_t(SP_USEC_PER_SEC) * 86400;
+	days = t / UsecPerDay;
+	usec = t % UsecPerDay;
+	if (usec < 0) {
+		usec += UsecPerDay;
+		-- days;
+	}
+}
+
 TimeInterval TimeInterval::between(const Time &v1, const Time &v2) {
 	if (v1 > v2) {
 		return TimeInterval(v1._value - v2._value);
@@ -121,12 +181,23 @@ Time Time::now() {
 	tt -= EPOCH;
 	return Time(tt);
 #else
-	struct timeval t0;
-	gettimeofday(&t0, NULL);
-	return Time(t0.tv_sec * 1000000LL + t0.tv_usec);
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return Time(ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
 #endif
 }
 
+Time Time::now(Clock clock) {
+#if LINUX || ANDROID
+	if (clock == RealtimeCoarse) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+		return Time(ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
+	}
+#endif
+	return now();
+}
+
 Time Time::microseconds(uint64_t mksec) {
 	return Time(mksec);
 }
@@ -161,25 +232,39 @@ sp_time_exp_t::sp_time_exp_t() {
 }
 
 sp_time_exp_t::sp_time_exp_t(int64_t t, int32_t offset, bool use_localtime) {
+	if (!use_localtime) {
+		// GMT decomposition does not require timezone data, use calendar arithmetic instead of gmtime
+		int64_t days, usec;
+		sp_split_time(t, days, usec);
+
+		auto civil = sp_civil_from_days(days);
+		auto secs = int32_t(usec / int64_t(SP_USEC_PER_SEC));
+
+		tm_usec = int32_t(usec % int64_t(SP_USEC_PER_SEC));
+		tm_sec = secs % 60;
+		tm_min = (secs / 60) % 60;
+		tm_hour = secs / 3600;
+		tm_mday = int32_t(civil.day);
+		tm_mon = int32_t(civil.month) - 1;
+		tm_year = int32_t(civil.year - 1900);
+		tm_wday = int32_t(sp_weekday_from_days(days));
+		tm_yday = int32_t(days - sp_days_from_civil(civil.year, 1, 1));
+		tm_isdst = 0;
+		tm_gmtoff = 0;
+		tm_gmt_type = gmt_set;
+		return;
+	}
+
 	struct tm tm;
 	time_t tt = time_t(t / int64_t(SP_USEC_PER_SEC));
 	tm_usec = t % int64_t(SP_USEC_PER_SEC);
 
-	if (use_localtime) {
-#if WIN32
-		localtime_s(&tm, &tt);
-#else
-		localtime_r(&tt, &tm);
-#endif
-		tm_gmt_type = gmt_local;
-	} else {
 #if WIN32
-		gmtime_s(&tm, &tt);
+	localtime_s(&tm, &tt);
 #else
-		gmtime_r(&tt, &tm);
+	localtime_r(&tt, &tm);
 #endif
-		tm_gmt_type = gmt_set;
-	}
+	tm_gmt_type = gmt_local;
 
 	tm_sec = tm.tm_sec;
 	tm_min = tm.tm_min;
@@ -192,6 +277,8 @@ sp_time_exp_t::sp_time_exp_t(int64_t t, int32_t offset, bool use_localtime) {
 	tm_isdst = tm.tm_isdst;
 #ifndef WIN32
 	tm_gmtoff = tm.tm_gmtoff;
+#else
+	tm_gmtoff = 0;
 #endif
 }
 
@@ -756,6 +843,225 @@ void sp_time_exp_t::encodeIso8601(char *date_str, size_t precision) const {
 	*date_str++ = 0;
 }
 
+static inline char *sp_time_write2(char *buf, uint32_t val) {
+	buf[0] = char('0' + val / 10);
+	buf[1] = char('0' + val % 10);
+	return buf + 2;
+}
+
+static inline char *sp_time_write4(char *buf, uint32_t val) {
+	buf[0] = char('0' + val / 1000);
+	buf[1] = char('0' + val / 100 % 10);
+	buf[2] = char('0' + val / 10 % 10);
+	buf[3] = char('0' + val % 10);
+	return buf + 4;
+}
+
+// Formatted representation of the last used second for current thread
+struct sp_time_format_cache_t {
+	int64_t rfc822Sec = minOf<int64_t>();
+	int64_t iso8601Sec = minOf<int64_t>();
+	char rfc822[32];
+	char iso8601[20]; // YYYY-MM-DDThh:mm:ss
+};
+
+static thread_local sp_time_format_cache_t tl_timeFormatCache;
+
+static void sp_time_fill_rfc822(char *buf, int64_t days, uint32_t secs) {
+	auto civil = sp_civil_from_days(days);
+	auto year = uint32_t(civil.year) % 10000; // This routine isn't y10k ready
+
+	/* example: "Sat, 08 Jan 2000 18:31:41 GMT" */
+	memcpy(buf, sp_day_snames[sp_weekday_from_days(days)], 3);
+	buf[3] = ','; buf[4] = ' ';
+	sp_time_write2(buf + 5, civil.day);
+	buf[7] = ' ';
+	memcpy(buf + 8, sp_month_snames[civil.month - 1], 3);
+	buf[11] = ' ';
+	sp_time_write4(buf + 12, year);
+	buf[16] = ' ';
+	sp_time_write2(buf + 17, secs / 3600);
+	buf[19] = ':';
+	sp_time_write2(buf + 20, secs / 60 % 60);
+	buf[22] = ':';
+	sp_time_write2(buf + 23, secs % 60);
+	memcpy(buf + 25, " GMT", 5);
+}
+
+static void sp_time_fill_iso8601(char *buf, int64_t days, uint32_t secs) {
+	auto civil = sp_civil_from_days(days);
+	auto year = uint32_t(civil.year) % 10000;
+
+	sp_time_write4(buf, year);
+	buf[4] = '-';
+	sp_time_write2(buf + 5, civil.month);
+	buf[7] = '-';
+	sp_time_write2(buf + 8, civil.day);
+	buf[10] = 'T';
+	sp_time_write2(buf + 11, secs / 3600);
+	buf[13] = ':';
+	sp_time_write2(buf + 14, secs / 60 % 60);
+	buf[16] = ':';
+	sp_time_write2(buf + 17, secs % 60);
+}
+
+size_t Time::encodeRfc822(char *buf) const {
+	auto sec = int64_t(_value / SP_USEC_PER_SEC);
+	auto &cache = tl_timeFormatCache;
+	if (cache.rfc822Sec != sec) {
+		int64_t days, usec;
+		sp_split_time(int64_t(_value), days, usec);
+		sp_time_fill_rfc822(cache.rfc822, days, uint32_t(usec / SP_USEC_PER_SEC));
+		cache.rfc822Sec = sec;
+	}
+	memcpy(buf, cache.rfc822, 30);
+	return 29;
+}
+
+size_t Time::encodeIso8601(char *buf, size_t precision) const {
+	auto sec = int64_t(_value / SP_USEC_PER_SEC);
+	auto &cache = tl_timeFormatCache;
+	if (cache.iso8601Sec != sec) {
+		int64_t days, usec;
+		sp_split_time(int64_t(_value), days, usec);
+		sp_time_fill_iso8601(cache.iso8601, days, uint32_t(usec / SP_USEC_PER_SEC));
+		cache.iso8601Sec = sec;
+	}
+	memcpy(buf, cache.iso8601, 19);
+
+	auto target = buf + 19;
+	if (precision > 0) {
+		// fraction is truncated, so it can not overflow into seconds
+		precision = std::min(precision, size_t(6));
+		auto usec = uint32_t(_value % SP_USEC_PER_SEC);
+		char digits[6];
+		for (size_t i = 6; i > 0; -- i) {
+			digits[i - 1] = char('0' + usec % 10);
+			usec /= 10;
+		}
+		*target++ = '.';
+		memcpy(target, digits, precision);
+		target += precision;
+	}
+	*target++ = 'Z';
+	*target = 0;
+	return target - buf;
+}
+
+// Fixed-layout parsers for canonical forms, that used by Time::toHttp and Time::toIso8601:
+//     Sun, 06 Nov 1994 08:49:37 GMT
+//     2011-04-28T06:34:00[.ffffff](Z|+hh:mm|-hh:mm|+hhmm|-hhmm)
+// Digits are validated with accumulated mask instead of per-char branches, all other forms
+// are handled with generic sp_time_exp_t::read
+
+template <size_t N>
+static inline bool sp_time_read_digits(const char *str, const uint8_t (&positions)[N], uint32_t (&out)[N]) {
+	uint32_t invalid = 0;
+	for (size_t i = 0; i < N; ++ i) {
+		out[i] = uint32_t(uint8_t(str[positions[i]]) - uint8_t('0'));
+		invalid |= uint32_t(out[i] > 9);
+	}
+	return invalid == 0;
+}
+
+static inline bool sp_time_make(int64_t year, uint32_t mon, uint32_t mday, uint32_t hour, uint32_t min, uint32_t sec, int64_t &ret) {
+	if (mon < 1 || mon > 12 || mday < 1 || mday > sp_last_day_of_month(year, mon) || hour > 23 || min > 59 || sec > 61) {
+		return false;
+	}
+	ret = (sp_days_from_civil(year, mon, mday) * 86400 + hour * 3600 + min * 60 + sec) * int64_t(SP_USEC_PER_SEC);
+	return true;
+}
+
+static bool sp_time_read_rfc1123(StringView r, int64_t &ret) {
+	static constexpr uint8_t positions[12] = { 5, 6, 12, 13, 14, 15, 17, 18, 20, 21, 23, 24 };
+	if (r.size() != 29 || r[3] != ',' || r[4] != ' ' || r[7] != ' ' || r[11] != ' ' || r[16] != ' '
+			|| r[19] != ':' || r[22] != ':' || memcmp(r.data() + 25, " GMT", 4) != 0) {
+		return false;
+	}
+
+	uint32_t d[12];
+	if (!sp_time_read_digits(r.data(), positions, d)) {
+		return false;
+	}
+
+	auto mint = (r[8] << 16) | (r[9] << 8) | r[10];
+	uint32_t mon = 0;
+	for (; mon < 12; ++ mon) {
+		if (mint == s_months[mon]) {
+			break;
+		}
+	}
+
+	return sp_time_make(d[2] * 1000 + d[3] * 100 + d[4] * 10 + d[5], mon + 1, d[0] * 10 + d[1],
+			d[6] * 10 + d[7], d[8] * 10 + d[9], d[10] * 10 + d[11], ret);
+}
+
+static bool sp_time_read_iso8601(StringView r, int64_t &ret) {
+	static constexpr uint8_t positions[14] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+	if (r.size() < 19 || r[4] != '-' || r[7] != '-' || r[10] != 'T' || r[13] != ':' || r[16] != ':') {
+		return false;
+	}
+
+	uint32_t d[14];
+	if (!sp_time_read_digits(r.data(), positions, d)) {
+		return false;
+	}
+
+	if (!sp_time_make(d[0] * 1000 + d[1] * 100 + d[2] * 10 + d[3], d[4] * 10 + d[5], d[6] * 10 + d[7],
+			d[8] * 10 + d[9], d[10] * 10 + d[11], d[12] * 10 + d[13], ret)) {
+		return false;
+	}
+
+	r += 19;
+	if (r.is('.')) {
+		++ r;
+		uint32_t usec = 0;
+		uint32_t scale = 100000;
+		size_t ndigits = 0;
+		while (!r.empty() && chars::isdigit(r[0])) {
+			usec += uint32_t(r[0] - '0') * scale;
+			scale /= 10;
+			++ ndigits;
+			++ r;
+		}
+		if (ndigits == 0) {
+			return false;
+		}
+		ret += usec;
+	}
+
+	if (r.empty() || r == "Z") {
+		return true;
+	}
+
+	if (r.size() != 5 && r.size() != 6) {
+		return false;
+	}
+
+	int64_t sign = 0;
+	switch (r[0]) {
+	case '+': sign = 1; break;
+	case '-': sign = -1; break;
+	default: return false;
+	}
+
+	uint32_t off[4];
+	if (r.size() == 6) {
+		static constexpr uint8_t offPositions[4] = { 1, 2, 4, 5 };
+		if (r[3] != ':' || !sp_time_read_digits(r.data(), offPositions, off)) {
+			return false;
+		}
+	} else {
+		static constexpr uint8_t offPositions[4] = { 1, 2, 3, 4 };
+		if (!sp_time_read_digits(r.data(), offPositions, off)) {
+			return false;
+		}
+	}
+
+	ret -= sign * int64_t(((off[0] * 10 + off[1]) * 60 + off[2] * 10 + off[3]) * 60) * int64_t(SP_USEC_PER_SEC);
+	return true;
+}
+
 Time Time::fromCompileTime(const char *date, const char *time) {
 	sp_time_exp_t ds;
 	ds.tm_year = ((date[7] - '0') * 10 + (date[8] - '0') - 19) * 100;
@@ -804,6 +1110,11 @@ Time Time::fromCompileTime(const char *date, const char *time) {
 }
 
 Time Time::fromHttp(StringView r) {
+	int64_t value = 0;
+	if (sp_time_read_rfc1123(r, value) || sp_time_read_iso8601(r, value)) {
+		return (value > 0) ? Time(uint64_t(value)) : Time();
+	}
+
 	sp_time_exp_t ds;
 	if (!ds.read(r)) {
 		return Time();
@@ -181,7 +181,15 @@ protected:
 
 class Time : public TimeStorage {
 public:
+	enum Clock {
+		Realtime,
+		// low-cost clock with resolution of system tick (1-4 ms on Linux), uses CLOCK_REALTIME_COARSE
+		// it's enough for logs and HTTP headers, but not for intervals measurements
+		RealtimeCoarse,
+	};
+
 	static Time now();
+	static Time now(Clock);
 
 	static Time fromCompileTime(const char *, const char *);
 
@@ -212,10 +220,8 @@ public:
 
 	template <typename Interface>
 	auto toRfc822() const -> typename Interface::StringType {
-		sp_time_exp_t xt(*this);
-		char buf[30] = { 0 };
-		xt.encodeRfc822(buf);
-		return typename Interface::StringType(buf, 29);
+		char buf[30];
+		return typename Interface::StringType(buf, encodeRfc822(buf));
 	}
 
 	template <typename Interface>
@@ -234,12 +240,16 @@ public:
 	// max - 6 - microseconds precision
 	template <typename Interface>
 	auto toIso8601(size_t precision = 0) const -> typename Interface::StringType {
-		sp_time_exp_t xt(*this, false);
-		char buf[30] = { 0 };
-		xt.encodeIso8601(buf, precision);
-		return typename Interface::StringType(buf, strlen(buf));
+		char buf[30];
+		return typename Interface::StringType(buf, encodeIso8601(buf, precision));
 	}
 
+	// Write formatted string into buffer with at least 30 bytes, returns string length.
+	// Result for the last used second is cached per thread, so repeated calls within
+	// the same second only copy cached string
+	size_t encodeRfc822(char *) const;
+	size_t encodeIso8601(char *, size_t precision = 0) const;
+
 	template <typename Interface>
 	auto toFormat(const char *fmt) const -> typename Interface::StringType {
 		char buf[256] = { 0 }; // should be enough
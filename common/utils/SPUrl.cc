@@ -484,14 +484,78 @@ auto UrlView::parsePath<memory::PoolInterface>(StringView str) -> memory::PoolIn
 }
 
 bool UrlView::isValidIdnTld(StringView str) {
-	auto p = s_IdnTld;
-	while (*p) {
-		if (str == *p) {
-			return true;
+	return s_IdnTldTable.find(str) != UrlHostTable::None;
+}
+
+static StringView getPublicSuffixHost(StringView host) {
+	if (host.empty() || host.is('[')) {
+		return StringView();
+	}
+
+	if (host.back() == '.') {
+		host = host.sub(0, host.size() - 1);
+	}
+
+	auto tmp = host;
+	tmp.skipChars<StringView::Chars<'.'>, StringView::CharGroup<CharGroupId::Numbers>>();
+	if (tmp.empty()) {
+		return StringView(); // IPv4 address
+	}
+
+	return host;
+}
+
+StringView UrlView::getPublicSuffix(StringView host) {
+	host = getPublicSuffixHost(host);
+	if (host.empty()) {
+		return StringView();
+	}
+
+	auto &table = getPublicSuffixTable();
+
+	// check suffixes from the longest one, first match is the longest
+	StringView suffix(host);
+	while (!suffix.empty()) {
+		StringView parent(suffix);
+		parent.skipUntil<StringView::Chars<'.'>>();
+		if (parent.is('.')) {
+			++ parent;
+		}
+
+		auto flags = table.find(suffix);
+		if (flags & UrlHostTable::Exception) {
+			return parent;
+		} else if (flags & UrlHostTable::Rule) {
+			return suffix;
+		} else if (!parent.empty() && (table.find(parent) & UrlHostTable::Wildcard)) {
+			return suffix;
+		} else if (parent.empty()) {
+			return suffix; // implicit "*" rule
 		}
-		++ p;
+
+		suffix = parent;
 	}
-	return false;
+	return StringView();
+}
+
+StringView UrlView::getRegistrableDomain(StringView host) {
+	host = getPublicSuffixHost(host);
+	auto suffix = getPublicSuffix(host);
+	if (suffix.empty() || suffix.size() >= host.size()) {
+		return StringView();
+	}
+
+	// one more label before suffix
+	StringView prefix(host.data(), host.size() - suffix.size() - 1);
+	if (prefix.empty()) {
+		return StringView();
+	}
+
+	auto pos = prefix.rfind('.');
+	if (pos == maxOf<size_t>()) {
+		return host;
+	}
+	return StringView(host, pos + 1, host.size() - pos - 1);
 }
 
 UrlView::UrlView() { }
@@ -57,6 +57,13 @@ struct UrlView {
 
 	static bool isValidIdnTld(StringView);
 
+	// Public suffix (effective TLD) of the host, like "co.uk" for "www.example.co.uk"
+	// Rules from Public Suffix List (SPUrlPublicSuffix.hpp) are matched in both Unicode and punycode forms
+	static StringView getPublicSuffix(StringView host);
+
+	// Public suffix with one more label, like "example.co.uk"; empty, if host is a public suffix itself
+	static StringView getRegistrableDomain(StringView host);
+
 	static bool parseUrl(StringView &s, const Callback<void(StringViewUtf8, UrlView::UrlToken)> &cb);
 
 	template <typename Interface>
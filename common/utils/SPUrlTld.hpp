@@ -24,9 +24,129 @@
 #ifndef COMMON_UTILS_SPURLTLD_HPP_
 #define COMMON_UTILS_SPURLTLD_HPP_
 
+#include "SPUrlPublicSuffix.hpp"
+
 namespace stappler {
 
-static const char *s_IdnTld[] = {
+// Host suffix tables are open addressing hash tables over static rule lists, slots refer to rules by index;
+// lookups are case-insensitive for ASCII characters
+struct UrlHostTable {
+	enum Flags : uint8_t {
+		None = 0,
+		Rule = 1, // suffix itself is listed
+		Wildcard = 2, // "*.suffix", any direct child of suffix is listed
+		Exception = 4, // "!suffix", suffix is excluded from wildcard rule
+	};
+
+	static constexpr char lower(char c) {
+		return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+	}
+
+	static constexpr uint32_t hash(const char *str, uint32_t len) {
+		// FNV-1a
+		uint32_t h = 2166136261U;
+		for (uint32_t i = 0; i < len; ++ i) {
+			h = (h ^ uint8_t(lower(str[i]))) * 16777619U;
+		}
+		return h;
+	}
+
+	static constexpr bool equal(const char *a, const char *b, uint32_t len) {
+		for (uint32_t i = 0; i < len; ++ i) {
+			if (lower(a[i]) != lower(b[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static constexpr uint32_t length(const char *str) {
+		uint32_t ret = 0;
+		while (str[ret]) { ++ ret; }
+		return ret;
+	}
+};
+
+template <size_t Size>
+struct UrlHostTableData : UrlHostTable {
+	static_assert((Size & (Size - 1)) == 0, "Table size should be power of two");
+
+	struct Slot {
+		uint16_t rule = 0; // index of rule + 1, 0 for empty slot
+		uint8_t len = 0;
+		uint8_t flags = None;
+	};
+
+	constexpr UrlHostTableData() = default;
+
+	template <size_t N>
+	constexpr UrlHostTableData(const char * const (&rules)[N]) {
+		load(rules);
+	}
+
+	template <size_t N>
+	constexpr void load(const char * const (&rules)[N]) {
+		static_assert(N * 2 <= Size, "Table should be at most half full");
+		static_assert(N < maxOf<uint16_t>(), "Too many rules");
+		_rules = rules;
+		for (size_t i = 0; i < N; ++ i) {
+			if (rules[i]) {
+				insert(uint16_t(i));
+			}
+		}
+	}
+
+	static constexpr const char *getName(const char *rule) {
+		if (rule[0] == '!') {
+			return rule + 1;
+		} else if (rule[0] == '*' && rule[1] == '.') {
+			return rule + 2;
+		}
+		return rule;
+	}
+
+	constexpr void insert(uint16_t ruleIdx) {
+		auto rule = _rules[ruleIdx];
+		uint8_t flags = Rule;
+		if (rule[0] == '!') {
+			flags = Exception;
+		} else if (rule[0] == '*' && rule[1] == '.') {
+			flags = Wildcard;
+		}
+
+		auto name = getName(rule);
+		auto len = length(name);
+		auto idx = hash(name, len) & (Size - 1);
+		while (slots[idx].rule && (slots[idx].len != len || !equal(getName(_rules[slots[idx].rule - 1]), name, len))) {
+			idx = (idx + 1) & (Size - 1);
+		}
+		if (!slots[idx].rule) {
+			slots[idx].rule = ruleIdx + 1;
+			slots[idx].len = uint8_t(len);
+		}
+		slots[idx].flags |= flags;
+	}
+
+	uint8_t find(StringView str) const {
+		if (str.size() > maxOf<uint8_t>()) {
+			return None;
+		}
+
+		auto idx = hash(str.data(), uint32_t(str.size())) & (Size - 1);
+		while (slots[idx].rule) {
+			if (slots[idx].len == str.size() && equal(getName(_rules[slots[idx].rule - 1]), str.data(), slots[idx].len)) {
+				return slots[idx].flags;
+			}
+			idx = (idx + 1) & (Size - 1);
+		}
+		return None;
+	}
+
+	const char * const *_rules = nullptr;
+	Slot slots[Size];
+};
+
+static constexpr const char *s_IdnTld[] = {
 // Generic IDN TLD
 	"موقع",
 	"كوم",
@@ -165,6 +285,20 @@ static const char *s_IdnTld[] = {
 	nullptr
 };
 
+static constexpr UrlHostTableData<512> s_IdnTldTable(s_IdnTld);
+
+// Full Public Suffix List exceeds compile time evaluation limits, so its table is filled on first use
+static constexpr size_t PublicSuffixTableSize = 32768;
+
+static const UrlHostTableData<PublicSuffixTableSize> &getPublicSuffixTable() {
+	static UrlHostTableData<PublicSuffixTableSize> s_table;
+	static std::once_flag s_flag;
+	std::call_once(s_flag, [] {
+		s_table.load(s_PublicSuffix);
+	});
+	return s_table;
+}
+
 }
 
 #endif /* COMMON_UTILS_SPURLTLD_HPP_ */
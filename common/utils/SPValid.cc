@@ -22,6 +22,11 @@ THE SOFTWARE.
 
 #include "SPValid.h"
 #include "SPUrl.h"
+#include "SPRandom.h"
+
+#if MODULE_COMMON_THREADS
+#include "SPThreadTaskQueue.h"
+#endif
 
 #if MODULE_COMMON_IDN
 #include "SPIdn.h"
@@ -373,24 +378,7 @@ void makeRandomBytes_buf(uint8_t * buf, size_t count) {
 		ap_random_insecure_bytes(buf, count);
 	}
 #else
-	auto bytesInRand = 0;
-	size_t tmp = RAND_MAX;
-	while (tmp > 255) {
-		++ tmp;
-		tmp /= 256;
-	}
-
-	size_t b = bytesInRand;
-	size_t r = rand();
-	for (size_t i = 0; i < count; i++) {
-		buf[i] = (uint8_t)(r % 256);
-		r /= 256;
-		-- b;
-		if (b == 0) {
-			b = bytesInRand;
-			r = rand();
-		}
-	}
+	random::fill(buf, count);
 #endif
 }
 
@@ -412,44 +400,122 @@ auto makeRandomBytes<memory::StandartInterface>(size_t count) -> memory::Standar
 	return ret;
 }
 
-static void makePassword_buf(uint8_t *passwdKey, const StringView &str, const StringView &key) {
-	string::Sha512::Buf source = string::Sha512::make(str, Config_getInternalPasswordKey());
+// Serenity/3 protocol: version code, Argon2id parameters, salt and tag
+static constexpr size_t PASSWORD_ARGON2_HEADER_SIZE = 12;
+static constexpr size_t PASSWORD_ARGON2_SALT_SIZE = 16;
+static constexpr size_t PASSWORD_ARGON2_TAG_SIZE = 32;
+static constexpr size_t PASSWORD_ARGON2_SIZE = PASSWORD_ARGON2_HEADER_SIZE + PASSWORD_ARGON2_SALT_SIZE + PASSWORD_ARGON2_TAG_SIZE;
 
-	passwdKey[0] = 0; passwdKey[1] = 1; // version code
-	makeRandomBytes_buf(passwdKey + 2, 14);
+// parameters are read from stored hash, so cost of validation should be bounded
+static constexpr uint32_t PASSWORD_ARGON2_MAX_MEMORY = 1024 * 1024; // in KiB
+static constexpr uint32_t PASSWORD_ARGON2_MAX_ITERATIONS = 64;
 
-	string::Sha512 hash_ctx;
-	hash_ctx.update(passwdKey, 16);
-	if (!key.empty()) {
-		hash_ctx.update(key);
+// comparison time does not depend on position of first mismatch
+static bool comparePassword(const uint8_t *a, const uint8_t *b, size_t size) {
+	volatile uint8_t ret = 0;
+	for (size_t i = 0; i < size; ++ i) {
+		ret = ret | (a[i] ^ b[i]);
 	}
-	hash_ctx.update(source);
-	hash_ctx.final(passwdKey + 16);
+	return ret == 0;
+}
+
+static bool isPasswordParamsValid(const PasswordParams &params) {
+	return params.lanes > 0 && params.lanes <= 0xFF
+			&& params.memory <= PASSWORD_ARGON2_MAX_MEMORY
+			&& params.iterations > 0 && params.iterations <= PASSWORD_ARGON2_MAX_ITERATIONS;
+}
+
+static void makePassword_store32(uint8_t *buf, uint32_t value) {
+	for (size_t i = 0; i < 4; ++ i) {
+		buf[i] = uint8_t(value >> (8 * i));
+	}
+}
+
+static uint32_t makePassword_load32(const uint8_t *buf) {
+	return uint32_t(buf[0]) | (uint32_t(buf[1]) << 8) | (uint32_t(buf[2]) << 16) | (uint32_t(buf[3]) << 24);
+}
+
+static bool readPasswordParams(const BytesView &passwd, PasswordParams &params) {
+	if (passwd.size() != PASSWORD_ARGON2_SIZE || passwd[0] != 0 || passwd[1] != 2 || passwd[3] != 0) {
+		return false;
+	}
+
+	params.lanes = passwd[2];
+	params.memory = makePassword_load32(passwd.data() + 4);
+	params.iterations = makePassword_load32(passwd.data() + 8);
+	return isPasswordParamsValid(params);
+}
+
+static bool makePassword_buf(uint8_t *passwdKey, const StringView &str, const StringView &key, const PasswordParams &params) {
+	if (!isPasswordParamsValid(params)) {
+		return false;
+	}
+
+	passwdKey[0] = 0; passwdKey[1] = 2; // version code
+	passwdKey[2] = uint8_t(params.lanes);
+	passwdKey[3] = 0;
+	makePassword_store32(passwdKey + 4, params.memory);
+	makePassword_store32(passwdKey + 8, params.iterations);
+
+	auto salt = passwdKey + PASSWORD_ARGON2_HEADER_SIZE;
+	makeRandomBytes_buf(salt, PASSWORD_ARGON2_SALT_SIZE);
+
+	return crypto::argon2id(salt + PASSWORD_ARGON2_SALT_SIZE, PASSWORD_ARGON2_TAG_SIZE, str,
+			BytesView(salt, PASSWORD_ARGON2_SALT_SIZE), params, key);
 }
 
 template <>
-auto makePassword<memory::PoolInterface>(const StringView &str, const StringView &key) -> memory::PoolInterface::BytesType {
+auto makePassword<memory::PoolInterface>(const StringView &str, const StringView &key, const PasswordParams &params) -> memory::PoolInterface::BytesType {
 	if (str.empty() || key.empty()) {
 		return memory::PoolInterface::BytesType();
 	}
 
-	memory::PoolInterface::BytesType passwdKey; passwdKey.resize(16 + string::Sha512::Length);
-	makePassword_buf(passwdKey.data(), str, key);
+	memory::PoolInterface::BytesType passwdKey; passwdKey.resize(PASSWORD_ARGON2_SIZE);
+	if (!makePassword_buf(passwdKey.data(), str, key, params)) {
+		return memory::PoolInterface::BytesType();
+	}
 	return passwdKey;
 }
 
 template <>
-auto makePassword<memory::StandartInterface>(const StringView &str, const StringView &key) -> memory::StandartInterface::BytesType {
+auto makePassword<memory::StandartInterface>(const StringView &str, const StringView &key, const PasswordParams &params) -> memory::StandartInterface::BytesType {
 	if (str.empty() || key.empty()) {
 		return memory::StandartInterface::BytesType();
 	}
 
-	memory::StandartInterface::BytesType passwdKey; passwdKey.resize(16 + string::Sha512::Length);
-	makePassword_buf(passwdKey.data(), str, key);
+	memory::StandartInterface::BytesType passwdKey; passwdKey.resize(PASSWORD_ARGON2_SIZE);
+	if (!makePassword_buf(passwdKey.data(), str, key, params)) {
+		return memory::StandartInterface::BytesType();
+	}
 	return passwdKey;
 }
 
+template <>
+auto makePassword<memory::PoolInterface>(const StringView &str, const StringView &key) -> memory::PoolInterface::BytesType {
+	return makePassword<memory::PoolInterface>(str, key, PasswordParams());
+}
+
+template <>
+auto makePassword<memory::StandartInterface>(const StringView &str, const StringView &key) -> memory::StandartInterface::BytesType {
+	return makePassword<memory::StandartInterface>(str, key, PasswordParams());
+}
+
 bool validatePassord(const StringView &str, const BytesView &passwd, const StringView &key) {
+	PasswordParams params;
+	if (readPasswordParams(passwd, params)) {
+		// Serenity/3 protocol, lanes are processed in parallel, when possible
+		params.threads = std::min(params.lanes, std::max(std::thread::hardware_concurrency(), 1U));
+
+		uint8_t controlKey[PASSWORD_ARGON2_TAG_SIZE] = { 0 };
+		auto salt = passwd.sub(PASSWORD_ARGON2_HEADER_SIZE, PASSWORD_ARGON2_SALT_SIZE);
+		if (!crypto::argon2id(controlKey, PASSWORD_ARGON2_TAG_SIZE, str, salt, params, key)) {
+			return false;
+		}
+
+		return comparePassword(passwd.data() + PASSWORD_ARGON2_HEADER_SIZE + PASSWORD_ARGON2_SALT_SIZE,
+				controlKey, PASSWORD_ARGON2_TAG_SIZE);
+	}
+
 	if (passwd.size() < 8 + string::Sha256::Length) {
 		return false; // not a password
 	}
@@ -471,7 +537,7 @@ bool validatePassord(const StringView &str, const BytesView &passwd, const Strin
 		}
 		hash_ctx.final(controlKey + 8);
 
-		if (memcmp(passwdKey + 8, controlKey + 8, string::Sha256::Length) == 0) {
+		if (comparePassword(passwdKey + 8, controlKey + 8, string::Sha256::Length)) {
 			return true;
 		} else {
 			return false;
@@ -496,13 +562,51 @@ bool validatePassord(const StringView &str, const BytesView &passwd, const Strin
 	hash_ctx.update(source);
 	hash_ctx.final(controlKey + 16);
 
-	if (memcmp(passwd.data() + 16, controlKey + 16, string::Sha512::Length) == 0) {
+	if (comparePassword(passwd.data() + 16, controlKey + 16, string::Sha512::Length)) {
 		return true;
 	} else {
 		return false;
 	}
 }
 
+bool isPasswordUpgradeRequired(const BytesView &passwd, const PasswordParams &target) {
+	PasswordParams params;
+	if (!readPasswordParams(passwd, params)) {
+		return true;
+	}
+	return params.memory < target.memory || params.iterations < target.iterations || params.lanes < target.lanes;
+}
+
+#if MODULE_COMMON_THREADS
+void validatePassord(thread::TaskQueue &queue, const StringView &str, const BytesView &passwd, const StringView &key,
+		std::function<void(bool)> &&cb) {
+	struct Request {
+		std::string str;
+		std::string key;
+		std::vector<uint8_t> passwd;
+		std::function<void(bool)> callback;
+		bool result = false;
+
+		~Request() {
+			memset(str.data(), 0, str.size());
+		}
+	};
+
+	auto req = std::make_shared<Request>();
+	req->str = str.str<memory::StandartInterface>();
+	req->key = key.str<memory::StandartInterface>();
+	req->passwd = passwd.bytes<memory::StandartInterface>();
+	req->callback = move(cb);
+
+	queue.perform(Rc<thread::Task>::create([req] (const thread::Task &) {
+		req->result = validatePassord(req->str, req->passwd, req->key);
+		return true;
+	}, [req] (const thread::Task &, bool) {
+		req->callback(req->result);
+	}));
+}
+#endif
+
 #define PSWD_NUMBERS "12345679"
 #define PSWD_LOWER "abcdefghijkmnopqrstuvwxyz"
 #define PSWD_UPPER "ABCDEFGHJKLMNPQRSTUVWXYZ"
@@ -25,9 +25,21 @@ THE SOFTWARE.
 
 #include "SPCommon.h"
 #include "SPStringView.h"
+#include "SPSha.h"
+
+#if MODULE_COMMON_THREADS
+namespace stappler::thread {
+
+class TaskQueue;
+
+}
+#endif
 
 namespace stappler::valid {
 
+// Argon2id cost parameters for new passwords
+using PasswordParams = crypto::Argon2Params;
+
 /** Identifier starts with [a-zA-Z_] and can contain [a-zA-Z0-9_\-.@] */
 bool validateIdentifier(StringView str);
 
@@ -50,11 +62,26 @@ void makeRandomBytes(uint8_t *, size_t);
 template <typename Interface>
 auto makeRandomBytes(size_t) -> typename Interface::BytesType;
 
+/* Password hash with Argon2id and default parameters; parameters are stored within hash,
+ * so they can be changed without invalidation of existing passwords */
 template <typename Interface>
 auto makePassword(const StringView &str, const StringView &key = StringView()) -> typename Interface::BytesType;
 
+template <typename Interface>
+auto makePassword(const StringView &str, const StringView &key, const PasswordParams &) -> typename Interface::BytesType;
+
+// Validates both Argon2id and legacy SHA-512 passwords
 bool validatePassord(const StringView &str, const BytesView &passwd, const StringView &key = StringView());
 
+// Legacy passwords, and passwords, hashed with lower cost, should be rehashed after successful validation
+bool isPasswordUpgradeRequired(const BytesView &passwd, const PasswordParams & = PasswordParams());
+
+#if MODULE_COMMON_THREADS
+// Validates password on queue worker, callback is called on queue's main thread
+void validatePassord(thread::TaskQueue &, const StringView &str, const BytesView &passwd, const StringView &key,
+		std::function<void(bool)> &&);
+#endif
+
 // Minimal length is 6
 template <typename Interface>
 auto generatePassword(size_t len) -> typename Interface::StringType;
@@ -31,6 +31,10 @@ GLOBAL_CFLAGS := -g -DDEBUG \
 	$(OSTYPE_CFLAGS) $(GLOBAL_CFLAGS)
 endif # ifdef RELEASE
 
+ifeq ($(SP_REF_DEBUG),1)
+GLOBAL_CFLAGS := $(GLOBAL_CFLAGS) -DSP_REF_DEBUG=1
+endif
+
 GLOBAL_STDXX = gnu++2a
 GLOBAL_STD = gnu11
 
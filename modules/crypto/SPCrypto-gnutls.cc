@@ -99,135 +99,155 @@ static gnutls_sign_algorithm_t getAlgo(SignAlgorithm a) {
 	case SignAlgorithm::RSA_SHA512: return GNUTLS_SIGN_RSA_SHA512; break;
 	case SignAlgorithm::ECDSA_SHA256: return GNUTLS_SIGN_ECDSA_SHA256; break;
 	case SignAlgorithm::ECDSA_SHA512: return GNUTLS_SIGN_ECDSA_SHA512; break;
+	case SignAlgorithm::EDDSA_ED25519: return GNUTLS_SIGN_EDDSA_ED25519; break;
 	}
 	return GNUTLS_SIGN_UNKNOWN;
 }
 
+static KeyType getKeyType(int algo) {
+	switch (algo) {
+	case GNUTLS_PK_RSA: return KeyType::RSA; break;
+	case GNUTLS_PK_DSA: return KeyType::DSA; break;
+	case GNUTLS_PK_ECDSA: return KeyType::ECDSA; break;
+	case GNUTLS_PK_EDDSA_ED25519: return KeyType::EDDSA_ED25519; break;
+	default: break;
+	}
+	return KeyType::Unknown;
+}
+
 static constexpr size_t DATA_ALIGN_BOUNDARY ( 16 );
 
-static bool doEncryptAes(const AesKey &key, BytesView d, size_t dataSize, BytesView output, uint32_t version) {
-	memcpy((uint8_t *)output.data(), &dataSize, sizeof(dataSize));
-	memcpy((uint8_t *)output.data() + 8, &version, sizeof(version));
-	memcpy((uint8_t *)output.data() + 16, d.data(), d.size());
+// AEAD handle keeps expanded key, so it is reused per thread while key is not changed
+struct GnuTLSThreadContext {
+	static GnuTLSThreadContext &get() {
+		static thread_local GnuTLSThreadContext tl_context;
+		return tl_context;
+	}
 
-	uint8_t iv[16] = { 0 };
-	gnutls_datum_t ivData;
-	ivData.data = (unsigned char *)iv;
-	ivData.size = (unsigned int)16;
+	~GnuTLSThreadContext() {
+		release();
+	}
 
-	gnutls_datum_t keyData;
-	keyData.data = (unsigned char *)key.data();
-	keyData.size = (unsigned int)key.size();
+	gnutls_aead_cipher_hd_t acquire(BytesView key) {
+		if (aead && memcmp(aeadKey.data(), key.data(), aeadKey.size()) == 0) {
+			return aead;
+		}
 
-	auto algo = GNUTLS_CIPHER_AES_256_CBC;
+		release();
 
-	gnutls_cipher_hd_t aes;
-	auto err = gnutls_cipher_init(&aes, algo, &keyData, &ivData);
-	if (err != 0) {
-		std::cout << "Crypto: gnutls_cipher_init() = [" << err << "] " << gnutls_strerror(err) << "\n";
-		return false;
+		gnutls_datum_t keyData;
+		keyData.data = (unsigned char *)key.data();
+		keyData.size = (unsigned int)key.size();
+
+		auto err = gnutls_aead_cipher_init(&aead, GNUTLS_CIPHER_AES_256_GCM, &keyData);
+		if (err != 0) {
+			std::cout << "Crypto: gnutls_aead_cipher_init() = [" << err << "] " << gnutls_strerror(err) << "\n";
+			aead = nullptr;
+			return nullptr;
+		}
+		memcpy(aeadKey.data(), key.data(), aeadKey.size());
+		return aead;
 	}
 
-	size_t outSize = output.size() - 16;
-	err = gnutls_cipher_encrypt(aes, (uint8_t *)output.data() + 16, outSize);
-	if (err != 0) {
-		gnutls_cipher_deinit(aes);
-		std::cout << "Crypto: gnutls_cipher_encrypt() = [" << err << "] " << gnutls_strerror(err) << "\n";
-		return false;
+	void release() {
+		if (aead) {
+			gnutls_aead_cipher_deinit(aead);
+			aead = nullptr;
+		}
+		gnutls_memset(aeadKey.data(), 0, aeadKey.size());
 	}
 
-	gnutls_cipher_deinit(aes);
-	return true;
-}
-
-static bool doDecryptAes(const AesKey &key, BytesView val, BytesView output) {
-	uint8_t iv[16] = { 0 };
-	gnutls_datum_t ivData;
-	ivData.data = (unsigned char *)iv;
-	ivData.size = (unsigned int)16;
+	gnutls_aead_cipher_hd_t aead = nullptr;
+	std::array<uint8_t, 32> aeadKey;
+};
 
-	gnutls_datum_t keyData;
-	keyData.data = (unsigned char *)key.data();
-	keyData.size = (unsigned int)key.size();
-
-	auto algo = GNUTLS_CIPHER_AES_256_CBC;
+void clearThreadCache() {
+	clearThreadPrivateKeys();
+	GnuTLSThreadContext::get().release();
+}
 
-	gnutls_cipher_hd_t aes;
-	auto err = gnutls_cipher_init(&aes, algo, &keyData, &ivData);
-	if (err != 0) {
-		std::cout << "Crypto: gnutls_cipher_init() = [" << err << "] " << gnutls_strerror(err) << "\n";
+bool encryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, uint8_t *out, uint8_t *tag) {
+	if (key.size() != 32) {
 		return false;
 	}
 
-	err = gnutls_cipher_decrypt2(aes, val.data(), val.size(), (uint8_t *)output.data(), output.size());
-	if (err != 0) {
-		gnutls_cipher_deinit(aes);
-		std::cout << "Crypto: gnutls_pubkey_init() = [" << err << "] " << gnutls_strerror(err) << "\n";
+	auto &context = GnuTLSThreadContext::get();
+	auto aes = context.acquire(key);
+	if (!aes) {
 		return false;
 	}
 
-	gnutls_cipher_deinit(aes);
-	return true;
-}
-
-template <>
-auto encryptAes<memory::PoolInterface>(const AesKey &key, BytesView d, uint32_t version) -> memory::PoolInterface::BytesType {
-	auto dataSize = d.size();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
-	memory::PoolInterface::BytesType output; output.resize(blockSize + 16);
-
-	if (!doEncryptAes(key, d, dataSize, output, version)) {
-		return memory::PoolInterface::BytesType();
+	// data is encrypted in place, tag is written separately
+	if (out != data.data() && !data.empty()) {
+		memcpy(out, data.data(), data.size());
 	}
 
-	return output;
-}
-
-template <>
-auto encryptAes<memory::StandartInterface>(const AesKey &key, BytesView d, uint32_t version) -> memory::StandartInterface::BytesType {
-	auto dataSize = d.size();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
-	memory::StandartInterface::BytesType output; output.resize(blockSize + 16);
+	giovec_t auth = { (void *)aad.data(), aad.size() };
+	giovec_t iov = { (void *)out, data.size() };
+	size_t tagSize = DATA_ALIGN_BOUNDARY;
 
-	if (!doEncryptAes(key, d, dataSize, output, version)) {
-		return memory::StandartInterface::BytesType();
+	auto err = gnutls_aead_cipher_encryptv2(aes, iv.data(), iv.size(), &auth, aad.empty() ? 0 : 1,
+			&iov, data.empty() ? 0 : 1, tag, &tagSize);
+	if (err != 0) {
+		std::cout << "Crypto: gnutls_aead_cipher_encryptv2() = [" << err << "] " << gnutls_strerror(err) << "\n";
+		context.release();
+		return false;
 	}
-
-	return output;
+	return true;
 }
 
-template <>
-auto decryptAes<memory::PoolInterface>(const AesKey &key, BytesView val) -> memory::PoolInterface::BytesType {
-	auto dataSize = val.readUnsigned64();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
-
-	val.offset(8);
+bool decryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, BytesView tag, uint8_t *out) {
+	if (key.size() != 32 || tag.size() != DATA_ALIGN_BOUNDARY) {
+		return false;
+	}
 
-	memory::PoolInterface::BytesType output; output.resize(blockSize);
+	auto aes = GnuTLSThreadContext::get().acquire(key);
+	if (!aes) {
+		return false;
+	}
 
-	if (!doDecryptAes(key, val, output)) {
-		return memory::PoolInterface::BytesType();
+	if (out != data.data() && !data.empty()) {
+		memcpy(out, data.data(), data.size());
 	}
 
-	output.resize(dataSize);
-	return output;
+	giovec_t auth = { (void *)aad.data(), aad.size() };
+	giovec_t iov = { (void *)out, data.size() };
+
+	// fails with GNUTLS_E_DECRYPTION_FAILED, if authentication tag does not match
+	auto err = gnutls_aead_cipher_decryptv2(aes, iv.data(), iv.size(), &auth, aad.empty() ? 0 : 1,
+			&iov, data.empty() ? 0 : 1, (void *)tag.data(), tag.size());
+	return err == 0;
 }
 
-template <>
-auto decryptAes<memory::StandartInterface>(const AesKey &key, BytesView val) -> memory::StandartInterface::BytesType {
-	auto dataSize = val.readUnsigned64();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
+bool decryptAesCbc(BytesView key, BytesView val, uint8_t *output) {
+	if (key.size() != 32 || val.size() % DATA_ALIGN_BOUNDARY != 0) {
+		return false;
+	}
 
-	val.offset(8);
+	uint8_t iv[16] = { 0 };
+	gnutls_datum_t ivData;
+	ivData.data = (unsigned char *)iv;
+	ivData.size = (unsigned int)16;
 
-	memory::StandartInterface::BytesType output; output.resize(blockSize);
+	gnutls_datum_t keyData;
+	keyData.data = (unsigned char *)key.data();
+	keyData.size = (unsigned int)key.size();
 
-	if (!doDecryptAes(key, val, output)) {
-		return memory::StandartInterface::BytesType();
+	gnutls_cipher_hd_t aes;
+	auto err = gnutls_cipher_init(&aes, GNUTLS_CIPHER_AES_256_CBC, &keyData, &ivData);
+	if (err != 0) {
+		std::cout << "Crypto: gnutls_cipher_init() = [" << err << "] " << gnutls_strerror(err) << "\n";
+		return false;
 	}
 
-	output.resize(dataSize);
-	return output;
+	// gnutls does not remove padding, caller knows data size
+	err = gnutls_cipher_decrypt2(aes, val.data(), val.size(), output, val.size());
+	gnutls_cipher_deinit(aes);
+	if (err != 0) {
+		std::cout << "Crypto: gnutls_cipher_decrypt2() = [" << err << "] " << gnutls_strerror(err) << "\n";
+		return false;
+	}
+	return true;
 }
 
 PrivateKey::PrivateKey() {
@@ -272,6 +292,36 @@ bool PrivateKey::generate(KeyBits bits) {
 	return false;
 }
 
+bool PrivateKey::generate(KeyType type) {
+	switch (type) {
+	case KeyType::RSA:
+		return generate(KeyBits::_2048);
+		break;
+	case KeyType::EDDSA_ED25519:
+		break;
+	default:
+		return false;
+		break;
+	}
+
+	if (_valid && !_loaded) {
+		auto err = gnutls_privkey_generate(_key, GNUTLS_PK_EDDSA_ED25519, 256, 0);
+		if (err == GNUTLS_E_SUCCESS) {
+			_loaded = true;
+			return true;
+		} else {
+			gnutls_privkey_deinit( _key );
+			_valid = false;
+		}
+	}
+
+	return false;
+}
+
+KeyType PrivateKey::getType() const {
+	return _loaded ? getKeyType(gnutls_privkey_get_pk_algorithm(_key, nullptr)) : KeyType::Unknown;
+}
+
 bool PrivateKey::import(BytesView data, const CoderSource &passwd) {
 	if (_valid && !_loaded) {
 		gnutls_datum_t keyData;
@@ -385,6 +435,10 @@ PublicKey::~PublicKey() {
 	}
 }
 
+KeyType PublicKey::getType() const {
+	return _loaded ? getKeyType(gnutls_pubkey_get_pk_algorithm(_key, nullptr)) : KeyType::Unknown;
+}
+
 bool PublicKey::import(BytesView data) {
 	if (_valid && !_loaded) {
 		gnutls_datum_t keyData;
@@ -57,68 +57,235 @@ static void logOpenSSLErrors() {
     ERR_clear_error();
 }
 
-bool encryptAes(const AesKey &key, BytesView d, const Callback<void(const uint8_t *, size_t)> &cb) {
-	auto dataSize = d.size();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
+// Unique for every key object, so cached contexts never match another key on the same address
+static std::atomic<uint64_t> s_openSSLKeyId = 0;
+
+// Per-thread reusable contexts: cipher contexts keep expanded key schedule while key is not changed,
+// digest contexts, initialized with key and algorithm, are copied instead of full initialization
+struct OpenSSLThreadContext {
+	static constexpr size_t DigestTemplates = 8;
+
+	struct CipherContext {
+		EVP_CIPHER_CTX *ctx = nullptr;
+		std::array<uint8_t, 32> key;
+		size_t ivSize = 0; // 0 when cipher is not initialized
+		bool hasKey = false;
+	};
 
-	uint8_t output[blockSize + 16];
-	memcpy(output, &dataSize, sizeof(dataSize));
-	memcpy(output + 8, &key.version, sizeof(key.version));
+	struct DigestTemplate {
+		uint64_t id = 0; // id of key object, 0 for empty template
+		EVP_MD_CTX *ctx = nullptr;
+		SignAlgorithm algo = SignAlgorithm::RSA_SHA256;
+		bool sign = false;
+		bool copyable = true;
+	};
 
-	uint8_t iv[16] = { 0 };
-	EVP_CIPHER_CTX *en = nullptr;
+	static OpenSSLThreadContext &get() {
+		static thread_local OpenSSLThreadContext tl_context;
+		return tl_context;
+	}
+
+	// does not create context, can be used from destructors on thread exit
+	static OpenSSLThreadContext *current() {
+		return tl_current;
+	}
+
+	static thread_local OpenSSLThreadContext *tl_current;
+
+	OpenSSLThreadContext() {
+		tl_current = this;
+	}
+
+	~OpenSSLThreadContext() {
+		tl_current = nullptr;
+		for (auto c : { &encrypt, &decrypt }) {
+			if (c->ctx) {
+				EVP_CIPHER_CTX_free(c->ctx);
+			}
+			OPENSSL_cleanse(c->key.data(), c->key.size());
+		}
+		for (auto &it : templates) {
+			releaseTemplate(it);
+		}
+		if (digest) {
+			EVP_MD_CTX_free(digest);
+		}
+	}
+
+	EVP_CIPHER_CTX *acquireCipher(bool enc, BytesView key, BytesView iv) {
+		auto &c = enc ? encrypt : decrypt;
+		if (!c.ctx) {
+			c.ctx = EVP_CIPHER_CTX_new();
+			if (!c.ctx) {
+				return nullptr;
+			}
+		}
+
+		bool sameKey = c.hasKey && c.ivSize == iv.size() && memcmp(c.key.data(), key.data(), c.key.size()) == 0;
+		if (!sameKey) {
+			c.hasKey = false;
+			if ((c.ivSize == 0 && !EVP_CipherInit_ex(c.ctx, EVP_aes_256_gcm(), NULL, NULL, NULL, enc ? 1 : 0))
+					|| !EVP_CIPHER_CTX_ctrl(c.ctx, EVP_CTRL_GCM_SET_IVLEN, int(iv.size()), NULL)) {
+				resetCipher(enc);
+				return nullptr;
+			}
+			c.ivSize = iv.size();
+		}
+
+		// with NULL key only IV is updated, expanded key is reused
+		if (!EVP_CipherInit_ex(c.ctx, NULL, NULL, sameKey ? NULL : key.data(), iv.data(), enc ? 1 : 0)) {
+			resetCipher(enc);
+			return nullptr;
+		}
+
+		if (!sameKey) {
+			memcpy(c.key.data(), key.data(), c.key.size());
+			c.hasKey = true;
+		}
+		return c.ctx;
+	}
+
+	void resetCipher(bool enc) {
+		auto &c = enc ? encrypt : decrypt;
+		if (c.ctx) {
+			EVP_CIPHER_CTX_reset(c.ctx);
+		}
+		OPENSSL_cleanse(c.key.data(), c.key.size());
+		c.ivSize = 0;
+		c.hasKey = false;
+	}
+
+	EVP_MD_CTX *acquireDigest(EVP_PKEY *key, uint64_t id, SignAlgorithm algo, bool sign);
+
+	void releaseTemplate(DigestTemplate &t) {
+		if (t.ctx) {
+			EVP_MD_CTX_free(t.ctx);
+			t.ctx = nullptr;
+		}
+		t.id = 0;
+	}
+
+	// templates keep key referenced, so they are released with key object
+	void releaseKey(uint64_t id) {
+		for (auto &it : templates) {
+			if (it.id == id) {
+				releaseTemplate(it);
+			}
+		}
+		if (digest) {
+			EVP_MD_CTX_reset(digest);
+		}
+	}
+
+	void clear() {
+		resetCipher(true);
+		resetCipher(false);
+		for (auto &it : templates) {
+			releaseTemplate(it);
+		}
+		if (digest) {
+			EVP_MD_CTX_reset(digest);
+		}
+	}
+
+	CipherContext encrypt;
+	CipherContext decrypt;
+	EVP_MD_CTX *digest = nullptr;
+	std::array<DigestTemplate, DigestTemplates> templates;
+	size_t nextTemplate = 0;
+};
+
+thread_local OpenSSLThreadContext *OpenSSLThreadContext::tl_current = nullptr;
+
+void clearThreadCache() {
+	clearThreadPrivateKeys();
+	if (auto ctx = OpenSSLThreadContext::current()) {
+		ctx->clear();
+	}
+}
+
+bool encryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, uint8_t *out, uint8_t *tag) {
+	if (key.size() != 32) {
+		return false;
+	}
+
+	auto &context = OpenSSLThreadContext::get();
+	auto en = context.acquireCipher(true, key, iv);
+	if (!en) {
+		return false;
+	}
 
 	auto finalize = [&] (bool value) {
-		if (en) {
-			EVP_CIPHER_CTX_free(en);
-			en = nullptr;
+		if (!value) {
+			context.resetCipher(true);
 		}
 		return value;
 	};
 
-	en = EVP_CIPHER_CTX_new();
-	if (!en) {
+	int outSize = 0;
+	if (!aad.empty() && !EVP_EncryptUpdate(en, NULL, &outSize, aad.data(), int(aad.size()))) {
 		return finalize(false);
 	}
 
-	if (!EVP_EncryptInit_ex(en, EVP_aes_256_cbc(), NULL, key.data.data(), iv)) {
+	if (!data.empty()) {
+		if (!EVP_EncryptUpdate(en, out, &outSize, data.data(), int(data.size()))) {
+			return finalize(false);
+		}
+		out += outSize;
+	}
+
+	if (!EVP_EncryptFinal_ex(en, out, &outSize)
+			|| !EVP_CIPHER_CTX_ctrl(en, EVP_CTRL_GCM_GET_TAG, DATA_ALIGN_BOUNDARY, tag)) {
 		return finalize(false);
 	}
 
-	auto target = d.data();
-	auto targetSize = d.size();
-	auto out = output + 16;
+	return finalize(true);
+}
+
+bool decryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, BytesView tag, uint8_t *out) {
+	if (key.size() != 32 || tag.size() != DATA_ALIGN_BOUNDARY) {
+		return false;
+	}
+
+	auto &context = OpenSSLThreadContext::get();
+	auto de = context.acquireCipher(false, key, iv);
+	if (!de) {
+		return false;
+	}
+
+	auto finalize = [&] (bool value) {
+		if (!value) {
+			context.resetCipher(false);
+		}
+		return value;
+	};
 
 	int outSize = 0;
-	while (targetSize > 0) {
-		if (!EVP_EncryptUpdate(en, out, &outSize,target, targetSize)) {
+	if (!aad.empty() && !EVP_DecryptUpdate(de, NULL, &outSize, aad.data(), int(aad.size()))) {
+		return finalize(false);
+	}
+
+	if (!data.empty()) {
+		if (!EVP_DecryptUpdate(de, out, &outSize, data.data(), int(data.size()))) {
 			return finalize(false);
 		}
-
 		out += outSize;
-		target += outSize;
-		if (int(targetSize) > outSize) {
-			targetSize -= outSize;
-		} else {
-			targetSize = 0;
-		}
 	}
 
-	if (!EVP_EncryptFinal(en, out, &outSize)) {
+	// final step fails, if authentication tag does not match
+	if (!EVP_CIPHER_CTX_ctrl(de, EVP_CTRL_GCM_SET_TAG, int(tag.size()), (void *)tag.data())
+			|| EVP_DecryptFinal_ex(de, out, &outSize) <= 0) {
 		return finalize(false);
 	}
 
-	cb(output, blockSize + 16);
 	return finalize(true);
 }
 
-bool decryptAes(const AesKey &key, BytesView d, const Callback<void(const uint8_t *, size_t)> &cb) {
-	auto dataSize = d.readUnsigned64();
-	auto blockSize = math::align<size_t>(dataSize, DATA_ALIGN_BOUNDARY);
-
-	d.offset(8); // skip version data
+bool decryptAesCbc(BytesView key, BytesView d, uint8_t *output) {
+	if (key.size() != 32 || d.size() % DATA_ALIGN_BOUNDARY != 0) {
+		return false;
+	}
 
-	uint8_t output[blockSize + 16];
 	uint8_t iv[16] = { 0 };
 	EVP_CIPHER_CTX *de = nullptr;
 
@@ -135,42 +302,46 @@ bool decryptAes(const AesKey &key, BytesView d, const Callback<void(const uint8_
 		return finalize(false);
 	}
 
-	if (!EVP_DecryptInit_ex(de, EVP_aes_256_cbc(), NULL, key.data.data(), iv)) {
+	if (!EVP_DecryptInit_ex(de, EVP_aes_256_cbc(), NULL, key.data(), iv)) {
 		return finalize(false);
 	}
 
+	// legacy blocks has no complete padding block, so padding is not checked, caller knows data size
+	EVP_CIPHER_CTX_set_padding(de, 0);
+
 	auto target = d.data();
 	auto targetSize = d.size();
 	auto out = output;
 
 	int outSize = 0;
 	while (targetSize > 0) {
-		if (!EVP_DecryptUpdate(de, out, &outSize, target, targetSize)) {
+		auto chunk = std::min(targetSize, size_t(1_GiB));
+		if (!EVP_DecryptUpdate(de, out, &outSize, target, int(chunk))) {
 			return finalize(false);
 		}
 
 		out += outSize;
-		target += outSize;
-		if (int(targetSize) > outSize) {
-			targetSize -= outSize;
-		} else {
-			targetSize = 0;
-		}
+		target += chunk;
+		targetSize -= chunk;
 	}
 
-	EVP_DecryptFinal(de, out, &outSize); // gives false-positive error
+	if (!EVP_DecryptFinal_ex(de, out, &outSize)) {
+		return finalize(false);
+	}
 
-	cb(output, dataSize);
 	return finalize(true);
 }
 
-PrivateKey::PrivateKey() : _valid(true), _key(nullptr) { }
+PrivateKey::PrivateKey() : _valid(true), _key(nullptr), _id(++ s_openSSLKeyId) { }
 
-PrivateKey::PrivateKey(BytesView data, const CoderSource &str) : _valid(true), _key(nullptr) {
+PrivateKey::PrivateKey(BytesView data, const CoderSource &str) : _valid(true), _key(nullptr), _id(++ s_openSSLKeyId) {
 	import(data, str);
 }
 
 PrivateKey::~PrivateKey() {
+	if (auto ctx = OpenSSLThreadContext::current()) {
+		ctx->releaseKey(_id);
+	}
 	if (_key) {
 		EVP_PKEY_free( _key );
 		_key = nullptr;
@@ -178,6 +349,121 @@ PrivateKey::~PrivateKey() {
 	}
 }
 
+static KeyType getOpenSSLKeyType(const EVP_PKEY *key) {
+	if (!key) {
+		return KeyType::Unknown;
+	}
+
+	switch (EVP_PKEY_base_id(key)) {
+	case EVP_PKEY_RSA: return KeyType::RSA; break;
+	case EVP_PKEY_DSA: return KeyType::DSA; break;
+	case EVP_PKEY_EC: return KeyType::ECDSA; break;
+	case EVP_PKEY_ED25519: return KeyType::EDDSA_ED25519; break;
+	default: break;
+	}
+	return KeyType::Unknown;
+}
+
+// EdDSA does not support streaming, so message is signed with one-shot functions
+static bool initOpenSSLDigest(EVP_MD_CTX *mdctx, EVP_PKEY *key, SignAlgorithm algo, bool sign) {
+	const EVP_MD *md = nullptr;
+	switch (algo) {
+	case SignAlgorithm::RSA_SHA256:
+	case SignAlgorithm::ECDSA_SHA256:
+		md = EVP_sha256();
+		break;
+	case SignAlgorithm::RSA_SHA512:
+	case SignAlgorithm::ECDSA_SHA512:
+		md = EVP_sha512();
+		break;
+	case SignAlgorithm::EDDSA_ED25519:
+		if (getOpenSSLKeyType(key) != KeyType::EDDSA_ED25519) {
+			return false;
+		}
+		break;
+	}
+
+	if (sign) {
+		return EVP_DigestSignInit(mdctx, NULL, md, NULL, key) == 1;
+	} else {
+		return EVP_DigestVerifyInit(mdctx, NULL, md, NULL, key) == 1;
+	}
+}
+
+EVP_MD_CTX *OpenSSLThreadContext::acquireDigest(EVP_PKEY *key, uint64_t id, SignAlgorithm algo, bool sign) {
+	if (!key) {
+		return nullptr;
+	}
+
+	if (!digest) {
+		digest = EVP_MD_CTX_new();
+		if (!digest) {
+			return nullptr;
+		}
+	}
+
+	DigestTemplate *t = nullptr;
+	for (auto &it : templates) {
+		if (it.id == id && it.algo == algo && it.sign == sign) {
+			t = &it;
+			break;
+		}
+	}
+
+	if (!t) {
+		auto ctx = EVP_MD_CTX_new();
+		if (!ctx || !initOpenSSLDigest(ctx, key, algo, sign)) {
+			if (ctx) {
+				EVP_MD_CTX_free(ctx);
+			}
+			return nullptr;
+		}
+
+		t = &templates[nextTemplate];
+		nextTemplate = (nextTemplate + 1) % templates.size();
+
+		releaseTemplate(*t);
+		t->id = id;
+		t->ctx = ctx;
+		t->algo = algo;
+		t->sign = sign;
+		t->copyable = true;
+	}
+
+	if (t->copyable) {
+		if (EVP_MD_CTX_copy_ex(digest, t->ctx)) {
+			return digest;
+		}
+		// some providers can not duplicate initialized context, do not try it again
+		ERR_clear_error();
+		t->copyable = false;
+	}
+
+	EVP_MD_CTX_reset(digest);
+	if (!initOpenSSLDigest(digest, key, algo, sign)) {
+		return nullptr;
+	}
+	return digest;
+}
+
+static bool verifyOpenSSLDigest(EVP_PKEY *key, uint64_t id, const CoderSource &data, BytesView signature, SignAlgorithm algo) {
+	EVP_MD_CTX *mdctx = OpenSSLThreadContext::get().acquireDigest(key, id, algo, false);
+	if (!mdctx) {
+		return false;
+	}
+
+	if (algo == SignAlgorithm::EDDSA_ED25519) {
+		return EVP_DigestVerify(mdctx, signature.data(), signature.size(), data.data(), data.size()) == 1;
+	}
+
+	/* Initialize `key` with a public key */
+	if (!EVP_DigestVerifyUpdate(mdctx, data.data(), data.size())) {
+		return false;
+	}
+
+	return EVP_DigestVerifyFinal(mdctx, signature.data(), signature.size()) == 1;
+}
+
 bool PrivateKey::generate(KeyBits bits) {
 	EVP_PKEY_CTX *kctx = nullptr;
 	auto finalize = [&] (bool value) {
@@ -216,6 +502,53 @@ bool PrivateKey::generate(KeyBits bits) {
 	return finalize(false);
 }
 
+bool PrivateKey::generate(KeyType type) {
+	switch (type) {
+	case KeyType::RSA:
+		return generate(KeyBits::_2048);
+		break;
+	case KeyType::EDDSA_ED25519:
+		break;
+	default:
+		return false;
+		break;
+	}
+
+	EVP_PKEY_CTX *kctx = nullptr;
+	auto finalize = [&] (bool value) {
+		if (kctx) {
+			EVP_PKEY_CTX_free(kctx);
+			kctx = nullptr;
+		}
+		if (!value) {
+			_valid = false;
+			_key = nullptr;
+		}
+		return value;
+	};
+
+	if (_valid && !_loaded) {
+		kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, NULL);
+		if (!kctx) {
+			return finalize(false);
+		}
+
+		if (!EVP_PKEY_keygen_init(kctx)) {
+			return finalize(false);
+		}
+
+		if (EVP_PKEY_keygen(kctx, &_key)) {
+			_loaded = true;
+			return finalize(true);
+		}
+	}
+	return finalize(false);
+}
+
+KeyType PrivateKey::getType() const {
+	return getOpenSSLKeyType(_key);
+}
+
 bool PrivateKey::import(BytesView data, const CoderSource &passwd) {
 	BIO *bioData = nullptr;
 
@@ -379,15 +712,11 @@ bool PrivateKey::exportDer(const Callback<void(const uint8_t *, size_t)> &cb, Ke
 }
 
 bool PrivateKey::sign(const Callback<void(const uint8_t *, size_t)> &cb, CoderSource data, SignAlgorithm algo) const {
-	EVP_MD_CTX *mdctx =  EVP_MD_CTX_create();
+	EVP_MD_CTX *mdctx = OpenSSLThreadContext::get().acquireDigest(_key, _id, algo, true);
 	unsigned char *sigdata = nullptr;
 	size_t siglen = 0;
 
 	auto cleanup = [&] (bool value) {
-		if (mdctx) {
-			EVP_MD_CTX_destroy(mdctx);
-			mdctx = nullptr;
-		}
 		if (sigdata) {
 			OPENSSL_free(sigdata);
 			sigdata = nullptr;
@@ -399,19 +728,16 @@ bool PrivateKey::sign(const Callback<void(const uint8_t *, size_t)> &cb, CoderSo
 		return cleanup(false);
 	}
 
-	switch (algo) {
-	case SignAlgorithm::RSA_SHA256:
-	case SignAlgorithm::ECDSA_SHA256:
-		if (1 != EVP_DigestSignInit(mdctx, NULL, EVP_sha256(), NULL, _key)) {
-			return cleanup(false);
-		}
-		break;
-	case SignAlgorithm::RSA_SHA512:
-	case SignAlgorithm::ECDSA_SHA512:
-		if (1 != EVP_DigestSignInit(mdctx, NULL, EVP_sha512(), NULL, _key)) {
-			return cleanup(false);
+	if (algo == SignAlgorithm::EDDSA_ED25519) {
+		if (1 == EVP_DigestSign(mdctx, NULL, &siglen, data.data(), data.size())) {
+			if ((sigdata = (unsigned char *)OPENSSL_malloc(sizeof(unsigned char) * siglen))) {
+				if (1 == EVP_DigestSign(mdctx, sigdata, &siglen, data.data(), data.size())) {
+					cb(sigdata, siglen);
+					return cleanup(true);
+				}
+			}
 		}
-		break;
+		return cleanup(false);
 	}
 
 	/* Call update with the message */
@@ -420,7 +746,7 @@ bool PrivateKey::sign(const Callback<void(const uint8_t *, size_t)> &cb, CoderSo
 	}
 
 	if (1 == EVP_DigestSignFinal(mdctx, (unsigned char *)NULL, &siglen)) {
-		if (auto sigdata = (unsigned char *)OPENSSL_malloc(sizeof(unsigned char) * siglen)) {
+		if ((sigdata = (unsigned char *)OPENSSL_malloc(sizeof(unsigned char) * siglen))) {
 			if (1 == EVP_DigestSignFinal(mdctx, sigdata, &siglen)) {
 				cb(sigdata, siglen);
 				return cleanup(true);
@@ -432,64 +758,27 @@ bool PrivateKey::sign(const Callback<void(const uint8_t *, size_t)> &cb, CoderSo
 }
 
 bool PrivateKey::verify(CoderSource data, BytesView signature, SignAlgorithm algo) const {
-	EVP_MD_CTX *mdctx =  EVP_MD_CTX_create();
-
-	auto cleanup = [&] (bool value) {
-		if (mdctx) {
-			EVP_MD_CTX_destroy(mdctx);
-			mdctx = nullptr;
-		}
-		return value;
-	};
-
-	if (!mdctx) {
-		return cleanup(false);
-	}
-
-	switch (algo) {
-	case SignAlgorithm::RSA_SHA256:
-	case SignAlgorithm::ECDSA_SHA256:
-		if (!EVP_DigestVerifyInit(mdctx, NULL, EVP_sha256(), NULL, _key)) {
-			return cleanup(false);
-		}
-		break;
-	case SignAlgorithm::RSA_SHA512:
-	case SignAlgorithm::ECDSA_SHA512:
-		if (!EVP_DigestVerifyInit(mdctx, NULL, EVP_sha512(), NULL, _key)) {
-			return cleanup(false);
-		}
-		break;
-	}
-
-	/* Initialize `key` with a public key */
-	if (!EVP_DigestVerifyUpdate(mdctx, data.data(), data.size())) {
-		return cleanup(false);
-	}
-
-	if (EVP_DigestVerifyFinal(mdctx, signature.data(), signature.size())) {
-		return cleanup(true);
-	}
-
-	return cleanup(false);
+	return verifyOpenSSLDigest(_key, _id, data, signature, algo);
 }
 
-PublicKey::PublicKey() : _valid(true), _key(nullptr) { }
+PublicKey::PublicKey() : _valid(true), _key(nullptr), _id(++ s_openSSLKeyId) { }
 
-PublicKey::PublicKey(BytesView data) : _valid(true), _key(nullptr) {
+PublicKey::PublicKey(BytesView data) : _valid(true), _key(nullptr), _id(++ s_openSSLKeyId) {
 	if (data.starts_with((const uint8_t *)"ssh-rsa", "ssh-rsa"_len)) {
 		importOpenSSH(StringView((const char *)data.data(), data.size()));
 	} else {
 		import(data);
 	}
 }
-PublicKey::PublicKey(const PrivateKey &priv) : _valid(true), _key(nullptr) {
+PublicKey::PublicKey(const PrivateKey &priv) : _valid(true), _key(nullptr), _id(++ s_openSSLKeyId) {
 	auto bp = BIO_new(BIO_s_mem());
 	if (!bp) {
 		return;
 	}
 
-	if (i2b_PublicKey_bio(bp, priv.getKey())) {
-		_key = b2i_PublicKey_bio(bp);
+	// SubjectPublicKeyInfo is supported for all key types
+	if (i2d_PUBKEY_bio(bp, priv.getKey())) {
+		_key = d2i_PUBKEY_bio(bp, NULL);
 		if (_key) {
 			_loaded = true;
 		}
@@ -499,6 +788,9 @@ PublicKey::PublicKey(const PrivateKey &priv) : _valid(true), _key(nullptr) {
 }
 
 PublicKey::~PublicKey() {
+	if (auto ctx = OpenSSLThreadContext::current()) {
+		ctx->releaseKey(_id);
+	}
 	if (_key) {
 		EVP_PKEY_free( _key );
 		_key = nullptr;
@@ -506,6 +798,10 @@ PublicKey::~PublicKey() {
 	}
 }
 
+KeyType PublicKey::getType() const {
+	return getOpenSSLKeyType(_key);
+}
+
 bool PublicKey::import(BytesView data) {
 	BIO *bioData = nullptr;
 
@@ -648,45 +944,7 @@ bool PublicKey::exportDer(const Callback<void(const uint8_t *, size_t)> &cb) con
 }
 
 bool PublicKey::verify(CoderSource data, BytesView signature, SignAlgorithm algo) const {
-	EVP_MD_CTX *mdctx =  EVP_MD_CTX_create();
-
-	auto cleanup = [&] (bool value) {
-		if (mdctx) {
-			EVP_MD_CTX_destroy(mdctx);
-			mdctx = nullptr;
-		}
-		return value;
-	};
-
-	if (!mdctx) {
-		return cleanup(false);
-	}
-
-	switch (algo) {
-	case SignAlgorithm::RSA_SHA256:
-	case SignAlgorithm::ECDSA_SHA256:
-		if (!EVP_DigestVerifyInit(mdctx, NULL, EVP_sha256(), NULL, _key)) {
-			return cleanup(false);
-		}
-		break;
-	case SignAlgorithm::RSA_SHA512:
-	case SignAlgorithm::ECDSA_SHA512:
-		if (!EVP_DigestVerifyInit(mdctx, NULL, EVP_sha512(), NULL, _key)) {
-			return cleanup(false);
-		}
-		break;
-	}
-
-	/* Initialize `key` with a public key */
-	if (!EVP_DigestVerifyUpdate(mdctx, data.data(), data.size())) {
-		return cleanup(false);
-	}
-
-	if (EVP_DigestVerifyFinal(mdctx, signature.data(), signature.size())) {
-		return cleanup(true);
-	}
-
-	return cleanup(false);
+	return verifyOpenSSLDigest(_key, _id, data, signature, algo);
 }
 
 }
@@ -23,13 +23,49 @@
 #include "SPCrypto.h"
 #include "SPValid.h"
 #include "SPString.h"
+#include "SPRandom.h"
 
 namespace stappler::crypto {
 
+// Parsing of a private key is slower, than signing with it, so recently used keys are kept per thread;
+// secrets, that are not valid keys, are remembered too, so they are not parsed again
+struct CachedPrivateKey {
+	string::Sha256::Buf hash;
+	std::unique_ptr<PrivateKey> key;
+};
+
+static thread_local std::array<CachedPrivateKey, 4> tl_keys;
+static thread_local size_t tl_nextKey = 0;
+
+// used by backend's clearThreadCache
+static void clearThreadPrivateKeys() {
+	for (auto &it : tl_keys) {
+		it.key = nullptr;
+		it.hash.fill(0);
+	}
+	tl_nextKey = 0;
+}
+
+static const PrivateKey *getThreadPrivateKey(BytesView pkey) {
+	auto hash = string::Sha256().update(pkey).final();
+	for (auto &it : tl_keys) {
+		if (it.key && it.hash == hash) {
+			return it.key.get();
+		}
+	}
+
+	auto &slot = tl_keys[tl_nextKey];
+	tl_nextKey = (tl_nextKey + 1) % tl_keys.size();
+
+	slot.hash = hash;
+	slot.key = std::make_unique<PrivateKey>(pkey);
+	return slot.key.get();
+}
+
 AesKey makeAesKey(BytesView pkey, BytesView hash, uint32_t version) {
-	crypto::PrivateKey pk(pkey);
-	if (pk && version > 0) {
-		auto ret = makeAesKey(pk, hash, version);
+	auto pk = (version > 0) ? getThreadPrivateKey(pkey) : nullptr;
+	if (pk && *pk) {
+		auto ret = makeAesKey(*pk, hash, version);
 		if (ret.version == 0) {
 			ret.data = string::Sha256().update(hash).update(pkey).final();
 		}
@@ -62,6 +98,308 @@ AesKey makeAesKey(const PrivateKey &pkey, BytesView hash, uint32_t version) {
 	return ret;
 }
 
+AesSegmentCipher::AesSegmentCipher(BytesView k, BytesView salt)
+: key(string::Sha256::hmac(CoderSource(salt), CoderSource(k))) { }
+
+static void AesSegmentCipher_makeNonce(uint64_t idx, uint8_t iv[12]) {
+	// nonce is unique within message key
+	memset(iv, 0, 4);
+	auto n = byteorder::HostToNetwork(idx);
+	memcpy(iv + 4, &n, sizeof(n));
+}
+
+bool AesSegmentCipher::seal(uint64_t idx, BytesView aad, BytesView data, uint8_t *out, uint8_t *tag) const {
+	uint8_t iv[12];
+	AesSegmentCipher_makeNonce(idx, iv);
+	return encryptAesGcm(BytesView(key.data(), key.size()), BytesView(iv, 12), aad, data, out, tag);
+}
+
+bool AesSegmentCipher::open(uint64_t idx, BytesView aad, BytesView data, BytesView tag, uint8_t *out) const {
+	uint8_t iv[12];
+	AesSegmentCipher_makeNonce(idx, iv);
+	return decryptAesGcm(BytesView(key.data(), key.size()), BytesView(iv, 12), aad, data, tag, out);
+}
+
+static constexpr uint32_t AES_STREAM_MAGIC = 0x47415053; // 'SPAG'
+static constexpr size_t AES_LEGACY_HEADER_SIZE = 16;
+static constexpr size_t AES_HEADER_SIZE = 40;
+static constexpr size_t AES_AUTH_SIZE = 24; // part of header, that is authenticated with every segment
+static constexpr size_t AES_TAG_SIZE = AesSegmentCipher::TagSize;
+static constexpr size_t AES_SALT_SIZE = 16;
+static constexpr size_t AES_MAX_SEGMENT_SIZE = 64_MiB;
+
+// Block header, first 16 bytes are compatible with legacy format
+struct AesStreamHeader {
+	uint64_t dataSize = 0;
+	uint32_t version = 0; // keygen version
+	uint32_t magic = AES_STREAM_MAGIC;
+	uint32_t segmentSize = 0;
+	uint32_t reserved = 0;
+	std::array<uint8_t, AES_SALT_SIZE> salt;
+};
+
+static_assert(sizeof(AesStreamHeader) == AES_HEADER_SIZE);
+
+struct AesStream {
+	AesStreamHeader header;
+	AesSegmentCipher cipher;
+
+	AesStream(const AesKey &k, size_t dataSize, size_t segmentSize) {
+		header.dataSize = dataSize;
+		header.version = k.version;
+		header.segmentSize = uint32_t(segmentSize);
+		random::fill(header.salt.data(), header.salt.size());
+		init(k);
+	}
+
+	AesStream(const AesKey &k, const AesStreamHeader &h) : header(h) {
+		init(k);
+	}
+
+	void init(const AesKey &k) {
+		cipher = AesSegmentCipher(BytesView(k.data.data(), k.data.size()), BytesView(header.salt.data(), header.salt.size()));
+	}
+
+	bool isValid() const {
+		return header.magic == AES_STREAM_MAGIC && header.reserved == 0
+				&& header.segmentSize > 0 && header.segmentSize <= AES_MAX_SEGMENT_SIZE;
+	}
+
+	size_t getSegmentsCount() const {
+		// dataSize is read from untrusted header, so rounding up should not overflow
+		return std::max(header.dataSize / header.segmentSize + ((header.dataSize % header.segmentSize) ? 1 : 0), uint64_t(1));
+	}
+
+	size_t getSegmentDataSize(size_t idx) const {
+		return std::min(size_t(header.dataSize - idx * header.segmentSize), size_t(header.segmentSize));
+	}
+
+	void prepare(size_t idx, uint8_t aad[AES_AUTH_SIZE + 1]) const {
+		memcpy(aad, &header, AES_AUTH_SIZE);
+		aad[AES_AUTH_SIZE] = (idx + 1 == getSegmentsCount()) ? 1 : 0;
+	}
+
+	bool encrypt(size_t idx, const uint8_t *data, uint8_t *out) const {
+		uint8_t aad[AES_AUTH_SIZE + 1];
+		prepare(idx, aad);
+		auto size = getSegmentDataSize(idx);
+		return cipher.seal(idx, BytesView(aad, sizeof(aad)), BytesView(data, size), out, out + size);
+	}
+
+	bool decrypt(size_t idx, const uint8_t *data, uint8_t *out) const {
+		uint8_t aad[AES_AUTH_SIZE + 1];
+		prepare(idx, aad);
+		auto size = getSegmentDataSize(idx);
+		return cipher.open(idx, BytesView(aad, sizeof(aad)), BytesView(data, size), BytesView(data + size, AES_TAG_SIZE), out);
+	}
+};
+
+static bool runAesSegments(size_t count, uint32_t threads, const Callback<bool(size_t)> &cb) {
+	if (threads <= 1 || count <= 1) {
+		for (size_t i = 0; i < count; ++ i) {
+			if (!cb(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::atomic<size_t> next = 0;
+	std::atomic<bool> success = true;
+
+	auto worker = [&] {
+		size_t idx = 0;
+		while (success.load(std::memory_order_relaxed) && (idx = next.fetch_add(1)) < count) {
+			if (!cb(idx)) {
+				success = false;
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < std::min(size_t(threads), count); ++ i) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto &it : workers) {
+		it.join();
+	}
+	return success.load();
+}
+
+static bool readAesData(const io::Producer &prod, uint8_t *buf, size_t size) {
+	while (size > 0) {
+		auto r = prod.read(buf, size);
+		if (r == 0 || r > size) {
+			return false;
+		}
+		buf += r;
+		size -= r;
+	}
+	return true;
+}
+
+size_t getAesEncryptedSize(size_t dataSize, size_t segmentSize) {
+	if (segmentSize == 0) {
+		return 0;
+	}
+
+	auto segments = std::max(dataSize / segmentSize + ((dataSize % segmentSize) ? 1 : 0), size_t(1));
+	if (segments > (maxOf<size_t>() - AES_HEADER_SIZE) / AES_TAG_SIZE) {
+		return 0;
+	}
+
+	auto overhead = AES_HEADER_SIZE + segments * AES_TAG_SIZE;
+	if (dataSize > maxOf<size_t>() - overhead) {
+		return 0;
+	}
+	return overhead + dataSize;
+}
+
+bool encryptAes(const AesKey &key, BytesView d, const Callback<void(const uint8_t *, size_t)> &cb, uint32_t threads) {
+	AesStream stream(key, d.size(), AesSegmentSize);
+
+	// output can be large, so it's allocated in heap
+	memory::StandartInterface::BytesType output; output.resize(getAesEncryptedSize(d.size(), AesSegmentSize));
+	memcpy(output.data(), &stream.header, AES_HEADER_SIZE);
+
+	auto out = output.data() + AES_HEADER_SIZE;
+	if (!runAesSegments(stream.getSegmentsCount(), threads, [&] (size_t idx) {
+		return stream.encrypt(idx, d.data() + idx * AesSegmentSize, out + idx * (AesSegmentSize + AES_TAG_SIZE));
+	})) {
+		return false;
+	}
+
+	cb(output.data(), output.size());
+	return true;
+}
+
+bool decryptAes(const AesKey &key, BytesView d, const Callback<void(const uint8_t *, size_t)> &cb, uint32_t threads) {
+	if (d.size() < AES_LEGACY_HEADER_SIZE) {
+		return false;
+	}
+
+	uint64_t dataSize = 0;
+	memcpy(&dataSize, d.data(), sizeof(uint64_t));
+
+	// data size is not trusted, encrypted data is never smaller then plain one
+	if (dataSize > d.size()) {
+		return false;
+	}
+
+	// encrypted block in current format is always larger then legacy one with the same data size
+	auto legacySize = math::align<size_t>(dataSize, 16);
+	if (d.size() == AES_LEGACY_HEADER_SIZE + legacySize) {
+		memory::StandartInterface::BytesType output; output.resize(legacySize);
+		if (!decryptAesCbc(BytesView(key.data.data(), key.data.size()), d.sub(AES_LEGACY_HEADER_SIZE), output.data())) {
+			return false;
+		}
+		cb(output.data(), dataSize);
+		return true;
+	}
+
+	if (d.size() < AES_HEADER_SIZE) {
+		return false;
+	}
+
+	AesStreamHeader header;
+	memcpy(&header, d.data(), AES_HEADER_SIZE);
+
+	AesStream stream(key, header);
+	if (!stream.isValid() || d.size() != getAesEncryptedSize(dataSize, header.segmentSize)) {
+		return false;
+	}
+
+	memory::StandartInterface::BytesType output; output.resize(dataSize);
+
+	auto segmentSize = header.segmentSize;
+	auto data = d.data() + AES_HEADER_SIZE;
+	if (!runAesSegments(stream.getSegmentsCount(), threads, [&] (size_t idx) {
+		return stream.decrypt(idx, data + idx * (segmentSize + AES_TAG_SIZE), output.data() + idx * segmentSize);
+	})) {
+		return false;
+	}
+
+	cb(output.data(), output.size());
+	return true;
+}
+
+bool encryptAes(const AesKey &key, const io::Producer &prod, size_t dataSize, const io::Consumer &cons, size_t segmentSize) {
+	if (segmentSize == 0 || segmentSize > AES_MAX_SEGMENT_SIZE) {
+		return false;
+	}
+
+	AesStream stream(key, dataSize, segmentSize);
+	cons.write((const uint8_t *)&stream.header, AES_HEADER_SIZE);
+
+	memory::StandartInterface::BytesType input; input.resize(segmentSize);
+	memory::StandartInterface::BytesType output; output.resize(segmentSize + AES_TAG_SIZE);
+
+	auto count = stream.getSegmentsCount();
+	for (size_t i = 0; i < count; ++ i) {
+		auto size = stream.getSegmentDataSize(i);
+		if (!readAesData(prod, input.data(), size) || !stream.encrypt(i, input.data(), output.data())) {
+			return false;
+		}
+		cons.write(output.data(), size + AES_TAG_SIZE);
+	}
+	return true;
+}
+
+bool decryptAes(const AesKey &key, const io::Producer &prod, const io::Consumer &cons) {
+	AesStreamHeader header;
+	if (!readAesData(prod, (uint8_t *)&header, AES_LEGACY_HEADER_SIZE)) {
+		return false;
+	}
+
+	if (header.magic != AES_STREAM_MAGIC) {
+		// legacy block, it can be decrypted only as a whole
+		auto size = math::align<uint64_t>(header.dataSize, 16);
+		if (size < header.dataSize || size > maxOf<size_t>()) {
+			return false;
+		}
+
+		// size from header is not trusted, so buffer grows only with data, that was actually read
+		memory::StandartInterface::BytesType data;
+		while (data.size() < size) {
+			auto offset = data.size();
+			data.resize(offset + std::min(size_t(size) - offset, AesSegmentSize));
+			if (!readAesData(prod, data.data() + offset, data.size() - offset)) {
+				return false;
+			}
+		}
+
+		memory::StandartInterface::BytesType output; output.resize(data.size());
+		if (!decryptAesCbc(BytesView(key.data.data(), key.data.size()), data, output.data())) {
+			return false;
+		}
+		cons.write(output.data(), header.dataSize);
+		return true;
+	}
+
+	if (!readAesData(prod, (uint8_t *)&header + AES_LEGACY_HEADER_SIZE, AES_HEADER_SIZE - AES_LEGACY_HEADER_SIZE)) {
+		return false;
+	}
+
+	AesStream stream(key, header);
+	if (!stream.isValid()) {
+		return false;
+	}
+
+	memory::StandartInterface::BytesType input; input.resize(header.segmentSize + AES_TAG_SIZE);
+	memory::StandartInterface::BytesType output; output.resize(header.segmentSize);
+
+	auto count = stream.getSegmentsCount();
+	for (size_t i = 0; i < count; ++ i) {
+		auto size = stream.getSegmentDataSize(i);
+		if (!readAesData(prod, input.data(), size + AES_TAG_SIZE) || !stream.decrypt(i, input.data(), output.data())) {
+			return false;
+		}
+		cons.write(output.data(), size);
+	}
+	return true;
+}
+
 uint32_t getAesVersion(BytesView val) {
 	val.offset(8);
 	return val.readUnsigned32();
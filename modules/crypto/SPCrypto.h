@@ -55,6 +55,15 @@ enum class SignAlgorithm {
 	RSA_SHA512,
 	ECDSA_SHA256,
 	ECDSA_SHA512,
+	EDDSA_ED25519, // message is signed as is, without external digest
+};
+
+enum class KeyType {
+	Unknown,
+	RSA,
+	DSA,
+	ECDSA,
+	EDDSA_ED25519,
 };
 
 enum class KeyBits {
@@ -85,12 +94,17 @@ public:
 
 	bool generate(KeyBits = KeyBits::_2048);
 
+	// RSA keys generated with default size
+	bool generate(KeyType);
+
 	bool import(BytesView, const CoderSource & passwd = CoderSource());
 
 	PublicKey exportPublic() const;
 
 	sp_privkey_t getKey() const { return _key; }
 
+	KeyType getType() const;
+
 	operator bool () const { return _valid && _loaded; }
 
 	bool exportPem(const Callback<void(const uint8_t *, size_t)> &, KeyFormat = KeyFormat::PKCS8, CoderSource passPhrase = StringView()) const;
@@ -103,6 +117,7 @@ protected:
 	bool _loaded = false;
 	bool _valid = false;
 	sp_privkey_t _key;
+	uint64_t _id = 0; // identifies key in per-thread contexts
 };
 
 class PublicKey {
@@ -120,6 +135,8 @@ public:
 
 	sp_pubkey_t getKey() const { return _key; }
 
+	KeyType getType() const;
+
 	operator bool () const { return _valid && _loaded; }
 
 	bool exportPem(const Callback<void(const uint8_t *, size_t)> &) const; // only pkcs8
@@ -131,10 +148,52 @@ protected:
 	bool _loaded = false;
 	bool _valid = false;
 	sp_pubkey_t _key;
+	uint64_t _id = 0; // identifies key in per-thread contexts
 };
 
-bool encryptAes(const AesKey &, BytesView, const Callback<void(const uint8_t *, size_t)> &);
-bool decryptAes(const AesKey &, BytesView, const Callback<void(const uint8_t *, size_t)> &);
+// Authenticated encryption (AES-256-GCM) with chunked framing
+//
+// Data is split into segments, every segment is sealed independently with message key (derived from
+// AesKey and random salt), nonce from segment index and block header with last segment flag as
+// additional data. So segments can be processed in parallel, and reordering or truncation is detected.
+// First 16 bytes of header keep legacy layout (data size, keygen version), so getAesVersion works
+// for both formats, and blocks from legacy AES-256-CBC encryption are still decrypted.
+static constexpr size_t AesSegmentSize = 64_KiB;
+
+// size of encrypted block for data of specified size, 0 if size is not representable
+size_t getAesEncryptedSize(size_t dataSize, size_t segmentSize = AesSegmentSize);
+
+// whole buffer, segments are processed with up to `threads` threads
+bool encryptAes(const AesKey &, BytesView, const Callback<void(const uint8_t *, size_t)> &, uint32_t threads = 1);
+bool decryptAes(const AesKey &, BytesView, const Callback<void(const uint8_t *, size_t)> &, uint32_t threads = 1);
+
+// streaming, only single segment is buffered; encryption requires data size to be known in advance
+bool encryptAes(const AesKey &, const io::Producer &, size_t dataSize, const io::Consumer &, size_t segmentSize = AesSegmentSize);
+bool decryptAes(const AesKey &, const io::Producer &, const io::Consumer &);
+
+// Segment sealing for chunked AES-256-GCM formats (AES blocks above, encrypted data values)
+// Message key is HMAC-SHA256 of key with per-message salt, nonce is segment index; caller provides
+// additional data, that binds segment to message header and its position
+struct AesSegmentCipher {
+	static constexpr size_t TagSize = 16;
+
+	std::array<uint8_t, 32> key;
+
+	AesSegmentCipher() = default;
+	AesSegmentCipher(BytesView key, BytesView salt);
+
+	bool seal(uint64_t idx, BytesView aad, BytesView data, uint8_t *out, uint8_t *tag) const;
+	bool open(uint64_t idx, BytesView aad, BytesView data, BytesView tag, uint8_t *out) const;
+};
+
+// backend primitives: single-shot AES-256-GCM (16-byte tag), and legacy AES-256-CBC with zero IV
+bool encryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, uint8_t *out, uint8_t *tag);
+bool decryptAesGcm(BytesView key, BytesView iv, BytesView aad, BytesView data, BytesView tag, uint8_t *out);
+bool decryptAesCbc(BytesView key, BytesView data, uint8_t *out);
+
+// releases keys and contexts, cached for current thread (parsed private keys from makeAesKey, signing
+// contexts, cipher key schedules); caches are released on thread exit too, and contexts of a key - with the key
+void clearThreadCache();
 
 AesKey makeAesKey(BytesView pkey, BytesView hash, uint32_t version = 1);
 AesKey makeAesKey(const PrivateKey &pkey, BytesView hash, uint32_t version = 1);
@@ -22,12 +22,329 @@
 
 #include "SPJsonWebToken.h"
 
-SPJsonWebToken::SPJsonWebToken() {
-	// TODO Auto-generated constructor stub
+#if MODULE_COMMON_DATA
 
+#include <shared_mutex>
+#include <list>
+
+namespace stappler {
+
+struct JsonWebTokenVerifier::Data {
+	using Hash = string::Sha256::Buf;
+
+	struct KeyData {
+		crypto::PublicKey pub;
+		crypto::KeyType type = crypto::KeyType::Unknown;
+		std::vector<uint8_t> secret;
+		bool hmac = false;
+
+		KeyData() = default;
+		KeyData(BytesView data) : pub(data), type(pub.getType()) { }
+	};
+
+	struct HashHasher {
+		size_t operator()(const Hash &h) const {
+			// token hash is already uniformly distributed
+			size_t ret;
+			memcpy(&ret, h.data(), sizeof(ret));
+			return ret;
+		}
+	};
+
+	struct CacheEntry {
+		Hash hash;
+		Time expires;
+		Value payload;
+	};
+
+	Config config;
+
+	mutable std::shared_mutex keysMutex;
+	std::map<std::string, std::shared_ptr<KeyData>, std::less<>> keys;
+
+	// most recently used entries are at front
+	mutable std::mutex cacheMutex;
+	std::list<CacheEntry> lru;
+	std::unordered_map<Hash, std::list<CacheEntry>::iterator, HashHasher> index;
+
+	// incremented under cacheMutex on every key change, results verified with previous keys are not cached
+	std::atomic<uint64_t> generation = 0;
+
+	std::atomic<uint64_t> requests = 0;
+	std::atomic<uint64_t> hits = 0;
+	std::atomic<uint64_t> verified = 0;
+	std::atomic<uint64_t> failed = 0;
+	std::atomic<uint64_t> evicted = 0;
+
+	Data(Config &&cfg) : config(move(cfg)) { }
+
+	std::shared_ptr<KeyData> getKey(StringView kid) const {
+		std::shared_lock lock(keysMutex);
+		auto it = keys.find(kid);
+		if (it != keys.end()) {
+			return it->second;
+		}
+		return nullptr;
+	}
+
+	void setKey(StringView kid, std::shared_ptr<KeyData> &&key) {
+		do {
+			std::unique_lock lock(keysMutex);
+			auto it = keys.find(kid);
+			if (it != keys.end()) {
+				it->second = move(key);
+			} else {
+				keys.emplace(kid.str<memory::StandartInterface>(), move(key));
+			}
+		} while (0);
+
+		// results, verified with previous key, are no longer valid
+		clear();
+	}
+
+	bool find(const Hash &hash, Time now, Value &ret) {
+		std::unique_lock lock(cacheMutex);
+		auto it = index.find(hash);
+		if (it == index.end()) {
+			return false;
+		}
+
+		if (it->second->expires <= now) {
+			lru.erase(it->second);
+			index.erase(it);
+			return false;
+		}
+
+		lru.splice(lru.begin(), lru, it->second);
+		ret = it->second->payload;
+		return true;
+	}
+
+	void insert(const Hash &hash, Time expires, const Value &payload, uint64_t gen) {
+		std::unique_lock lock(cacheMutex);
+		if (gen != generation.load()) {
+			// key was replaced or removed while token was verified
+			return;
+		}
+
+		auto it = index.find(hash);
+		if (it != index.end()) {
+			// token was verified concurrently
+			lru.splice(lru.begin(), lru, it->second);
+			return;
+		}
+
+		lru.emplace_front(CacheEntry{hash, expires, payload});
+		index.emplace(hash, lru.begin());
+
+		while (lru.size() > config.cacheSize) {
+			index.erase(lru.back().hash);
+			lru.pop_back();
+			++ evicted;
+		}
+	}
+
+	void clear() {
+		std::unique_lock lock(cacheMutex);
+		++ generation;
+		index.clear();
+		lru.clear();
+	}
+
+	bool isValidKey(const Token &token, const KeyData &key) const {
+		switch (token.alg) {
+		case Token::HS256:
+		case Token::HS512:
+			return key.hmac;
+			break;
+		case Token::RS256:
+		case Token::RS512:
+			return !key.hmac && key.type == crypto::KeyType::RSA;
+			break;
+		case Token::ES256:
+		case Token::ES512:
+			return !key.hmac && key.type == crypto::KeyType::ECDSA;
+			break;
+		case Token::EdDSA:
+			return !key.hmac && key.type == crypto::KeyType::EDDSA_ED25519;
+			break;
+		default:
+			break;
+		}
+		return false;
+	}
+
+	bool isValidPayload(const Token &token) const {
+		if (!config.issuer.empty() && token.payload.getString("iss") != config.issuer) {
+			return false;
+		}
+		if (!config.audience.empty() && token.payload.getString("aud") != config.audience) {
+			return false;
+		}
+		return token.validatePayload();
+	}
+
+	Value verify(StringView source) {
+		++ requests;
+
+		if (source.empty()) {
+			++ failed;
+			return Value();
+		}
+
+		auto now = Time::now();
+		auto hash = string::Sha256().update(source).final();
+
+		Value ret;
+		if (config.cacheSize > 0 && find(hash, now, ret)) {
+			++ hits;
+			return ret;
+		}
+
+		// captured before key lookup, so result is not cached, if keys changed during verification
+		auto gen = generation.load();
+
+		Token token(source);
+
+		// key type should match token's algorithm, so public key can not be used as HMAC secret
+		auto key = getKey(token.kid);
+		if (!key || !isValidKey(token, *key) || !isValidPayload(token)) {
+			++ failed;
+			return Value();
+		}
+
+		auto valid = key->hmac ? token.validate(BytesView(key->secret.data(), key->secret.size())) : token.validate(key->pub);
+		if (!valid) {
+			++ failed;
+			return Value();
+		}
+
+		++ verified;
+
+		if (config.cacheSize > 0) {
+			auto expires = now + config.cacheTimeout;
+			if (auto exp = token.payload.getInteger("exp")) {
+				expires = std::min(expires, Time::seconds(exp));
+			}
+			insert(hash, expires, token.payload, gen);
+		}
+
+		return move(token.payload);
+	}
+};
+
+JsonWebTokenVerifier::JsonWebTokenVerifier() {
+	_data = new Data(Config());
+}
+
+JsonWebTokenVerifier::JsonWebTokenVerifier(Config &&cfg) {
+	_data = new Data(move(cfg));
+}
+
+JsonWebTokenVerifier::~JsonWebTokenVerifier() {
+	delete _data;
+}
+
+bool JsonWebTokenVerifier::addKey(StringView kid, BytesView data) {
+	auto key = std::make_shared<Data::KeyData>(data);
+	if (!key->pub) {
+		return false;
+	}
+
+	_data->setKey(kid, move(key));
+	return true;
+}
+
+bool JsonWebTokenVerifier::addSecret(StringView kid, BytesView data) {
+	if (data.empty()) {
+		return false;
+	}
+
+	auto key = std::make_shared<Data::KeyData>();
+	key->secret.assign(data.data(), data.data() + data.size());
+	key->hmac = true;
+	_data->setKey(kid, move(key));
+	return true;
+}
+
+void JsonWebTokenVerifier::removeKey(StringView kid) {
+	do {
+		std::unique_lock lock(_data->keysMutex);
+		auto it = _data->keys.find(kid);
+		if (it == _data->keys.end()) {
+			return;
+		}
+		_data->keys.erase(it);
+	} while (0);
+
+	_data->clear();
+}
+
+auto JsonWebTokenVerifier::verify(StringView token) -> Value {
+	return _data->verify(token);
+}
+
+#if MODULE_COMMON_THREADS
+void JsonWebTokenVerifier::verify(thread::TaskQueue &queue, std::vector<std::string> &&tokens, std::function<void(std::vector<Value> &&)> &&cb) {
+	struct Batch {
+		std::vector<std::string> tokens;
+		std::vector<Value> results;
+		std::function<void(std::vector<Value> &&)> callback;
+		size_t pending = 0;
+	};
+
+	if (tokens.empty()) {
+		cb(std::vector<Value>());
+		return;
+	}
+
+	auto batch = std::make_shared<Batch>();
+	batch->tokens = move(tokens);
+	batch->results.resize(batch->tokens.size());
+	batch->callback = move(cb);
+
+	// few chunks per worker to balance cached and uncached tokens
+	const size_t workers = std::max(queue.getThreadIds().size(), size_t(1));
+	const size_t chunkSize = std::max((batch->tokens.size() + workers * 4 - 1) / (workers * 4), size_t(1));
+	batch->pending = (batch->tokens.size() + chunkSize - 1) / chunkSize;
+
+	auto data = _data;
+	for (size_t begin = 0; begin < batch->tokens.size(); begin += chunkSize) {
+		auto end = std::min(begin + chunkSize, batch->tokens.size());
+		queue.perform(Rc<thread::Task>::create([data, batch, begin, end] (const thread::Task &) {
+			for (size_t i = begin; i < end; ++ i) {
+				batch->results[i] = data->verify(batch->tokens[i]);
+			}
+			return true;
+		}, [batch] (const thread::Task &, bool) {
+			// complete callbacks are called sequentially on main thread
+			if (-- batch->pending == 0) {
+				batch->callback(move(batch->results));
+			}
+		}));
+	}
+}
+#endif
+
+void JsonWebTokenVerifier::clearCache() {
+	_data->clear();
+}
+
+size_t JsonWebTokenVerifier::getCacheSize() const {
+	std::unique_lock lock(_data->cacheMutex);
+	return _data->lru.size();
+}
+
+auto JsonWebTokenVerifier::getStats() const -> Stats {
+	Stats ret;
+	ret.requests = _data->requests.load();
+	ret.hits = _data->hits.load();
+	ret.verified = _data->verified.load();
+	ret.failed = _data->failed.load();
+	ret.evicted = _data->evicted.load();
+	return ret;
 }
 
-SPJsonWebToken::~SPJsonWebToken() {
-	// TODO Auto-generated destructor stub
 }
 
+#endif
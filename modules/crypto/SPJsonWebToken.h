@@ -33,6 +33,10 @@
 #include "SPDataWrapper.h"
 #include "SPCrypto.h"
 
+#if MODULE_COMMON_THREADS
+#include "SPThreadTaskQueue.h"
+#endif
+
 namespace stappler {
 
 template <typename Interface>
@@ -49,6 +53,7 @@ struct JsonWebToken {
 		RS512,
 		ES256,
 		ES512,
+		EdDSA, // Ed25519 curve only (RFC 8037)
 	};
 
 	static SigAlg getAlg(StringView);
@@ -135,6 +140,66 @@ protected:
 	Keys _keys;
 };
 
+// Verification service for tokens from trusted issuers
+// Parsed keys are cached by key id ('kid' header, empty id for tokens without it),
+// successfully verified tokens are cached by SHA-256 of the token source until expiration,
+// so repeated tokens are returned without signature verification
+class JsonWebTokenVerifier {
+public:
+	using Token = JsonWebToken<memory::StandartInterface>;
+	using Value = data::ValueTemplate<memory::StandartInterface>;
+
+	struct Config {
+		size_t cacheSize = 64 * 1024; // max number of cached tokens, 0 to disable cache
+		TimeInterval cacheTimeout = TimeInterval::seconds(300); // max lifetime of cached result
+		std::string issuer; // if not empty, token's 'iss' should match it
+		std::string audience; // if not empty, token's 'aud' should match it
+	};
+
+	struct Stats {
+		uint64_t requests = 0;
+		uint64_t hits = 0; // results, returned from cache
+		uint64_t verified = 0; // successful signature verifications
+		uint64_t failed = 0;
+		uint64_t evicted = 0;
+	};
+
+	JsonWebTokenVerifier();
+	JsonWebTokenVerifier(Config &&);
+	~JsonWebTokenVerifier();
+
+	JsonWebTokenVerifier(const JsonWebTokenVerifier &) = delete;
+	JsonWebTokenVerifier &operator=(const JsonWebTokenVerifier &) = delete;
+
+	// public key in PEM, DER or OpenSSH format, used for RS*, ES* and EdDSA tokens
+	bool addKey(StringView kid, BytesView);
+
+	// shared secret, used for HS* tokens
+	bool addSecret(StringView kid, BytesView);
+
+	// cached results are dropped, when key is removed
+	void removeKey(StringView kid);
+
+	// returns token payload if signature, expiration and issuer are valid, null value otherwise
+	Value verify(StringView token);
+
+#if MODULE_COMMON_THREADS
+	// tokens are verified on queue's workers, callback is called on queue's main thread
+	// with results in the same order as tokens; verifier should outlive the batch
+	void verify(thread::TaskQueue &, std::vector<std::string> &&tokens, std::function<void(std::vector<Value> &&)> &&);
+#endif
+
+	void clearCache();
+
+	size_t getCacheSize() const;
+	Stats getStats() const;
+
+protected:
+	struct Data;
+
+	Data *_data = nullptr;
+};
+
 template <typename Interface>
 auto JsonWebToken<Interface>::getAlg(StringView name) -> typename JsonWebToken<Interface>::SigAlg  {
 	if (name == "HS256") {
@@ -149,6 +214,8 @@ auto JsonWebToken<Interface>::getAlg(StringView name) -> typename JsonWebToken<I
 		return ES256;
 	} else if (name == "ES512") {
 		return ES512;
+	} else if (name == "EdDSA") {
+		return EdDSA;
 	}
 	return JsonWebToken::None;
 }
@@ -163,6 +230,7 @@ StringView JsonWebToken<Interface>::getAlgName(const SigAlg &alg) {
 	case RS512: return "RS512"; break;
 	case ES256: return "ES256"; break;
 	case ES512: return "ES512"; break;
+	case EdDSA: return "EdDSA"; break;
 	}
 	return StringView();
 }
@@ -274,6 +342,7 @@ bool JsonWebToken<Interface>::validate(const crypto::PublicKey &pk) const {
 	case ES256: algo = crypto::SignAlgorithm::ECDSA_SHA256; break;
 	case RS512: algo = crypto::SignAlgorithm::RSA_SHA512; break;
 	case ES512: algo = crypto::SignAlgorithm::ECDSA_SHA512; break;
+	case EdDSA: algo = crypto::SignAlgorithm::EDDSA_ED25519; break;
 	default: return false; break;
 	}
 
@@ -383,6 +452,7 @@ auto JsonWebToken<Interface>::exportSigned(SigAlg alg, const crypto::PrivateKey
 	case ES256: algo = crypto::SignAlgorithm::ECDSA_SHA256; break;
 	case RS512: algo = crypto::SignAlgorithm::RSA_SHA512; break;
 	case ES512: algo = crypto::SignAlgorithm::ECDSA_SHA512; break;
+	case EdDSA: algo = crypto::SignAlgorithm::EDDSA_ED25519; break;
 	default: break;
 	}
 
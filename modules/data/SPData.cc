@@ -41,6 +41,11 @@ THE SOFTWARE.
 #include "brotli/decode.h"
 #endif
 
+#ifdef MODULE_COMMON_CRYPTO
+#include "SPCrypto.h"
+#include "SPRandom.h"
+#endif
+
 namespace stappler::data {
 
 EncodeFormat EncodeFormat::CborCompressed(EncodeFormat::Cbor, EncodeFormat::LZ4HCCompression);
@@ -157,6 +162,77 @@ auto ValueTemplate<memory::StandartInterface>::convert<memory::PoolInterface>()
 	return ValueTemplate<memory::PoolInterface>();
 }
 
+// copies value between interfaces with different container types, used for PoolBtreeInterface
+template <typename Target, typename Source>
+static auto ValueTemplate_convert(const ValueTemplate<Source> &val) -> ValueTemplate<Target> {
+	using SourceType = typename ValueTemplate<Source>::Type;
+	using TargetType = typename ValueTemplate<Target>::Type;
+
+	switch (val.getType()) {
+	case SourceType::INTEGER: return ValueTemplate<Target>(val.getInteger()); break;
+	case SourceType::DOUBLE: return ValueTemplate<Target>(val.getDouble()); break;
+	case SourceType::BOOLEAN: return ValueTemplate<Target>(val.getBool()); break;
+	case SourceType::CHARSTRING:
+		return ValueTemplate<Target>(typename Target::StringType(val.getString().data(), val.getString().size()));
+		break;
+	case SourceType::BYTESTRING:
+		return ValueTemplate<Target>(typename Target::BytesType(val.getBytes().data(), val.getBytes().data() + val.getBytes().size()));
+		break;
+	case SourceType::ARRAY: {
+		ValueTemplate<Target> ret(TargetType::ARRAY);
+		auto &arr = ret.asArray();
+		arr.reserve(val.asArray().size());
+		for (auto &it : val.asArray()) {
+			arr.emplace_back(ValueTemplate_convert<Target>(it));
+		}
+		return ret;
+		break;
+	}
+	case SourceType::DICTIONARY: {
+		ValueTemplate<Target> ret(TargetType::DICTIONARY);
+		auto &dict = ret.asDict();
+		for (auto &it : val.asDict()) {
+			dict.emplace(StringView(it.first).str<Target>(), ValueTemplate_convert<Target>(it.second));
+		}
+		return ret;
+		break;
+	}
+	default:
+		break;
+	}
+	return ValueTemplate<Target>();
+}
+
+template <>
+template <>
+auto ValueTemplate<memory::PoolBtreeInterface>::convert<memory::PoolBtreeInterface>() const -> ValueTemplate<memory::PoolBtreeInterface> {
+	return ValueTemplate<memory::PoolBtreeInterface>(*this);
+}
+
+template <>
+template <>
+auto ValueTemplate<memory::PoolBtreeInterface>::convert<memory::PoolInterface>() const -> ValueTemplate<memory::PoolInterface> {
+	return ValueTemplate_convert<memory::PoolInterface>(*this);
+}
+
+template <>
+template <>
+auto ValueTemplate<memory::PoolBtreeInterface>::convert<memory::StandartInterface>() const -> ValueTemplate<memory::StandartInterface> {
+	return ValueTemplate_convert<memory::StandartInterface>(*this);
+}
+
+template <>
+template <>
+auto ValueTemplate<memory::PoolInterface>::convert<memory::PoolBtreeInterface>() const -> ValueTemplate<memory::PoolBtreeInterface> {
+	return ValueTemplate_convert<memory::PoolBtreeInterface>(*this);
+}
+
+template <>
+template <>
+auto ValueTemplate<memory::StandartInterface>::convert<memory::PoolBtreeInterface>() const -> ValueTemplate<memory::PoolBtreeInterface> {
+	return ValueTemplate_convert<memory::PoolBtreeInterface>(*this);
+}
+
 size_t getCompressBounds(size_t size, EncodeFormat::Compression c) {
 	switch (c) {
 	case EncodeFormat::LZ4Compression:
@@ -302,6 +378,11 @@ auto compress<memory::StandartInterface>(const uint8_t *src, size_t size, Encode
 	return doCompress<memory::StandartInterface>(src, size, c, conditional);
 }
 
+template <>
+auto compress<memory::PoolBtreeInterface>(const uint8_t *src, size_t size, EncodeFormat::Compression c, bool conditional) -> memory::PoolBtreeInterface::BytesType {
+	return doCompress<memory::PoolBtreeInterface>(src, size, c, conditional);
+}
+
 using decompress_ptr = const uint8_t *;
 
 static bool doDecompressLZ4Frame(const uint8_t *src, size_t srcSize, uint8_t *dest, size_t destSize) {
@@ -336,6 +417,11 @@ auto decompressLZ4(const uint8_t *srcPtr, size_t srcSize, bool sh) -> ValueTempl
 	return doDecompressLZ4<memory::StandartInterface>(BytesView(srcPtr, srcSize), sh);
 }
 
+template <>
+auto decompressLZ4(const uint8_t *srcPtr, size_t srcSize, bool sh) -> ValueTemplate<memory::PoolBtreeInterface> {
+	return doDecompressLZ4<memory::PoolBtreeInterface>(BytesView(srcPtr, srcSize), sh);
+}
+
 #ifdef MODULE_COMMON_BROTLI_LIB
 static bool doDecompressBrotliFrame(const uint8_t *src, size_t srcSize, uint8_t *dest, size_t destSize) {
 	size_t ret = destSize;
@@ -369,6 +455,11 @@ auto decompressBrotli(const uint8_t *srcPtr, size_t srcSize, bool sh) -> ValueTe
 	return doDecompressBrotli<memory::StandartInterface>(BytesView(srcPtr, srcSize), sh);
 }
 
+template <>
+auto decompressBrotli(const uint8_t *srcPtr, size_t srcSize, bool sh) -> ValueTemplate<memory::PoolBtreeInterface> {
+	return doDecompressBrotli<memory::PoolBtreeInterface>(BytesView(srcPtr, srcSize), sh);
+}
+
 #endif
 
 template <typename Interface>
@@ -429,4 +520,285 @@ auto decompress<memory::StandartInterface>(const uint8_t *d, size_t size) -> typ
 	return doDecompress<memory::StandartInterface>(d, size);
 }
 
+template <>
+auto decompress<memory::PoolBtreeInterface>(const uint8_t *d, size_t size) -> typename memory::PoolBtreeInterface::BytesType {
+	return doDecompress<memory::PoolBtreeInterface>(d, size);
+}
+
+#ifdef MODULE_COMMON_CRYPTO
+
+// Encrypted format: header, then sequence of independent blocks, every block is LZ4-compressed (when it's
+// profitable) and sealed with AES-256-GCM. Message key is HMAC-SHA256 of user key with random salt, nonce is
+// block index, header and block descriptor are authenticated, so blocks can not be reordered, modified or truncated
+static constexpr uint8_t EncryptedVersion = 1;
+static constexpr uint32_t EncryptedBlockSize = uint32_t(64_KiB);
+static constexpr uint32_t EncryptedMaxBlockSize = uint32_t(16_MiB);
+static constexpr uint32_t EncryptedBlockLast = uint32_t(1) << 31;
+static constexpr uint32_t EncryptedBlockCompressed = uint32_t(1) << 30;
+static constexpr uint32_t EncryptedBlockSizeMask = EncryptedBlockCompressed - 1;
+static constexpr size_t EncryptedTagSize = crypto::AesSegmentCipher::TagSize;
+
+struct EncryptedHeader {
+	std::array<uint8_t, 4> magic;
+	uint8_t version;
+	uint8_t format;
+	uint8_t compression;
+	uint8_t reserved;
+	uint32_t blockSize;
+	std::array<uint8_t, 16> salt;
+};
+
+struct EncryptedBlock {
+	uint32_t info; // plain data size with block flags
+	uint32_t size; // stored data size
+};
+
+static_assert(sizeof(EncryptedHeader) == 28 && sizeof(EncryptedBlock) == 8, "Invalid encrypted block layout");
+
+struct EncryptedCipher {
+	EncryptedHeader header;
+	crypto::AesSegmentCipher cipher;
+
+	void init(BytesView k) {
+		cipher = crypto::AesSegmentCipher(k, BytesView(header.salt.data(), header.salt.size()));
+	}
+
+	void prepare(const EncryptedBlock &block, uint8_t aad[sizeof(EncryptedHeader) + sizeof(EncryptedBlock)]) const {
+		memcpy(aad, &header, sizeof(EncryptedHeader));
+		memcpy(aad + sizeof(EncryptedHeader), &block, sizeof(EncryptedBlock));
+	}
+
+	bool seal(size_t idx, const EncryptedBlock &block, BytesView data, uint8_t *out) const {
+		uint8_t aad[sizeof(EncryptedHeader) + sizeof(EncryptedBlock)];
+		prepare(block, aad);
+
+		memcpy(out, &block, sizeof(EncryptedBlock));
+		return cipher.seal(idx, BytesView(aad, sizeof(aad)), data, out + sizeof(EncryptedBlock) + EncryptedTagSize,
+				out + sizeof(EncryptedBlock));
+	}
+
+	bool open(size_t idx, const EncryptedBlock &block, BytesView tag, BytesView data, uint8_t *out) const {
+		uint8_t aad[sizeof(EncryptedHeader) + sizeof(EncryptedBlock)];
+		prepare(block, aad);
+
+		return cipher.open(idx, BytesView(aad, sizeof(aad)), data, tag, out);
+	}
+};
+
+// Encoder output buffer, block is compressed and sealed when filled
+class EncryptedWriter : public std::streambuf {
+public:
+	EncryptedWriter(const EncodeFormat &fmt, const Callback<void(const uint8_t *, size_t)> &out)
+	: _compression(fmt.compression), _out(out) {
+		memcpy(_cipher.header.magic.data(), "SPEV", 4);
+		_cipher.header.version = EncryptedVersion;
+		_cipher.header.format = uint8_t(fmt.format);
+		_cipher.header.compression = uint8_t(fmt.compression);
+		_cipher.header.reserved = 0;
+		_cipher.header.blockSize = EncryptedBlockSize;
+		random::fill(_cipher.header.salt.data(), _cipher.header.salt.size());
+		_cipher.init(BytesView((const uint8_t *)fmt.key.data(), fmt.key.size()));
+
+		_block.resize(EncryptedBlockSize);
+		_sealed.resize(sizeof(EncryptedBlock) + EncryptedTagSize + LZ4_compressBound(EncryptedBlockSize));
+		setp((char *)_block.data(), (char *)_block.data() + _block.size());
+
+		_out((const uint8_t *)&_cipher.header, sizeof(EncryptedHeader));
+	}
+
+	// writes last block, that can be empty
+	bool finalize() {
+		return flush(true);
+	}
+
+protected:
+	virtual int_type overflow(int_type c) override {
+		if (!flush(false)) {
+			return traits_type::eof();
+		}
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	bool flush(bool last) {
+		if (!_valid) {
+			return false;
+		}
+
+		const auto size = size_t(pptr() - pbase());
+		BytesView data(_block.data(), size);
+
+		EncryptedBlock block;
+		block.info = uint32_t(size) | (last ? EncryptedBlockLast : 0);
+
+		if (size > 0) {
+			int ret = 0;
+			switch (_compression) {
+			case EncodeFormat::NoCompression:
+				break;
+			case EncodeFormat::LZ4Compression:
+				ret = LZ4_compress_fast_extState(tl_lz4HCEncodeState, (const char *)data.data(), (char *)tl_compressBuffer,
+						int(size), int(sizeof(tl_compressBuffer)), 1);
+				break;
+			default:
+				// block-level compression is LZ4-only, other methods use LZ4HC
+				ret = LZ4_compress_HC_extStateHC(tl_lz4HCEncodeState, (const char *)data.data(), (char *)tl_compressBuffer,
+						int(size), int(sizeof(tl_compressBuffer)), LZ4HC_CLEVEL_MAX);
+				break;
+			}
+			if (ret > 0 && size_t(ret) < size) {
+				data = BytesView(tl_compressBuffer, ret);
+				block.info |= EncryptedBlockCompressed;
+			}
+		}
+
+		block.size = uint32_t(data.size());
+		if (!_cipher.seal(_index, block, data, _sealed.data())) {
+			_valid = false;
+			return false;
+		}
+
+		_out(_sealed.data(), sizeof(EncryptedBlock) + EncryptedTagSize + data.size());
+		++ _index;
+		setp((char *)_block.data(), (char *)_block.data() + _block.size());
+		return true;
+	}
+
+	EncodeFormat::Compression _compression;
+	const Callback<void(const uint8_t *, size_t)> &_out;
+	EncryptedCipher _cipher;
+	mem_std::Bytes _block;
+	mem_std::Bytes _sealed;
+	size_t _index = 0;
+	bool _valid = true;
+};
+
+bool writeEncrypted(const EncodeFormat &fmt, const Callback<void(std::ostream &)> &encode, const Callback<void(const uint8_t *, size_t)> &out) {
+	if (fmt.key.empty()) {
+		return false;
+	}
+
+	EncryptedWriter writer(fmt, out);
+	std::ostream stream(&writer);
+	encode(stream);
+	return !stream.fail() && writer.finalize();
+}
+
+template <typename Interface>
+static inline auto doDecryptValue(BytesView data, BytesView key) -> ValueTemplate<Interface> {
+	EncryptedCipher cipher;
+	if (key.empty() || data.size() < sizeof(EncryptedHeader)) {
+		return ValueTemplate<Interface>();
+	}
+
+	memcpy(&cipher.header, data.data(), sizeof(EncryptedHeader));
+	data += sizeof(EncryptedHeader);
+
+	auto &header = cipher.header;
+	if (memcmp(header.magic.data(), "SPEV", 4) != 0 || header.version != EncryptedVersion
+			|| header.blockSize == 0 || header.blockSize > EncryptedMaxBlockSize) {
+		return ValueTemplate<Interface>();
+	}
+
+	cipher.init(key);
+
+	// JSON and CBOR are decoded as blocks arrive, other formats are collected for the regular reader
+	StreamBuffer<Interface> stream;
+	typename Interface::BytesType buffer;
+	bool streamed = true;
+	switch (EncodeFormat::Format(header.format)) {
+	case EncodeFormat::Json: case EncodeFormat::Pretty: stream.setFormat(DataFormat::Json); break;
+	case EncodeFormat::Cbor: case EncodeFormat::DefaultFormat: stream.setFormat(DataFormat::Cbor); break;
+	default: streamed = false; break;
+	}
+
+	const size_t storedBound = LZ4_compressBound(header.blockSize);
+	mem_std::Bytes scratch; scratch.resize(storedBound + header.blockSize);
+
+	size_t idx = 0;
+	bool last = false;
+	while (!last) {
+		if (data.size() < sizeof(EncryptedBlock) + EncryptedTagSize) {
+			return ValueTemplate<Interface>();
+		}
+
+		EncryptedBlock block;
+		memcpy(&block, data.data(), sizeof(EncryptedBlock));
+
+		const size_t plainSize = block.info & EncryptedBlockSizeMask;
+		const size_t blockSize = sizeof(EncryptedBlock) + EncryptedTagSize + block.size;
+		if (plainSize > header.blockSize || block.size > storedBound || data.size() < blockSize) {
+			return ValueTemplate<Interface>();
+		}
+
+		if (!cipher.open(idx, block, BytesView(data.data() + sizeof(EncryptedBlock), EncryptedTagSize),
+				BytesView(data.data() + sizeof(EncryptedBlock) + EncryptedTagSize, block.size), scratch.data())) {
+			return ValueTemplate<Interface>();
+		}
+
+		BytesView plain(scratch.data(), block.size);
+		if (block.info & EncryptedBlockCompressed) {
+			auto target = scratch.data() + storedBound;
+			if (LZ4_decompress_safe((const char *)scratch.data(), (char *)target, int(block.size), int(plainSize)) != int(plainSize)) {
+				return ValueTemplate<Interface>();
+			}
+			plain = BytesView(target, plainSize);
+		} else if (block.size != plainSize) {
+			return ValueTemplate<Interface>();
+		}
+
+		if (streamed) {
+			if (!stream.read(plain)) {
+				return ValueTemplate<Interface>();
+			}
+		} else {
+			buffer.insert(buffer.end(), plain.data(), plain.data() + plain.size());
+		}
+
+		last = (block.info & EncryptedBlockLast) != 0;
+		data += blockSize;
+		++ idx;
+	}
+
+	if (!data.empty()) {
+		return ValueTemplate<Interface>();
+	}
+
+	if (streamed) {
+		return stream.finalize() ? stream.extract() : ValueTemplate<Interface>();
+	}
+	return data::read<Interface>(buffer);
+}
+
+#else
+
+bool writeEncrypted(const EncodeFormat &fmt, const Callback<void(std::ostream &)> &encode, const Callback<void(const uint8_t *, size_t)> &out) {
+	return false;
+}
+
+template <typename Interface>
+static inline auto doDecryptValue(BytesView data, BytesView key) -> ValueTemplate<Interface> {
+	return ValueTemplate<Interface>();
+}
+
+#endif
+
+template <>
+auto decryptValue(const uint8_t *srcPtr, size_t srcSize, BytesView key) -> ValueTemplate<memory::PoolInterface> {
+	return doDecryptValue<memory::PoolInterface>(BytesView(srcPtr, srcSize), key);
+}
+
+template <>
+auto decryptValue(const uint8_t *srcPtr, size_t srcSize, BytesView key) -> ValueTemplate<memory::StandartInterface> {
+	return doDecryptValue<memory::StandartInterface>(BytesView(srcPtr, srcSize), key);
+}
+
+template <>
+auto decryptValue(const uint8_t *srcPtr, size_t srcSize, BytesView key) -> ValueTemplate<memory::PoolBtreeInterface> {
+	return doDecryptValue<memory::PoolBtreeInterface>(BytesView(srcPtr, srcSize), key);
+}
+
 }
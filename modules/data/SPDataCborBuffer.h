@@ -0,0 +1,403 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef MODULES_DATA_SPDATACBORBUFFER_H_
+#define MODULES_DATA_SPDATACBORBUFFER_H_
+
+#include "SPDataDecodeCbor.h"
+
+namespace stappler::data {
+
+// Incremental CBOR decoder
+// Data can be fed with chunks of any size. Item headers and string payloads can be split between chunks,
+// only incomplete header or string is buffered. Tags (including self-describe prefix 0xd9d9f7) are skipped.
+template <typename Interface>
+class CborBuffer : public Interface::AllocBaseType {
+public:
+	using InterfaceType = Interface;
+	using ValueType = ValueTemplate<Interface>;
+	using StringType = typename InterfaceType::StringType;
+	using BytesType = typename InterfaceType::BytesType;
+
+	CborBuffer(string::Interner *i = nullptr) : _interner(i) { }
+
+	CborBuffer(CborBuffer &&) = default;
+	CborBuffer &operator=(CborBuffer &&) = default;
+
+	// returns false if data is malformed, all subsequent data will be ignored
+	bool read(const uint8_t *, size_t);
+	bool read(BytesView);
+
+	bool finalize() { return _state == Complete; }
+
+	bool isComplete() const { return _state == Complete; }
+	bool isFailed() const { return _state == Failed; }
+
+	ValueType &data() { return _data; }
+	ValueType extract() { return std::move(_data); }
+
+protected:
+	enum State : uint8_t {
+		Header,
+		Payload,
+		Complete,
+		Failed
+	};
+
+	struct Frame {
+		ValueType *value; // nullptr for root
+		size_t remaining; // items for arrays, pairs for maps
+		bool undefinedLength;
+		bool dictionary;
+		bool key; // map expects key as the next item
+	};
+
+	void beginItem();
+	void processHeader();
+	void completeItem();
+	void completeString(StringView);
+
+	void pushContainer(ValueType &, size_t size, bool undefinedLength);
+
+	ValueType &target();
+
+	State _state = Header;
+	bool _itemStarted = false;
+	bool _readKey = false; // current item is a map key, it's decoded into _keyValue
+	bool _chunked = false; // reading chunks of undefined length string
+	bool _stringKey = false; // map key was read as string directly into _key
+	cbor::MajorTypeEncoded _stringType = cbor::MajorTypeEncoded::CharString;
+
+	std::array<uint8_t, 9> _header;
+	uint8_t _headerSize = 0;
+	uint8_t _headerRequired = 0;
+	size_t _payloadRemaining = 0;
+
+	ValueType _data;
+	ValueType *_target = nullptr;
+	ValueType _keyValue;
+	StringType _buf;
+	StringType _key;
+	typename InterfaceType::template SmallVectorType<Frame, 16> _stack;
+
+	// if defined, dictionary keys for pool-based values will be stored in interner as weak strings
+	string::Interner *_interner = nullptr;
+};
+
+template <typename Interface>
+bool CborBuffer<Interface>::read(const uint8_t *ptr, size_t size) {
+	return read(BytesView(ptr, size));
+}
+
+template <typename Interface>
+bool CborBuffer<Interface>::read(BytesView r) {
+	while (!r.empty()) {
+		switch (_state) {
+		case Header:
+			if (_headerSize == 0) {
+				_header[0] = r[0];
+				auto info = _header[0] & toInt(cbor::Flags::AdditionalInfoMask);
+				if (info < toInt(cbor::Flags::MaxAdditionalNumber) || info == toInt(cbor::Flags::UndefinedLength)) {
+					_headerRequired = 1;
+				} else if (info <= toInt(cbor::Flags::AdditionalNumber64Bit)) {
+					_headerRequired = 1 + (1 << (info - toInt(cbor::Flags::AdditionalNumber8Bit)));
+				} else {
+					_state = Failed;
+					return false;
+				}
+				_headerSize = 1;
+				++ r;
+			}
+			if (_headerSize < _headerRequired) {
+				auto size = std::min(r.size(), size_t(_headerRequired - _headerSize));
+				memcpy(_header.data() + _headerSize, r.data(), size);
+				_headerSize += size;
+				r += size;
+			}
+			if (_headerSize == _headerRequired) {
+				processHeader();
+				_headerSize = 0;
+			}
+			break;
+		case Payload: {
+			auto size = std::min(r.size(), _payloadRemaining);
+			if (size == _payloadRemaining && !_chunked && _buf.empty()) {
+				// string is within a single chunk, no need to buffer it
+				_payloadRemaining = 0;
+				completeString(StringView((const char *)r.data(), size));
+				r += size;
+				break;
+			}
+			_buf.append((const char *)r.data(), size);
+			_payloadRemaining -= size;
+			r += size;
+			if (_payloadRemaining == 0) {
+				if (_chunked) {
+					_state = Header;
+				} else {
+					completeString(_buf);
+				}
+			}
+			break;
+		}
+		case Complete:
+			// trailing data is ignored
+			r.clear();
+			break;
+		case Failed:
+			return false;
+			break;
+		}
+	}
+	return _state != Failed;
+}
+
+template <typename Interface>
+auto CborBuffer<Interface>::target() -> ValueType & {
+	if (_readKey) {
+		return _keyValue;
+	}
+	return _target ? *_target : _data;
+}
+
+template <typename Interface>
+void CborBuffer<Interface>::beginItem() {
+	_itemStarted = true;
+	_readKey = false;
+	_stringKey = false;
+	if (_stack.empty()) {
+		_target = nullptr;
+		return;
+	}
+
+	auto &frame = _stack.back();
+	auto &container = frame.value ? *frame.value : _data;
+	if (!frame.dictionary) {
+		container.arrayVal->emplace_back(ValueType::Type::EMPTY);
+		_target = &container.arrayVal->back();
+	} else if (frame.key) {
+		_keyValue.clear();
+		_readKey = true;
+	} else {
+		if constexpr (Interface::usesMemoryPool()) {
+			if (_interner) {
+				auto str = _interner->intern(_key);
+				StringType weakKey;
+				weakKey.assign_weak(str.data(), str.size());
+				_target = &container.dictVal->emplace(std::move(weakKey), ValueType::Type::EMPTY).first->second;
+				return;
+			}
+		}
+		_target = &container.dictVal->emplace(std::move(_key), ValueType::Type::EMPTY).first->second;
+	}
+}
+
+template <typename Interface>
+void CborBuffer<Interface>::processHeader() {
+	auto majorType = cbor::MajorTypeEncoded(_header[0] & toInt(cbor::Flags::MajorTypeMaskEncoded));
+	uint8_t info = _header[0] & toInt(cbor::Flags::AdditionalInfoMask);
+
+	BytesViewTemplate<Endian::Network> r(_header.data() + 1, _headerSize - 1);
+
+	if (majorType == cbor::MajorTypeEncoded::Simple && info == toInt(cbor::Flags::UndefinedLength)) {
+		// break code
+		if (_chunked) {
+			_chunked = false;
+			completeString(_buf);
+		} else if (!_itemStarted && !_stack.empty() && _stack.back().undefinedLength
+				&& (_stack.back().key || !_stack.back().dictionary)) {
+			_stack.pop_back();
+			completeItem();
+		} else {
+			_state = Failed;
+		}
+		return;
+	}
+
+	if (_chunked) {
+		// only definite length chunks of the same type are allowed within undefined length string
+		if (majorType != _stringType || info == toInt(cbor::Flags::UndefinedLength)) {
+			_state = Failed;
+			return;
+		}
+		_payloadRemaining = size_t(cbor::_readIntValue(r, info));
+		if (_payloadRemaining > 0) {
+			_state = Payload;
+		}
+		return;
+	}
+
+	if (!_itemStarted) {
+		beginItem();
+	}
+
+	auto &v = target();
+
+	switch (majorType) {
+	case cbor::MajorTypeEncoded::Unsigned:
+		v._type = ValueType::Type::INTEGER;
+		v.intVal = int64_t(cbor::_readIntValue(r, info));
+		completeItem();
+		break;
+	case cbor::MajorTypeEncoded::Negative:
+		v._type = ValueType::Type::INTEGER;
+		v.intVal = int64_t(-1 - cbor::_readIntValue(r, info));
+		completeItem();
+		break;
+	case cbor::MajorTypeEncoded::ByteString:
+	case cbor::MajorTypeEncoded::CharString:
+		_stringType = majorType;
+		_buf.clear();
+		if (info == toInt(cbor::Flags::UndefinedLength)) {
+			_chunked = true;
+		} else {
+			_payloadRemaining = size_t(cbor::_readIntValue(r, info));
+			if (_payloadRemaining > 0) {
+				_state = Payload;
+			} else {
+				completeString(StringView());
+			}
+		}
+		break;
+	case cbor::MajorTypeEncoded::Array:
+	case cbor::MajorTypeEncoded::Map:
+		if (_readKey) {
+			// containers as map keys are not supported
+			_state = Failed;
+			return;
+		}
+		if (majorType == cbor::MajorTypeEncoded::Array) {
+			v._type = ValueType::Type::ARRAY;
+			v.arrayVal = new typename ValueType::ArrayType();
+		} else {
+			v._type = ValueType::Type::DICTIONARY;
+			v.dictVal = new typename ValueType::DictionaryType();
+		}
+		if (info == toInt(cbor::Flags::UndefinedLength)) {
+			pushContainer(v, 0, true);
+		} else if (auto size = size_t(cbor::_readIntValue(r, info))) {
+			pushContainer(v, size, false);
+		} else {
+			completeItem();
+		}
+		break;
+	case cbor::MajorTypeEncoded::Tag:
+		// tag applies to the next item, so item is not completed
+		break;
+	case cbor::MajorTypeEncoded::Simple:
+		if (info == toInt(cbor::Flags::Simple8Bit)) {
+			v._type = ValueType::Type::INTEGER;
+			v.intVal = r.readUnsigned();
+		} else if (info == toInt(cbor::Flags::AdditionalFloat16Bit)) {
+			v._type = ValueType::Type::DOUBLE;
+			v.doubleVal = double(r.readFloat16());
+		} else if (info == toInt(cbor::Flags::AdditionalFloat32Bit)) {
+			v._type = ValueType::Type::DOUBLE;
+			v.doubleVal = double(r.readFloat32());
+		} else if (info == toInt(cbor::Flags::AdditionalFloat64Bit)) {
+			v._type = ValueType::Type::DOUBLE;
+			v.doubleVal = r.readFloat64();
+		} else if (info == toInt(cbor::SimpleValue::Null) || info == toInt(cbor::SimpleValue::Undefined)) {
+			v._type = ValueType::Type::EMPTY;
+		} else if (info == toInt(cbor::SimpleValue::True)) {
+			v._type = ValueType::Type::BOOLEAN;
+			v.boolVal = true;
+		} else if (info == toInt(cbor::SimpleValue::False)) {
+			v._type = ValueType::Type::BOOLEAN;
+			v.boolVal = false;
+		} else {
+			v._type = ValueType::Type::INTEGER;
+			v.intVal = info;
+		}
+		completeItem();
+		break;
+	}
+}
+
+template <typename Interface>
+void CborBuffer<Interface>::pushContainer(ValueType &v, size_t size, bool undefinedLength) {
+	if (!undefinedLength && v.isArray()) {
+		// size is not trusted, it can be arbitrary large in malformed data
+		v.arrayVal->reserve(std::min(size, size_t(1024)));
+	}
+	_stack.push_back(Frame{_stack.empty() ? nullptr : _target, size, undefinedLength, v.isDictionary(), v.isDictionary()});
+	_itemStarted = false;
+	_readKey = false;
+}
+
+template <typename Interface>
+void CborBuffer<Interface>::completeString(StringView str) {
+	if (_readKey) {
+		_key.assign(str.data(), str.size());
+		_stringKey = true;
+	} else {
+		auto &v = target();
+		if (_stringType == cbor::MajorTypeEncoded::CharString) {
+			v._type = ValueType::Type::CHARSTRING;
+			v.strVal = new StringType(str.data(), str.size());
+		} else {
+			v._type = ValueType::Type::BYTESTRING;
+			v.bytesVal = new BytesType((const uint8_t *)str.data(), (const uint8_t *)str.data() + str.size());
+		}
+	}
+	_buf.clear();
+	_state = Header;
+	completeItem();
+}
+
+template <typename Interface>
+void CborBuffer<Interface>::completeItem() {
+	_itemStarted = false;
+	while (!_stack.empty()) {
+		auto &frame = _stack.back();
+		if (frame.key) {
+			// key is completed, it will be used for the next item
+			_readKey = false;
+			frame.key = false;
+			if (!_stringKey) {
+				if (_keyValue.isInteger()) {
+					_key = string::ToStringTraits<Interface>::toString(_keyValue.getInteger());
+				} else {
+					_state = Failed;
+				}
+			}
+			return;
+		}
+
+		if (frame.dictionary) {
+			frame.key = true;
+		}
+
+		if (frame.undefinedLength || -- frame.remaining > 0) {
+			return;
+		}
+
+		// container is completed as an item of it's parent
+		_stack.pop_back();
+	}
+	_target = nullptr;
+	_state = Complete;
+}
+
+}
+
+#endif /* MODULES_DATA_SPDATACBORBUFFER_H_ */
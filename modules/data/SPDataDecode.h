@@ -27,6 +27,10 @@ THE SOFTWARE.
 #include "SPDataDecodeCbor.h"
 #include "SPDataDecodeJson.h"
 #include "SPDataDecodeSerenity.h"
+#include "SPDataJsonBuffer.h"
+#include "SPDataCborBuffer.h"
+
+#include <variant>
 
 namespace stappler::data {
 
@@ -45,8 +49,7 @@ enum class DataFormat {
 	Brotli_Word,
 #endif
 
-	// for future implementations
-	// Encrypt,
+	Encrypted,
 };
 
 inline DataFormat detectDataFormat(const uint8_t *ptr, size_t size) {
@@ -54,6 +57,8 @@ inline DataFormat detectDataFormat(const uint8_t *ptr, size_t size) {
 		return DataFormat::Cbor;
 	} else if (size > 4 && ptr[0] == '2' && ptr[1] == 'd' && ptr[2] == 'n' && ptr[3] == '3') {
 		return DataFormat::CborBase64;
+	} else if (size > 4 && ptr[0] == 'S' && ptr[1] == 'P' && ptr[2] == 'E' && ptr[3] == 'V') {
+		return DataFormat::Encrypted;
 	} else if (size > 3 && ptr[0] == 'L' && ptr[1] == 'Z' && ptr[2] == '4') {
 		if (ptr[3] == 'S') {
 			return DataFormat::LZ4_Short;
@@ -85,6 +90,10 @@ auto decompressBrotli(const uint8_t *, size_t, bool sh) -> ValueTemplate<Interfa
 template <typename Interface>
 auto decompress(const uint8_t *, size_t) -> typename Interface::BytesType;
 
+// decrypted blocks are decoded incrementally for JSON and CBOR, without full plain text copy
+template <typename Interface>
+auto decryptValue(const uint8_t *, size_t, BytesView key) -> ValueTemplate<Interface>;
+
 template <typename Interface, typename StringType>
 auto read(const StringType &data, const StringView &key = StringView()) -> ValueTemplate<Interface> {
 	if (data.size() == 0) {
@@ -118,16 +127,151 @@ auto read(const StringType &data, const StringView &key = StringView()) -> Value
 		return decompressBrotli<Interface>((const uint8_t *)data.data() + 4, data.size() - 4, false);
 		break;
 #endif
+	case DataFormat::Encrypted:
+		return decryptValue<Interface>((const uint8_t *)data.data(), data.size(), BytesView((const uint8_t *)key.data(), key.size()));
+		break;
 	default:
 		break;
 	}
 	return ValueTemplate<Interface>();
 }
 
+// key provider is called only when encrypted data was detected
+template <typename Interface, typename StringType, typename KeyProvider,
+	typename std::enable_if<std::is_invocable_r<StringView, const KeyProvider &>::value>::type* = nullptr>
+auto read(const StringType &data, const KeyProvider &provider) -> ValueTemplate<Interface> {
+	if (data.size() > 0 && detectDataFormat((const uint8_t *)data.data(), data.size()) == DataFormat::Encrypted) {
+		return read<Interface>(data, StringView(provider()));
+	}
+	return read<Interface>(data);
+}
+
+// Incremental decoder for streamed data, only JSON and CBOR are supported
+// If format is not defined, it's detected with the first byte: JSON starts with ASCII char,
+// CBOR usually starts with self-describe tag (0xd9d9f7) or other non-ASCII header
+template <typename Interface>
+class StreamBuffer : public Interface::AllocBaseType {
+public:
+	using ValueType = ValueTemplate<Interface>;
+
+	StreamBuffer(DataFormat fmt = DataFormat::Unknown, string::Interner *i = nullptr)
+	: _requested(fmt), _format(fmt), _interner(i) { }
+
+	// format can be changed only before the first data was read
+	bool setFormat(DataFormat fmt) {
+		if (std::holds_alternative<std::monostate>(_buffer)) {
+			_format = fmt;
+			return true;
+		}
+		return false;
+	}
+
+	DataFormat getFormat() const { return _format; }
+
+	bool read(const uint8_t *ptr, size_t size) {
+		if (size == 0) {
+			return !isFailed();
+		}
+
+		if (std::holds_alternative<std::monostate>(_buffer)) {
+			if (_format == DataFormat::Unknown) {
+				_format = (ptr[0] & 0x80) ? DataFormat::Cbor : DataFormat::Json;
+			}
+			switch (_format) {
+			case DataFormat::Json: _buffer = JsonBuffer<Interface>(_interner); break;
+			case DataFormat::Cbor: _buffer = CborBuffer<Interface>(_interner); break;
+			default: _failed = true; break;
+			}
+		}
+
+		return std::visit([&] (auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, std::monostate>) {
+				return false;
+			} else {
+				return arg.read(ptr, size);
+			}
+		}, _buffer);
+	}
+
+	bool read(BytesView data) {
+		return read(data.data(), data.size());
+	}
+
+	// end of stream, returns true if complete value was decoded
+	bool finalize() {
+		return std::visit([&] (auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, std::monostate>) {
+				return false;
+			} else {
+				return arg.finalize();
+			}
+		}, _buffer);
+	}
+
+	bool isComplete() const {
+		return std::visit([&] (auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, std::monostate>) {
+				return false;
+			} else {
+				return arg.isComplete();
+			}
+		}, _buffer);
+	}
+
+	bool isFailed() const {
+		return std::visit([&] (auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, std::monostate>) {
+				return _failed;
+			} else {
+				return arg.isFailed();
+			}
+		}, _buffer);
+	}
+
+	// value is available only when decoding is complete
+	ValueType extract() {
+		return std::visit([&] (auto &&arg) {
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, std::monostate>) {
+				return ValueType();
+			} else {
+				return arg.isComplete() ? arg.extract() : ValueType();
+			}
+		}, _buffer);
+	}
+
+	// drop decoded data and restore requested format
+	void clear() {
+		_buffer = std::monostate();
+		_format = _requested;
+		_failed = false;
+	}
+
+protected:
+	DataFormat _requested = DataFormat::Unknown;
+	DataFormat _format = DataFormat::Unknown;
+	bool _failed = false;
+	string::Interner *_interner = nullptr;
+	std::variant<std::monostate, JsonBuffer<Interface>, CborBuffer<Interface>> _buffer;
+};
+
 #ifdef MODULE_COMMON_FILESYSTEM
+// file is decoded directly from memory mapping, without intermediate copy
 template <typename Interface>
 auto readFile(StringView filename, const StringView &key = StringView()) -> ValueTemplate<Interface> {
-	return read<Interface>(filesystem::readIntoMemory<Interface>(filename));
+	if (auto file = filesystem::MappedFile::open(filename, filesystem::MappedFile::Flags::Sequential)) {
+		return read<Interface>(file.view(), key);
+	}
+	return read<Interface>(filesystem::readIntoMemory<Interface>(filename), key);
+}
+
+template <typename Interface>
+auto readFile(const filesystem::MappedFile &file, const StringView &key = StringView()) -> ValueTemplate<Interface> {
+	return read<Interface>(file.view(), key);
 }
 #endif
 }
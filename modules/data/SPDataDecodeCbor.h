@@ -25,6 +25,7 @@ THE SOFTWARE.
 
 #include "SPDataValue.h"
 #include "SPDataCbor.h"
+#include "SPStringInterner.h"
 
 namespace stappler::data::cbor {
 
@@ -37,9 +38,7 @@ struct Decoder : public Interface::AllocBaseType {
 	using ArrayType = typename ValueType::ArrayType;
 	using DictionaryType = typename ValueType::DictionaryType;
 
-	Decoder(BytesViewTemplate<Endian::Network> &r) : r(r), back(nullptr) {
-		stack.reserve(10);
-	}
+	Decoder(BytesViewTemplate<Endian::Network> &r, string::Interner *i = nullptr) : r(r), back(nullptr), interner(i) { }
 
 	void decodePositiveInt(uint8_t type, ValueType &v) {
 		auto value = _readIntValue(r, type);
@@ -68,10 +67,15 @@ struct Decoder : public Interface::AllocBaseType {
 	void parseValue(ValueType &current);
 	void parse(ValueType &val);
 
+	ValueType &emplaceKey(DictionaryType &, StringView key);
+
 	BytesViewTemplate<Endian::Network> r;
 	StringType buf;
 	ValueType *back;
-	typename InterfaceType::template ArrayType<ValueType *> stack;
+	typename InterfaceType::template SmallVectorType<ValueType *, 16> stack;
+
+	// if defined, dictionary keys for pool-based values will be stored in interner as weak strings
+	string::Interner *interner = nullptr;
 };
 
 template <typename Interface>
@@ -272,7 +276,7 @@ void Decoder<Interface>::decodeMap(uint8_t type, ValueType &ret) {
 			}
 
 			if (!skip) {
-				decode(majorType, type, ret.dictVal->emplace(key.str<Interface>(), ValueType::Type::EMPTY).first->second);
+				decode(majorType, type, emplaceKey(*ret.dictVal, key));
 			} else {
 				ValueType val;
 				decode(majorType, type, val);
@@ -292,6 +296,19 @@ void Decoder<Interface>::decodeMap(uint8_t type, ValueType &ret) {
 	}
 }
 
+template <typename Interface>
+auto Decoder<Interface>::emplaceKey(DictionaryType &dict, StringView key) -> ValueType & {
+	if constexpr (Interface::usesMemoryPool()) {
+		if (interner) {
+			auto str = interner->intern(key);
+			StringType weakKey;
+			weakKey.assign_weak(str.data(), str.size());
+			return dict.emplace(std::move(weakKey), ValueType::Type::EMPTY).first->second;
+		}
+	}
+	return dict.emplace(key.str<Interface>(), ValueType::Type::EMPTY).first->second;
+}
+
 template <typename Interface>
 void Decoder<Interface>::decodeTaggedValue(uint8_t type, ValueType &ret) {
 	/* auto tagValue = */ _readIntValue(r, type);
@@ -370,7 +387,7 @@ void Decoder<Interface>::decode(ValueType &ret) {
 }
 
 template <typename Interface>
-auto read(BytesViewTemplate<Endian::Network> &data) -> ValueTemplate<Interface> {
+auto read(BytesViewTemplate<Endian::Network> &data, string::Interner *interner = nullptr) -> ValueTemplate<Interface> {
 	// read CBOR id ( 0xd9d9f7 )
 	if (data.size() <= 3 || data[0] != 0xd9 || data[1] != 0xd9 || data[2] != 0xf7) {
 		return ValueTemplate<Interface>();
@@ -380,14 +397,14 @@ auto read(BytesViewTemplate<Endian::Network> &data) -> ValueTemplate<Interface>
 	reader.offset(3);
 
 	ValueTemplate<Interface> ret;
-	Decoder<Interface> dec(reader);
+	Decoder<Interface> dec(reader, interner);
 	dec.decode(ret);
 	data = dec.r;
 	return ret;
 }
 
 template <typename Interface>
-auto read(BytesViewTemplate<Endian::Little> &data) -> ValueTemplate<Interface> {
+auto read(BytesViewTemplate<Endian::Little> &data, string::Interner *interner = nullptr) -> ValueTemplate<Interface> {
 	// read CBOR id ( 0xd9d9f7 )
 	if (data.size() <= 3 || data[0] != 0xd9 || data[1] != 0xd9 || data[2] != 0xf7) {
 		return ValueTemplate<Interface>();
@@ -397,16 +414,16 @@ auto read(BytesViewTemplate<Endian::Little> &data) -> ValueTemplate<Interface> {
 	reader.offset(3);
 
 	ValueTemplate<Interface> ret;
-	Decoder<Interface> dec(reader);
+	Decoder<Interface> dec(reader, interner);
 	dec.decode(ret);
 	data = dec.r;
 	return ret;
 }
 
 template <typename Interface, typename Container>
-auto read(const Container &data) -> ValueTemplate<Interface> {
+auto read(const Container &data, string::Interner *interner = nullptr) -> ValueTemplate<Interface> {
 	BytesViewTemplate<Endian::Network> reader((const uint8_t*)data.data(), data.size());
-	return read<Interface>(reader);
+	return read<Interface>(reader, interner);
 }
 
 }
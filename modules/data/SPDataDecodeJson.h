@@ -24,6 +24,7 @@ THE SOFTWARE.
 #define MODULES_DATA_SPDATADECODEJSON_H_
 
 #include "SPDataValue.h"
+#include "SPStringInterner.h"
 
 namespace stappler::data::json {
 
@@ -50,6 +51,19 @@ inline StringView decodeNumber(StringView &r, bool &isFloat) {
 	return StringView(tmp.data(), tmp.size() - r.size());
 }
 
+inline char decodeEscapeChar(char c) {
+#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+	static const char escape[256] = {
+		Z16, Z16, 0, 0,'\"', 0, 0, 0, 0, '\'', 0, 0, 0, 0, 0, 0, 0,'/',
+		Z16, Z16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'\\', 0, 0, 0,
+		0, 0,'\b', 0, 0, 0,'\f', 0, 0, 0, 0, 0, 0, 0,'\n', 0,
+		0, 0,'\r', 0,'\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
+	};
+#undef Z16
+	return escape[uint8_t(c)];
+}
+
 template <typename Interface>
 struct Decoder : public Interface::AllocBaseType {
 	using InterfaceType = Interface;
@@ -62,11 +76,11 @@ struct Decoder : public Interface::AllocBaseType {
 		BackIsEmpty
 	};
 
-	Decoder(StringView &r, bool v) : validate(v), backType(BackIsEmpty), r(r), back(nullptr) {
-		stack.reserve(10);
-	}
+	Decoder(StringView &r, bool v, string::Interner *i = nullptr)
+	: validate(v), backType(BackIsEmpty), r(r), back(nullptr), interner(i) { }
 
 	inline void parseBufferString(StringType &ref);
+	inline ValueType &emplaceKey(StringType &key);
 	inline void parseJsonNumber(ValueType &ref) SPINLINE;
 
 	inline void parseValue(ValueType &current);
@@ -97,20 +111,14 @@ struct Decoder : public Interface::AllocBaseType {
 	StringView r;
 	ValueType *back;
 	StringType buf;
-	typename InterfaceType::template ArrayType<ValueType *> stack;
+	typename InterfaceType::template SmallVectorType<ValueType *, 16> stack;
+
+	// if defined, dictionary keys for pool-based values will be stored in interner as weak strings
+	string::Interner *interner = nullptr;
 };
 
 template <typename Interface>
 inline void Decoder<Interface>::parseBufferString(StringType &ref) {
-#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-	static const char escape[256] = {
-		Z16, Z16, 0, 0,'\"', 0, 0, 0, 0, '\'', 0, 0, 0, 0, 0, 0, 0,'/',
-		Z16, Z16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'\\', 0, 0, 0,
-		0, 0,'\b', 0, 0, 0,'\f', 0, 0, 0, 0, 0, 0, 0,'\n', 0,
-		0, 0,'\r', 0,'\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
-	};
-#undef Z16
 	if (r.is('"')) { r ++; }
 	auto s = r.readUntil<StringView::Chars<'\\', '"'>>();
 	ref.assign(s.data(), s.size());
@@ -126,7 +134,7 @@ inline void Decoder<Interface>::parseBufferString(StringType &ref) {
 					r.clear();
 				}
 			} else {
-				ref.push_back(escape[(uint8_t)r[0]]);
+				ref.push_back(decodeEscapeChar(r[0]));
 				++ r;
 			}
 		}
@@ -136,6 +144,20 @@ inline void Decoder<Interface>::parseBufferString(StringType &ref) {
 	if (r.is('"')) { ++ r; }
 }
 
+template <typename Interface>
+inline auto Decoder<Interface>::emplaceKey(StringType &key) -> ValueType & {
+	if constexpr (Interface::usesMemoryPool()) {
+		if (interner) {
+			// key buffer is not consumed, so its memory will be reused for the next key
+			auto str = interner->intern(key);
+			StringType weakKey;
+			weakKey.assign_weak(str.data(), str.size());
+			return back->dictVal->emplace(std::move(weakKey), ValueType::Type::EMPTY).first->second;
+		}
+	}
+	return back->dictVal->emplace(std::move(key), ValueType::Type::EMPTY).first->second;
+}
+
 template <typename Interface>
 inline void Decoder<Interface>::parseJsonNumber(ValueType &result) {
 	bool isFloat = false;
@@ -233,7 +255,7 @@ void Decoder<Interface>::parseJson(ValueType &val) {
 				} else {
 					r.skipChars<StringView::Chars<':', ' ', '\n', '\r', '\t'>>();
 				}
-				parseValue(back->dictVal->emplace(std::move(buf), ValueType::Type::EMPTY).first->second);
+				parseValue(emplaceKey(buf));
 			} else {
 				pop();
 			}
@@ -246,14 +268,14 @@ void Decoder<Interface>::parseJson(ValueType &val) {
 }
 
 template <typename Interface>
-auto read(StringView &n, bool validate = false) -> ValueTemplate<Interface> {
+auto read(StringView &n, bool validate = false, string::Interner *interner = nullptr) -> ValueTemplate<Interface> {
 	auto r = n;
 	if (r.empty() || r == "null") {
 		return ValueTemplate<Interface>();
 	}
 
 	r.skipChars<StringView::Chars<' ', '\n', '\r', '\t'>>();
-	Decoder<Interface> dec(r, validate);
+	Decoder<Interface> dec(r, validate, interner);
 	ValueTemplate<Interface> ret;
 	dec.parseJson(ret);
 	n = dec.r;
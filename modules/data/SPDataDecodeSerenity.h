@@ -48,9 +48,7 @@ struct Decoder : public Interface::AllocBaseType {
 		Generic,
 	};
 
-	Decoder(StringView &r) : backType(BackIsGeneric), r(r), back(nullptr) {
-		stack.reserve(10);
-	}
+	Decoder(StringView &r) : backType(BackIsGeneric), r(r), back(nullptr) { }
 
 	inline void parseBufferString(StringType &ref);
 	inline void parseNumber(StringView &token, ValueType &ref) SPINLINE;
@@ -88,7 +86,7 @@ struct Decoder : public Interface::AllocBaseType {
 	BackType backType;
 	StringView r;
 	ValueType *back;
-	typename InterfaceType::template ArrayType<Pair<BackType, ValueType *>> stack;
+	typename InterfaceType::template SmallVectorType<Pair<BackType, ValueType *>, 16> stack;
 };
 
 template <typename Interface>
@@ -61,6 +61,8 @@ struct EncodeFormat {
 		DefaultCompress = NoCompression
 	};
 
+	// Encrypted data is split into blocks, every block compressed with LZ4 and sealed with AES-256-GCM,
+	// so encoding, compression and encryption runs as a single pass; requires 'common_crypto' module
 	enum Encryption {
 		Unencrypted			= 0b0000 << 8,
 		Encrypted			= 0b0001 << 8
@@ -69,20 +71,22 @@ struct EncodeFormat {
 	static EncodeFormat CborCompressed;
 	static EncodeFormat JsonCompressed;
 
-	constexpr EncodeFormat(Format fmt = DefaultFormat, Compression cmp = DefaultCompress, Encryption enc = Unencrypted, StringView = StringView())
-	: format(fmt), compression(cmp), encryption(enc) { }
+	// key is not copied, it should be valid until encoding is finished
+	constexpr EncodeFormat(Format fmt = DefaultFormat, Compression cmp = DefaultCompress, Encryption enc = Unencrypted, StringView k = StringView())
+	: format(fmt), compression(cmp), encryption(enc), key(k) { }
 
 	constexpr explicit EncodeFormat(long flag)
 	: format((Format)(flag & 0x0F)), compression((Compression)(flag & 0xF0))
 	, encryption((Encryption)(flag &0xF00)) { }
 
 	EncodeFormat(const EncodeFormat & other) : format(other.format), compression(other.compression)
-	, encryption(other.encryption) { }
+	, encryption(other.encryption), key(other.key) { }
 
 	EncodeFormat & operator=(const EncodeFormat & other) {
 		format = other.format;
 		compression = other.compression;
 		encryption = other.encryption;
+		key = other.key;
 		return *this;
 	}
 
@@ -101,6 +105,7 @@ struct EncodeFormat {
 	Format format;
 	Compression compression;
 	Encryption encryption;
+	StringView key;
 };
 
 uint8_t *getLZ4EncodeState();
@@ -112,6 +117,9 @@ auto compress(const uint8_t *, size_t, EncodeFormat::Compression, bool condition
 
 size_t getCompressBounds(size_t, EncodeFormat::Compression);
 
+// encoder writes into stream, encrypted blocks are passed into callback as soon as they are filled
+bool writeEncrypted(const EncodeFormat &, const Callback<void(std::ostream &)> &, const Callback<void(const uint8_t *, size_t)> &);
+
 template <typename Interface>
 struct EncodeTraits {
 	using InterfaceType = Interface;
@@ -121,6 +129,17 @@ struct EncodeTraits {
 
 	static BytesType write(const ValueType &data, EncodeFormat fmt) {
 		BytesType ret;
+		if (fmt.encryption == EncodeFormat::Encrypted) {
+			if (!writeEncrypted(fmt, [&] (std::ostream &stream) {
+				write(stream, data, EncodeFormat(fmt.format));
+			}, [&] (const uint8_t *buf, size_t size) {
+				ret.insert(ret.end(), buf, buf + size);
+			})) {
+				ret.clear();
+			}
+			return ret;
+		}
+
 		switch (fmt.format) {
 		case EncodeFormat::Json:
 		case EncodeFormat::Pretty:
@@ -166,6 +185,12 @@ struct EncodeTraits {
 			case EncodeFormat::Serenity: serenity::write(stream, data, false); return true; break;
 			case EncodeFormat::SerenityPretty: serenity::write(stream, data, true); return true; break;
 			}
+		} else if (fmt.encryption == EncodeFormat::Encrypted) {
+			return writeEncrypted(fmt, [&] (std::ostream &out) {
+				write(out, data, EncodeFormat(fmt.format));
+			}, [&] (const uint8_t *buf, size_t size) {
+				stream.write((const char *)buf, size);
+			});
 		} else {
 			auto ret = write(data, fmt);
 			if (!ret.empty()) {
@@ -0,0 +1,395 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef MODULES_DATA_SPDATAJSONBUFFER_H_
+#define MODULES_DATA_SPDATAJSONBUFFER_H_
+
+#include "SPDataDecodeJson.h"
+
+namespace stappler::data {
+
+// Incremental JSON decoder
+// Data can be fed with chunks of any size, value is built as data arrives, so complete source buffer
+// is not required. Only incomplete token (string, number or literal) is buffered between chunks.
+template <typename Interface>
+class JsonBuffer : public Interface::AllocBaseType {
+public:
+	using InterfaceType = Interface;
+	using ValueType = ValueTemplate<Interface>;
+	using StringType = typename InterfaceType::StringType;
+
+	JsonBuffer(string::Interner *i = nullptr) : _interner(i) { }
+
+	JsonBuffer(JsonBuffer &&) = default;
+	JsonBuffer &operator=(JsonBuffer &&) = default;
+
+	// returns false if data is malformed, all subsequent data will be ignored
+	bool read(const uint8_t *, size_t);
+	bool read(StringView);
+
+	// end of stream, top-level number or literal is completed here
+	bool finalize();
+
+	bool isComplete() const { return _state == Complete; }
+	bool isFailed() const { return _state == Failed; }
+
+	ValueType &data() { return _data; }
+	ValueType extract() { return std::move(_data); }
+
+protected:
+	enum State : uint8_t {
+		Value,
+		ArrayValue,
+		DictKey,
+		DictColon,
+		Complete,
+		Failed
+	};
+
+	enum Token : uint8_t {
+		None,
+		String,
+		Key,
+		Number,
+		Literal
+	};
+
+	// root value is stored as nullptr, so buffer can be moved within transfer
+	ValueType *resolve(ValueType *v) { return v ? v : &_data; }
+
+	void beginValue(StringView &r);
+	void completeValue();
+	void completeString(StringView);
+	void completeNumber(StringView);
+	void completeLiteral();
+
+	void readString(StringView &r);
+
+	void push(ValueType *);
+	void pop();
+
+	ValueType &emplaceKey(ValueType &dict);
+
+	State _state = Value;
+	Token _token = None;
+	uint8_t _escape = 0; // 1 - after backslash, 2-5 - number of \u digits read + 2
+	std::array<char, 4> _unicode;
+
+	ValueType _data;
+	ValueType *_target = nullptr;
+	StringType _buf;
+	StringType _key;
+	typename InterfaceType::template SmallVectorType<ValueType *, 16> _stack;
+
+	// if defined, dictionary keys for pool-based values will be stored in interner as weak strings
+	string::Interner *_interner = nullptr;
+};
+
+template <typename Interface>
+bool JsonBuffer<Interface>::read(const uint8_t *ptr, size_t size) {
+	return read(StringView((const char *)ptr, size));
+}
+
+template <typename Interface>
+bool JsonBuffer<Interface>::read(StringView r) {
+	while (!r.empty() && _state != Failed) {
+		switch (_token) {
+		case String:
+		case Key:
+			readString(r);
+			continue;
+			break;
+		case Number:
+			do {
+				auto s = r.readChars<StringView::CharGroup<CharGroupId::Numbers>, StringView::Chars<'+', '-', '.', 'e', 'E'>>();
+				if (!r.empty() && _buf.empty()) {
+					// number is within a single chunk, no need to buffer it
+					completeNumber(s);
+				} else {
+					_buf.append(s.data(), s.size());
+					if (!r.empty()) {
+						completeNumber(_buf);
+					}
+				}
+			} while (0);
+			continue;
+			break;
+		case Literal:
+			do {
+				auto s = r.readChars<StringView::Range<'a', 'z'>>();
+				_buf.append(s.data(), s.size());
+			} while (0);
+			if (!r.empty()) {
+				completeLiteral();
+			}
+			continue;
+			break;
+		case None:
+			break;
+		}
+
+		switch (_state) {
+		case Value:
+			r.skipChars<StringView::Chars<' ', '\n', '\r', '\t'>>();
+			if (!r.empty()) {
+				beginValue(r);
+			}
+			break;
+		case ArrayValue:
+			r.skipChars<StringView::Chars<' ', '\n', '\r', '\t', ','>>();
+			if (r.is(']')) {
+				++ r;
+				pop();
+			} else if (!r.empty()) {
+				auto back = resolve(_stack.back());
+				back->arrayVal->emplace_back(ValueType::Type::EMPTY);
+				_target = &back->arrayVal->back();
+				beginValue(r);
+			}
+			break;
+		case DictKey:
+			r.skipChars<StringView::Chars<' ', '\n', '\r', '\t', ','>>();
+			if (r.is('}')) {
+				++ r;
+				pop();
+			} else if (r.is('"')) {
+				++ r;
+				_token = Key;
+				_buf.clear();
+			} else if (!r.empty()) {
+				_state = Failed;
+			}
+			break;
+		case DictColon:
+			r.skipChars<StringView::Chars<':', ' ', '\n', '\r', '\t'>>();
+			if (!r.empty()) {
+				_target = &emplaceKey(*resolve(_stack.back()));
+				beginValue(r);
+			}
+			break;
+		case Complete:
+			// trailing data is ignored
+			r.clear();
+			break;
+		case Failed:
+			return false;
+			break;
+		}
+	}
+	return _state != Failed;
+}
+
+template <typename Interface>
+bool JsonBuffer<Interface>::finalize() {
+	switch (_token) {
+	case Number: completeNumber(_buf); break;
+	case Literal: completeLiteral(); break;
+	default: break;
+	}
+	return _state == Complete;
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::beginValue(StringView &r) {
+	auto target = resolve(_target);
+	switch (r[0]) {
+	case '"':
+		++ r;
+		_token = String;
+		_buf.clear();
+		break;
+	case 't': case 'f': case 'n':
+		_token = Literal;
+		_buf.clear();
+		break;
+	case '0': case '1': case '2': case '3': case '4': case '5':
+	case '6': case '7': case '8': case '9': case '+': case '-':
+		_token = Number;
+		_buf.clear();
+		break;
+	case '[':
+		++ r;
+		target->_type = ValueType::Type::ARRAY;
+		target->arrayVal = new typename ValueType::ArrayType();
+		push(_target);
+		break;
+	case '{':
+		++ r;
+		target->_type = ValueType::Type::DICTIONARY;
+		target->dictVal = new typename ValueType::DictionaryType();
+		push(_target);
+		break;
+	default:
+		if (r.is('}') && !_stack.empty() && resolve(_stack.back())->isDictionary()) {
+			// value is missing, leave it empty, bracket will be processed by container
+			completeValue();
+		} else {
+			_state = Failed;
+		}
+		break;
+	}
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::completeValue() {
+	_token = None;
+	_target = nullptr;
+	if (_stack.empty()) {
+		_state = Complete;
+	} else {
+		_state = resolve(_stack.back())->isArray() ? ArrayValue : DictKey;
+	}
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::completeString(StringView str) {
+	if (_token == Key) {
+		_key.assign(str.data(), str.size());
+		_token = None;
+		_state = DictColon;
+	} else {
+		auto target = resolve(_target);
+		target->_type = ValueType::Type::CHARSTRING;
+		target->strVal = new StringType(str.data(), str.size());
+		completeValue();
+	}
+	_buf.clear();
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::completeNumber(StringView r) {
+	auto target = resolve(_target);
+	bool isFloat = false;
+	auto value = json::decodeNumber(r, isFloat);
+	if (value.empty() || !r.empty()) {
+		_state = Failed;
+		return;
+	}
+
+	if (isFloat) {
+		value.readDouble().unwrap([&] (double v) {
+			target->_type = ValueType::Type::DOUBLE;
+			target->doubleVal = v;
+		});
+	} else {
+		value.readInteger().unwrap([&] (int64_t v) {
+			target->_type = ValueType::Type::INTEGER;
+			target->intVal = v;
+		});
+	}
+	completeValue();
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::completeLiteral() {
+	auto target = resolve(_target);
+	StringView r(_buf);
+	if (r == "true") {
+		target->_type = ValueType::Type::BOOLEAN;
+		target->boolVal = true;
+	} else if (r == "false") {
+		target->_type = ValueType::Type::BOOLEAN;
+		target->boolVal = false;
+	} else if (r == "nan") {
+		target->_type = ValueType::Type::DOUBLE;
+		target->doubleVal = nan();
+	} else if (r != "null") {
+		_state = Failed;
+		return;
+	}
+	completeValue();
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::readString(StringView &r) {
+	while (!r.empty()) {
+		if (_escape == 1) {
+			if (r.is('u')) {
+				_escape = 2;
+			} else {
+				_buf.push_back(json::decodeEscapeChar(r[0]));
+				_escape = 0;
+			}
+			++ r;
+		} else if (_escape > 1) {
+			_unicode[_escape - 2] = r[0];
+			++ r;
+			if (++ _escape == 6) {
+				string::utf8Encode(_buf, char16_t(base16::hexToChar(_unicode[0], _unicode[1]) << 8
+						| base16::hexToChar(_unicode[2], _unicode[3])));
+				_escape = 0;
+			}
+		} else {
+			auto s = r.readUntil<StringView::Chars<'\\', '"'>>();
+			if (r.is('"') && _buf.empty()) {
+				// string is within a single chunk and has no escapes, no need to buffer it
+				++ r;
+				completeString(s);
+				return;
+			}
+			_buf.append(s.data(), s.size());
+			if (r.is('\\')) {
+				++ r;
+				_escape = 1;
+			} else if (r.is('"')) {
+				++ r;
+				completeString(_buf);
+				return;
+			}
+		}
+	}
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::push(ValueType *v) {
+	_stack.push_back(v);
+	_target = nullptr;
+	_token = None;
+	_state = resolve(v)->isArray() ? ArrayValue : DictKey;
+}
+
+template <typename Interface>
+void JsonBuffer<Interface>::pop() {
+	auto back = resolve(_stack.back());
+	if (back->isArray()) {
+		back->arrayVal->shrink_to_fit();
+	}
+	_stack.pop_back();
+	completeValue();
+}
+
+template <typename Interface>
+auto JsonBuffer<Interface>::emplaceKey(ValueType &dict) -> ValueType & {
+	if constexpr (Interface::usesMemoryPool()) {
+		if (_interner) {
+			auto str = _interner->intern(_key);
+			StringType weakKey;
+			weakKey.assign_weak(str.data(), str.size());
+			return dict.dictVal->emplace(std::move(weakKey), ValueType::Type::EMPTY).first->second;
+		}
+	}
+	return dict.dictVal->emplace(std::move(_key), ValueType::Type::EMPTY).first->second;
+}
+
+}
+
+#endif /* MODULES_DATA_SPDATAJSONBUFFER_H_ */
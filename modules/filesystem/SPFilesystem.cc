@@ -22,6 +22,13 @@
 
 #include "SPFilesystem.h"
 
+#ifndef __MINGW32__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace stappler::filesystem {
 
 File File::open_tmp(const char *prefix, bool delOnClose) {
@@ -168,6 +175,13 @@ size_t File::size() const {
 	return _size;
 }
 
+int File::fd() const {
+	if (!_isBundled && _nativeFile) {
+		return fileno(_nativeFile);
+	}
+	return -1;
+}
+
 typename File::int_type File::xsgetc() {
 	int_type ret = traits_type::eof();
 	if (is_open()) {
@@ -201,6 +215,19 @@ typename File::streamsize File::xsputn(const char* s, streamsize n) {
 	return ret;
 }
 
+void File::flush() {
+	if (is_open() && !_isBundled) {
+		fflush(_nativeFile);
+#ifndef __MINGW32__
+		// stdio caches descriptor position, it can be changed by direct writes
+		auto pos = ::lseek(fileno(_nativeFile), 0, SEEK_CUR);
+		if (pos >= 0) {
+			fseeko(_nativeFile, pos, SEEK_SET);
+		}
+#endif
+	}
+}
+
 typename File::streamsize File::xsgetn(char* s, streamsize n) {
 	streamsize ret = -1;
 	if (is_open()) {
@@ -297,12 +324,13 @@ bool exists(StringView ipath) {
 	}
 }
 
-bool stat(StringView path, Stat &stat) {
-	if (filepath::inAppBundle(path)) {
-		return filesystem::platform::_stat(path, stat);
+bool stat(StringView ipath, Stat &stat) {
+	if (filepath::inAppBundle(ipath)) {
+		return filesystem::platform::_stat(ipath, stat);
 	}
 
-	return filesystem::stat(path, stat);
+	auto path = filepath::absolute<memory::StandartInterface>(ipath);
+	return filesystem::native::stat_fn(path, stat);
 }
 
 bool remove(StringView ipath, bool recursive, bool withDirs) {
@@ -405,6 +433,11 @@ bool ftw_b(StringView ipath, const Callback<bool(StringView path, bool isFile)>
 	return filesystem::native::ftw_b_fn(path, callback, depth, dir_first);
 }
 
+bool walk(StringView ipath, const Callback<bool(SpanView<WalkEntry>)> &callback, const WalkOptions &opts) {
+	auto path = filepath::absolute<memory::StandartInterface>(ipath, true);
+	return filesystem::native::walk_fn(path, callback, opts);
+}
+
 bool move(StringView isource, StringView idest) {
 	auto source = filepath::absolute<memory::StandartInterface>(isource, true);
 	auto dest = filepath::absolute<memory::StandartInterface>(idest, true);
@@ -423,6 +456,10 @@ static bool performCopy(StringView source, StringView dest) {
 		stappler::filesystem::remove(dest);
 	}
 	if (!stappler::filesystem::exists(dest)) {
+		if (native::copy_fn(source, dest)) {
+			return true;
+		}
+
 		std::ofstream destStream(dest.data(), std::ios::binary);
 		auto f = openForReading(source);
 		if (f && destStream.is_open()) {
@@ -441,7 +478,52 @@ static bool isdir(StringView path) {
 	return stat.isDir;
 }
 
-bool copy(StringView isource, StringView idest, bool stopOnError) {
+// directories are created in traversal order, then files are distributed between threads
+static bool performParallelCopy(StringView source, StringView dest, bool stopOnError, uint32_t nthreads) {
+	std::vector<std::pair<std::string, std::string>> files;
+	auto ret = ftw_b(source, [&] (StringView path, bool isFile) -> bool {
+		if (!isFile) {
+			bool ret = mkdir(filepath::replace<memory::StandartInterface>(path, source, dest));
+			return (path == source || !stopOnError) ? true : ret;
+		} else {
+			files.emplace_back(path.str<memory::StandartInterface>(), filepath::replace<memory::StandartInterface>(path, source, dest));
+			return true;
+		}
+	}, -1, true);
+
+	if (!ret) {
+		return false;
+	}
+
+	std::atomic<size_t> next = 0;
+	std::atomic<bool> success = true;
+
+	auto worker = [&] {
+		while (!stopOnError || success.load()) {
+			auto idx = next.fetch_add(1);
+			if (idx >= files.size()) {
+				break;
+			}
+			if (!performCopy(files[idx].first, files[idx].second)) {
+				success = false;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	nthreads = std::min(nthreads, uint32_t(files.size()));
+	for (uint32_t i = 1; i < nthreads; ++ i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &it : threads) {
+		it.join();
+	}
+
+	return !stopOnError || success.load();
+}
+
+bool copy(StringView isource, StringView idest, bool stopOnError, uint32_t nthreads) {
 	auto source = filepath::absolute<memory::StandartInterface>(isource, true);
 	auto dest = filepath::absolute<memory::StandartInterface>(idest, true);
 	if (dest.back() == '/') {
@@ -451,6 +533,8 @@ bool copy(StringView isource, StringView idest, bool stopOnError) {
 	}
 	if (!isdir(source)) {
 		return performCopy(source, dest);
+	} else if (nthreads > 1) {
+		return performParallelCopy(source, dest, stopOnError, nthreads);
 	} else {
 		return ftw_b(source, [source, dest, stopOnError] (StringView path, bool isFile) -> bool {
 			if (!isFile) {
@@ -499,6 +583,157 @@ File openForReading(StringView ipath) {
 	return File();
 }
 
+#ifndef __MINGW32__
+
+static int MappedFile_getAdvice(MappedFile::Flags flags) {
+	if ((flags & MappedFile::Flags::Sequential) != MappedFile::Flags::None) {
+		return MADV_SEQUENTIAL;
+	} else if ((flags & MappedFile::Flags::Random) != MappedFile::Flags::None) {
+		return MADV_RANDOM;
+	} else if ((flags & MappedFile::Flags::WillNeed) != MappedFile::Flags::None) {
+		return MADV_WILLNEED;
+	}
+	return MADV_NORMAL;
+}
+
+MappedFile MappedFile::open(StringView ipath, Flags flags, size_t off, size_t size) {
+	if (filepath::inAppBundle(ipath)) {
+		// bundled files can not be mapped, use readIntoMemory
+		return MappedFile();
+	}
+
+	auto path = filepath::absolute<memory::StandartInterface>(ipath);
+	const bool writable = (flags & Flags::Write) != Flags::None;
+
+	int fd = ::open(path.data(), writable ? O_RDWR : O_RDONLY);
+	if (fd < 0) {
+		return MappedFile();
+	}
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || size_t(st.st_size) <= off) {
+		::close(fd);
+		return MappedFile();
+	}
+
+	size = std::min(size, size_t(st.st_size) - off);
+
+	// mapping offset should be aligned by page size
+	static const size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+	const size_t alignedOffset = off - off % pageSize;
+	const size_t mapSize = size + (off - alignedOffset);
+
+	int mapFlags = writable ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	if ((flags & Flags::Populate) != Flags::None) {
+		mapFlags |= MAP_POPULATE;
+	}
+#endif
+
+	auto ptr = ::mmap(nullptr, mapSize, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, mapFlags, fd, off_t(alignedOffset));
+
+	// mapping holds its own reference for the file
+	::close(fd);
+
+	if (ptr == MAP_FAILED) {
+		return MappedFile();
+	}
+
+	auto advice = MappedFile_getAdvice(flags);
+	if (advice != MADV_NORMAL) {
+		::madvise(ptr, mapSize, advice);
+	}
+
+	return MappedFile((uint8_t *)ptr, mapSize, off - alignedOffset, size, flags);
+}
+
+bool MappedFile::advise(Flags flags) {
+	if (!_base) {
+		return false;
+	}
+	return ::madvise(_base, _mapSize, MappedFile_getAdvice(flags)) == 0;
+}
+
+bool MappedFile::sync(bool async) {
+	if (!_base || !is_writable()) {
+		return false;
+	}
+	return ::msync(_base, _mapSize, async ? MS_ASYNC : MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+	if (_base) {
+		::munmap(_base, _mapSize);
+	}
+	_base = nullptr;
+	_mapSize = 0;
+	_data = nullptr;
+	_size = 0;
+}
+
+#else
+
+MappedFile MappedFile::open(StringView ipath, Flags flags, size_t off, size_t size) {
+	// not implemented, use readIntoMemory
+	return MappedFile();
+}
+
+bool MappedFile::advise(Flags flags) {
+	return false;
+}
+
+bool MappedFile::sync(bool async) {
+	return false;
+}
+
+void MappedFile::close() {
+	_base = nullptr;
+	_mapSize = 0;
+	_data = nullptr;
+	_size = 0;
+}
+
+#endif
+
+MappedFile::MappedFile() { }
+
+MappedFile::MappedFile(uint8_t *base, size_t mapSize, size_t offset, size_t size, Flags flags)
+: _base(base), _mapSize(mapSize), _data(base + offset), _size(size), _flags(flags) { }
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::is_writable() const {
+	return (_flags & Flags::Write) != Flags::None;
+}
+
+MappedFile::MappedFile(MappedFile &&other)
+: _base(other._base), _mapSize(other._mapSize), _data(other._data), _size(other._size), _flags(other._flags) {
+	other._base = nullptr;
+	other._mapSize = 0;
+	other._data = nullptr;
+	other._size = 0;
+}
+
+MappedFile & MappedFile::operator=(MappedFile &&other) {
+	if (&other == this) {
+		return *this;
+	}
+
+	close();
+	_base = other._base;
+	_mapSize = other._mapSize;
+	_data = other._data;
+	_size = other._size;
+	_flags = other._flags;
+	other._base = nullptr;
+	other._mapSize = 0;
+	other._data = nullptr;
+	other._size = 0;
+	return *this;
+}
+
 bool readIntoBuffer(uint8_t *buf, const StringView &ipath, size_t off, size_t size) {
 	auto f = openForReading(ipath);
 	if (f) {
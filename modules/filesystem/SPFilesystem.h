@@ -27,6 +27,7 @@
 #include "SPFilepath.h"
 #include "SPIO.h"
 #include "SPTime.h"
+#include "SPSpanView.h"
 
 namespace stappler::filesystem {
 
@@ -77,12 +78,19 @@ public:
 	size_t tell() const;
 	size_t size() const;
 
+	// native descriptor, -1 for bundled files
+	int fd() const;
+
 	int_type xsgetc();
 	int_type xsputc(int_type c);
 
 	streamsize xsputn(const char* s, streamsize n);
 	streamsize xsgetn(char* s, streamsize n);
 
+	// writes buffered data and syncs stream position with native descriptor,
+	// so descriptor can be written directly after flush
+	void flush();
+
 	bool eof() const;
 	void close();
 	void close_remove();
@@ -107,6 +115,64 @@ protected:
 	};
 };
 
+// Memory-mapped file
+// File content is loaded by OS on demand, so large files can be processed without
+// intermediate copy (data::read and cbor::read can be used on MappedFile directly)
+class MappedFile {
+public:
+	enum class Flags : uint32_t {
+		None = 0,
+		Write = 1 << 0, // shared read-write mapping, changes are written back into file
+		Populate = 1 << 1, // prefault all pages on open (MAP_POPULATE)
+		Sequential = 1 << 2, // expect sequential access (MADV_SEQUENTIAL), aggressive read-ahead
+		Random = 1 << 3, // expect random access (MADV_RANDOM), no read-ahead
+		WillNeed = 1 << 4, // start read-ahead for whole mapping (MADV_WILLNEED)
+	};
+
+	// maps region of existing file, offset is not required to be page-aligned
+	static MappedFile open(StringView path, Flags = Flags::None, size_t off = 0, size_t size = maxOf<size_t>());
+
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile &&);
+	MappedFile & operator=(MappedFile &&);
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	// apply access pattern hint (Sequential, Random or WillNeed) to mapping
+	bool advise(Flags);
+
+	// flush changes for writable mapping
+	bool sync(bool async = false);
+
+	void close();
+
+	bool is_open() const { return _data != nullptr; }
+	operator bool() const { return is_open(); }
+
+	bool is_writable() const;
+
+	// writing is allowed only for mapping with Flags::Write
+	uint8_t *data() { return _data; }
+	const uint8_t *data() const { return _data; }
+	size_t size() const { return _size; }
+
+	BytesView view() const { return BytesView(_data, _size); }
+
+protected:
+	MappedFile(uint8_t *base, size_t mapSize, size_t offset, size_t size, Flags);
+
+	uint8_t *_base = nullptr; // page-aligned mapping start
+	size_t _mapSize = 0;
+	uint8_t *_data = nullptr;
+	size_t _size = 0;
+	Flags _flags = Flags::None;
+};
+
+SP_DEFINE_ENUM_AS_MASK(MappedFile::Flags)
+
 // Check if file at path exists
 bool exists(StringView path);
 
@@ -125,7 +191,8 @@ bool touch(StringView path);
 bool move(StringView source, StringView dest);
 
 // copy file or directory to dest; use ftw_b for dirs, no directory tree check
-bool copy(StringView source, StringView dest, bool stopOnError = true);
+// files are copied within kernel when possible, with nthreads > 1 files in directory tree are copied in parallel
+bool copy(StringView source, StringView dest, bool stopOnError = true, uint32_t nthreads = 1);
 
 // remove file or directory
 // if not recursive, only single file or empty dir will be removed
@@ -142,6 +209,53 @@ void ftw(StringView path, const Callback<void(StringView path, bool isFile)> &,
 // same as ftw, but iteration can be stopped by returning false from callback
 bool ftw_b(StringView path, const Callback<bool(StringView path, bool isFile)> &, int depth = -1, bool dirFirst = false);
 
+enum class WalkFlags {
+	None = 0,
+
+	// fill WalkEntry::stat for every entry (one fstatat per entry)
+	Stat = 1 << 0,
+
+	// descend into symlinked directories (no loop detection)
+	FollowLinks = 1 << 1,
+};
+
+SP_DEFINE_ENUM_AS_MASK(WalkFlags)
+
+struct WalkEntry {
+	enum class Type : uint8_t {
+		Unknown,
+		File,
+		Dir,
+		Link,
+		Other,
+	};
+
+	StringView path; // absolute path
+	StringView name; // last path component
+	Type type = Type::Unknown;
+	uint32_t depth = 0;
+	Stat stat; // only with WalkFlags::Stat
+};
+
+struct WalkOptions {
+	// threads to read directories, 0 - hardware concurrency
+	uint32_t threads = 0;
+
+	// depth = -1 - unlimited, 0 - root entry only
+	int depth = -1;
+
+	// max entries in single callback call
+	uint32_t batchSize = 256;
+
+	WalkFlags flags = WalkFlags::None;
+};
+
+// parallel file-tree-walk, subdirectories are distributed between worker threads
+// callback receives batches of entries, calls are serialized, but order of entries is not defined
+// entry data is valid only within callback, iteration can be stopped by returning false
+// on posix systems it uses descriptor-relative lookups and directory entry type instead of per-entry stat
+bool walk(StringView path, const Callback<bool(SpanView<WalkEntry>)> &, const WalkOptions & = WalkOptions());
+
 // returns application writable path (or path inside writable dir, if path is set
 // if relative == false - do not merge paths, if provided path is absolute
 //
@@ -290,8 +404,13 @@ bool touch_fn(StringView path);
 void ftw_fn(StringView path, const Callback<void(StringView path, bool isFile)> &, int depth, bool dirFirst);
 bool ftw_b_fn(StringView path, const Callback<bool(StringView path, bool isFile)> &, int depth, bool dirFirst);
 
+bool walk_fn(StringView path, const Callback<bool(SpanView<WalkEntry>)> &, const WalkOptions &);
+
 bool rename_fn(StringView source, StringView dest);
 
+// copy file content within kernel when possible, false if native copy is not supported
+bool copy_fn(StringView source, StringView dest);
+
 FILE *fopen_fn(StringView, StringView mode);
 
 }
@@ -416,6 +535,25 @@ struct ProducerTraits<filesystem::File> {
 	static size_t TellFn(void *ptr) {
 		return ((type *)ptr)->tell();
 	}
+	static int FdFn(void *ptr) {
+		return ((type *)ptr)->fd();
+	}
+};
+
+template <>
+struct ConsumerTraits<filesystem::File> {
+	using type = filesystem::File;
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		auto ret = ((type *)ptr)->xsputn((const char *)buf, nbytes);
+		return ret > 0 ? size_t(ret) : 0;
+	}
+
+	static void FlushFn(void *ptr) {
+		((type *)ptr)->flush();
+	}
+	static int FdFn(void *ptr) {
+		return ((type *)ptr)->fd();
+	}
 };
 
 }
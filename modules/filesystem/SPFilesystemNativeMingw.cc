@@ -208,6 +208,24 @@ String getcwd_fn() {
 	return String();
 }
 
+bool walk_fn(const StringView &path, const Callback<bool(SpanView<WalkEntry>)> &cb, const WalkOptions &opts) {
+	// serial fallback, entries are sent one by one
+	return ftw_b_fn(path, [&] (const StringView &p, bool isFile) -> bool {
+		WalkEntry entry;
+		entry.path = p;
+		entry.name = filepath::lastComponent(p);
+		entry.type = isFile ? WalkEntry::Type::File : WalkEntry::Type::Dir;
+		if ((opts.flags & WalkFlags::Stat) != WalkFlags::None) {
+			stat_fn(p, entry.stat);
+		}
+		return cb(SpanView<WalkEntry>(&entry, 1));
+	}, opts.depth, true);
+}
+
+bool copy_fn(const StringView &source, const StringView &dest) {
+	return false;
+}
+
 FILE *fopen_fn(const StringView &path, const StringView &mode) {
 	WideString str = string::toUtf16(posixToNative(path));
 	WideString wmode = string::toUtf16(mode);
@@ -29,6 +29,9 @@ THE SOFTWARE.
 #include <errno.h>
 #include <dirent.h>
 #include <utime.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 #ifndef __MINGW32__
 
@@ -96,21 +99,25 @@ bool access_fn(StringView path, Access mode) {
 	return ::access(SP_TERMINATED_DATA(path), m) == 0;
 }
 
-bool stat_fn(StringView path, Stat &stat) {
-	struct stat s;
-	if(::stat(SP_TERMINATED_DATA(path), &s) == 0 ) {
-		stat.size = size_t(s.st_size);
-		stat.isDir = (s.st_mode & S_IFDIR);
+static void fillStat(Stat &stat, const struct stat &s) {
+	stat.size = size_t(s.st_size);
+	stat.isDir = S_ISDIR(s.st_mode);
 #if LINUX || ANDROID
-		stat.atime = Time::microseconds(s.st_atime * 1000000 + s.st_atim.tv_nsec / 1000);
-		stat.ctime = Time::microseconds(s.st_ctime * 1000000 + s.st_ctim.tv_nsec / 1000);
-		stat.mtime = Time::microseconds(s.st_mtime * 1000000 + s.st_mtim.tv_nsec / 1000);
+	stat.atime = Time::microseconds(s.st_atime * 1000000 + s.st_atim.tv_nsec / 1000);
+	stat.ctime = Time::microseconds(s.st_ctime * 1000000 + s.st_ctim.tv_nsec / 1000);
+	stat.mtime = Time::microseconds(s.st_mtime * 1000000 + s.st_mtim.tv_nsec / 1000);
 #else
-		// some fruit systems just made by assholes
-		stat.atime = Time::seconds(s.st_atime);
-		stat.ctime = Time::seconds(s.st_ctime);
-		stat.mtime = Time::seconds(s.st_mtime);
+	// some fruit systems just made by assholes
+	stat.atime = Time::seconds(s.st_atime);
+	stat.ctime = Time::seconds(s.st_ctime);
+	stat.mtime = Time::seconds(s.st_mtime);
 #endif
+}
+
+bool stat_fn(StringView path, Stat &stat) {
+	struct stat s;
+	if(::stat(SP_TERMINATED_DATA(path), &s) == 0 ) {
+		fillStat(stat, s);
 		return true;
 	} else {
 		return false;
@@ -178,10 +185,366 @@ bool ftw_b_fn(StringView path, const Callback<bool(StringView path, bool isFile)
 	return true;
 }
 
+static WalkEntry::Type getWalkEntryType(mode_t mode) {
+	if (S_ISREG(mode)) {
+		return WalkEntry::Type::File;
+	} else if (S_ISDIR(mode)) {
+		return WalkEntry::Type::Dir;
+	} else if (S_ISLNK(mode)) {
+		return WalkEntry::Type::Link;
+	}
+	return WalkEntry::Type::Other;
+}
+
+struct WalkContext;
+
+// entries are stored in single string block, views are created when batch is sent to callback
+struct WalkBatch {
+	struct Record {
+		size_t offset;
+		size_t size;
+		size_t nameOffset;
+		WalkEntry::Type type;
+		uint32_t depth;
+		Stat stat;
+	};
+
+	void add(StringView dir, StringView name, WalkEntry::Type type, uint32_t depth, const Stat &stat) {
+		auto offset = data.size();
+		data.append(dir.data(), dir.size());
+		if (dir.empty() || dir.back() != '/') {
+			data.push_back('/');
+		}
+		auto nameOffset = data.size();
+		data.append(name.data(), name.size());
+		records.emplace_back(Record{offset, data.size() - offset, nameOffset, type, depth, stat});
+	}
+
+	bool flush(WalkContext &);
+
+	std::string data;
+	std::vector<Record> records;
+	std::vector<WalkEntry> entries;
+};
+
+struct WalkContext {
+	struct Dir {
+		int fd;
+		std::string path;
+		uint32_t depth;
+	};
+
+	// queued directories holds open descriptors, when queue is too long,
+	// subdirectories are processed in place to limit number of descriptors
+	static constexpr size_t MaxQueued = 256;
+	static constexpr size_t DirentBufferSize = 32_KiB;
+
+	WalkContext(const Callback<bool(SpanView<WalkEntry>)> &cb, const WalkOptions &o) : callback(cb), opts(o) { }
+
+	bool canList(uint32_t depth) const {
+		return opts.depth < 0 || int64_t(depth) < int64_t(opts.depth);
+	}
+
+	bool emit(SpanView<WalkEntry> entries) {
+		std::unique_lock lock(callbackMutex);
+		if (stopped.load()) {
+			return false;
+		}
+		if (!callback(entries)) {
+			stopped = true;
+			cond.notify_all();
+			return false;
+		}
+		return true;
+	}
+
+	void push(Dir &&dir) {
+		std::unique_lock lock(mutex);
+		queue.emplace_back(std::move(dir));
+		cond.notify_one();
+	}
+
+	bool pop(Dir &dir) {
+		std::unique_lock lock(mutex);
+		cond.wait(lock, [&] { return !queue.empty() || active == 0 || stopped.load(); });
+		if (queue.empty() || stopped.load()) {
+			cond.notify_all();
+			return false;
+		}
+		dir = std::move(queue.front());
+		queue.pop_front();
+		++ active;
+		return true;
+	}
+
+	void finish() {
+		std::unique_lock lock(mutex);
+		-- active;
+		if (active == 0 && queue.empty()) {
+			cond.notify_all();
+		}
+	}
+
+	bool isQueueFull() {
+		std::unique_lock lock(mutex);
+		return queue.size() >= MaxQueued;
+	}
+
+	void worker() {
+		WalkBatch batch;
+		batch.records.reserve(opts.batchSize);
+		auto buf = std::make_unique<uint8_t[]>(DirentBufferSize);
+
+		Dir dir;
+		while (pop(dir)) {
+			process(dir, batch, buf.get());
+			finish();
+		}
+		batch.flush(*this);
+	}
+
+	void process(const Dir &dir, WalkBatch &batch, uint8_t *buf) {
+		const bool withStat = (opts.flags & WalkFlags::Stat) != WalkFlags::None;
+		const bool followLinks = (opts.flags & WalkFlags::FollowLinks) != WalkFlags::None;
+		const bool listChilds = canList(dir.depth + 1);
+
+		std::vector<std::string> subdirs;
+
+		while (!stopped.load()) {
+			auto nread = ::syscall(SYS_getdents64, dir.fd, buf, DirentBufferSize);
+			if (nread <= 0) {
+				break;
+			}
+
+			for (long offset = 0; offset < nread;) {
+				auto d = (struct dirent64 *)(buf + offset);
+				offset += d->d_reclen;
+
+				if (d->d_name[0] == '.' && (d->d_name[1] == 0 || (d->d_name[1] == '.' && d->d_name[2] == 0))) {
+					continue;
+				}
+
+				StringView name(d->d_name);
+				Stat stat;
+				WalkEntry::Type type = WalkEntry::Type::Unknown;
+				switch (d->d_type) {
+				case DT_REG: type = WalkEntry::Type::File; break;
+				case DT_DIR: type = WalkEntry::Type::Dir; break;
+				case DT_LNK: type = WalkEntry::Type::Link; break;
+				case DT_UNKNOWN: break;
+				default: type = WalkEntry::Type::Other; break;
+				}
+
+				// some filesystems does not provide d_type
+				if (withStat || type == WalkEntry::Type::Unknown) {
+					struct stat s;
+					if (::fstatat(dir.fd, d->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0) {
+						type = getWalkEntryType(s.st_mode);
+						fillStat(stat, s);
+					}
+				}
+
+				if (listChilds) {
+					if (type == WalkEntry::Type::Dir) {
+						subdirs.emplace_back(name.data(), name.size());
+					} else if (type == WalkEntry::Type::Link && followLinks) {
+						struct stat s;
+						if (::fstatat(dir.fd, d->d_name, &s, 0) == 0 && S_ISDIR(s.st_mode)) {
+							subdirs.emplace_back(name.data(), name.size());
+						}
+					}
+				}
+
+				batch.add(dir.path, name, type, dir.depth + 1, stat);
+				if (batch.records.size() >= opts.batchSize) {
+					if (!batch.flush(*this)) {
+						break;
+					}
+				}
+			}
+		}
+
+		for (auto &it : subdirs) {
+			if (stopped.load()) {
+				break;
+			}
+
+			auto fd = ::openat(dir.fd, it.data(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | (followLinks ? 0 : O_NOFOLLOW));
+			if (fd < 0) {
+				continue;
+			}
+
+			auto path = dir.path;
+			if (path.empty() || path.back() != '/') {
+				path.push_back('/');
+			}
+			path.append(it);
+
+			if (isQueueFull()) {
+				process(Dir{fd, std::move(path), dir.depth + 1}, batch, buf);
+			} else {
+				push(Dir{fd, std::move(path), dir.depth + 1});
+			}
+		}
+
+		::close(dir.fd);
+	}
+
+	const Callback<bool(SpanView<WalkEntry>)> &callback;
+	const WalkOptions &opts;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<Dir> queue;
+	uint32_t active = 0;
+
+	std::mutex callbackMutex;
+	std::atomic<bool> stopped = false;
+};
+
+bool WalkBatch::flush(WalkContext &ctx) {
+	if (records.empty()) {
+		return !ctx.stopped.load();
+	}
+
+	entries.clear();
+	for (auto &it : records) {
+		WalkEntry entry;
+		entry.path = StringView(data.data() + it.offset, it.size);
+		entry.name = StringView(data.data() + it.nameOffset, it.size - (it.nameOffset - it.offset));
+		entry.type = it.type;
+		entry.depth = it.depth;
+		entry.stat = it.stat;
+		entries.emplace_back(entry);
+	}
+
+	auto ret = ctx.emit(SpanView<WalkEntry>(entries.data(), entries.size()));
+	records.clear();
+	data.clear();
+	return ret;
+}
+
+bool walk_fn(StringView path, const Callback<bool(SpanView<WalkEntry>)> &callback, const WalkOptions &opts) {
+	auto rootPath = path.str<memory::StandartInterface>();
+
+	struct stat s;
+	if (::lstat(rootPath.data(), &s) != 0) {
+		return false;
+	}
+
+	WalkContext ctx(callback, opts);
+
+	Stat rootStat;
+	fillStat(rootStat, s);
+
+	WalkEntry root;
+	root.path = rootPath;
+	root.name = filepath::lastComponent(rootPath);
+	root.type = getWalkEntryType(s.st_mode);
+	root.depth = 0;
+	if ((opts.flags & WalkFlags::Stat) != WalkFlags::None) {
+		root.stat = rootStat;
+	}
+
+	if (!ctx.emit(SpanView<WalkEntry>(&root, 1))) {
+		return false;
+	}
+
+	const bool followLinks = (opts.flags & WalkFlags::FollowLinks) != WalkFlags::None;
+	if (!ctx.canList(0) || (root.type != WalkEntry::Type::Dir && (root.type != WalkEntry::Type::Link || !followLinks))) {
+		return true;
+	}
+
+	auto fd = ::open(rootPath.data(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | (followLinks ? 0 : O_NOFOLLOW));
+	if (fd < 0) {
+		// symlink to file
+		return true;
+	}
+
+	ctx.push(WalkContext::Dir{fd, std::move(rootPath), 0});
+
+	auto nthreads = opts.threads ? opts.threads : std::max(std::thread::hardware_concurrency(), 1U);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 1; i < nthreads; ++ i) {
+		threads.emplace_back([&] {
+			ctx.worker();
+		});
+	}
+	ctx.worker();
+
+	for (auto &it : threads) {
+		it.join();
+	}
+
+	// walk was stopped, release queued descriptors
+	for (auto &it : ctx.queue) {
+		::close(it.fd);
+	}
+
+	return !ctx.stopped.load();
+}
+
 bool rename_fn(StringView source, StringView dest) {
 	return rename(SP_TERMINATED_DATA(source), SP_TERMINATED_DATA(dest)) == 0;
 }
 
+bool copy_fn(StringView source, StringView dest) {
+	auto in = ::open(SP_TERMINATED_DATA(source), O_RDONLY | O_CLOEXEC);
+	if (in < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (::fstat(in, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		// size of special files (like procfs) is unknown, stream copy should be used for them
+		::close(in);
+		return false;
+	}
+
+	auto out = ::open(SP_TERMINATED_DATA(dest), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+	if (out < 0) {
+		::close(in);
+		return false;
+	}
+
+	::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	int64_t offset = 0;
+	auto size = size_t(st.st_size);
+	auto ret = io::copy(in, out, &offset, size);
+	if (ret == maxOf<size_t>()) {
+		// kernel copy is not available, use large buffer instead of stdio
+		ret = 0;
+		auto buf = std::make_unique<uint8_t[]>(256_KiB);
+		while (ret < size) {
+			auto r = ::read(in, buf.get(), 256_KiB);
+			if (r < 0 && errno == EINTR) {
+				continue;
+			} else if (r <= 0) {
+				break;
+			}
+
+			ssize_t written = 0;
+			while (written < r) {
+				auto w = ::write(out, buf.get() + written, r - written);
+				if (w < 0 && errno == EINTR) {
+					continue;
+				} else if (w <= 0) {
+					break;
+				}
+				written += w;
+			}
+			ret += size_t(written);
+			if (written != r) {
+				break;
+			}
+		}
+	}
+
+	::close(in);
+	return ::close(out) == 0 && ret == size;
+}
+
 FILE *fopen_fn(StringView path, StringView mode) {
 	return fopen(SP_TERMINATED_DATA(path), SP_TERMINATED_DATA(mode));
 }
@@ -137,7 +137,7 @@ public:
 	}
 
 	/** Constructs a quaternion equal to the rotation from the specified axis and angle. */
-	constexpr Quaternion(const Vec3& axis, float angle) {
+	Quaternion(const Vec3& axis, float angle) {
 		float halfAngle = angle * 0.5f;
 		float sinHalfAngle = std::sin(halfAngle);
 
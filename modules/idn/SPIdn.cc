@@ -37,12 +37,58 @@ using HostUnicodeChars = chars::Compose<char, chars::CharGroup<char, CharGroupId
 using HostAsciiChars = chars::Compose<char, chars::CharGroup<char, CharGroupId::Alphanumeric>,
 		chars::Chars<char, '.', '-'>>;
 
+// hyphens in the third and fourth positions are reserved for punycode ("xn--")
+static bool isAsciiLabel(const char *label, size_t len) {
+	return len > 0 && len <= 63 && label[0] != '-' && label[len - 1] != '-'
+			&& (len < 4 || label[2] != '-' || label[3] != '-');
+}
+
+// Most hosts are plain ASCII without punycode labels, conversion for them is only lowercasing,
+// so IDN library is called only for hosts, that can be changed by it otherwise
+static bool isAsciiHost(StringView source) {
+	// 253 characters with optional trailing dot
+	if (source.size() > 254) {
+		return false;
+	}
+
+	auto data = source.data();
+	size_t start = 0;
+	for (size_t i = 0; i < source.size(); ++ i) {
+		auto c = data[i];
+		if (c == '.') {
+			if (!isAsciiLabel(data + start, i - start)) {
+				return false;
+			}
+			start = i + 1;
+		} else if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-')) {
+			return false;
+		}
+	}
+
+	// trailing dot is allowed
+	return (start == source.size()) ? start > 0 : isAsciiLabel(data + start, source.size() - start);
+}
+
+template <typename Interface>
+static auto _idnToLowerAscii(StringView source) -> typename Interface::StringType {
+	typename Interface::StringType ret; ret.resize(source.size());
+	for (size_t i = 0; i < source.size(); ++ i) {
+		auto c = source[i];
+		ret[i] = (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+	}
+	return ret;
+}
+
 template <typename Interface>
 auto _idnToAscii(StringView source, bool validate) -> typename Interface::StringType {
 	if (source.empty()) {
 		return typename Interface::StringType();
 	}
 
+	if (isAsciiHost(source)) {
+		return _idnToLowerAscii<Interface>(source);
+	}
+
 	if (validate) {
 		StringView r(source);
 		r.skipChars<HostUnicodeChars>();
@@ -84,6 +130,10 @@ auto _idnToUnicode(StringView source, bool validate) -> typename Interface::Stri
 		return typename Interface::StringType();
 	}
 
+	if (isAsciiHost(source)) {
+		return _idnToLowerAscii<Interface>(source);
+	}
+
 	if (validate) {
 		StringView r(source);
 		r.skipChars<HostAsciiChars>();
@@ -240,8 +240,10 @@ static auto network_getUserMime(const StringView &filename) -> typename Interfac
 }
 
 #include "SPNetworkCABundle.cc"
+#include "SPNetworkShare.cc"
 #include "SPNetworkSetup.cc"
 #include "SPNetworkData.cc"
 #include "SPNetworkHandle.cc"
+#include "SPNetworkAsyncClient.cc"
 
 //#include "SPNetworkMultiHandle.cc"
@@ -0,0 +1,903 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPNetworkAsyncClient.h"
+#include "SPRandom.h"
+#include "SPLog.h"
+
+#include <curl/curl.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace stappler::network {
+
+using AsyncClock = std::chrono::steady_clock;
+
+struct AsyncClientRequest {
+	AsyncClient::Handle handle;
+	AsyncClient::Callback callback;
+	Context<memory::StandartInterface> ctx;
+
+	AsyncClient::Data *client = nullptr;
+	std::string host; // ShareContext::getHostKey
+	std::string coalesceKey; // empty if request can not be coalesced
+	std::vector<AsyncClientRequest *> waiters; // coalesced requests, served with this request's response
+	std::string body; // response body, captured for waiters
+	AsyncClock::time_point start;
+	size_t received = 0; // bytes, passed to receive target within current attempt
+	uint32_t attempt = 0;
+	bool hostSlot = false; // request is counted as active for it's host
+};
+
+struct AsyncClient::Data {
+	static constexpr size_t MaxEvents = 64;
+
+	struct HostData {
+		size_t active = 0;
+		std::deque<AsyncClientRequest *> queue;
+		HostStats stats;
+	};
+
+	static int onSocket(CURL *, curl_socket_t, int what, void *userp, void *socketp);
+	static int onTimer(CURLM *, long timeoutMs, void *userp);
+	static size_t onWrite(char *data, size_t size, size_t nmemb, void *userp);
+
+	Data(const Config &);
+	~Data();
+
+	bool init();
+	void cancel();
+
+	void submit(AsyncClientRequest *);
+	void wait();
+
+	void wakeup();
+	void loop();
+	int getLoopTimeout() const;
+	void processPending();
+	void processDelayed();
+	void processMessages();
+
+	void schedule(AsyncClientRequest *);
+	void start(AsyncClientRequest *);
+	void finish(AsyncClientRequest *, int code);
+	AsyncClientRequest *releaseSlot(AsyncClientRequest *);
+	void complete(AsyncClientRequest *, bool success);
+	void deliver(AsyncClientRequest *, bool success);
+
+	bool isRetryAllowed(AsyncClientRequest *) const;
+	bool isRetryableStatus(AsyncClientRequest *) const;
+	bool isRetryable(AsyncClientRequest *, curl_off_t downloaded) const;
+	AsyncClock::duration getRetryDelay(uint32_t attempt) const;
+	std::string getCoalesceKey(AsyncClientRequest *) const;
+
+	CURL *acquireHandle();
+	void releaseHandle(CURL *, bool reuse);
+
+	Config config;
+
+	Rc<thread::TaskQueue> target;
+	Rc<thread::EventTaskQueue> eventTarget;
+
+	CURLM *multi = nullptr;
+	bool multiplex = true;
+	bool reuseConnections = true;
+	int epollFd = -1;
+	int eventFd = -1;
+	int timerFd = -1;
+
+	std::thread thread;
+	std::atomic<bool> running = false;
+
+	// submitted from other threads, but not yet added to multi handle
+	std::mutex pendingMutex;
+	std::vector<AsyncClientRequest *> pending;
+
+	// loop thread only
+	std::vector<CURL *> idleHandles;
+	std::unordered_set<AsyncClientRequest *> active;
+	std::multimap<AsyncClock::time_point, AsyncClientRequest *> delayed; // waiting for retry
+	std::unordered_map<std::string, AsyncClientRequest *> coalescing;
+
+	// modified from loop thread, stats can be read from any thread
+	mutable std::mutex hostsMutex;
+	std::map<std::string, HostData> hosts;
+
+	std::mutex waitMutex;
+	std::condition_variable waitCond;
+	std::atomic<size_t> inflight = 0;
+
+	std::atomic<size_t> submitted = 0;
+	std::atomic<size_t> completed = 0;
+	std::atomic<size_t> failed = 0;
+};
+
+static bool AsyncClient_isFileTarget(const HandleData<memory::StandartInterface> &iface) {
+	return std::holds_alternative<HandleData<memory::StandartInterface>::String>(iface.receive.data);
+}
+
+void AsyncClient::Histogram::add(TimeInterval val) {
+	auto v = val.toMicros();
+	size_t idx = 0;
+	while (idx + 1 < Buckets && v >= (MinBound << idx)) {
+		++ idx;
+	}
+	++ buckets[idx];
+	++ count;
+	sum += v;
+	max = std::max(max, v);
+}
+
+TimeInterval AsyncClient::Histogram::getPercentile(float p) const {
+	if (count == 0) {
+		return TimeInterval();
+	}
+
+	auto target = std::max(uint64_t(std::ceil(count * std::clamp(p, 0.0f, 1.0f))), uint64_t(1));
+	uint64_t acc = 0;
+	for (size_t i = 0; i < Buckets; ++ i) {
+		acc += buckets[i];
+		if (acc >= target) {
+			return TimeInterval::microseconds(std::min(MinBound << i, max));
+		}
+	}
+	return TimeInterval::microseconds(max);
+}
+
+TimeInterval AsyncClient::Histogram::getAverage() const {
+	return count ? TimeInterval::microseconds(sum / count) : TimeInterval();
+}
+
+int AsyncClient::Data::onSocket(CURL *, curl_socket_t s, int what, void *userp, void *socketp) {
+	auto data = (Data *)userp;
+
+	if (what == CURL_POLL_REMOVE) {
+		::epoll_ctl(data->epollFd, EPOLL_CTL_DEL, s, nullptr);
+		curl_multi_assign(data->multi, s, nullptr);
+		return 0;
+	}
+
+	struct epoll_event ev;
+	ev.data.fd = s;
+	ev.events = 0;
+	if (what & CURL_POLL_IN) {
+		ev.events |= EPOLLIN;
+	}
+	if (what & CURL_POLL_OUT) {
+		ev.events |= EPOLLOUT;
+	}
+
+	if (socketp) {
+		::epoll_ctl(data->epollFd, EPOLL_CTL_MOD, s, &ev);
+	} else {
+		if (::epoll_ctl(data->epollFd, EPOLL_CTL_ADD, s, &ev) != 0 && errno == EEXIST) {
+			::epoll_ctl(data->epollFd, EPOLL_CTL_MOD, s, &ev);
+		}
+		// non-null value marks socket as registered
+		curl_multi_assign(data->multi, s, data);
+	}
+	return 0;
+}
+
+int AsyncClient::Data::onTimer(CURLM *, long timeoutMs, void *userp) {
+	auto data = (Data *)userp;
+
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	if (timeoutMs == 0) {
+		spec.it_value.tv_nsec = 1; // zero value disarms timer, so expire as soon as possible
+	} else if (timeoutMs > 0) {
+		spec.it_value.tv_sec = timeoutMs / 1000;
+		spec.it_value.tv_nsec = (timeoutMs % 1000) * 1000000;
+	}
+	::timerfd_settime(data->timerFd, 0, &spec, nullptr);
+	return 0;
+}
+
+size_t AsyncClient::Data::onWrite(char *data, size_t size, size_t nmemb, void *userp) {
+	auto req = (AsyncClientRequest *)userp;
+
+	// body of response, that will be retried, should not reach receive target
+	if (req->client->isRetryAllowed(req) && req->client->isRetryableStatus(req)) {
+		return size * nmemb;
+	}
+
+	req->received += size * nmemb;
+	if (!req->waiters.empty()) {
+		req->body.append(data, size * nmemb);
+	}
+	return _writeData<memory::StandartInterface>(data, size, nmemb, req->handle.getData());
+}
+
+AsyncClient::Data::Data(const Config &cfg) : config(cfg) { }
+
+AsyncClient::Data::~Data() {
+	if (timerFd >= 0) { ::close(timerFd); }
+	if (eventFd >= 0) { ::close(eventFd); }
+	if (epollFd >= 0) { ::close(epollFd); }
+}
+
+bool AsyncClient::Data::init() {
+	epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (epollFd < 0 || eventFd < 0 || timerFd < 0) {
+		log::vtext("AsyncClient", "Fail to create event descriptors: ", errno);
+		return false;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = eventFd;
+	::epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev);
+	ev.data.fd = timerFd;
+	::epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+
+	multi = curl_multi_init();
+	if (!multi) {
+		return false;
+	}
+
+	curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, &onSocket);
+	curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+	curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, &onTimer);
+	curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+	curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, long(config.maxTotalConnections));
+	curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, long(config.maxHostConnections));
+	curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, long(std::max(config.maxTotalConnections, uint32_t(1))));
+
+	multiplex = config.multiplex;
+	if (config.http2PriorKnowledge && curl_version_info(CURLVERSION_NOW)->version_num < 0x080000) {
+		// libcurl 7.x fails to reuse or multiplex prior knowledge connections with CURLE_HTTP2,
+		// so every transfer uses its own connection
+		multiplex = false;
+		reuseConnections = false;
+	}
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+
+	running = true;
+	thread = std::thread([this] {
+		loop();
+	});
+	return true;
+}
+
+void AsyncClient::Data::cancel() {
+	if (thread.joinable()) {
+		running = false;
+		wakeup();
+		thread.join();
+	}
+
+	// loop is stopped, so multi handle can be used from this thread
+	std::vector<AsyncClientRequest *> requests;
+	do {
+		std::unique_lock lock(pendingMutex);
+		requests = move(pending);
+		pending.clear();
+	} while (0);
+
+	do {
+		std::unique_lock lock(hostsMutex);
+		for (auto &it : hosts) {
+			for (auto &req : it.second.queue) {
+				requests.emplace_back(req);
+			}
+			it.second.queue.clear();
+		}
+	} while (0);
+
+	for (auto &it : delayed) {
+		requests.emplace_back(it.second);
+	}
+	delayed.clear();
+
+	for (auto &it : active) {
+		curl_multi_remove_handle(multi, it->ctx.curl);
+		requests.emplace_back(it);
+	}
+	active.clear();
+
+	// loop is not running, so requests will not be retried or dequeued
+	for (auto &it : requests) {
+		finish(it, CURLE_ABORTED_BY_CALLBACK);
+	}
+
+	for (auto &it : idleHandles) {
+		CurlHandle::release(it);
+	}
+	idleHandles.clear();
+
+	if (multi) {
+		curl_multi_cleanup(multi);
+		multi = nullptr;
+	}
+}
+
+void AsyncClient::Data::submit(AsyncClientRequest *req) {
+	++ submitted;
+	++ inflight;
+
+	bool notify = false;
+	do {
+		std::unique_lock lock(pendingMutex);
+		notify = pending.empty();
+		pending.emplace_back(req);
+	} while (0);
+
+	// loop takes all pending requests on wakeup, so only first one should wake it
+	if (notify) {
+		wakeup();
+	}
+}
+
+void AsyncClient::Data::wait() {
+	std::unique_lock lock(waitMutex);
+	waitCond.wait(lock, [&] {
+		return inflight.load() == 0;
+	});
+}
+
+void AsyncClient::Data::wakeup() {
+	uint64_t value = 1;
+	if (::write(eventFd, &value, sizeof(uint64_t)) != sizeof(uint64_t)) {
+		log::vtext("AsyncClient", "Fail to wakeup loop thread: ", errno);
+	}
+}
+
+void AsyncClient::Data::loop() {
+	std::array<struct epoll_event, MaxEvents> events;
+	int runningHandles = 0;
+
+	while (running.load()) {
+		auto nevents = ::epoll_wait(epollFd, events.data(), MaxEvents, getLoopTimeout());
+		if (nevents < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			log::vtext("AsyncClient", "epoll_wait() failed with errno ", errno);
+			break;
+		}
+
+		for (int i = 0; i < nevents; ++ i) {
+			auto fd = events[i].data.fd;
+			if (fd == eventFd) {
+				uint64_t value = 0;
+				if (::read(eventFd, &value, sizeof(uint64_t)) == sizeof(uint64_t)) {
+					processPending();
+				}
+			} else if (fd == timerFd) {
+				uint64_t value = 0;
+				if (::read(timerFd, &value, sizeof(uint64_t)) == sizeof(uint64_t)) {
+					curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &runningHandles);
+				}
+			} else {
+				int mask = 0;
+				if (events[i].events & EPOLLIN) {
+					mask |= CURL_CSELECT_IN;
+				}
+				if (events[i].events & EPOLLOUT) {
+					mask |= CURL_CSELECT_OUT;
+				}
+				if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+					mask |= CURL_CSELECT_ERR;
+				}
+				curl_multi_socket_action(multi, fd, mask, &runningHandles);
+			}
+		}
+
+		processMessages();
+		processDelayed();
+	}
+}
+
+int AsyncClient::Data::getLoopTimeout() const {
+	if (delayed.empty()) {
+		return -1;
+	}
+
+	auto now = AsyncClock::now();
+	auto next = delayed.begin()->first;
+	if (next <= now) {
+		return 0;
+	}
+
+	// round up, so request is ready, when loop wakes up
+	return int(std::chrono::ceil<std::chrono::milliseconds>(next - now).count());
+}
+
+void AsyncClient::Data::processPending() {
+	std::vector<AsyncClientRequest *> requests;
+	do {
+		std::unique_lock lock(pendingMutex);
+		requests = move(pending);
+		pending.clear();
+	} while (0);
+
+	for (auto &req : requests) {
+		req->client = this;
+		req->start = AsyncClock::now();
+		req->host = ShareContext::getHostKey(req->handle.getUrl());
+
+		if (config.coalesce) {
+			req->coalesceKey = getCoalesceKey(req);
+			if (!req->coalesceKey.empty()) {
+				auto it = coalescing.find(req->coalesceKey);
+				if (it != coalescing.end() && it->second->received == 0) {
+					// response was not started yet, so it can be captured completely
+					it->second->waiters.emplace_back(req);
+					continue;
+				}
+				coalescing.insert_or_assign(req->coalesceKey, req);
+			}
+		}
+
+		schedule(req);
+	}
+}
+
+void AsyncClient::Data::processDelayed() {
+	auto now = AsyncClock::now();
+	while (!delayed.empty() && delayed.begin()->first <= now) {
+		auto req = delayed.begin()->second;
+		delayed.erase(delayed.begin());
+		schedule(req);
+	}
+}
+
+void AsyncClient::Data::processMessages() {
+	CURLMsg *msg = nullptr;
+	int msgq = 0;
+	while ((msg = curl_multi_info_read(multi, &msgq))) {
+		if (msg->msg != CURLMSG_DONE) {
+			continue;
+		}
+
+		auto curl = msg->easy_handle;
+		auto result = msg->data.result;
+
+		AsyncClientRequest *req = nullptr;
+		curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&req);
+		curl_multi_remove_handle(multi, curl);
+
+		if (req) {
+			active.erase(req);
+			finish(req, result);
+		}
+	}
+}
+
+void AsyncClient::Data::schedule(AsyncClientRequest *req) {
+	do {
+		std::unique_lock lock(hostsMutex);
+		auto &host = hosts[req->host];
+		if (config.maxHostRequests > 0 && host.active >= config.maxHostRequests) {
+			host.queue.emplace_back(req);
+			return;
+		}
+		++ host.active;
+		host.stats.maxActive = std::max(host.stats.maxActive, host.active);
+		req->hostSlot = true;
+	} while (0);
+
+	start(req);
+}
+
+void AsyncClient::Data::start(AsyncClientRequest *req) {
+	auto &iface = *req->handle.getData();
+	iface.process.performed = false;
+	iface.process.errorCode = CURLE_OK;
+	iface.process.responseCode = -1;
+
+	// headers of previous attempt should not leak into retried response
+	iface.receive.headers.clear();
+	iface.receive.parsed.clear();
+	iface.receive.contentType.clear();
+
+	req->received = 0;
+	req->body.clear();
+
+	req->ctx.curl = acquireHandle();
+	if (!req->ctx.curl || !prepare(iface, &req->ctx, nullptr)) {
+		finish(req, CURLE_FAILED_INIT);
+		return;
+	}
+
+	auto curl = req->ctx.curl;
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, req);
+	if (iface.send.method != Method::Head && !AsyncClient_isFileTarget(iface)) {
+		// intercept data to discard retryable responses and capture body for coalesced requests
+		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &onWrite);
+		curl_easy_setopt(curl, CURLOPT_WRITEDATA, req);
+	}
+	if (config.http2PriorKnowledge) {
+		curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, long(CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE));
+	}
+	if (!reuseConnections) {
+		curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+	}
+	if (multiplex) {
+		// wait for existing connection to confirm multiplexing instead of opening new one
+		curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+	}
+
+	if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+		finish(req, CURLE_FAILED_INIT);
+		return;
+	}
+	active.emplace(req);
+}
+
+void AsyncClient::Data::finish(AsyncClientRequest *req, int code) {
+	auto &iface = *req->handle.getData();
+	req->ctx.code = code;
+
+	bool success = false;
+	bool retry = false;
+	if (req->ctx.curl) {
+		curl_off_t downloaded = req->received;
+		if (AsyncClient_isFileTarget(iface)) {
+			curl_easy_getinfo(req->ctx.curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+		}
+
+		success = finalize(iface, &req->ctx, nullptr);
+		releaseHandle(req->ctx.curl, code == CURLE_OK);
+		req->ctx.curl = nullptr;
+		retry = !success && running.load() && isRetryable(req, downloaded);
+	} else {
+		iface.process.errorCode = code;
+	}
+
+	auto next = releaseSlot(req);
+
+	if (retry) {
+		++ req->attempt;
+		do {
+			std::unique_lock lock(hostsMutex);
+			++ hosts[req->host].stats.retries;
+		} while (0);
+		delayed.emplace(AsyncClock::now() + getRetryDelay(req->attempt), req);
+	} else {
+		complete(req, success);
+	}
+
+	if (next) {
+		start(next);
+	}
+}
+
+AsyncClientRequest *AsyncClient::Data::releaseSlot(AsyncClientRequest *req) {
+	if (!req->hostSlot) {
+		return nullptr;
+	}
+
+	req->hostSlot = false;
+
+	std::unique_lock lock(hostsMutex);
+	auto &host = hosts[req->host];
+	if (!host.queue.empty() && running.load()) {
+		// pass slot to next queued request
+		auto next = host.queue.front();
+		host.queue.pop_front();
+		next->hostSlot = true;
+		return next;
+	}
+	-- host.active;
+	return nullptr;
+}
+
+void AsyncClient::Data::complete(AsyncClientRequest *req, bool success) {
+	if (!req->coalesceKey.empty()) {
+		auto it = coalescing.find(req->coalesceKey);
+		if (it != coalescing.end() && it->second == req) {
+			coalescing.erase(it);
+		}
+	}
+
+	auto waiters = move(req->waiters);
+	req->waiters.clear();
+
+	if (!req->host.empty()) {
+		auto now = AsyncClock::now();
+		auto getLatency = [&] (AsyncClientRequest *r) {
+			return TimeInterval::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(now - r->start).count());
+		};
+
+		std::unique_lock lock(hostsMutex);
+		auto &stats = hosts[req->host].stats;
+		stats.requests += 1 + waiters.size();
+		stats.coalesced += waiters.size();
+		if (!success) {
+			stats.failed += 1 + waiters.size();
+		}
+		stats.latency.add(getLatency(req));
+		for (auto &it : waiters) {
+			stats.latency.add(getLatency(it));
+		}
+	}
+
+	// copy response into coalesced requests, before primary request can be moved out in callback
+	auto &source = *req->handle.getData();
+	for (auto &it : waiters) {
+		auto &iface = *it->handle.getData();
+		iface.process.errorCode = source.process.errorCode;
+		iface.process.responseCode = source.process.responseCode;
+		iface.process.error = source.process.error;
+		iface.process.performed = source.process.performed;
+		iface.receive.headers = source.receive.headers;
+		iface.receive.parsed = source.receive.parsed;
+		iface.receive.contentType = source.receive.contentType;
+		if (auto buf = std::get_if<data::StreamBuffer<memory::StandartInterface>>(&iface.receive.data)) {
+			buf->clear();
+		}
+		if (!req->body.empty()) {
+			_writeData<memory::StandartInterface>(req->body.data(), 1, req->body.size(), &iface);
+		}
+		deliver(it, success);
+	}
+
+	deliver(req, success);
+}
+
+void AsyncClient::Data::deliver(AsyncClientRequest *req, bool success) {
+	++ completed;
+	if (!success) {
+		++ failed;
+	}
+
+	std::shared_ptr<AsyncClientRequest> ptr(req);
+	if (target) {
+		target->perform([ptr, success] {
+			ptr->callback(ptr->handle, success);
+		});
+	} else if (eventTarget) {
+		eventTarget->perform([ptr, success] {
+			ptr->callback(ptr->handle, success);
+		});
+	} else {
+		ptr->callback(ptr->handle, success);
+	}
+
+	if (inflight.fetch_sub(1) == 1) {
+		std::unique_lock lock(waitMutex);
+		waitCond.notify_all();
+	}
+}
+
+bool AsyncClient::Data::isRetryAllowed(AsyncClientRequest *req) const {
+	if (req->attempt >= config.retry.maxRetries) {
+		return false;
+	}
+
+	// only idempotent requests, that can be sent again, are retried
+	auto &iface = *req->handle.getData();
+	switch (iface.send.method) {
+	case Method::Get:
+	case Method::Head:
+	case Method::Delete:
+		return true;
+	case Method::Put:
+		return !std::holds_alternative<HandleData<memory::StandartInterface>::IOCallback>(iface.send.data);
+	default:
+		break;
+	}
+	return false;
+}
+
+bool AsyncClient::Data::isRetryableStatus(AsyncClientRequest *req) const {
+	auto &iface = *req->handle.getData();
+	if (!config.retry.retryServerErrors || AsyncClient_isFileTarget(iface)) {
+		return false;
+	}
+
+	switch (iface.process.responseCode) {
+	case 429:
+	case 500:
+	case 502:
+	case 503:
+	case 504:
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+bool AsyncClient::Data::isRetryable(AsyncClientRequest *req, curl_off_t downloaded) const {
+	if (!isRetryAllowed(req)) {
+		return false;
+	}
+
+	auto &iface = *req->handle.getData();
+	switch (iface.process.errorCode) {
+	case CURLE_OK:
+		return isRetryableStatus(req);
+	case CURLE_COULDNT_CONNECT:
+	case CURLE_OPERATION_TIMEDOUT:
+	case CURLE_SEND_ERROR:
+	case CURLE_RECV_ERROR:
+	case CURLE_GOT_NOTHING:
+	case CURLE_HTTP2:
+	case CURLE_HTTP2_STREAM:
+		// transfer can be repeated only if nothing was delivered to receive target
+		return downloaded == 0;
+	default:
+		break;
+	}
+	return false;
+}
+
+AsyncClock::duration AsyncClient::Data::getRetryDelay(uint32_t attempt) const {
+	auto value = config.retry.delay.toMicros() << std::min(attempt - 1, uint32_t(20));
+	value = std::min(value, config.retry.maxDelay.toMicros());
+
+	// randomize part of the delay, so concurrent retries are spread in time
+	auto jitter = std::clamp(config.retry.jitter, 0.0f, 1.0f) * (random::next32() / float(maxOf<uint32_t>()));
+	value -= uint64_t(value * jitter);
+	return std::chrono::microseconds(value);
+}
+
+std::string AsyncClient::Data::getCoalesceKey(AsyncClientRequest *req) const {
+	auto &iface = *req->handle.getData();
+	if (iface.send.method != Method::Get || AsyncClient_isFileTarget(iface)) {
+		return std::string();
+	}
+
+	// everything, that can affect response, should be in key
+	std::string ret(iface.send.url);
+	ret.append("\n").append(iface.send.userAgent);
+	ret.append("\n").append(iface.process.cookieFile);
+	std::visit([&] (auto &&arg) {
+		using T = std::decay_t<decltype(arg)>;
+		if constexpr (std::is_same_v<T, HandleData<memory::StandartInterface>::String>) {
+			ret.append("\n").append(arg);
+		} else {
+			ret.append("\n").append(arg.first).append(":").append(arg.second);
+		}
+	}, iface.auth.data);
+	for (auto &it : iface.send.headers) {
+		ret.append("\n").append(it.first).append(": ").append(it.second);
+	}
+	return ret;
+}
+
+CURL *AsyncClient::Data::acquireHandle() {
+	if (!idleHandles.empty()) {
+		auto ret = idleHandles.back();
+		idleHandles.pop_back();
+		return ret;
+	}
+	return CurlHandle::alloc();
+}
+
+void AsyncClient::Data::releaseHandle(CURL *curl, bool reuse) {
+	if (reuse && idleHandles.size() < config.maxIdleHandles) {
+		curl_easy_reset(curl);
+		// detach from handle's ShareContext, it can be released before client
+		curl_easy_setopt(curl, CURLOPT_SHARE, nullptr);
+		idleHandles.emplace_back(curl);
+	} else {
+		CurlHandle::release(curl);
+	}
+}
+
+AsyncClient::AsyncClient() { }
+
+AsyncClient::~AsyncClient() {
+	cancel();
+}
+
+bool AsyncClient::init() {
+	return init(Config());
+}
+
+bool AsyncClient::init(const Config &cfg) {
+	if (_data) {
+		return false;
+	}
+
+	_data = new Data(cfg);
+	if (!_data->init()) {
+		_data->cancel();
+		delete _data;
+		_data = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool AsyncClient::init(const Config &cfg, thread::TaskQueue *q) {
+	if (!init(cfg)) {
+		return false;
+	}
+	_data->target = q;
+	return true;
+}
+
+bool AsyncClient::init(const Config &cfg, thread::EventTaskQueue *q) {
+	if (!init(cfg)) {
+		return false;
+	}
+	_data->eventTarget = q;
+	return true;
+}
+
+void AsyncClient::cancel() {
+	Data *data = nullptr;
+	do {
+		std::unique_lock lock(_dataMutex);
+		data = _data;
+		_data = nullptr;
+	} while (0);
+
+	// lock is not held while loop is stopped, completion callbacks can call submit
+	if (data) {
+		data->cancel();
+		delete data;
+	}
+}
+
+bool AsyncClient::submit(Handle &&handle, Callback &&cb) {
+	std::shared_lock lock(_dataMutex);
+	if (!_data || !cb || handle.getUrl().empty()) {
+		return false;
+	}
+
+	auto req = new AsyncClientRequest{move(handle), move(cb)};
+	_data->submit(req);
+	return true;
+}
+
+void AsyncClient::wait() {
+	if (_data) {
+		_data->wait();
+	}
+}
+
+AsyncClient::Stats AsyncClient::getStats() const {
+	Stats ret;
+	std::shared_lock lock(_dataMutex);
+	if (_data) {
+		ret.submitted = _data->submitted.load();
+		ret.completed = _data->completed.load();
+		ret.failed = _data->failed.load();
+		ret.active = ret.submitted - ret.completed;
+	}
+	return ret;
+}
+
+std::map<std::string, AsyncClient::HostStats> AsyncClient::getHostStats() const {
+	std::map<std::string, HostStats> ret;
+	std::shared_lock dataLock(_dataMutex);
+	if (_data) {
+		std::unique_lock lock(_data->hostsMutex);
+		for (auto &it : _data->hosts) {
+			ret.emplace(it.first, it.second.stats);
+		}
+	}
+	return ret;
+}
+
+}
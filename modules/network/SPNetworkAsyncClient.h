@@ -0,0 +1,138 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef MODULES_NETWORK_SPNETWORKASYNCCLIENT_H_
+#define MODULES_NETWORK_SPNETWORKASYNCCLIENT_H_
+
+#include "SPNetworkHandle.h"
+#include "SPThreadTaskQueue.h"
+#include "SPEventTaskQueue.h"
+
+#include <shared_mutex>
+
+namespace stappler::network {
+
+// Persistent asynchronous client
+// Single curl multi handle is driven with curl_multi_socket_action from the client's epoll loop thread,
+// so connections and TLS sessions are reused between submissions. Requests can be submitted from any thread.
+//
+// Client also schedules requests: number of concurrent requests per host can be limited (excess requests
+// wait in per-host queue), failed idempotent requests can be retried with jittered exponential backoff,
+// and identical concurrent GET requests can be coalesced into single transfer.
+class AsyncClient : public RefBase<memory::StandartInterface> {
+public:
+	using Handle = network::Handle<memory::StandartInterface>;
+
+	// handle is owned by client until callback returns, it can be moved out from callback
+	using Callback = std::function<void(Handle &, bool success)>;
+
+	struct RetryPolicy {
+		uint32_t maxRetries = 0; // 0 - retries are disabled
+		TimeInterval delay = TimeInterval::milliseconds(100); // before first retry, doubled for every next one
+		TimeInterval maxDelay = TimeInterval::seconds(5);
+		float jitter = 0.5f; // fraction of delay to randomize, 0.0 - 1.0
+		bool retryServerErrors = true; // retry on 5xx and 429 responses, not only on transport errors
+	};
+
+	struct Config {
+		uint32_t maxTotalConnections = 64;
+		uint32_t maxHostConnections = 16;
+		uint32_t maxHostRequests = 0; // concurrent requests per host, 0 - unlimited
+		uint32_t maxIdleHandles = 256; // easy handles to keep for reuse
+		bool multiplex = true; // HTTP/2 multiplexing, when server supports it; new requests wait for it
+		// use HTTP/2 without upgrade for plain http:// urls
+		// libcurl 7.x can not reuse such connections, so with it every request opens its own connection
+		bool http2PriorKnowledge = false;
+		bool coalesce = false; // share single transfer between identical concurrent GET requests
+		RetryPolicy retry;
+	};
+
+	struct Stats {
+		size_t submitted = 0;
+		size_t completed = 0;
+		size_t failed = 0;
+		size_t active = 0; // submitted, but not completed
+	};
+
+	// Latency histogram with log2 buckets, first bucket is [0, 128us)
+	struct Histogram {
+		static constexpr size_t Buckets = 20;
+		static constexpr uint64_t MinBound = 128;
+
+		std::array<uint64_t, Buckets> buckets = { 0 };
+		uint64_t count = 0;
+		uint64_t sum = 0;
+		uint64_t max = 0;
+
+		void add(TimeInterval);
+
+		// upper bound of bucket, that contains requested percentile (0.0 - 1.0)
+		TimeInterval getPercentile(float) const;
+		TimeInterval getAverage() const;
+	};
+
+	struct HostStats {
+		size_t requests = 0; // completed requests, including coalesced
+		size_t failed = 0;
+		size_t retries = 0;
+		size_t coalesced = 0; // requests, that was served by other request's transfer
+		size_t maxActive = 0; // peak number of concurrent transfers
+		Histogram latency; // from submission to completion, including queueing and retries
+	};
+
+	struct Data;
+
+	AsyncClient();
+	virtual ~AsyncClient();
+
+	// completions are called on client's loop thread
+	bool init();
+	bool init(const Config &);
+
+	// completions are performed as tasks on queue
+	bool init(const Config &, thread::TaskQueue *);
+	bool init(const Config &, thread::EventTaskQueue *);
+
+	// stops loop thread, unfinished requests are completed as failed
+	// can be called concurrently with submit, later submits return false
+	void cancel();
+
+	bool submit(Handle &&, Callback &&);
+
+	// wait until all submitted requests are completed and their callbacks are called or scheduled
+	// should not be called concurrently with cancel
+	void wait();
+
+	Stats getStats() const;
+
+	// keyed with ShareContext::getHostKey
+	std::map<std::string, HostStats> getHostStats() const;
+
+protected:
+	// protects _data pointer from release in cancel while it is used by submit or stats
+	mutable std::shared_mutex _dataMutex;
+	Data *_data = nullptr;
+};
+
+}
+
+#endif /* MODULES_NETWORK_SPNETWORKASYNCCLIENT_H_ */
@@ -34,10 +34,12 @@
 namespace stappler::network {
 
 template <typename Interface>
-static void Handle_destroy(HandleData<Interface> &data) {
-	if (data.process.sharedHandle) {
-		curl_share_cleanup(data.process.sharedHandle);
+static auto Handle_extractReceivedValue(HandleData<Interface> &data) -> typename HandleData<Interface>::Value {
+	if (auto buf = std::get_if<data::StreamBuffer<Interface>>(&data.receive.data)) {
+		buf->finalize();
+		return buf->extract();
 	}
+	return typename HandleData<Interface>::Value();
 }
 
 template <typename Interface>
@@ -235,7 +237,6 @@ static int64_t Handle_getReceivedHeaderInt(const HandleData<Interface> &iface, S
 
 #define HANDLE_INTERFACE memory::PoolInterface
 
-HANDLE_NAME(,~HandleData) { Handle_destroy(*this); }
 HANDLE_NAME(bool, reset, Method method, StringView url) { return Handle_reset(*this, method, url); }
 HANDLE_NAME_CONST(long, getResponseCode) { return process.responseCode; }
 HANDLE_NAME_CONST(long, getErrorCode) { return process.errorCode; }
@@ -262,6 +263,8 @@ HANDLE_NAME(void, setReceiveFile, StringView filename, bool resumeDownload) {
 	receive.resumeDownload = resumeDownload;
 }
 HANDLE_NAME(void, setReceiveCallback, IOCallback &&cb) { receive.data = move(cb); }
+HANDLE_NAME(void, setReceiveValue, data::DataFormat fmt) { receive.data = data::StreamBuffer<HANDLE_INTERFACE>(fmt); }
+HANDLE_NAME(auto, extractReceivedValue) -> Value { return Handle_extractReceivedValue(*this); }
 HANDLE_NAME(void, setResumeDownload, bool resumeDownload) { receive.resumeDownload = resumeDownload; }
 HANDLE_NAME(void, setSendSize, size_t size) { send.size = size; }
 HANDLE_NAME(void, setSendFile, StringView filename, StringView type) { Handle_setSendFile(*this, filename, type); }
@@ -283,7 +286,9 @@ HANDLE_NAME_CONST(const Vector<String> &, getRecievedHeaders) { return receive.h
 
 HANDLE_NAME(void, setDebug, bool value) { process.debug = value; }
 HANDLE_NAME(void, setReuse, bool value) { process.reuse = value; }
-HANDLE_NAME(void, setShared, bool value) { process.shared = value; }
+HANDLE_NAME(void, setShared, bool value) { process.shareContext = value ? ShareContext::getDefault() : nullptr; }
+HANDLE_NAME(void, setShareContext, ShareContext *ctx) { process.shareContext = ctx; }
+HANDLE_NAME_CONST(ShareContext *, getShareContext) { return process.shareContext.get(); }
 HANDLE_NAME(void, setSilent, bool value) { process.silent = value; }
 HANDLE_NAME_CONST(const StringStream &, getDebugData) { return process.debugData; }
 
@@ -298,7 +303,6 @@ HANDLE_NAME(void, setLowSpeedLimit, int time, size_t limit) { process.lowSpeedTi
 
 #define HANDLE_INTERFACE memory::StandartInterface
 
-HANDLE_NAME(,~HandleData) { Handle_destroy(*this); }
 HANDLE_NAME(bool, reset, Method method, StringView url) { return Handle_reset(*this, method, url); }
 HANDLE_NAME_CONST(long, getResponseCode) { return process.responseCode; }
 HANDLE_NAME_CONST(long, getErrorCode) { return process.errorCode; }
@@ -325,6 +329,8 @@ HANDLE_NAME(void, setReceiveFile, StringView filename, bool resumeDownload) {
 	receive.resumeDownload = resumeDownload;
 }
 HANDLE_NAME(void, setReceiveCallback, IOCallback &&cb) { receive.data = move(cb); }
+HANDLE_NAME(void, setReceiveValue, data::DataFormat fmt) { receive.data = data::StreamBuffer<HANDLE_INTERFACE>(fmt); }
+HANDLE_NAME(auto, extractReceivedValue) -> Value { return Handle_extractReceivedValue(*this); }
 HANDLE_NAME(void, setResumeDownload, bool resumeDownload) { receive.resumeDownload = resumeDownload; }
 HANDLE_NAME(void, setSendSize, size_t size) { send.size = size; }
 HANDLE_NAME(void, setSendFile, StringView filename, StringView type) { Handle_setSendFile(*this, filename, type); }
@@ -346,7 +352,9 @@ HANDLE_NAME_CONST(const Vector<String> &, getRecievedHeaders) { return receive.h
 
 HANDLE_NAME(void, setDebug, bool value) { process.debug = value; }
 HANDLE_NAME(void, setReuse, bool value) { process.reuse = value; }
-HANDLE_NAME(void, setShared, bool value) { process.shared = value; }
+HANDLE_NAME(void, setShared, bool value) { process.shareContext = value ? ShareContext::getDefault() : nullptr; }
+HANDLE_NAME(void, setShareContext, ShareContext *ctx) { process.shareContext = ctx; }
+HANDLE_NAME_CONST(ShareContext *, getShareContext) { return process.shareContext.get(); }
 HANDLE_NAME(void, setSilent, bool value) { process.silent = value; }
 HANDLE_NAME_CONST(const StringStream &, getDebugData) { return process.debugData; }
 
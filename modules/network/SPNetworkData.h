@@ -27,6 +27,7 @@
 #include "SPTime.h"
 #include "SPData.h"
 #include "SPCrypto.h"
+#include "SPNetworkShare.h"
 
 #include <variant>
 
@@ -117,7 +118,7 @@ struct ProcessData {
 	ProgressCallback uploadProgress = nullptr;
 	ProgressCallback downloadProgress = nullptr;
 
-	void *sharedHandle = nullptr;
+	Rc<ShareContext> shareContext;
 
 	int64_t uploadProgressValue = 0;
 	Time uploadProgressTiming;
@@ -132,7 +133,6 @@ struct ProcessData {
 	int lowSpeedTime = 120;
 	int lowSpeedLimit = 10_KiB;
 
-	bool shared = false;
 	bool verifyTsl = true;
 	bool debug = false;
 	bool reuse = true;
@@ -161,7 +161,8 @@ struct ReceiveData {
 
 	std::variant<
 		String, // filename
-		IOCallback // data callback
+		IOCallback, // data callback
+		data::StreamBuffer<Interface> // incremental decoder
 		> data;
 
 	int64_t offset = 0;
@@ -193,7 +194,10 @@ struct HandleData : Interface::AllocBaseType {
 	ReceiveData<Interface> receive;
 	AuthData<Interface> auth;
 
-	~HandleData();
+	HandleData() = default;
+
+	HandleData(HandleData &&) = default;
+	HandleData &operator=(HandleData &&) = default;
 
 	bool reset(Method method, StringView url);
 
@@ -221,6 +225,13 @@ struct HandleData : Interface::AllocBaseType {
 
 	void setReceiveFile(StringView str, bool resumeDownload);
 	void setReceiveCallback(IOCallback &&cb);
+
+	// received data is decoded into Value as it arrives, without buffering the whole response
+	// JSON and CBOR are supported, if format is not defined, it's detected with Content-Type or data itself
+	void setReceiveValue(data::DataFormat = data::DataFormat::Unknown);
+
+	// returns decoded value, or null value if data was not received or was malformed
+	Value extractReceivedValue();
 	void setResumeDownload(bool value);
 	void setSendSize(size_t size);
 
@@ -245,7 +256,9 @@ struct HandleData : Interface::AllocBaseType {
 
 	void setDebug(bool value);
 	void setReuse(bool value);
-	void setShared(bool value);
+	void setShared(bool value); // use process-wide ShareContext
+	void setShareContext(ShareContext *);
+	ShareContext *getShareContext() const;
 	void setSilent(bool value);
 	const StringStream &getDebugData() const;
 
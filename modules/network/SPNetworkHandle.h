@@ -27,6 +27,8 @@ THE SOFTWARE.
 
 namespace stappler::network {
 
+class AsyncClient;
+
 template <typename Interface>
 class Handle : private HandleData<Interface> {
 public:
@@ -67,6 +69,8 @@ public:
 	using DataType::setProxy;
 	using DataType::setReceiveFile;
 	using DataType::setReceiveCallback;
+	using DataType::setReceiveValue;
+	using DataType::extractReceivedValue;
 	using DataType::setSendFile;
 	using DataType::setSendCallback;
 	using DataType::setSendData;
@@ -81,6 +85,8 @@ public:
 	using DataType::setDebug;
 	using DataType::setReuse;
 	using DataType::setShared;
+	using DataType::setShareContext;
+	using DataType::getShareContext;
 	using DataType::setSilent;
 	using DataType::getDebugData;
 	using DataType::setDownloadProgress;
@@ -92,6 +98,8 @@ protected:
 	template <typename I>
 	friend class MultiHandle;
 
+	friend class AsyncClient;
+
 	HandleData<Interface> *getData() { return this; }
 };
 
@@ -50,6 +50,17 @@ static size_t _writeData(char *data, size_t size, size_t nmemb, void *userptr) {
 		using T = std::decay_t<decltype(arg)>;
 		if constexpr (std::is_same_v<T, typename HandleData<Interface>::IOCallback>) {
 			return arg(data, size * nmemb);
+		} else if constexpr (std::is_same_v<T, data::StreamBuffer<Interface>>) {
+			if (arg.getFormat() == data::DataFormat::Unknown) {
+				auto ct = task->getReceivedHeaderString("Content-Type");
+				if (ct.find("cbor") != maxOf<size_t>()) {
+					arg.setFormat(data::DataFormat::Cbor);
+				} else if (ct.find("json") != maxOf<size_t>()) {
+					arg.setFormat(data::DataFormat::Json);
+				}
+			}
+			// malformed data is ignored, transfer is not interrupted, so response code and headers are available
+			arg.read((const uint8_t *)data, size * nmemb);
 		}
 		return size_t(size * nmemb);
 	}, task->receive.data);
@@ -394,6 +405,10 @@ static bool _setupReceive(HandleData<Interface> &iface, CURL *curl, FILE * & inp
 			} else if constexpr (std::is_same_v<T, typename HandleData<Interface>::IOCallback>) {
 				SetOpt(check, curl, CURLOPT_WRITEFUNCTION, _writeData<Interface>);
 				SetOpt(check, curl, CURLOPT_WRITEDATA, &iface);
+			} else if constexpr (std::is_same_v<T, data::StreamBuffer<Interface>>) {
+				arg.clear();
+				SetOpt(check, curl, CURLOPT_WRITEFUNCTION, _writeData<Interface>);
+				SetOpt(check, curl, CURLOPT_WRITEDATA, &iface);
 			}
 		}, iface.receive.data);
 	}
@@ -507,19 +522,14 @@ static bool prepare(HandleData<Interface> &iface, Context<Interface> *ctx, const
 
 	bool check = true;
 
-	if (ctx->share) {
-		SetOpt(check, ctx->curl, CURLOPT_SHARE, iface.process.sharedHandle);
-	} else if (iface.process.shared) {
-		if (!iface.process.sharedHandle) {
-			iface.process.sharedHandle = curl_share_init();
-			curl_share_setopt((CURLSH *)iface.process.sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
-			curl_share_setopt((CURLSH *)iface.process.sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
-			curl_share_setopt((CURLSH *)iface.process.sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
-			curl_share_setopt((CURLSH *)iface.process.sharedHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+	if (auto share = iface.process.shareContext.get()) {
+		ctx->share = (CURLSH *)share->getShareHandle();
+		if (share->getConfig().shareCookies) {
+			SetOpt(check, ctx->curl, CURLOPT_COOKIEFILE, "/undefined");
 		}
-		SetOpt(check, ctx->curl, CURLOPT_COOKIEFILE, "/undefined");
-		SetOpt(check, ctx->curl, CURLOPT_SHARE, iface.process.sharedHandle);
+		SetOpt(check, ctx->curl, CURLOPT_SHARE, ctx->share);
 	} else {
+		ctx->share = nullptr;
 		SetOpt(check, ctx->curl, CURLOPT_SHARE, nullptr);
 	}
 
@@ -585,6 +595,10 @@ static bool prepare(HandleData<Interface> &iface, Context<Interface> *ctx, const
 template <typename Interface>
 bool finalize(HandleData<Interface> &iface, Context<Interface> *ctx, const Callback<bool(CURL *)> &onAfterPerform) {
 	iface.process.errorCode = ctx->code;
+	if (auto share = iface.process.shareContext.get()) {
+		share->onPerformed(ctx->curl, ctx->code == CURLE_OK);
+	}
+
 	if (ctx->headers) {
 		curl_slist_free_all(ctx->headers);
 		ctx->headers = nullptr;
@@ -698,6 +712,14 @@ template <>
 bool perform(HandleData<memory::PoolInterface> &iface, const Callback<bool(CURL *)> &onBeforePerform, const Callback<bool(CURL *)> &onAfterPerform) {
 	auto p = memory::pool::acquire();
 	Context<memory::PoolInterface> ctx;
+	if (auto share = iface.process.shareContext.get()) {
+		auto key = ShareContext::getHostKey(iface.send.url);
+		ctx.curl = (CURL *)share->acquireHandle(key);
+		auto ret = _perform<memory::PoolInterface>(ctx, iface, onBeforePerform, onAfterPerform);
+		share->releaseHandle(key, ctx.curl, ctx.code == CURLE_OK);
+		return ret;
+	}
+
 	ctx.curl = CurlHandle::getHandle(iface.process.reuse, p);
 	auto ret = _perform<memory::PoolInterface>(ctx, iface, onBeforePerform, onAfterPerform);
 	CurlHandle::releaseHandle(ctx.curl, iface.process.reuse, ctx.code == CURLE_OK, p);
@@ -707,6 +729,14 @@ bool perform(HandleData<memory::PoolInterface> &iface, const Callback<bool(CURL
 template <>
 bool perform(HandleData<memory::StandartInterface> &iface, const Callback<bool(CURL *)> &onBeforePerform, const Callback<bool(CURL *)> &onAfterPerform) {
 	Context<memory::StandartInterface> ctx;
+	if (auto share = iface.process.shareContext.get()) {
+		auto key = ShareContext::getHostKey(iface.send.url);
+		ctx.curl = (CURL *)share->acquireHandle(key);
+		auto ret = _perform<memory::StandartInterface>(ctx, iface, onBeforePerform, onAfterPerform);
+		share->releaseHandle(key, ctx.curl, ctx.code == CURLE_OK);
+		return ret;
+	}
+
 	ctx.curl = CurlHandle::getHandle(iface.process.reuse, nullptr);
 	auto ret = _perform<memory::StandartInterface>(ctx, iface, onBeforePerform, onAfterPerform);
 	CurlHandle::releaseHandle(ctx.curl, iface.process.reuse, ctx.code == CURLE_OK, nullptr);
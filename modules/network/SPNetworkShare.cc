@@ -0,0 +1,206 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPNetworkShare.h"
+#include "SPUrl.h"
+
+#include <curl/curl.h>
+
+namespace stappler::network {
+
+struct ShareContext::Data {
+	Config config;
+	CURLSH *share = nullptr;
+
+	// curl calls lock functions with data type to protect, unlock call has no access type,
+	// so exclusive mutex per data type is used
+	std::array<std::mutex, CURL_LOCK_DATA_LAST> locks;
+
+	mutable std::mutex mutex;
+	std::map<std::string, std::vector<CURL *>, std::less<>> idle;
+	size_t idleCount = 0;
+
+	std::atomic<size_t> requests = 0;
+	std::atomic<size_t> failed = 0;
+	std::atomic<size_t> newConnections = 0;
+	std::atomic<size_t> reusedConnections = 0;
+	std::atomic<size_t> handleHits = 0;
+	std::atomic<size_t> handleMisses = 0;
+
+	Data(const Config &);
+	~Data();
+};
+
+static void ShareContext_lock(CURL *, curl_lock_data data, curl_lock_access, void *ptr) {
+	((ShareContext::Data *)ptr)->locks[data].lock();
+}
+
+static void ShareContext_unlock(CURL *, curl_lock_data data, void *ptr) {
+	((ShareContext::Data *)ptr)->locks[data].unlock();
+}
+
+ShareContext::Data::Data(const Config &cfg) : config(cfg) {
+	share = curl_share_init();
+	curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &ShareContext_lock);
+	curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &ShareContext_unlock);
+	if (config.shareDns) {
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	}
+	if (config.shareSessions) {
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+	if (config.shareConnections) {
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+	}
+	if (config.shareCookies) {
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+	}
+}
+
+ShareContext::Data::~Data() {
+	// easy handles should be detached before share cleanup
+	for (auto &it : idle) {
+		for (auto &curl : it.second) {
+			CurlHandle::release(curl);
+		}
+	}
+	idle.clear();
+
+	if (share) {
+		curl_share_cleanup(share);
+		share = nullptr;
+	}
+}
+
+ShareContext *ShareContext::getDefault() {
+	static ShareContext *s_default = new ShareContext();
+	return s_default;
+}
+
+std::string ShareContext::getHostKey(StringView url) {
+	UrlView view(url);
+	auto scheme = view.scheme.empty() ? StringView("http") : view.scheme;
+	if (view.port.empty()) {
+		return mem_std::toString(scheme, "://", view.host);
+	}
+	return mem_std::toString(scheme, "://", view.host, ":", view.port);
+}
+
+ShareContext::ShareContext() : ShareContext(Config()) { }
+
+ShareContext::ShareContext(const Config &cfg) {
+	_data = new Data(cfg);
+}
+
+ShareContext::~ShareContext() {
+	if (_data) {
+		delete _data;
+		_data = nullptr;
+	}
+}
+
+const ShareContext::Config &ShareContext::getConfig() const {
+	return _data->config;
+}
+
+void *ShareContext::getShareHandle() const {
+	return _data->share;
+}
+
+void *ShareContext::acquireHandle(StringView key) {
+	do {
+		std::unique_lock lock(_data->mutex);
+		auto it = _data->idle.find(key);
+		if (it != _data->idle.end() && !it->second.empty()) {
+			auto curl = it->second.back();
+			it->second.pop_back();
+			-- _data->idleCount;
+			++ _data->handleHits;
+			return curl;
+		}
+	} while (0);
+
+	++ _data->handleMisses;
+	auto curl = CurlHandle::alloc();
+	curl_easy_setopt(curl, CURLOPT_SHARE, _data->share);
+	return curl;
+}
+
+void ShareContext::releaseHandle(StringView key, void *curl, bool success) {
+	if (!curl) {
+		return;
+	}
+
+	if (success) {
+		// reset keeps connections and share handle, only options are dropped
+		curl_easy_reset(curl);
+
+		std::unique_lock lock(_data->mutex);
+		if (_data->idleCount < _data->config.maxIdleHandles) {
+			auto it = _data->idle.find(key);
+			if (it == _data->idle.end()) {
+				it = _data->idle.emplace(key.str<memory::StandartInterface>(), std::vector<CURL *>()).first;
+			}
+			if (it->second.size() < _data->config.maxHostIdleHandles) {
+				it->second.emplace_back(curl);
+				++ _data->idleCount;
+				return;
+			}
+		}
+	}
+
+	CurlHandle::release(curl);
+}
+
+void ShareContext::onPerformed(void *curl, bool success) {
+	++ _data->requests;
+	if (!success) {
+		++ _data->failed;
+		return;
+	}
+
+	long connects = 0;
+	if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK) {
+		if (connects == 0) {
+			++ _data->reusedConnections;
+		} else {
+			_data->newConnections += connects;
+		}
+	}
+}
+
+ShareContext::Stats ShareContext::getStats() const {
+	Stats ret;
+	ret.requests = _data->requests.load();
+	ret.failed = _data->failed.load();
+	ret.newConnections = _data->newConnections.load();
+	ret.reusedConnections = _data->reusedConnections.load();
+	ret.handleHits = _data->handleHits.load();
+	ret.handleMisses = _data->handleMisses.load();
+
+	std::unique_lock lock(_data->mutex);
+	ret.idleHandles = _data->idleCount;
+	return ret;
+}
+
+}
@@ -0,0 +1,95 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef MODULES_NETWORK_SPNETWORKSHARE_H_
+#define MODULES_NETWORK_SPNETWORKSHARE_H_
+
+#include "SPCommon.h"
+#include "SPRef.h"
+
+namespace stappler::network {
+
+// Sharing context for independent handles
+// Wraps curl share handle with proper locking, so DNS cache and TLS sessions are shared between
+// handles performed from different threads. Also keeps pool of warmed easy handles, grouped by
+// scheme, host and port of request; every pooled handle keeps its own connections alive, so
+// connections are reused without shared connection cache.
+class ShareContext : public RefBase<memory::StandartInterface> {
+public:
+	struct Config {
+		uint32_t maxIdleHandles = 64; // easy handles to keep for reuse
+		uint32_t maxHostIdleHandles = 8;
+		// libcurl does not support shared connection cache for handles, performed concurrently
+		// from different threads; enable only when context is used by a single thread at a time
+		bool shareConnections = false;
+		bool shareSessions = true;
+		bool shareDns = true;
+		bool shareCookies = false; // cookies are shared between all handles within context
+	};
+
+	struct Stats {
+		size_t requests = 0;
+		size_t failed = 0;
+		size_t newConnections = 0; // connections, opened for requests
+		size_t reusedConnections = 0; // requests, performed on existing connection
+		size_t handleHits = 0; // easy handles, acquired from pool
+		size_t handleMisses = 0;
+		size_t idleHandles = 0;
+
+		float getReuseRate() const {
+			return requests ? float(reusedConnections) / float(requests) : 0.0f;
+		}
+	};
+
+	struct Data;
+
+	// process-wide context, used by handles with setShared(true)
+	static ShareContext *getDefault();
+
+	// scheme://host:port, used as pool key
+	static std::string getHostKey(StringView url);
+
+	ShareContext();
+	ShareContext(const Config &);
+	virtual ~ShareContext();
+
+	const Config &getConfig() const;
+
+	// CURLSH *
+	void *getShareHandle() const;
+
+	// CURL *, configured with context's share handle
+	void *acquireHandle(StringView key);
+	void releaseHandle(StringView key, void *, bool success);
+
+	// collect reuse stats from performed easy handle
+	void onPerformed(void *, bool success);
+
+	Stats getStats() const;
+
+protected:
+	Data *_data = nullptr;
+};
+
+}
+
+#endif /* MODULES_NETWORK_SPNETWORKSHARE_H_ */
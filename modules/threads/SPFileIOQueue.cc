@@ -0,0 +1,1176 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPFileIOQueue.h"
+#include "SPLog.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if LINUX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace stappler::thread {
+
+struct FileIOQueue::Data {
+	struct Pending {
+		Callback callback;
+		bool immediate = false;
+
+		// request state to continue partial transfers with io_uring
+		Op op = Op::Sync;
+		int fd = -1;
+		uint64_t offset = 0;
+		uint8_t *data = nullptr;
+		size_t size = 0;
+		uint32_t buffer = InvalidBuffer;
+		size_t transferred = 0;
+	};
+
+	// kernel limit for a single read or write (MAX_RW_COUNT), larger requests are split
+	static constexpr size_t MaxTransfer = 0x7fff'f000;
+
+	Data(FileIOQueue *q, const Config &cfg) : queue(q), config(cfg) { }
+
+	bool init();
+	// returns false, if data is released by completion thread
+	bool cancel();
+
+	size_t submit(std::vector<Request> &&);
+	void perform(Request &&);
+	void complete(Pending *, int64_t);
+	void wait();
+
+	// returns false, if queue is full and caller should wait
+	bool acquireSlot(std::unique_lock<std::mutex> &);
+	bool isCompletionThread() const;
+
+	bool initBuffers();
+	void freeBuffers();
+
+#if LINUX
+	bool initRing();
+	void freeRing();
+	void pushRequest(Request &&);
+	void pushPending(Pending *);
+	bool resubmit(Pending *, int64_t);
+	void enter(uint32_t toSubmit);
+	void reaperThread();
+#endif
+
+	FileIOQueue *queue = nullptr;
+	Config config;
+	Backend backend = Backend::Default;
+
+	Rc<TaskQueue> target;
+	Rc<EventTaskQueue> eventTarget;
+
+	uint8_t *buffers = nullptr;
+	bool buffersRegistered = false;
+	std::vector<uint32_t> freeBufferList;
+	std::mutex buffersMutex;
+	std::condition_variable buffersCond;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::atomic<size_t> inflight = 0;
+
+	// thread pool backend
+	Rc<TaskQueue> pool;
+	std::vector<std::thread::id> workerIds;
+
+#if LINUX
+	int ringFd = -1;
+	uint32_t pending = 0;
+	std::mutex submitMutex;
+	std::thread reaper;
+	std::thread::id reaperId;
+	std::atomic<bool> detached = false;
+
+	void *sqPtr = nullptr;
+	size_t sqSize = 0;
+	void *cqPtr = nullptr;
+	size_t cqSize = 0;
+	io_uring_sqe *sqes = nullptr;
+	size_t sqesSize = 0;
+
+	unsigned *sqHead = nullptr;
+	unsigned *sqTail = nullptr;
+	unsigned *sqMask = nullptr;
+	unsigned *sqEntries = nullptr;
+	unsigned *sqArray = nullptr;
+
+	unsigned *cqHead = nullptr;
+	unsigned *cqTail = nullptr;
+	unsigned *cqMask = nullptr;
+	io_uring_cqe *cqes = nullptr;
+#endif
+};
+
+bool FileIOQueue::Data::init() {
+	if (config.queueDepth == 0) {
+		config.queueDepth = 1;
+	}
+
+	if (!initBuffers()) {
+		return false;
+	}
+
+#if LINUX
+	if (config.backend != Backend::ThreadPool) {
+		if (initRing()) {
+			backend = Backend::IoUring;
+			return true;
+		} else if (config.backend == Backend::IoUring) {
+			freeBuffers();
+			return false;
+		}
+	}
+#endif
+
+	pool = Rc<TaskQueue>::alloc("FileIOQueue");
+	if (!pool->spawnWorkers(TaskQueue::Flags::None, maxOf<uint32_t>(), std::max(config.threadCount, uint16_t(1)))) {
+		pool = nullptr;
+		freeBuffers();
+		return false;
+	}
+	workerIds = pool->getThreadIds();
+	backend = Backend::ThreadPool;
+	return true;
+}
+
+bool FileIOQueue::Data::cancel() {
+#if LINUX
+	if (ringFd >= 0 && std::this_thread::get_id() == reaperId) {
+		// queue was released from completion callback, reaper can not wait for or join itself,
+		// so it finishes remaining requests and then releases data
+		std::unique_lock lock(submitMutex);
+		Request req;
+		req.op = Op::Sync;
+		pushRequest(move(req));
+		enter(pending);
+		pending = 0;
+		lock.unlock();
+
+		detached = true;
+		reaper.detach();
+		return false;
+	}
+#endif
+
+	wait();
+
+#if LINUX
+	if (ringFd >= 0) {
+		// empty user_data is a signal for reaper to stop
+		std::unique_lock lock(submitMutex);
+		Request req;
+		req.op = Op::Sync;
+		pushRequest(move(req));
+		enter(pending);
+		pending = 0;
+		lock.unlock();
+
+		reaper.join();
+		freeRing();
+	}
+#endif
+
+	if (pool) {
+		pool->cancelWorkers();
+		pool = nullptr;
+	}
+
+	freeBuffers();
+	return true;
+}
+
+size_t FileIOQueue::Data::submit(std::vector<Request> &&reqs) {
+	size_t ret = 0;
+#if LINUX
+	if (backend == Backend::IoUring) {
+		std::unique_lock submitLock(submitMutex);
+		for (auto &it : reqs) {
+			std::unique_lock lock(mutex);
+			if (!acquireSlot(lock)) {
+				// send pending requests to kernel before waiting for completions
+				lock.unlock();
+				enter(pending);
+				pending = 0;
+
+				// completion callbacks can submit new requests, do not block them while waiting
+				submitLock.unlock();
+				lock.lock();
+				cond.wait(lock, [&] { return acquireSlot(lock); });
+				lock.unlock();
+				submitLock.lock();
+			} else {
+				lock.unlock();
+			}
+
+			pushRequest(move(it));
+			++ ret;
+		}
+		enter(pending);
+		pending = 0;
+		return ret;
+	}
+#endif
+
+	for (auto &it : reqs) {
+		do {
+			std::unique_lock lock(mutex);
+			if (!acquireSlot(lock)) {
+				cond.wait(lock, [&] { return acquireSlot(lock); });
+			}
+		} while (0);
+
+		perform(move(it));
+		++ ret;
+	}
+	return ret;
+}
+
+void FileIOQueue::Data::perform(Request &&req) {
+	pool->perform([this, req = move(req)] () mutable {
+		int64_t result = 0;
+		switch (req.op) {
+		case Op::Read:
+			while (size_t(result) < req.size) {
+				auto ret = ::pread(req.fd, req.data + result, req.size - result, req.offset + result);
+				if (ret < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					result = -errno;
+					break;
+				} else if (ret == 0) {
+					break;
+				}
+				result += ret;
+			}
+			break;
+		case Op::Write:
+			while (size_t(result) < req.size) {
+				auto ret = ::pwrite(req.fd, req.data + result, req.size - result, req.offset + result);
+				if (ret < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					result = -errno;
+					break;
+				} else if (ret == 0) {
+					break;
+				}
+				result += ret;
+			}
+			break;
+		case Op::Sync:
+			if (::fsync(req.fd) != 0) {
+				result = -errno;
+			}
+			break;
+		}
+
+		complete(new Pending{move(req.callback), req.immediate}, result);
+	});
+}
+
+void FileIOQueue::Data::complete(Pending *p, int64_t result) {
+	if (p->callback) {
+		if (p->immediate || (!target && !eventTarget)) {
+			p->callback(result);
+		} else if (target) {
+			target->perform([cb = move(p->callback), result] {
+				cb(result);
+			});
+		} else {
+			eventTarget->perform([cb = move(p->callback), result] {
+				cb(result);
+			});
+		}
+	}
+	delete p;
+
+	std::unique_lock lock(mutex);
+	-- inflight;
+	cond.notify_all();
+}
+
+void FileIOQueue::Data::wait() {
+	std::unique_lock lock(mutex);
+	cond.wait(lock, [&] { return inflight.load() == 0; });
+}
+
+bool FileIOQueue::Data::acquireSlot(std::unique_lock<std::mutex> &) {
+	// callbacks on completion thread should not wait for itself
+	if (inflight.load() < config.queueDepth || isCompletionThread()) {
+		++ inflight;
+		return true;
+	}
+	return false;
+}
+
+bool FileIOQueue::Data::isCompletionThread() const {
+	auto id = std::this_thread::get_id();
+#if LINUX
+	if (id == reaperId) {
+		return true;
+	}
+#endif
+	return std::find(workerIds.begin(), workerIds.end(), id) != workerIds.end();
+}
+
+bool FileIOQueue::Data::initBuffers() {
+	if (config.bufferCount == 0 || config.bufferSize == 0) {
+		return true;
+	}
+
+	// page alignment is required for O_DIRECT and preferred for registered buffers
+	config.bufferSize = math::align<size_t>(config.bufferSize, 4_KiB);
+	if (::posix_memalign((void **)&buffers, 4_KiB, config.bufferSize * config.bufferCount) != 0) {
+		buffers = nullptr;
+		return false;
+	}
+
+	freeBufferList.reserve(config.bufferCount);
+	for (uint32_t i = config.bufferCount; i > 0; -- i) {
+		freeBufferList.emplace_back(i - 1);
+	}
+	return true;
+}
+
+void FileIOQueue::Data::freeBuffers() {
+	if (buffers) {
+		::free(buffers);
+		buffers = nullptr;
+	}
+	freeBufferList.clear();
+}
+
+#if LINUX
+
+static int FileIOQueue_setup(uint32_t entries, io_uring_params *p) {
+	return int(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int FileIOQueue_enter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+	return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int FileIOQueue_register(int fd, uint32_t opcode, const void *arg, uint32_t nargs) {
+	return int(::syscall(__NR_io_uring_register, fd, opcode, arg, nargs));
+}
+
+// plain read and write are available since 5.6, older kernels fail them with EINVAL;
+// probe itself is not supported before 5.6 too
+static bool FileIOQueue_probe(int fd) {
+	static constexpr uint32_t OpsCount = 256;
+	auto probe = (io_uring_probe *)::calloc(1, sizeof(io_uring_probe) + OpsCount * sizeof(io_uring_probe_op));
+	if (FileIOQueue_register(fd, IORING_REGISTER_PROBE, probe, OpsCount) != 0) {
+		::free(probe);
+		return false;
+	}
+
+	bool ret = true;
+	for (auto op : { IORING_OP_NOP, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FSYNC }) {
+		if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+			ret = false;
+		}
+	}
+	::free(probe);
+	return ret;
+}
+
+bool FileIOQueue::Data::initRing() {
+	io_uring_params params;
+	memset(&params, 0, sizeof(io_uring_params));
+
+	ringFd = FileIOQueue_setup(config.queueDepth, &params);
+	if (ringFd < 0) {
+		ringFd = -1;
+		return false;
+	}
+
+	if (!FileIOQueue_probe(ringFd)) {
+		freeRing();
+		return false;
+	}
+
+	sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		sqSize = cqSize = std::max(sqSize, cqSize);
+	}
+
+	sqPtr = ::mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	if (sqPtr == MAP_FAILED) {
+		sqPtr = nullptr;
+		freeRing();
+		return false;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cqPtr = sqPtr;
+	} else {
+		cqPtr = ::mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if (cqPtr == MAP_FAILED) {
+			cqPtr = nullptr;
+			freeRing();
+			return false;
+		}
+	}
+
+	sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	sqes = (io_uring_sqe *)::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		sqes = nullptr;
+		freeRing();
+		return false;
+	}
+
+	sqHead = (unsigned *)((uint8_t *)sqPtr + params.sq_off.head);
+	sqTail = (unsigned *)((uint8_t *)sqPtr + params.sq_off.tail);
+	sqMask = (unsigned *)((uint8_t *)sqPtr + params.sq_off.ring_mask);
+	sqEntries = (unsigned *)((uint8_t *)sqPtr + params.sq_off.ring_entries);
+	sqArray = (unsigned *)((uint8_t *)sqPtr + params.sq_off.array);
+
+	cqHead = (unsigned *)((uint8_t *)cqPtr + params.cq_off.head);
+	cqTail = (unsigned *)((uint8_t *)cqPtr + params.cq_off.tail);
+	cqMask = (unsigned *)((uint8_t *)cqPtr + params.cq_off.ring_mask);
+	cqes = (io_uring_cqe *)((uint8_t *)cqPtr + params.cq_off.cqes);
+
+	// kernel can round queue size, in-flight requests should fit into submission queue
+	config.queueDepth = std::min(config.queueDepth, params.sq_entries);
+
+	if (buffers) {
+		std::vector<iovec> iov;
+		iov.reserve(config.bufferCount);
+		for (uint32_t i = 0; i < config.bufferCount; ++ i) {
+			iov.emplace_back(iovec{buffers + config.bufferSize * i, config.bufferSize});
+		}
+
+		// registration can fail with RLIMIT_MEMLOCK, buffers still usable without it
+		buffersRegistered = FileIOQueue_register(ringFd, IORING_REGISTER_BUFFERS, iov.data(), uint32_t(iov.size())) == 0;
+	}
+
+	reaper = std::thread([this] {
+		reaperThread();
+	});
+	reaperId = reaper.get_id();
+	return true;
+}
+
+void FileIOQueue::Data::freeRing() {
+	if (sqes) {
+		::munmap(sqes, sqesSize);
+		sqes = nullptr;
+	}
+	if (cqPtr && cqPtr != sqPtr) {
+		::munmap(cqPtr, cqSize);
+	}
+	cqPtr = nullptr;
+	if (sqPtr) {
+		::munmap(sqPtr, sqSize);
+		sqPtr = nullptr;
+	}
+	if (ringFd >= 0) {
+		::close(ringFd);
+		ringFd = -1;
+	}
+	buffersRegistered = false;
+}
+
+void FileIOQueue::Data::pushRequest(Request &&req) {
+	// request without file is a stop signal for reaper, it has empty user_data
+	Pending *p = nullptr;
+	if (req.fd >= 0) {
+		p = new Pending{move(req.callback), req.immediate, req.op, req.fd, req.offset, req.data, req.size, req.buffer};
+	}
+	pushPending(p);
+}
+
+void FileIOQueue::Data::pushPending(Pending *p) {
+	auto tail = *sqTail;
+	if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= *sqEntries) {
+		enter(pending);
+		pending = 0;
+		tail = *sqTail;
+	}
+
+	auto index = tail & *sqMask;
+	auto sqe = &sqes[index];
+	memset(sqe, 0, sizeof(io_uring_sqe));
+
+	if (p) {
+		sqe->fd = p->fd;
+		sqe->off = p->offset + p->transferred;
+		sqe->addr = uint64_t(uintptr_t(p->data + p->transferred));
+		sqe->len = uint32_t(std::min(p->size - p->transferred, MaxTransfer));
+
+		const bool fixed = buffersRegistered && p->buffer < config.bufferCount;
+		switch (p->op) {
+		case Op::Read:
+			sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			break;
+		case Op::Write:
+			sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+			break;
+		case Op::Sync:
+			sqe->opcode = IORING_OP_FSYNC;
+			break;
+		}
+
+		if (fixed) {
+			sqe->buf_index = uint16_t(p->buffer);
+		}
+
+		sqe->user_data = uint64_t(uintptr_t(p));
+	} else {
+		sqe->fd = -1;
+		sqe->opcode = IORING_OP_NOP;
+	}
+
+	sqArray[index] = index;
+	__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+	++ pending;
+}
+
+bool FileIOQueue::Data::resubmit(Pending *p, int64_t result) {
+	// continue short or split transfers until whole request is done or EOF,
+	// same way as thread pool backend does with pread/pwrite
+	if (p->op == Op::Sync) {
+		return false;
+	}
+
+	if (result == -EINTR || result == -EAGAIN) {
+		// retry the same part
+	} else if (result <= 0) {
+		return false;
+	} else {
+		p->transferred += size_t(result);
+		if (p->transferred >= p->size) {
+			return false;
+		}
+	}
+
+	std::unique_lock lock(submitMutex);
+	pushPending(p);
+	enter(pending);
+	pending = 0;
+	return true;
+}
+
+void FileIOQueue::Data::enter(uint32_t toSubmit) {
+	while (toSubmit > 0) {
+		auto ret = FileIOQueue_enter(ringFd, toSubmit, 0, 0);
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+				std::this_thread::yield();
+				continue;
+			}
+			log::vtext("FileIOQueue", "io_uring_enter() failed with errno ", errno);
+			return;
+		}
+		toSubmit -= std::min(toSubmit, uint32_t(ret));
+	}
+}
+
+void FileIOQueue::Data::reaperThread() {
+	thread::ThreadInfo::setThreadInfo("FileIOQueue");
+
+	bool running = true;
+	while (running || (detached && inflight.load() > 0)) {
+		auto ret = FileIOQueue_enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+		if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			log::vtext("FileIOQueue", "io_uring_enter() failed with errno ", errno);
+			break;
+		}
+
+		auto head = *cqHead;
+		auto tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		while (head != tail) {
+			auto cqe = &cqes[head & *cqMask];
+			auto userData = cqe->user_data;
+			auto result = cqe->res;
+
+			++ head;
+			__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+			if (userData) {
+				auto p = (Pending *)uintptr_t(userData);
+				if (!resubmit(p, result)) {
+					complete(p, (result < 0) ? int64_t(result) : int64_t(p->transferred));
+				}
+			} else {
+				running = false;
+			}
+		}
+	}
+
+	if (detached) {
+		freeRing();
+		freeBuffers();
+		delete this;
+	}
+}
+
+#endif
+
+FileIOQueue::FileIOQueue() { }
+
+FileIOQueue::~FileIOQueue() {
+	cancel();
+}
+
+bool FileIOQueue::init() {
+	return init(Config());
+}
+
+bool FileIOQueue::init(const Config &cfg) {
+	if (_data) {
+		return false;
+	}
+
+	_data = new Data(this, cfg);
+	if (!_data->init()) {
+		delete _data;
+		_data = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool FileIOQueue::init(const Config &cfg, TaskQueue *q) {
+	if (!init(cfg)) {
+		return false;
+	}
+	_data->target = q;
+	return true;
+}
+
+bool FileIOQueue::init(const Config &cfg, EventTaskQueue *q) {
+	if (!init(cfg)) {
+		return false;
+	}
+	_data->eventTarget = q;
+	return true;
+}
+
+void FileIOQueue::cancel() {
+	if (_data) {
+		if (_data->cancel()) {
+			delete _data;
+		}
+		_data = nullptr;
+	}
+}
+
+bool FileIOQueue::submit(Request &&req) {
+	std::vector<Request> reqs;
+	reqs.emplace_back(move(req));
+	return submit(move(reqs)) == 1;
+}
+
+size_t FileIOQueue::submit(std::vector<Request> &&reqs) {
+	if (!_data) {
+		return 0;
+	}
+
+	for (auto &it : reqs) {
+		if (it.fd < 0) {
+			return 0;
+		}
+	}
+
+	return _data->submit(move(reqs));
+}
+
+void FileIOQueue::wait() {
+	if (_data) {
+		_data->wait();
+	}
+}
+
+uint32_t FileIOQueue::acquireBuffer(bool wait) {
+	if (!_data || !_data->buffers) {
+		return InvalidBuffer;
+	}
+
+	std::unique_lock lock(_data->buffersMutex);
+	if (_data->freeBufferList.empty()) {
+		if (!wait) {
+			return InvalidBuffer;
+		}
+		_data->buffersCond.wait(lock, [&] { return !_data->freeBufferList.empty(); });
+	}
+
+	auto ret = _data->freeBufferList.back();
+	_data->freeBufferList.pop_back();
+	return ret;
+}
+
+void FileIOQueue::releaseBuffer(uint32_t idx) {
+	if (!_data || idx >= _data->config.bufferCount) {
+		return;
+	}
+
+	std::unique_lock lock(_data->buffersMutex);
+	_data->freeBufferList.emplace_back(idx);
+	_data->buffersCond.notify_one();
+}
+
+uint8_t *FileIOQueue::getBuffer(uint32_t idx) const {
+	if (!_data || !_data->buffers || idx >= _data->config.bufferCount) {
+		return nullptr;
+	}
+	return _data->buffers + _data->config.bufferSize * idx;
+}
+
+size_t FileIOQueue::getBufferSize() const {
+	return _data ? _data->config.bufferSize : 0;
+}
+
+uint32_t FileIOQueue::getBufferCount() const {
+	return _data ? _data->config.bufferCount : 0;
+}
+
+FileIOQueue::Backend FileIOQueue::getBackend() const {
+	return _data ? _data->backend : Backend::Default;
+}
+
+size_t FileIOQueue::getInflightCount() const {
+	return _data ? _data->inflight.load() : 0;
+}
+
+bool FileIOQueue::isCompletionThread() const {
+	return _data ? _data->isCompletionThread() : false;
+}
+
+struct AsyncFileReader::Slot {
+	uint8_t *data = nullptr;
+	uint32_t buffer = FileIOQueue::InvalidBuffer;
+	size_t offset = 0;
+	size_t size = 0; // requested size
+	int64_t result = 0; // bytes read or negative errno
+	size_t consumed = 0;
+	bool pending = false;
+	bool ready = false;
+};
+
+AsyncFileReader::AsyncFileReader(FileIOQueue *queue, StringView path, uint32_t depth) : _queue(queue) {
+	if (!_queue || _queue->getBufferSize() == 0) {
+		return;
+	}
+
+	_fd = ::open(path.str<memory::StandartInterface>().data(), O_RDONLY | O_CLOEXEC);
+	if (_fd < 0) {
+		_error = -errno;
+		return;
+	}
+
+	struct stat st;
+	if (::fstat(_fd, &st) != 0) {
+		_error = -errno;
+		close();
+		return;
+	}
+
+	_size = size_t(st.st_size);
+
+	::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	_slots.resize(std::max(depth, uint32_t(1)));
+	for (auto &it : _slots) {
+		// use shared registered buffers when possible, fallback to own memory
+		it.buffer = _queue->acquireBuffer(false);
+		if (it.buffer != FileIOQueue::InvalidBuffer) {
+			it.data = _queue->getBuffer(it.buffer);
+		} else {
+			it.data = (uint8_t *)::malloc(_queue->getBufferSize());
+		}
+	}
+
+	reset(0);
+}
+
+AsyncFileReader::~AsyncFileReader() {
+	close();
+}
+
+size_t AsyncFileReader::read(uint8_t *buf, size_t nbytes) {
+	size_t ret = 0;
+	while (nbytes > 0 && _position < _size && is_open()) {
+		auto &slot = _slots[_current];
+		if (!slot.pending) {
+			break;
+		}
+
+		do {
+			std::unique_lock lock(_mutex);
+			_cond.wait(lock, [&] { return slot.ready; });
+		} while (0);
+
+		if (slot.result <= 0) {
+			if (slot.result < 0 && _error == 0) {
+				_error = int(slot.result);
+			}
+			break;
+		}
+
+		auto available = size_t(slot.result) - slot.consumed;
+		auto size = std::min(available, nbytes);
+		memcpy(buf, slot.data + slot.consumed, size);
+		slot.consumed += size;
+		_position += size;
+		ret += size;
+		buf += size;
+		nbytes -= size;
+
+		if (slot.consumed == size_t(slot.result)) {
+			slot.pending = false;
+			if (size_t(slot.result) < slot.size && _position < _size) {
+				// short read in the middle of file, next requests does not match position
+				reset(_position);
+			} else {
+				_current = (_current + 1) % _slots.size();
+				schedule(slot);
+			}
+		}
+	}
+	return ret;
+}
+
+size_t AsyncFileReader::seek(int64_t offset, io::Seek s) {
+	if (!is_open()) {
+		return maxOf<size_t>();
+	}
+
+	int64_t target = 0;
+	switch (s) {
+	case io::Seek::Set: target = offset; break;
+	case io::Seek::Current: target = int64_t(_position) + offset; break;
+	case io::Seek::End: target = int64_t(_size) + offset; break;
+	}
+
+	if (target < 0) {
+		return maxOf<size_t>();
+	}
+
+	if (size_t(target) != _position) {
+		reset(std::min(size_t(target), _size));
+	}
+	return _position;
+}
+
+void AsyncFileReader::close() {
+	if (_fd < 0) {
+		return;
+	}
+
+	if (_queue->isCompletionThread()) {
+		// reader waits for its requests, that should be completed by this thread
+		stappler::log::vtext("AsyncFileReader", "close() can not be called on FileIOQueue completion thread");
+		return;
+	}
+
+	waitAll();
+	for (auto &it : _slots) {
+		if (it.buffer != FileIOQueue::InvalidBuffer) {
+			_queue->releaseBuffer(it.buffer);
+		} else if (it.data) {
+			::free(it.data);
+		}
+	}
+	_slots.clear();
+
+	::close(_fd);
+	_fd = -1;
+}
+
+bool AsyncFileReader::prepare(Slot &slot, FileIOQueue::Request &req) {
+	if (_nextOffset >= _size) {
+		return false;
+	}
+
+	slot.offset = _nextOffset;
+	slot.size = std::min(_queue->getBufferSize(), _size - _nextOffset);
+	slot.result = 0;
+	slot.consumed = 0;
+	slot.ready = false;
+	slot.pending = true;
+	_nextOffset += slot.size;
+
+	req.op = FileIOQueue::Op::Read;
+	req.fd = _fd;
+	req.offset = slot.offset;
+	req.data = slot.data;
+	req.size = slot.size;
+	req.buffer = slot.buffer;
+	req.immediate = true;
+	req.callback = [this, s = &slot] (int64_t result) {
+		std::unique_lock lock(_mutex);
+		s->result = result;
+		s->ready = true;
+		_cond.notify_all();
+	};
+	return true;
+}
+
+void AsyncFileReader::schedule(Slot &slot) {
+	FileIOQueue::Request req;
+	if (prepare(slot, req)) {
+		if (!_queue->submit(move(req))) {
+			slot.result = -EIO;
+			slot.ready = true;
+		}
+	}
+}
+
+void AsyncFileReader::reset(size_t offset) {
+	waitAll();
+
+	for (auto &it : _slots) {
+		it.pending = false;
+	}
+
+	_position = _nextOffset = offset;
+	_current = 0;
+
+	// initial read-ahead is submitted as a single batch
+	std::vector<FileIOQueue::Request> reqs;
+	reqs.reserve(_slots.size());
+	for (auto &it : _slots) {
+		FileIOQueue::Request req;
+		if (prepare(it, req)) {
+			reqs.emplace_back(move(req));
+		}
+	}
+
+	if (!reqs.empty() && _queue->submit(move(reqs)) == 0) {
+		for (auto &it : _slots) {
+			if (it.pending) {
+				it.result = -EIO;
+				it.ready = true;
+			}
+		}
+	}
+}
+
+void AsyncFileReader::waitAll() {
+	std::unique_lock lock(_mutex);
+	_cond.wait(lock, [&] {
+		for (auto &it : _slots) {
+			if (it.pending && !it.ready) {
+				return false;
+			}
+		}
+		return true;
+	});
+}
+
+struct AsyncFileWriter::Slot {
+	uint8_t *data = nullptr;
+	uint32_t buffer = FileIOQueue::InvalidBuffer;
+	size_t filled = 0;
+	bool pending = false;
+};
+
+AsyncFileWriter::AsyncFileWriter(FileIOQueue *queue, StringView path, uint32_t depth) : _queue(queue) {
+	if (!_queue || _queue->getBufferSize() == 0) {
+		return;
+	}
+
+	_fd = ::open(path.str<memory::StandartInterface>().data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (_fd < 0) {
+		_error = -errno;
+		return;
+	}
+
+	_slots.resize(std::max(depth, uint32_t(1)));
+	for (auto &it : _slots) {
+		it.buffer = _queue->acquireBuffer(false);
+		if (it.buffer != FileIOQueue::InvalidBuffer) {
+			it.data = _queue->getBuffer(it.buffer);
+		} else {
+			it.data = (uint8_t *)::malloc(_queue->getBufferSize());
+		}
+	}
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+	close();
+}
+
+size_t AsyncFileWriter::write(const uint8_t *buf, size_t nbytes) {
+	if (!is_open()) {
+		return 0;
+	}
+
+	const auto bufferSize = _queue->getBufferSize();
+	size_t ret = 0;
+	while (nbytes > 0) {
+		auto &slot = _slots[_current];
+		do {
+			// pending flag is reset by completion callback
+			std::unique_lock lock(_mutex);
+			_cond.wait(lock, [&] { return !slot.pending; });
+		} while (0);
+
+		auto size = std::min(bufferSize - slot.filled, nbytes);
+		memcpy(slot.data + slot.filled, buf, size);
+		slot.filled += size;
+		_position += size;
+		ret += size;
+		buf += size;
+		nbytes -= size;
+
+		if (slot.filled == bufferSize) {
+			schedule(slot);
+			_current = (_current + 1) % _slots.size();
+		}
+	}
+	return ret;
+}
+
+void AsyncFileWriter::flush() {
+	if (!is_open()) {
+		return;
+	}
+
+	auto &slot = _slots[_current];
+	bool pending = false;
+	do {
+		std::unique_lock lock(_mutex);
+		pending = slot.pending;
+	} while (0);
+
+	if (!pending && slot.filled > 0) {
+		schedule(slot);
+		_current = (_current + 1) % _slots.size();
+	}
+	waitAll();
+}
+
+bool AsyncFileWriter::close(bool sync) {
+	if (_fd < 0) {
+		return _error == 0;
+	}
+
+	if (_queue->isCompletionThread()) {
+		// writer waits for its requests, that should be completed by this thread
+		stappler::log::vtext("AsyncFileWriter", "close() can not be called on FileIOQueue completion thread");
+		return false;
+	}
+
+	flush();
+
+	if (sync && _error == 0) {
+		// wait only for own sync request, queue can be used by other writers
+		bool synced = false;
+
+		FileIOQueue::Request req;
+		req.op = FileIOQueue::Op::Sync;
+		req.fd = _fd;
+		req.immediate = true;
+		req.callback = [this, &synced] (int64_t result) {
+			std::unique_lock lock(_mutex);
+			if (result < 0 && _error == 0) {
+				_error = int(result);
+			}
+			synced = true;
+			_cond.notify_all();
+		};
+
+		if (_queue->submit(move(req))) {
+			std::unique_lock lock(_mutex);
+			_cond.wait(lock, [&] { return synced; });
+		} else {
+			_error = -EIO;
+		}
+	}
+
+	for (auto &it : _slots) {
+		if (it.buffer != FileIOQueue::InvalidBuffer) {
+			_queue->releaseBuffer(it.buffer);
+		} else if (it.data) {
+			::free(it.data);
+		}
+	}
+	_slots.clear();
+
+	::close(_fd);
+	_fd = -1;
+	return _error == 0;
+}
+
+void AsyncFileWriter::schedule(Slot &slot) {
+	slot.pending = true;
+
+	FileIOQueue::Request req;
+	req.op = FileIOQueue::Op::Write;
+	req.fd = _fd;
+	req.offset = _nextOffset;
+	req.data = slot.data;
+	req.size = slot.filled;
+	req.buffer = slot.buffer;
+	req.immediate = true;
+	req.callback = [this, s = &slot, size = slot.filled] (int64_t result) {
+		std::unique_lock lock(_mutex);
+		if (result < 0 || size_t(result) != size) {
+			if (_error == 0) {
+				_error = (result < 0) ? int(result) : -EIO;
+			}
+		}
+		s->filled = 0;
+		s->pending = false;
+		_cond.notify_all();
+	};
+
+	_nextOffset += slot.filled;
+
+	if (!_queue->submit(move(req))) {
+		_error = -EIO;
+		slot.filled = 0;
+		slot.pending = false;
+	}
+}
+
+void AsyncFileWriter::waitAll() {
+	std::unique_lock lock(_mutex);
+	_cond.wait(lock, [&] {
+		for (auto &it : _slots) {
+			if (it.pending) {
+				return false;
+			}
+		}
+		return true;
+	});
+}
+
+}
@@ -0,0 +1,241 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#ifndef MODULES_THREADS_SPFILEIOQUEUE_H_
+#define MODULES_THREADS_SPFILEIOQUEUE_H_
+
+#include "SPThreadTaskQueue.h"
+#include "SPEventTaskQueue.h"
+#include "SPIO.h"
+
+namespace stappler::thread {
+
+// Asynchronous positional file I/O
+// On Linux it uses io_uring with registered buffers, when io_uring is not available
+// (old kernel, seccomp filter) requests are performed with pread/pwrite on worker threads
+class FileIOQueue : public RefBase<memory::StandartInterface> {
+public:
+	using Ref = RefBase<memory::StandartInterface>;
+
+	enum class Backend {
+		Default, // io_uring if available, thread pool otherwise
+		IoUring,
+		ThreadPool,
+	};
+
+	enum class Op {
+		Read,
+		Write,
+		Sync,
+	};
+
+	// result is number of bytes transferred or negative errno value,
+	// short transfers are continued, so read result is less than requested size only at EOF
+	using Callback = std::function<void(int64_t)>;
+
+	static constexpr uint32_t InvalidBuffer = maxOf<uint32_t>();
+
+	struct Config {
+		Backend backend = Backend::Default;
+		uint32_t queueDepth = 128;
+		uint32_t bufferCount = 32;
+		size_t bufferSize = 128_KiB;
+		uint16_t threadCount = 4; // for thread pool backend
+	};
+
+	struct Request {
+		Op op = Op::Read;
+		int fd = -1;
+		uint64_t offset = 0;
+		uint8_t *data = nullptr;
+		size_t size = 0;
+
+		// index of queue buffer, that contains `data`, it allows to use registered buffers with io_uring
+		uint32_t buffer = InvalidBuffer;
+
+		// call callback directly from completion thread instead of target queue
+		bool immediate = false;
+
+		Callback callback;
+	};
+
+	struct Data;
+
+	FileIOQueue();
+	virtual ~FileIOQueue();
+
+	// completions are called on internal completion thread
+	bool init();
+	bool init(const Config &);
+
+	// completions are performed as tasks on queue
+	bool init(const Config &, TaskQueue *);
+	bool init(const Config &, EventTaskQueue *);
+
+	// waits for pending requests and stops completion threads
+	// when called from completion callback, io_uring reaper finishes remaining requests in background
+	void cancel();
+
+	bool submit(Request &&);
+
+	// all requests are submitted with a single syscall when possible
+	size_t submit(std::vector<Request> &&);
+
+	// wait until all submitted requests are completed and their callbacks are called or scheduled
+	void wait();
+
+	uint32_t acquireBuffer(bool wait = true);
+	void releaseBuffer(uint32_t);
+
+	uint8_t *getBuffer(uint32_t) const;
+	size_t getBufferSize() const;
+	uint32_t getBufferCount() const;
+
+	Backend getBackend() const;
+	size_t getInflightCount() const;
+
+	// io_uring reaper or thread pool worker, waiting for queue requests on it can deadlock
+	bool isCompletionThread() const;
+
+protected:
+	Data *_data = nullptr;
+};
+
+// Sequential file reader with read-ahead of `depth` buffers, can be used as io::Producer
+class AsyncFileReader {
+public:
+	AsyncFileReader(FileIOQueue *, StringView path, uint32_t depth = 4);
+	~AsyncFileReader();
+
+	AsyncFileReader(const AsyncFileReader &) = delete;
+	AsyncFileReader &operator=(const AsyncFileReader &) = delete;
+
+	size_t read(uint8_t *buf, size_t nbytes);
+	size_t seek(int64_t offset, io::Seek s);
+
+	size_t tell() const { return _position; }
+	size_t size() const { return _size; }
+
+	// negative errno of first failed request
+	int getError() const { return _error; }
+
+	bool is_open() const { return _fd >= 0; }
+	operator bool() const { return is_open(); }
+
+	void close();
+
+protected:
+	struct Slot;
+
+	bool prepare(Slot &, FileIOQueue::Request &);
+	void schedule(Slot &);
+	void reset(size_t offset);
+	void waitAll();
+
+	Rc<FileIOQueue> _queue;
+	int _fd = -1;
+	int _error = 0;
+	size_t _size = 0;
+	size_t _position = 0;
+	size_t _nextOffset = 0;
+	uint32_t _current = 0;
+	std::vector<Slot> _slots;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+};
+
+// Sequential file writer with write-behind of `depth` buffers, can be used as io::Consumer
+class AsyncFileWriter {
+public:
+	AsyncFileWriter(FileIOQueue *, StringView path, uint32_t depth = 4);
+	~AsyncFileWriter();
+
+	AsyncFileWriter(const AsyncFileWriter &) = delete;
+	AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+	size_t write(const uint8_t *buf, size_t nbytes);
+
+	// submit partially filled buffer and wait for all pending writes
+	void flush();
+
+	size_t tell() const { return _position; }
+
+	int getError() const { return _error; }
+
+	bool is_open() const { return _fd >= 0; }
+	operator bool() const { return is_open(); }
+
+	// returns false if any write was failed; with sync, waits only for own fsync request
+	// should not be called from queue completion thread, returns false without closing there
+	bool close(bool sync = false);
+
+protected:
+	struct Slot;
+
+	void schedule(Slot &);
+	void waitAll();
+
+	Rc<FileIOQueue> _queue;
+	int _fd = -1;
+	int _error = 0;
+	size_t _position = 0;
+	size_t _nextOffset = 0;
+	uint32_t _current = 0;
+	std::vector<Slot> _slots;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+};
+
+}
+
+namespace stappler::io {
+
+template <>
+struct ProducerTraits<thread::AsyncFileReader> {
+	using type = thread::AsyncFileReader;
+	static size_t ReadFn(void *ptr, uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->read(buf, nbytes);
+	}
+
+	static size_t SeekFn(void *ptr, int64_t offset, Seek s) {
+		return ((type *)ptr)->seek(offset, s);
+	}
+	static size_t TellFn(void *ptr) {
+		return ((type *)ptr)->tell();
+	}
+};
+
+template <>
+struct ConsumerTraits<thread::AsyncFileWriter> {
+	using type = thread::AsyncFileWriter;
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		return ((type *)ptr)->write(buf, nbytes);
+	}
+
+	static void FlushFn(void *ptr) {
+		((type *)ptr)->flush();
+	}
+};
+
+}
+
+#endif /* MODULES_THREADS_SPFILEIOQUEUE_H_ */
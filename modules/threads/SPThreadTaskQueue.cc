@@ -43,8 +43,13 @@ public:
 	Worker(TaskQueue::WorkerContext *queue, uint32_t threadId, uint32_t workerId, StringView name);
 	virtual ~Worker();
 
+#if SP_REF_DEBUG
 	uint64_t retain() override;
 	void release(uint64_t) override;
+#else
+	uint64_t retain();
+	void release(uint64_t);
+#endif
 
 	bool execute(Task *task);
 
@@ -573,6 +578,7 @@ Worker::Worker(TaskQueue::WorkerContext *queue, uint32_t threadId, uint32_t work
 		_local = new LocalQueue;
 	}
 	_thread = std::thread(Worker::workerThread, this, queue->queue);
+	_threadId = _thread.get_id();
 }
 
 Worker::~Worker() {
@@ -607,7 +613,6 @@ void Worker::threadInit() {
 	_pool = memory::pool::createTagged(_name.data(), _flags);
 
 	_shouldQuit.test_and_set();
-	_threadId = std::this_thread::get_id();
 
 	ThreadInfo::setThreadInfo(_managerId, _workerId, _name, true);
 }
@@ -102,6 +102,7 @@ void ThreadInterface<memory::PoolInterface>::workerThread(ThreadInterface<memory
 #include "SPThreadTask.cc"
 #include "SPThreadTaskQueue.cc"
 #include "SPEventTaskQueue.cc"
+#include "SPFileIOQueue.cc"
 
 namespace stappler::thread {
 
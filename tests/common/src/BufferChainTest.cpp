@@ -0,0 +1,203 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPIO.h"
+#include "SPBufferChain.h"
+#include "Test.h"
+
+namespace stappler::app::test {
+
+struct BufferChainTest : Test {
+	BufferChainTest() : Test("BufferChainTest") { }
+
+	static Bytes makeData(size_t size) {
+		Bytes ret; ret.resize(size);
+		for (size_t i = 0; i < size; ++ i) {
+			ret[i] = uint8_t((i * 31) ^ (i >> 8));
+		}
+		return ret;
+	}
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "chain test", count, passed, [&] {
+			BufferChunkPool pool(1_KiB, 4);
+			auto data = makeData(10_KiB + 123);
+
+			BufferChain chain(&pool);
+			for (size_t i = 0; i < data.size(); i += 100) {
+				chain.put(data.data() + i, std::min(size_t(100), data.size() - i));
+			}
+
+			if (chain.size() != data.size() || chain.chunks() != 11 || chain.bytes<Interface>() != data) {
+				return false;
+			}
+
+			BytesView segs[16];
+			auto nsegs = chain.segments(segs, 16);
+			size_t offset = 0;
+			for (size_t i = 0; i < nsegs; ++ i) {
+				if (memcmp(segs[i].data(), data.data() + offset, segs[i].size()) != 0) {
+					return false;
+				}
+				offset += segs[i].size();
+			}
+
+			// partial reads across chunk boundaries
+			Bytes out; out.resize(data.size());
+			size_t r = 0;
+			while (!chain.empty()) {
+				r += chain.read(out.data() + r, 777);
+			}
+
+			return nsegs == 11 && offset == data.size() && r == data.size() && out == data
+					&& chain.chunks() == 1 && chain.consumed() == data.size() && pool.getFreeChunks() == 4;
+		});
+
+		runTest(stream, "splice test", count, passed, [&] {
+			BufferChain a, b, c(nullptr);
+			a.put(StringView("Hello, "));
+			b.put(StringView("World"));
+			c.putc('!');
+
+			size_t size = 16;
+			auto buf = c.prepare(size);
+			memcpy(buf, "\n", 1);
+			c.save(buf, 1);
+
+			a.splice(move(b));
+			a.splice(move(c));
+			return a.str<Interface>() == "Hello, World!\n" && b.empty() && c.empty() && a.chunks() == 3
+					&& a.front() == BytesView((const uint8_t *)"Hello, ", 7);
+		});
+
+		runTest(stream, "io test", count, passed, [&] {
+			auto data = makeData(200_KiB);
+
+			// chain as producer and as consumer
+			BufferChain source;
+			source.put(data.data(), data.size());
+			BufferChain target;
+			auto r1 = io::read(io::Producer(source), io::Consumer(target));
+
+			// chain as io::Buffer
+			BufferChain source2;
+			source2.put(data.data(), data.size());
+			BufferChain buffer;
+			Bytes out;
+			auto r2 = io::read(io::Producer(source2), io::Buffer(buffer), [&] (const io::Buffer &buf) {
+				out.insert(out.end(), buf.data(), buf.data() + buf.size());
+			});
+
+			return r1 == data.size() && target.bytes<Interface>() == data && source.empty()
+					&& r2 == data.size() && out == data;
+		});
+
+		runTest(stream, "ring test", count, passed, [&] {
+			static constexpr size_t Total = 16_MiB;
+
+			BufferRing ring(4_KiB);
+			uint64_t producerSum = 0;
+			uint64_t consumerSum = 0;
+			size_t received = 0;
+			bool ordered = true;
+
+			std::thread producer([&] {
+				uint8_t buf[777];
+				size_t sent = 0;
+				while (sent < Total) {
+					auto n = std::min(sizeof(buf), Total - sent);
+					for (size_t i = 0; i < n; ++ i) {
+						buf[i] = uint8_t(sent + i);
+						producerSum += buf[i];
+					}
+					size_t written = 0;
+					while (written < n) {
+						written += ring.put(buf + written, n - written);
+						if (written < n) {
+							std::this_thread::yield();
+						}
+					}
+					sent += n;
+				}
+			});
+
+			while (received < Total) {
+				BytesView segs[2];
+				auto nsegs = ring.segments(segs);
+				if (nsegs == 0) {
+					std::this_thread::yield();
+					continue;
+				}
+				size_t n = 0;
+				for (size_t i = 0; i < nsegs; ++ i) {
+					for (size_t j = 0; j < segs[i].size(); ++ j) {
+						auto v = segs[i].data()[j];
+						ordered = ordered && (v == uint8_t(received + n));
+						consumerSum += v;
+						++ n;
+					}
+				}
+				ring.consume(n);
+				received += n;
+			}
+
+			producer.join();
+			return ordered && received == Total && producerSum == consumerSum && ring.empty() && ring.capacity() == 4_KiB;
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Total = 64_MiB;
+			auto data = makeData(1500);
+
+			auto t = Time::now();
+			BufferTemplate<memory::StandartInterface> buffer;
+			for (size_t i = 0; i < Total; i += data.size()) {
+				buffer.put(data.data(), data.size());
+			}
+			auto bufferTime = Time::now() - t;
+
+			t = Time::now();
+			BufferChain chain;
+			for (size_t i = 0; i < Total; i += data.size()) {
+				chain.put(data.data(), data.size());
+			}
+			auto chainTime = Time::now() - t;
+
+			stream << "\t\tBufferTemplate: " << bufferTime.toMicros() << " mks; BufferChain: " << chainTime.toMicros()
+					<< " mks (" << chain.chunks() << " chunks)\n\t";
+			return buffer.size() == chain.size();
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _BufferChainTest;
+
+}
@@ -65,7 +65,8 @@ struct PoolCborTest : MemPoolTest {
 		});
 
 		runTest(stream, "PoolCborTest", count, passed, [&] {
-			auto data = filesystem::readIntoMemory<memory::PoolInterface>(filesystem::currentDir<memory::PoolInterface>("app.cbor"));
+			// source data should not be allocated from pool, that will be cleared
+			auto data = filesystem::readIntoMemory<Interface>(filesystem::currentDir<Interface>("app.cbor"));
 
 			uint64_t v = 0;
 			for (size_t i = 0; i < ntests; ++i) {
@@ -100,6 +101,59 @@ struct PoolCborTest : MemPoolTest {
 			return ret;
 		});
 
+		runTest(stream, "MappedFileTest", count, passed, [&] {
+			auto tmp = filesystem::File::open_tmp("sp.mapped", false);
+			auto path = StringView(tmp.path()).str<Interface>();
+			tmp.close();
+
+			// ~10 MiB snapshot
+			auto source = data::readFile<Interface>(filesystem::currentDir<Interface>("app.cbor"));
+			Value snapshot;
+			for (size_t i = 0; i < 2000; ++ i) {
+				snapshot.addValue(source);
+			}
+			data::save(snapshot, path, data::EncodeFormat::Cbor);
+
+			static constexpr size_t Passes = 4;
+			uint64_t copyTime = 0;
+			uint64_t mappedTime = 0;
+			bool success = true;
+			for (size_t i = 0; i < Passes; ++ i) {
+				auto t = Time::now();
+				auto d1 = data::read<Interface>(filesystem::readIntoMemory<Interface>(path));
+				copyTime += (Time::now() - t).toMicros();
+
+				t = Time::now();
+				auto d2 = data::readFile<Interface>(path);
+				mappedTime += (Time::now() - t).toMicros();
+
+				if (d1 != d2 || d2.size() != 2000) {
+					success = false;
+				}
+			}
+
+			stream << "readIntoMemory: " << copyTime / Passes << " us; mapped: " << mappedTime / Passes << " us; ";
+
+			// unaligned region
+			auto region = filesystem::MappedFile::open(path, filesystem::MappedFile::Flags::Random, 4097, 16);
+			auto buf = filesystem::readIntoMemory<Interface>(path, 4097, 16);
+			if (!region || region.size() != 16 || memcmp(region.data(), buf.data(), 16) != 0) {
+				success = false;
+			}
+			region.close();
+
+			// writable mapping
+			if (auto file = filesystem::MappedFile::open(path, filesystem::MappedFile::Flags::Write)) {
+				file.data()[0] = 'X';
+				file.sync();
+			}
+			auto head = filesystem::readIntoMemory<Interface>(path, 0, 1);
+			filesystem::remove(path);
+
+			return success && head.size() == 1 && head[0] == 'X'
+					&& !filesystem::MappedFile::open(path);
+		});
+
 		_desc = stream.str();
 
 		return count == passed;
@@ -30,6 +30,10 @@
 
 #include "SPCrypto.h"
 
+#if MODULE_COMMON_DATA
+#include "SPData.h"
+#endif
+
 namespace stappler::app::test {
 
 static constexpr StringView s_PKCS1PemKey(
@@ -511,6 +515,422 @@ struct CryptoTest : Test {
 			return success;
 		});
 
+		runTest(stream, "thread cache", count, passed, [&] () -> bool {
+			auto message = StringView("thread cache message");
+			Bytes firstSignature;
+
+			// key objects are often allocated at the same address, cached contexts should not be reused for new key
+			for (size_t i = 0; i < 2; ++ i) {
+				auto pk = std::make_unique<crypto::PrivateKey>();
+				if (!pk->generate(crypto::KeyType::EDDSA_ED25519)) {
+					return false;
+				}
+
+				Bytes signature;
+				pk->sign([&] (const uint8_t *d, size_t s) {
+					signature = BytesView(d, s).bytes<Interface>();
+				}, message, crypto::SignAlgorithm::EDDSA_ED25519);
+
+				crypto::PublicKey pub(*pk);
+				if (signature.empty() || !pub.verify(message, signature, crypto::SignAlgorithm::EDDSA_ED25519)
+						|| signature == firstSignature) {
+					stream << " signature " << i << " is invalid;";
+					return false;
+				}
+				firstSignature = signature;
+			}
+
+			// keys and contexts are recreated after explicit release
+			crypto::PrivateKey pk(BytesView((const uint8_t *)s_PKCS8PemKey.data(), s_PKCS8PemKey.size()));
+			auto key1 = crypto::makeAesKey(BytesView((const uint8_t *)s_PKCS8PemKey.data(), s_PKCS8PemKey.size()), message, 2);
+			crypto::clearThreadCache();
+			auto key2 = crypto::makeAesKey(BytesView((const uint8_t *)s_PKCS8PemKey.data(), s_PKCS8PemKey.size()), message, 2);
+			auto key3 = crypto::makeAesKey(pk, message, 2);
+
+			return key1.version == 2 && key1.data == key2.data && key2.data == key3.data;
+		});
+
+		runTest(stream, "aes", count, passed, [&] () -> bool {
+			crypto::AesKey key;
+			for (size_t i = 0; i < key.data.size(); ++ i) {
+				key.data[i] = uint8_t(i);
+			}
+			key.version = 2;
+
+			auto makeData = [] (size_t size) {
+				Bytes ret; ret.resize(size);
+				for (size_t i = 0; i < size; ++ i) {
+					ret[i] = uint8_t(i * 31 + (i >> 8));
+				}
+				return ret;
+			};
+
+			auto encrypt = [&] (BytesView data) {
+				Bytes ret;
+				crypto::encryptAes(key, data, [&] (const uint8_t *d, size_t s) {
+					ret = BytesView(d, s).bytes<Interface>();
+				});
+				return ret;
+			};
+
+			auto decrypt = [&] (BytesView data, Bytes &ret) {
+				return crypto::decryptAes(key, data, [&] (const uint8_t *d, size_t s) {
+					ret = BytesView(d, s).bytes<Interface>();
+				});
+			};
+
+			for (auto size : { size_t(0), size_t(1), size_t(16), size_t(38), crypto::AesSegmentSize,
+					crypto::AesSegmentSize + 1, size_t(1_MiB + 7) }) {
+				auto source = makeData(size);
+				auto enc = encrypt(source);
+				Bytes dec;
+				if (enc.size() != crypto::getAesEncryptedSize(size) || crypto::getAesVersion(enc) != 2
+						|| !decrypt(enc, dec) || dec != source) {
+					stream << " roundtrip failed for " << size << ";";
+					return false;
+				}
+			}
+
+			// every block uses own salt
+			auto source = makeData(crypto::AesSegmentSize * 3 + 100);
+			auto enc = encrypt(source);
+			if (encrypt(source) == enc) {
+				stream << " salt is not random;";
+				return false;
+			}
+
+			Bytes dec;
+			auto segment = crypto::AesSegmentSize + 16;
+
+			// modified segment
+			auto tampered = enc;
+			tampered[40 + segment + 10] ^= 1;
+			if (decrypt(tampered, dec)) {
+				stream << " tampered data accepted;";
+				return false;
+			}
+
+			// reordered segments
+			auto reordered = enc;
+			memcpy(reordered.data() + 40, enc.data() + 40 + segment, segment);
+			memcpy(reordered.data() + 40 + segment, enc.data() + 40, segment);
+			if (decrypt(reordered, dec)) {
+				stream << " reordered data accepted;";
+				return false;
+			}
+
+			// truncated to complete segments, with fixed size in header
+			auto truncated = enc;
+			truncated.resize(40 + segment * 2);
+			uint64_t truncatedSize = crypto::AesSegmentSize * 2;
+			memcpy(truncated.data(), &truncatedSize, sizeof(uint64_t));
+			if (decrypt(truncated, dec)) {
+				stream << " truncated data accepted;";
+				return false;
+			}
+
+			// wrong key
+			auto otherKey = key;
+			otherKey.data[0] ^= 1;
+			if (crypto::decryptAes(otherKey, enc, [&] (const uint8_t *, size_t) { })) {
+				stream << " wrong key accepted;";
+				return false;
+			}
+
+			// forged data size should be rejected before output allocation
+			for (auto forgedSize : { maxOf<uint64_t>(), maxOf<uint64_t>() - 15, uint64_t(1) << 62 }) {
+				auto forged = enc;
+				memcpy(forged.data(), &forgedSize, sizeof(uint64_t));
+
+				CoderSource forgedSource(forged);
+				StringStream forgedOut;
+				if (decrypt(forged, dec) || crypto::decryptAes(key, io::Producer(forgedSource), io::Consumer(forgedOut))) {
+					stream << " forged size accepted;";
+					return false;
+				}
+			}
+
+			if (crypto::getAesEncryptedSize(maxOf<size_t>()) != 0 || crypto::getAesEncryptedSize(100, 0) != 0) {
+				stream << " size overflow is not detected;";
+				return false;
+			}
+
+			return true;
+		});
+
+		runTest(stream, "aes legacy", count, passed, [&] () -> bool {
+			// AES-256-CBC block from previous format: size, keygen version, 4 unused bytes, truncated ciphertext
+			auto legacy = base16::decode<Interface>(StringView(
+					"260000000000000002000000deadbeefc6060b9823cb89f813dbeea6532d2308577be7202889663494b556f0925fb481932c933316e9b8dc6b0c83d5ae1a8287"));
+
+			crypto::AesKey key;
+			for (size_t i = 0; i < key.data.size(); ++ i) {
+				key.data[i] = uint8_t(i);
+			}
+			key.version = 2;
+
+			String dec;
+			auto success = crypto::decryptAes(key, legacy, [&] (const uint8_t *d, size_t s) {
+				dec = String((const char *)d, s);
+			});
+
+			CoderSource source(legacy);
+			StringStream out;
+			auto streamSuccess = crypto::decryptAes(key, io::Producer(source), io::Consumer(out));
+
+			// forged size in legacy header
+			auto forged = legacy;
+			auto forgedSize = uint64_t(1) << 62;
+			memcpy(forged.data(), &forgedSize, sizeof(uint64_t));
+			CoderSource forgedSource(forged);
+			StringStream forgedOut;
+			auto forgedSuccess = crypto::decryptAes(key, forged, [&] (const uint8_t *, size_t) { })
+					|| crypto::decryptAes(key, io::Producer(forgedSource), io::Consumer(forgedOut));
+
+			return success && streamSuccess && !forgedSuccess && crypto::getAesVersion(legacy) == 2
+					&& dec == "Legacy AES-256-CBC block from stappler" && out.str() == dec;
+		});
+
+		runTest(stream, "aes stream", count, passed, [&] () -> bool {
+			crypto::AesKey key;
+			for (size_t i = 0; i < key.data.size(); ++ i) {
+				key.data[i] = uint8_t(255 - i);
+			}
+			key.version = 1;
+
+			String data; data.resize(1_MiB + 123);
+			for (size_t i = 0; i < data.size(); ++ i) {
+				data[i] = char('a' + i % 26);
+			}
+
+			// segment size is stored in header
+			CoderSource source(data);
+			StringStream enc;
+			if (!crypto::encryptAes(key, io::Producer(source), data.size(), io::Consumer(enc), 16_KiB)) {
+				return false;
+			}
+
+			auto encrypted = enc.str();
+			String dec;
+			crypto::decryptAes(key, BytesView((const uint8_t *)encrypted.data(), encrypted.size()), [&] (const uint8_t *d, size_t s) {
+				dec = String((const char *)d, s);
+			}, 4);
+
+			CoderSource encSource(encrypted);
+			StringStream out;
+			auto success = crypto::decryptAes(key, io::Producer(encSource), io::Consumer(out));
+
+			// truncated stream
+			CoderSource truncSource(BytesView((const uint8_t *)encrypted.data(), encrypted.size() - 100));
+			StringStream truncOut;
+			auto truncSuccess = crypto::decryptAes(key, io::Producer(truncSource), io::Consumer(truncOut));
+
+			return encrypted.size() == crypto::getAesEncryptedSize(data.size(), 16_KiB) && dec == data
+					&& success && out.str() == data && !truncSuccess;
+		});
+
+		runTest(stream, "aes parallel", count, passed, [&] () -> bool {
+			static constexpr size_t Size = 32_MiB;
+			static constexpr uint32_t Threads = 4;
+
+			auto key = crypto::makeAesKey(BytesView((const uint8_t *)"secret", 6), BytesView((const uint8_t *)"hash", 4), 0);
+
+			Bytes data; data.resize(Size);
+			for (size_t i = 0; i < Size; ++ i) {
+				data[i] = uint8_t(i ^ (i >> 11));
+			}
+
+			auto run = [&] (uint32_t threads, Bytes &enc, Bytes &dec) {
+				auto t = Time::now();
+				crypto::encryptAes(key, data, [&] (const uint8_t *d, size_t s) {
+					enc = BytesView(d, s).bytes<Interface>();
+				}, threads);
+				auto encTime = Time::now() - t;
+				t = Time::now();
+				crypto::decryptAes(key, enc, [&] (const uint8_t *d, size_t s) {
+					dec = BytesView(d, s).bytes<Interface>();
+				}, threads);
+				return pair(encTime, Time::now() - t);
+			};
+
+			Bytes enc1, dec1, encN, decN;
+			auto single = run(1, enc1, dec1);
+			auto parallel = run(Threads, encN, decN);
+
+			auto speed = [] (TimeInterval t) {
+				return Size / std::max(t.toMicros(), uint64_t(1));
+			};
+
+			stream << "\t\t" << Size / 1_MiB << " MiB: encrypt " << speed(single.first) << " MB/s, " << Threads
+					<< " threads: " << speed(parallel.first) << " MB/s; decrypt " << speed(single.second) << " MB/s, "
+					<< Threads << " threads: " << speed(parallel.second) << " MB/s\n\t";
+
+			return dec1 == data && decN == data && enc1.size() == encN.size();
+		});
+
+		runTest(stream, "small payloads", count, passed, [&] () -> bool {
+			static constexpr size_t Iterations = 1000;
+
+			crypto::PrivateKey rsaKey;
+			crypto::PrivateKey edKey;
+			rsaKey.generate(crypto::KeyBits::_2048);
+			edKey.generate(crypto::KeyType::EDDSA_ED25519);
+
+			auto rsaPub = rsaKey.exportPublic();
+			auto edPub = edKey.exportPublic();
+
+			Bytes payload; payload.resize(256);
+			for (size_t i = 0; i < payload.size(); ++ i) {
+				payload[i] = uint8_t(i * 7);
+			}
+
+			auto secret = StringView("not-a-private-key-secret");
+			auto aesKey = crypto::makeAesKey(BytesView((const uint8_t *)secret.data(), secret.size()), BytesView(payload), 0);
+
+			auto bench = [&] (StringView name, size_t n, const Callback<bool()> &cb) {
+				bool success = true;
+				auto t = Time::now();
+				for (size_t i = 0; i < n; ++ i) {
+					success = cb() && success;
+				}
+				stream << "\t\t" << name << ": " << (Time::now() - t).toMicros() * 1000 / n << " ns/op\n";
+				return success;
+			};
+
+			Bytes rsaSig, edSig, enc;
+			rsaKey.sign([&] (const uint8_t *d, size_t s) { rsaSig = BytesView(d, s).bytes<Interface>(); }, payload, crypto::SignAlgorithm::RSA_SHA256);
+			edKey.sign([&] (const uint8_t *d, size_t s) { edSig = BytesView(d, s).bytes<Interface>(); }, payload, crypto::SignAlgorithm::EDDSA_ED25519);
+			crypto::encryptAes(aesKey, payload, [&] (const uint8_t *d, size_t s) { enc = BytesView(d, s).bytes<Interface>(); });
+
+			bool success = true;
+			success = bench("sign RSA-2048", Iterations / 10, [&] {
+				return rsaKey.sign([] (const uint8_t *, size_t) { }, payload, crypto::SignAlgorithm::RSA_SHA256);
+			}) && success;
+			success = bench("verify RSA-2048", Iterations, [&] {
+				return rsaPub.verify(payload, rsaSig, crypto::SignAlgorithm::RSA_SHA256);
+			}) && success;
+			success = bench("sign Ed25519", Iterations, [&] {
+				return edKey.sign([] (const uint8_t *, size_t) { }, payload, crypto::SignAlgorithm::EDDSA_ED25519);
+			}) && success;
+			success = bench("verify Ed25519", Iterations, [&] {
+				return edPub.verify(payload, edSig, crypto::SignAlgorithm::EDDSA_ED25519);
+			}) && success;
+			success = bench("encryptAes", Iterations, [&] {
+				return crypto::encryptAes(aesKey, payload, [] (const uint8_t *, size_t) { });
+			}) && success;
+			success = bench("decryptAes", Iterations, [&] {
+				return crypto::decryptAes(aesKey, enc, [] (const uint8_t *, size_t) { });
+			}) && success;
+			success = bench("makeAesKey from secret", Iterations, [&] {
+				return crypto::makeAesKey(BytesView((const uint8_t *)secret.data(), secret.size()), BytesView(payload), 2).data == aesKey.data;
+			}) && success;
+			stream << "\t";
+
+			// keys are shared between threads
+			std::atomic<size_t> valid = 0;
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t < 4; ++ t) {
+				threads.emplace_back([&] {
+					for (size_t i = 0; i < 50; ++ i) {
+						Bytes sig;
+						edKey.sign([&] (const uint8_t *d, size_t s) { sig = BytesView(d, s).bytes<Interface>(); }, payload, crypto::SignAlgorithm::EDDSA_ED25519);
+						Bytes out;
+						crypto::decryptAes(aesKey, enc, [&] (const uint8_t *d, size_t s) { out = BytesView(d, s).bytes<Interface>(); });
+						if (edPub.verify(payload, sig, crypto::SignAlgorithm::EDDSA_ED25519)
+								&& rsaPub.verify(payload, rsaSig, crypto::SignAlgorithm::RSA_SHA256)
+								&& !rsaPub.verify(payload, edSig, crypto::SignAlgorithm::RSA_SHA256) && out == payload) {
+							++ valid;
+						}
+					}
+				});
+			}
+			for (auto &it : threads) {
+				it.join();
+			}
+
+			return success && valid == 200;
+		});
+
+#if MODULE_COMMON_DATA
+		runTest(stream, "data encrypted", count, passed, [&] () -> bool {
+			StringView secret("encryption-secret");
+			StringView wrongSecret("encryption-secrex");
+
+			Value val;
+			for (size_t i = 0; i < 10000; ++ i) {
+				auto &it = val.emplace();
+				it.setInteger(i, "id");
+				it.setString(toString("name-", i), "name");
+				it.setDouble(i * 0.25, "value");
+				it.setBool(i % 2 == 0, "flag");
+			}
+
+			bool success = true;
+			// JSON and Serenity do not preserve value types exactly, so compare with unencrypted round-trip
+			for (auto fmt : { data::EncodeFormat::Cbor, data::EncodeFormat::Json, data::EncodeFormat::Serenity }) {
+				for (auto cmp : { data::EncodeFormat::NoCompression, data::EncodeFormat::LZ4Compression }) {
+					auto enc = data::write(val, data::EncodeFormat(fmt, cmp, data::EncodeFormat::Encrypted, secret));
+					if (enc.empty() || data::detectDataFormat(enc.data(), enc.size()) != data::DataFormat::Encrypted) {
+						success = false;
+						continue;
+					}
+
+					auto expected = data::read<Interface>(data::write(val, data::EncodeFormat(fmt)));
+
+					size_t requested = 0;
+					auto dec = data::read<Interface>(enc, [&] () -> StringView {
+						++ requested;
+						return secret;
+					});
+					if (!dec || dec != expected || requested != 1 || data::read<Interface>(enc, secret) != expected
+							|| data::read<Interface>(enc, wrongSecret) || data::read<Interface>(enc)) {
+						success = false;
+					}
+
+					// tampered and truncated data should be rejected
+					auto tampered = enc;
+					tampered[tampered.size() / 2] ^= 0x01;
+					auto truncated = BytesView(enc).sub(0, enc.size() - 1).bytes<Interface>();
+					if (data::read<Interface>(tampered, secret) || data::read<Interface>(truncated, secret)) {
+						success = false;
+					}
+				}
+			}
+
+			// provider is not called for unencrypted data
+			size_t requested = 0;
+			auto plain = data::write(val, data::EncodeFormat::Cbor);
+			auto plainVal = data::read<Interface>(plain, [&] () -> StringView {
+				++ requested;
+				return secret;
+			});
+
+			auto key = crypto::makeAesKey(BytesView((const uint8_t *)secret.data(), secret.size()), BytesView((const uint8_t *)"hash", 4), 0);
+
+			auto t = Time::now();
+			Bytes separate;
+			auto compressed = data::write(val, data::EncodeFormat(data::EncodeFormat::Cbor, data::EncodeFormat::LZ4Compression));
+			crypto::encryptAes(key, compressed, [&] (const uint8_t *d, size_t s) {
+				separate = BytesView(d, s).bytes<Interface>();
+			});
+			auto separateTime = Time::now() - t;
+
+			t = Time::now();
+			auto fused = data::write(val, data::EncodeFormat(data::EncodeFormat::Cbor, data::EncodeFormat::LZ4Compression,
+					data::EncodeFormat::Encrypted, secret));
+			auto fusedTime = Time::now() - t;
+
+			t = Time::now();
+			auto fusedVal = data::read<Interface>(fused, secret);
+			auto readTime = Time::now() - t;
+
+			stream << "\t\tencode, compress, encrypt: " << separateTime.toMicros() << " mcs (" << separate.size() << " bytes); fused: "
+					<< fusedTime.toMicros() << " mcs (" << fused.size() << " bytes); fused read: " << readTime.toMicros() << " mcs\n\t";
+
+			return success && plainVal == val && requested == 0 && fusedVal == val;
+		});
+#endif
+
 		_desc = stream.str();
 
 		return count == passed;
@@ -0,0 +1,237 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+
+#ifdef MODULE_COMMON_DATA
+
+#include "SPTime.h"
+#include "SPString.h"
+#include "SPData.h"
+#include "Test.h"
+
+namespace stappler::app::test {
+
+static constexpr auto DataStreamTestString(
+R"JsonString({
+	"string": "escaped \"quote\" \\ \/ \t\n жук",
+	"numbers": [0, -1, 1234567890123, 1.5, -2.5e-3, 1E+2],
+	"literals": [true, false, null],
+	"empty": { "array": [], "dict": {} },
+	"nested": [[1, [2, [3, {"key": "value"}]]], {"a": {"b": {"c": []}}}]
+})JsonString");
+
+template <typename Interface, typename Buffer>
+static auto DataStreamTest_read(BytesView data, size_t chunk, string::Interner *interner = nullptr) -> data::ValueTemplate<Interface> {
+	Buffer buf(interner);
+	while (!data.empty()) {
+		auto size = std::min(chunk, data.size());
+		if (!buf.read(data.data(), size)) {
+			return data::ValueTemplate<Interface>();
+		}
+		data += size;
+	}
+	if (!buf.finalize()) {
+		return data::ValueTemplate<Interface>();
+	}
+	return buf.extract();
+}
+
+static Value DataStreamTest_makeValue(size_t count) {
+	Value ret;
+	auto &arr = ret.emplace("items");
+	for (size_t i = 0; i < count; ++ i) {
+		auto &it = arr.emplace();
+		it.setInteger(i, "id");
+		it.setDouble(i / 3.0, "weight");
+		it.setString(toString("name-", i, " \"quoted\"\n"), "name");
+		it.setBool(i % 2 == 0, "flag");
+		it.setBytes(Bytes{uint8_t(i), uint8_t(i >> 8), 0xff}, "bytes");
+		auto &tags = it.emplace("tags");
+		for (size_t j = 0; j < i % 5; ++ j) {
+			tags.addString(toString("tag", j));
+		}
+		it.setValue(Value(), "null");
+	}
+	ret.setString("total", "name");
+	ret.setInteger(-maxOf<int32_t>(), "negative");
+	return ret;
+}
+
+struct DataStreamTest : MemPoolTest {
+	DataStreamTest() : MemPoolTest("DataStreamTest") { }
+
+	virtual bool run(pool_t *pool) {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "json chunks", count, passed, [&] {
+			StringView source(DataStreamTestString);
+			auto expected = data::read<Interface>(source);
+			for (size_t chunk : { 1, 2, 3, 7, 64, 4096 }) {
+				auto val = DataStreamTest_read<Interface, data::JsonBuffer<Interface>>(BytesView((const uint8_t *)source.data(), source.size()), chunk);
+				if (val != expected) {
+					stream << "chunk " << chunk << ": " << val << "\n";
+					return false;
+				}
+			}
+			return expected.getString("string") == "escaped \"quote\" \\ / \t\n жук"
+					&& expected.getValue("numbers").size() == 6 && expected.getValue("literals").size() == 3;
+		});
+
+		runTest(stream, "json top-level", count, passed, [&] {
+			auto read = [] (StringView str) {
+				return DataStreamTest_read<Interface, data::JsonBuffer<Interface>>(BytesView((const uint8_t *)str.data(), str.size()), 1);
+			};
+			return read("12345").getInteger() == 12345 && read(" -1.5 ").getDouble() == -1.5 && read("true").getBool()
+					&& read("\"str\"").getString() == "str" && read("null").isNull() && std::isnan(read("nan").getDouble()) && read("[1,2] trailing").size() == 2;
+		});
+
+		runTest(stream, "json malformed", count, passed, [&] {
+			auto fails = [] (StringView str) {
+				data::JsonBuffer<Interface> buf;
+				return !buf.read(str) || !buf.finalize();
+			};
+			return fails("<html></html>") && fails("{\"key\": tru}") && fails("{\"key\": [1, 2, 3}")
+					&& fails("{\"key\" 1 2") && fails("\"unterminated");
+		});
+
+		runTest(stream, "cbor chunks", count, passed, [&] {
+			auto source = DataStreamTest_makeValue(100);
+			auto data = data::write<Interface>(source, data::EncodeFormat::Cbor);
+			for (size_t chunk : { 1, 2, 3, 7, 64, 4096 }) {
+				auto val = DataStreamTest_read<Interface, data::CborBuffer<Interface>>(data, chunk);
+				if (val != source) {
+					stream << "chunk " << chunk << ": " << val << "\n";
+					return false;
+				}
+			}
+
+			// undefined length containers and strings, integer keys
+			Bytes undefined{
+				0xbf, // map
+					0x63, 'a', 'r', 'r',
+					0x9f, 0x01, 0x7f, 0x62, 'a', 'b', 0x61, 'c', 0xff, 0x5f, 0x41, 0x01, 0xff, 0xff, // [1, "abc", b"\x01"]
+					0x18, 0x2a, 0xf9, 0x3c, 0x00, // 42: 1.0 (float16)
+					0x20, 0xf5, // -1: true
+				0xff
+			};
+			auto val = DataStreamTest_read<Interface, data::CborBuffer<Interface>>(undefined, 1);
+			return val.getValue("arr").getInteger(0) == 1 && val.getValue("arr").getString(1) == "abc"
+					&& val.getValue("arr").getBytes(2) == Bytes{0x01} && val.getDouble("42") == 1.0 && val.getBool("-1");
+		});
+
+		runTest(stream, "cbor malformed", count, passed, [&] {
+			auto fails = [] (BytesView data) {
+				data::CborBuffer<Interface> buf;
+				return !buf.read(data) || !buf.finalize();
+			};
+			return fails(Bytes{0xa1, 0x81, 0x01, 0x01}) // array as a key
+					&& fails(Bytes{0x82, 0x01}) // incomplete array
+					&& fails(Bytes{0x1c}) // reserved additional info
+					&& fails(Bytes{0x7f, 0x41, 0x01, 0xff}); // bytes chunk within char string
+		});
+
+		runTest(stream, "stream buffer", count, passed, [&] {
+			memory::pool::push(pool);
+			string::PoolInterner interner(pool);
+
+			auto source = DataStreamTest_makeValue(100);
+			auto json = data::write<Interface>(source, data::EncodeFormat::Json);
+			auto cbor = data::write<Interface>(source, data::EncodeFormat::Cbor);
+
+			auto read = [&] (BytesView data, data::DataFormat fmt, data::DataFormat &detected) {
+				data::StreamBuffer<memory::PoolInterface> buf(fmt, &interner);
+				while (!data.empty()) {
+					auto size = std::min(size_t(1000), data.size());
+					buf.read(data.data(), size);
+					data += size;
+				}
+				detected = buf.getFormat();
+				buf.finalize();
+				return buf.extract();
+			};
+
+			data::DataFormat jsonFormat, cborFormat, failedFormat;
+			auto jsonValue = read(BytesView((const uint8_t *)json.data(), json.size()), data::DataFormat::Unknown, jsonFormat);
+			auto cborValue = read(cbor, data::DataFormat::Unknown, cborFormat);
+			auto failedValue = read(cbor, data::DataFormat::Json, failedFormat);
+
+			auto expected = data::read<memory::PoolInterface>(json);
+			auto ret = jsonFormat == data::DataFormat::Json && cborFormat == data::DataFormat::Cbor
+					&& jsonValue == expected && Value(cborValue) == source && failedValue.isNull()
+					&& interner.size() > 0;
+
+			memory::pool::pop();
+			return ret;
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			auto source = DataStreamTest_makeValue(20000);
+			auto json = data::write<Interface>(source, data::EncodeFormat::Json);
+			auto cbor = data::write<Interface>(source, data::EncodeFormat::Cbor);
+			BytesView jsonData((const uint8_t *)json.data(), json.size());
+
+			// full buffering: data accumulated, then decoded
+			auto t = Time::now();
+			Bytes buffer;
+			for (auto data = jsonData; !data.empty(); data += std::min(size_t(16_KiB), data.size())) {
+				auto chunk = data.sub(0, 16_KiB);
+				buffer.insert(buffer.end(), chunk.data(), chunk.data() + chunk.size());
+			}
+			auto v1 = data::read<Interface>(buffer);
+			auto jsonFull = Time::now() - t;
+
+			t = Time::now();
+			auto v2 = DataStreamTest_read<Interface, data::JsonBuffer<Interface>>(jsonData, 16_KiB);
+			auto jsonStream = Time::now() - t;
+
+			t = Time::now();
+			buffer.clear();
+			for (BytesView data = cbor; !data.empty(); data += std::min(size_t(16_KiB), data.size())) {
+				auto chunk = data.sub(0, 16_KiB);
+				buffer.insert(buffer.end(), chunk.data(), chunk.data() + chunk.size());
+			}
+			auto v3 = data::read<Interface>(buffer);
+			auto cborFull = Time::now() - t;
+
+			t = Time::now();
+			auto v4 = DataStreamTest_read<Interface, data::CborBuffer<Interface>>(cbor, 16_KiB);
+			auto cborStream = Time::now() - t;
+
+			stream << "\t\tjson " << json.size() << " bytes: full: " << jsonFull.toMicros() << " mks, stream: " << jsonStream.toMicros() << " mks\n"
+					<< "\t\tcbor " << cbor.size() << " bytes: full: " << cborFull.toMicros() << " mks, stream: " << cborStream.toMicros() << " mks\n\t";
+
+			return v1 == v2 && v3 == v4 && v4 == source;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _DataStreamTest;
+
+}
+
+#endif
@@ -0,0 +1,326 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPSha.h"
+#include "SPFilesystem.h"
+#include "SPFileIOQueue.h"
+#include "Test.h"
+
+#include <fcntl.h>
+
+namespace stappler::app::test {
+
+struct FileIOQueueTest : Test {
+	FileIOQueueTest() : Test("FileIOQueueTest") { }
+
+	static String getTmpPath(const char *prefix) {
+		auto tmp = filesystem::File::open_tmp(prefix, false);
+		auto path = StringView(tmp.path()).str<Interface>();
+		tmp.close();
+		return path;
+	}
+
+	static Bytes makeData(size_t size) {
+		Bytes data; data.resize(size);
+		uint64_t seed = 0x9E3779B97F4A7C15ULL;
+		for (size_t i = 0; i < size; ++ i) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			data[i] = uint8_t(seed >> 56);
+		}
+		return data;
+	}
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		// size is not multiple of buffer size to test partial tail
+		auto data = makeData(8_MiB + 12345);
+		auto dataHash = string::Sha256().update(data).final();
+
+		auto src = getTmpPath("sp.fileio.src");
+		auto dst = getTmpPath("sp.fileio.dst");
+
+		for (auto backend : { thread::FileIOQueue::Backend::IoUring, thread::FileIOQueue::Backend::ThreadPool }) {
+			auto queue = Rc<thread::FileIOQueue>::alloc();
+			thread::FileIOQueue::Config cfg;
+			cfg.backend = backend;
+			cfg.bufferSize = 64_KiB;
+			if (!queue->init(cfg)) {
+				// io_uring can be disabled in kernel or with seccomp
+				stream << "\t" << (backend == thread::FileIOQueue::Backend::IoUring ? "io_uring" : "thread pool") << ": not available\n";
+				continue;
+			}
+
+			auto name = (queue->getBackend() == thread::FileIOQueue::Backend::IoUring) ? StringView("io_uring") : StringView("pool");
+
+			runTest(stream, toString(name, " write/read"), count, passed, [&] {
+				thread::AsyncFileWriter writer(queue, src, 8);
+				// uneven writes to cross buffer boundaries
+				size_t offset = 0;
+				size_t step = 1000;
+				while (offset < data.size()) {
+					auto size = std::min(step, data.size() - offset);
+					writer.write(data.data() + offset, size);
+					offset += size;
+					step = (step * 3) % 100000 + 1;
+				}
+				filesystem::Stat stat;
+				if (!writer.close() || !filesystem::stat(src, stat) || stat.size != data.size()) {
+					return false;
+				}
+
+				thread::AsyncFileReader reader(queue, src, 8);
+				string::Sha256 sha;
+				io::read(io::Producer(reader), [&] (const io::Buffer &buf) {
+					sha.update((const uint8_t *)buf.data(), buf.size());
+				});
+				return reader.tell() == data.size() && sha.final() == dataHash && reader.getError() == 0;
+			});
+
+			runTest(stream, toString(name, " seek"), count, passed, [&] {
+				thread::AsyncFileReader reader(queue, src, 4);
+				uint8_t buf[256];
+				for (auto pos : { size_t(5_MiB + 17), size_t(64_KiB - 100), size_t(0), data.size() - 100 }) {
+					if (reader.seek(pos, io::Seek::Set) != pos) {
+						return false;
+					}
+					auto ret = reader.read(buf, 256);
+					auto expected = std::min(size_t(256), data.size() - pos);
+					if (ret != expected || memcmp(buf, data.data() + pos, ret) != 0) {
+						return false;
+					}
+				}
+				return reader.read(buf, 256) == 0;
+			});
+
+			runTest(stream, toString(name, " batch"), count, passed, [&] {
+				auto fd = ::open(src.data(), O_RDONLY);
+				std::atomic<size_t> completed = 0;
+				std::atomic<size_t> failed = 0;
+
+				std::vector<thread::FileIOQueue::Request> reqs;
+				std::vector<uint32_t> buffers;
+				for (size_t i = 0; i < queue->getBufferCount(); ++ i) {
+					auto idx = queue->acquireBuffer();
+					auto offset = queue->getBufferSize() * i * 3;
+					buffers.emplace_back(idx);
+
+					thread::FileIOQueue::Request req;
+					req.fd = fd;
+					req.offset = offset;
+					req.buffer = idx;
+					req.data = queue->getBuffer(idx);
+					req.size = queue->getBufferSize();
+					req.callback = [&, offset, ptr = req.data, size = req.size] (int64_t result) {
+						auto expected = (offset < data.size()) ? std::min(size, data.size() - offset) : 0;
+						if (size_t(result) != expected || memcmp(ptr, data.data() + offset, expected) != 0) {
+							++ failed;
+						}
+						++ completed;
+					};
+					reqs.emplace_back(move(req));
+				}
+
+				auto nreqs = reqs.size();
+				auto submitted = queue->submit(move(reqs));
+				queue->wait();
+
+				for (auto &it : buffers) {
+					queue->releaseBuffer(it);
+				}
+				::close(fd);
+				return submitted == nreqs && completed == nreqs && failed == 0;
+			});
+
+			runTest(stream, toString(name, " sync close"), count, passed, [&] {
+				thread::AsyncFileWriter writer(queue, dst, 4);
+				writer.write(data.data(), 1_MiB);
+
+				// close on completion thread would wait for itself, so it is rejected
+				auto fd = ::open(src.data(), O_RDONLY);
+				uint8_t buf[16];
+				std::atomic<bool> rejected = false;
+				thread::FileIOQueue::Request req;
+				req.fd = fd;
+				req.data = buf;
+				req.size = sizeof(buf);
+				req.immediate = true;
+				req.callback = [&] (int64_t) {
+					rejected = !writer.close(true) && writer.is_open();
+				};
+				queue->submit(move(req));
+				queue->wait();
+				::close(fd);
+
+				filesystem::Stat stat;
+				return rejected.load() && writer.close(true) && !writer.is_open()
+						&& filesystem::stat(dst, stat) && stat.size == 1_MiB;
+			});
+
+			runTest(stream, toString(name, " resubmit from callback"), count, passed, [&] {
+				// with small queue depth submitter waits for free slots while callbacks submit chained requests
+				thread::FileIOQueue::Config smallCfg;
+				smallCfg.backend = backend;
+				smallCfg.queueDepth = 2;
+				smallCfg.bufferCount = 0;
+
+				auto small = Rc<thread::FileIOQueue>::alloc();
+				if (!small->init(smallCfg)) {
+					return false;
+				}
+
+				auto fd = ::open(src.data(), O_RDONLY);
+				std::atomic<size_t> completed = 0;
+				Bytes buf; buf.resize(64_KiB);
+
+				auto makeRequest = [&] (size_t offset, thread::FileIOQueue::Callback &&cb) {
+					thread::FileIOQueue::Request req;
+					req.fd = fd;
+					req.offset = offset;
+					req.data = buf.data() + offset;
+					req.size = 1_KiB;
+					req.immediate = true;
+					req.callback = move(cb);
+					return req;
+				};
+
+				std::vector<thread::FileIOQueue::Request> reqs;
+				for (size_t i = 0; i < 32; ++ i) {
+					reqs.emplace_back(makeRequest(i * 1_KiB, [&, i] (int64_t result) {
+						if (result == int64_t(1_KiB)) {
+							++ completed;
+						}
+						small->submit(makeRequest((i + 32) * 1_KiB, [&] (int64_t result) {
+							if (result == int64_t(1_KiB)) {
+								++ completed;
+							}
+						}));
+					}));
+				}
+				small->submit(move(reqs));
+				small->wait();
+				small->cancel();
+				::close(fd);
+
+				return completed == 64 && memcmp(buf.data(), data.data(), buf.size()) == 0;
+			});
+
+			queue->cancel();
+		}
+
+		runTest(stream, "task queue completions", count, passed, [&] {
+			auto target = Rc<thread::TaskQueue>::alloc("FileIOQueueTest");
+			target->spawnWorkers(thread::TaskQueue::Flags::Cancelable, maxOf<uint32_t>(), 2);
+
+			auto queue = Rc<thread::FileIOQueue>::alloc();
+			queue->init(thread::FileIOQueue::Config(), target);
+
+			auto fd = ::open(src.data(), O_RDONLY);
+			std::atomic<size_t> completed = 0;
+			std::atomic<bool> onWorker = true;
+			auto ids = target->getThreadIds();
+
+			Bytes buf; buf.resize(1_KiB * 16);
+			std::vector<thread::FileIOQueue::Request> reqs;
+			for (size_t i = 0; i < 16; ++ i) {
+				thread::FileIOQueue::Request req;
+				req.fd = fd;
+				req.offset = i * 1_KiB;
+				req.data = buf.data() + i * 1_KiB;
+				req.size = 1_KiB;
+				req.callback = [&] (int64_t result) {
+					if (std::find(ids.begin(), ids.end(), std::this_thread::get_id()) == ids.end()) {
+						onWorker = false;
+					}
+					if (result == int64_t(1_KiB)) {
+						++ completed;
+					}
+				};
+				reqs.emplace_back(move(req));
+			}
+			queue->submit(move(reqs));
+			queue->wait();
+			target->waitForAll();
+			target->cancelWorkers();
+			queue->cancel();
+			::close(fd);
+
+			return completed == 16 && onWorker && memcmp(buf.data(), data.data(), buf.size()) == 0;
+		});
+
+		runTest(stream, "copy benchmark", count, passed, [&] {
+			static constexpr size_t Iterations = 4;
+
+			auto t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				auto f = filesystem::openForReading(src);
+				std::ofstream out(dst.data(), std::ios::binary);
+				string::Sha256 sha;
+				io::read(io::Producer(f), io::Consumer(out), [&] (const io::Buffer &buf) {
+					sha.update((const uint8_t *)buf.data(), buf.size());
+				});
+				if (sha.final() != dataHash) {
+					return false;
+				}
+			}
+			auto bufferedTime = Time::now() - t;
+
+			auto queue = Rc<thread::FileIOQueue>::alloc();
+			queue->init();
+
+			auto buf = std::make_unique<StackBuffer<64_KiB>>();
+			t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				thread::AsyncFileReader reader(queue, src, 8);
+				thread::AsyncFileWriter writer(queue, dst, 8);
+				string::Sha256 sha;
+				io::read(io::Producer(reader), io::Consumer(writer), *buf, [&] (const io::Buffer &buf) {
+					sha.update((const uint8_t *)buf.data(), buf.size());
+				});
+				if (!writer.close() || sha.final() != dataHash) {
+					return false;
+				}
+			}
+			auto asyncTime = Time::now() - t;
+
+			stream << "\t\tbuffered: " << bufferedTime.toMicros() / Iterations << " us;"
+					<< " async (" << ((queue->getBackend() == thread::FileIOQueue::Backend::IoUring) ? "io_uring" : "pool") << "): "
+					<< asyncTime.toMicros() / Iterations << " us\n\t";
+			queue->cancel();
+			return true;
+		});
+
+		filesystem::remove(src);
+		filesystem::remove(dst);
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _FileIOQueueTest;
+
+}
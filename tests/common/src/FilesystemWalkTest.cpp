@@ -0,0 +1,210 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPFilesystem.h"
+#include "Test.h"
+
+#include <unistd.h>
+
+namespace stappler::app::test {
+
+struct FilesystemWalkTest : Test {
+	FilesystemWalkTest() : Test("FilesystemWalkTest") { }
+
+	// 20 * 10 directories with 100 files each
+	static constexpr size_t TopDirs = 20;
+	static constexpr size_t SubDirs = 10;
+	static constexpr size_t Files = 100;
+
+	static String makeTree() {
+		// tmpfs is preferred, so benchmark measures traversal, not disk
+		auto root = filesystem::exists("/dev/shm") ? String("/dev/shm/sp.walk.test") : String("/tmp/sp.walk.test");
+		filesystem::remove(root, true, true);
+		filesystem::mkdir(root);
+		for (size_t i = 0; i < TopDirs; ++ i) {
+			auto top = toString(root, "/top", i);
+			filesystem::mkdir(top);
+			for (size_t j = 0; j < SubDirs; ++ j) {
+				auto sub = toString(top, "/sub", j);
+				filesystem::mkdir(sub);
+				for (size_t k = 0; k < Files; ++ k) {
+					filesystem::write(toString(sub, "/file", k), BytesView((const uint8_t *)"data", (i + j + k) % 4));
+				}
+			}
+		}
+		return root;
+	}
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		auto root = makeTree();
+		const size_t total = 1 + TopDirs + TopDirs * SubDirs + TopDirs * SubDirs * Files;
+
+		runTest(stream, "walk equals ftw", count, passed, [&] {
+			std::set<String> ftwPaths;
+			filesystem::ftw(root, [&] (StringView path, bool isFile) {
+				ftwPaths.emplace(path.str<Interface>());
+			});
+
+			std::set<String> walkPaths;
+			size_t files = 0;
+			size_t dirs = 0;
+			bool valid = true;
+			filesystem::WalkOptions opts;
+			opts.threads = 4;
+			opts.batchSize = 100;
+			filesystem::walk(root, [&] (SpanView<filesystem::WalkEntry> entries) {
+				if (entries.size() > 100) {
+					valid = false;
+				}
+				for (auto &it : entries) {
+					walkPaths.emplace(it.path.str<Interface>());
+					if (!it.path.ends_with(it.name)) {
+						valid = false;
+					}
+					switch (it.type) {
+					case filesystem::WalkEntry::Type::File: ++ files; break;
+					case filesystem::WalkEntry::Type::Dir: ++ dirs; break;
+					default: valid = false; break;
+					}
+				}
+				return true;
+			}, opts);
+
+			return valid && ftwPaths.size() == total && walkPaths == ftwPaths
+					&& files == TopDirs * SubDirs * Files && dirs == 1 + TopDirs + TopDirs * SubDirs;
+		});
+
+		runTest(stream, "walk stat and depth", count, passed, [&] {
+			bool valid = true;
+			size_t entries = 0;
+			filesystem::WalkOptions opts;
+			opts.flags = filesystem::WalkFlags::Stat;
+			opts.depth = 2;
+			filesystem::walk(root, [&] (SpanView<filesystem::WalkEntry> batch) {
+				for (auto &it : batch) {
+					++ entries;
+					filesystem::Stat stat;
+					filesystem::stat(it.path, stat);
+					if (it.depth > 2 || stat.isDir != it.stat.isDir || stat.size != it.stat.size || stat.mtime != it.stat.mtime) {
+						valid = false;
+					}
+				}
+				return true;
+			}, opts);
+			return valid && entries == 1 + TopDirs + TopDirs * SubDirs;
+		});
+
+		runTest(stream, "walk stop", count, passed, [&] {
+			size_t entries = 0;
+			filesystem::WalkOptions opts;
+			opts.threads = 4;
+			opts.batchSize = 16;
+			auto ret = filesystem::walk(root, [&] (SpanView<filesystem::WalkEntry> batch) {
+				entries += batch.size();
+				return entries < 1000;
+			}, opts);
+			return !ret && entries >= 1000 && entries < total;
+		});
+
+		runTest(stream, "walk root link", count, passed, [&] {
+			// symlinked root is listed only with FollowLinks
+			auto link = toString(root, ".link");
+			::unlink(link.data());
+			if (::symlink(toString(root, "/top0").data(), link.data()) != 0) {
+				return false;
+			}
+
+			auto countEntries = [&] (filesystem::WalkFlags flags) {
+				size_t entries = 0;
+				filesystem::WalkOptions opts;
+				opts.flags = flags;
+				filesystem::walk(link, [&] (SpanView<filesystem::WalkEntry> batch) {
+					entries += batch.size();
+					return true;
+				}, opts);
+				return entries;
+			};
+
+			auto noFollow = countEntries(filesystem::WalkFlags::None);
+			auto follow = countEntries(filesystem::WalkFlags::FollowLinks);
+			::unlink(link.data());
+			return noFollow == 1 && follow == 1 + SubDirs + SubDirs * Files;
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			auto t = Time::now();
+			size_t ftwCount = 0;
+			filesystem::ftw(root, [&] (StringView path, bool isFile) {
+				++ ftwCount;
+			});
+			auto ftwTime = Time::now() - t;
+
+			t = Time::now();
+			size_t ftwStatCount = 0;
+			filesystem::ftw(root, [&] (StringView path, bool isFile) {
+				filesystem::Stat stat;
+				if (filesystem::stat(path, stat)) {
+					++ ftwStatCount;
+				}
+			});
+			auto ftwStatTime = Time::now() - t;
+
+			auto runWalk = [&] (uint32_t threads, filesystem::WalkFlags flags, size_t &result) {
+				filesystem::WalkOptions opts;
+				opts.threads = threads;
+				opts.flags = flags;
+				auto t = Time::now();
+				filesystem::walk(root, [&] (SpanView<filesystem::WalkEntry> batch) {
+					result += batch.size();
+					return true;
+				}, opts);
+				return Time::now() - t;
+			};
+
+			size_t walk1 = 0, walk4 = 0, walkStat = 0;
+			auto walk1Time = runWalk(1, filesystem::WalkFlags::None, walk1);
+			auto walk4Time = runWalk(4, filesystem::WalkFlags::None, walk4);
+			auto walkStatTime = runWalk(4, filesystem::WalkFlags::Stat, walkStat);
+
+			stream << "\t\t" << total << " entries: ftw: " << ftwTime.toMicros() << " us; ftw+stat: " << ftwStatTime.toMicros() << " us;"
+					<< " walk(1): " << walk1Time.toMicros() << " us; walk(4): " << walk4Time.toMicros() << " us;"
+					<< " walk(4)+stat: " << walkStatTime.toMicros() << " us\n\t";
+
+			return ftwCount == total && ftwStatCount == total && walk1 == total && walk4 == total && walkStat == total;
+		});
+
+		filesystem::remove(root, true, true);
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _FilesystemWalkTest;
+
+}
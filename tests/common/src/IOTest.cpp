@@ -0,0 +1,301 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPIO.h"
+#include "SPFilesystem.h"
+#include "Test.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace stappler::app::test {
+
+// consumer, that writes directly into file descriptor
+struct FdConsumer {
+	int fd = -1;
+	size_t written = 0;
+};
+
+// file consumer, that counts writes through user space
+struct CountingFile : filesystem::File {
+	using File::File;
+
+	size_t written = 0;
+};
+
+}
+
+namespace stappler::io {
+
+template <>
+struct ConsumerTraits<app::test::FdConsumer> {
+	using type = app::test::FdConsumer;
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		auto ret = ::write(((type *)ptr)->fd, buf, nbytes);
+		if (ret > 0) {
+			((type *)ptr)->written += ret;
+			return size_t(ret);
+		}
+		return 0;
+	}
+	static void FlushFn(void *ptr) { }
+	static int FdFn(void *ptr) { return ((type *)ptr)->fd; }
+};
+
+template <>
+struct ConsumerTraits<app::test::CountingFile> : ConsumerTraits<filesystem::File> {
+	using type = app::test::CountingFile;
+	static size_t WriteFn(void *ptr, const uint8_t *buf, size_t nbytes) {
+		((type *)ptr)->written += nbytes;
+		return ConsumerTraits<filesystem::File>::WriteFn(ptr, buf, nbytes);
+	}
+};
+
+}
+
+namespace stappler::app::test {
+
+struct IOTest : Test {
+	IOTest() : Test("IOTest") { }
+
+	static String getTmpPath(const char *prefix) {
+		auto tmp = filesystem::File::open_tmp(prefix, false);
+		auto path = StringView(tmp.path()).str<Interface>();
+		tmp.close();
+		return path;
+	}
+
+	static Bytes makeData(size_t size, uint64_t seed) {
+		Bytes data; data.resize(size);
+		for (size_t i = 0; i < size; ++ i) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			data[i] = uint8_t(seed >> 56);
+		}
+		return data;
+	}
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		auto data = makeData(4_MiB + 777, 1);
+		auto src = getTmpPath("sp.io.src");
+		auto dst = getTmpPath("sp.io.dst");
+		filesystem::write(src, data);
+
+		runTest(stream, "kernel copy", count, passed, [&] {
+			auto in = ::open(src.data(), O_RDONLY);
+			auto out = ::open(dst.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+			// partial copy from offset
+			int64_t offset = 1000;
+			auto ret = io::copy(in, out, &offset, 1_MiB);
+			::close(in);
+			::close(out);
+
+			auto result = filesystem::readIntoMemory<Interface>(dst);
+			return ret == 1_MiB && offset == int64_t(1000 + 1_MiB) && result.size() == 1_MiB
+					&& memcmp(result.data(), data.data() + 1000, 1_MiB) == 0;
+		});
+
+		runTest(stream, "kernel copy pipe", count, passed, [&] {
+			int p[2];
+			if (::pipe(p) != 0) {
+				return false;
+			}
+
+			// pipe source can be processed only with splice
+			auto out = ::open(dst.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (out < 0) {
+				::close(p[0]);
+				::close(p[1]);
+				return false;
+			}
+
+			std::thread writer([&] {
+				size_t written = 0;
+				while (written < data.size()) {
+					auto r = ::write(p[1], data.data() + written, std::min(size_t(100_KiB), data.size() - written));
+					if (r <= 0) {
+						break;
+					}
+					written += r;
+				}
+				::close(p[1]);
+			});
+			auto ret = io::copy(p[0], out);
+			writer.join();
+			::close(p[0]);
+			::close(out);
+
+			auto result = filesystem::readIntoMemory<Interface>(dst);
+			return ret == data.size() && result == data;
+		});
+
+		runTest(stream, "producer/consumer fast path", count, passed, [&] {
+			auto f = filesystem::openForReading(src);
+			uint8_t head[100];
+			f.read(head, 100);
+
+			FdConsumer consumer;
+			consumer.fd = ::open(dst.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			auto ret = io::read(io::Producer(f), io::Consumer(consumer));
+			::close(consumer.fd);
+
+			auto result = filesystem::readIntoMemory<Interface>(dst);
+
+			// no data should pass through user space, producer position should be updated
+			return ret == data.size() - 100 && consumer.written == 0 && f.tell() == data.size()
+					&& result.size() == data.size() - 100 && memcmp(result.data(), data.data() + 100, result.size()) == 0;
+		});
+
+		runTest(stream, "kernel copy append target", count, passed, [&] {
+			// splice into O_APPEND file is rejected, data from intermediate pipe should be written anyway
+			auto in = ::open(src.data(), O_RDONLY);
+			auto out = ::open(dst.data(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+			int64_t offset = 0;
+			auto ret = io::copy(in, out, &offset);
+			::close(in);
+			::close(out);
+
+			auto result = filesystem::readIntoMemory<Interface>(dst);
+			return ret == data.size() && offset == int64_t(data.size()) && result == data;
+		});
+
+		runTest(stream, "file consumer", count, passed, [&] {
+			auto f = filesystem::openForReading(src);
+			CountingFile out(filesystem::native::fopen_fn(dst, "wb"));
+
+			// buffered data before and after kernel copy should keep its order
+			out.xsputn("head", 4);
+			auto ret = io::read(io::Producer(f), io::Consumer(out));
+			out.xsputn("tail", 4);
+			auto pos = out.tell();
+			out.close();
+
+			auto result = filesystem::readIntoMemory<Interface>(dst);
+			return ret == data.size() && out.written == 0 && pos == data.size() + 8
+					&& result.size() == data.size() + 8
+					&& memcmp(result.data(), "head", 4) == 0
+					&& memcmp(result.data() + 4, data.data(), data.size()) == 0
+					&& memcmp(result.data() + 4 + data.size(), "tail", 4) == 0;
+		});
+
+		runTest(stream, "adaptive buffer", count, passed, [&] {
+			auto f = filesystem::openForReading(src);
+			size_t chunks = 0;
+			size_t maxChunk = 0;
+			Bytes result;
+			io::read(io::Producer(f), [&] (const io::Buffer &buf) {
+				++ chunks;
+				maxChunk = std::max(maxChunk, buf.size());
+				result.insert(result.end(), buf.data(), buf.data() + buf.size());
+			});
+			return result == data && maxChunk == 1_MiB && chunks < 16;
+		});
+
+		runTest(stream, "tree copy", count, passed, [&] {
+			auto root = getTmpPath("sp.io.tree");
+			filesystem::remove(root);
+			filesystem::mkdir(root);
+			for (size_t i = 0; i < 4; ++ i) {
+				auto dir = toString(root, "/dir", i);
+				filesystem::mkdir(dir);
+				for (size_t j = 0; j < 8; ++ j) {
+					filesystem::write(toString(dir, "/file", j), makeData(1_KiB * (i * 8 + j + 1), i * 8 + j));
+				}
+			}
+
+			bool success = true;
+			for (uint32_t nthreads : { 1, 4 }) {
+				auto target = toString(root, ".copy", nthreads);
+				filesystem::remove(target, true, true);
+				if (!filesystem::copy(root, target, true, nthreads)) {
+					success = false;
+				}
+
+				for (size_t i = 0; i < 4; ++ i) {
+					for (size_t j = 0; j < 8; ++ j) {
+						auto a = filesystem::readIntoMemory<Interface>(toString(root, "/dir", i, "/file", j));
+						auto b = filesystem::readIntoMemory<Interface>(toString(target, "/dir", i, "/file", j));
+						if (a.empty() || a != b) {
+							success = false;
+						}
+					}
+				}
+				filesystem::remove(target, true, true);
+			}
+			filesystem::remove(root, true, true);
+			return success;
+		});
+
+		runTest(stream, "copy benchmark", count, passed, [&] {
+			static constexpr size_t Iterations = 4;
+			auto large = makeData(32_MiB, 2);
+			filesystem::write(src, large);
+
+			auto t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				// previous implementation: 1 KiB stack buffer and std::ofstream
+				std::ofstream out(dst.data(), std::ios::binary);
+				auto f = filesystem::openForReading(src);
+				io::Producer from(f);
+				StackBuffer<1_KiB> buf;
+				io::read(from, io::Consumer(out), io::Buffer(buf));
+			}
+			auto streamTime = Time::now() - t;
+
+			t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				std::ofstream out(dst.data(), std::ios::binary);
+				auto f = filesystem::openForReading(src);
+				io::read(io::Producer(f), io::Consumer(out));
+			}
+			auto adaptiveTime = Time::now() - t;
+
+			t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				filesystem::copy(src, dst);
+			}
+			auto kernelTime = Time::now() - t;
+
+			stream << "\t\t32 MiB: 1 KiB buffer: " << streamTime.toMicros() / Iterations << " us;"
+					<< " adaptive buffer: " << adaptiveTime.toMicros() / Iterations << " us;"
+					<< " kernel copy: " << kernelTime.toMicros() / Iterations << " us\n\t";
+
+			return filesystem::readIntoMemory<Interface>(dst) == large;
+		});
+
+		filesystem::remove(src);
+		filesystem::remove(dst);
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _IOTest;
+
+}
@@ -27,6 +27,7 @@
 #include "SPCrypto.h"
 #include "SPJsonWebToken.h"
 #include "SPValid.h"
+#include "SPTime.h"
 #include "Test.h"
 
 namespace stappler::app::test {
@@ -172,6 +173,227 @@ struct JwtTest : Test {
 			return true;
 		});
 
+		runTest(stream, "eddsa", count, passed, [&] () -> bool {
+			crypto::PrivateKey edPriv;
+			if (!edPriv.generate(crypto::KeyType::EDDSA_ED25519) || edPriv.getType() != crypto::KeyType::EDDSA_ED25519) {
+				return false;
+			}
+
+			auto edPub = edPriv.exportPublic();
+
+			JsonWebToken<Interface> token({
+				pair("data", Value("data")),
+			}, TimeInterval::seconds(60));
+
+			auto d = token.exportSigned(JsonWebToken<Interface>::SigAlg::EdDSA, edPriv);
+			JsonWebToken<Interface> tmpToken(d);
+
+			// RSA key should not be accepted for EdDSA token
+			return edPub.getType() == crypto::KeyType::EDDSA_ED25519 && pub.getType() == crypto::KeyType::RSA
+					&& tmpToken.alg == JsonWebToken<Interface>::SigAlg::EdDSA
+					&& tmpToken.validate(edPub) && !tmpToken.validate(pub) && tmpToken.validatePayload();
+		});
+
+		runTest(stream, "verifier", count, passed, [&] () -> bool {
+			crypto::PrivateKey edPriv;
+			edPriv.generate(crypto::KeyType::EDDSA_ED25519);
+
+			String edPem;
+			edPriv.exportPublic().exportPem([&] (const uint8_t *data, size_t len) {
+				edPem = String((const char *)data, len);
+			});
+
+			auto secret = StringView("hmac-secret");
+
+			JsonWebTokenVerifier::Config cfg;
+			cfg.issuer = "issuer";
+			JsonWebTokenVerifier verifier(move(cfg));
+			verifier.addKey("rsa", BytesView((const uint8_t *)PUBLIC_KEY, strlen(PUBLIC_KEY)));
+			verifier.addKey("ed", BytesView((const uint8_t *)edPem.data(), edPem.size()));
+			verifier.addSecret("hs", BytesView((const uint8_t *)secret.data(), secret.size()));
+
+			auto makeToken = [&] (StringView kid, TimeInterval maxage, StringView iss = StringView("issuer")) {
+				auto tok = JsonWebToken<Interface>::make(iss, "aud", maxage, "subject");
+				tok.header.setString(kid, "kid");
+				return tok;
+			};
+
+			auto rsaToken = makeToken("rsa", TimeInterval::seconds(60)).exportSigned(JsonWebToken<Interface>::RS256, priv);
+			auto edToken = makeToken("ed", TimeInterval::seconds(60)).exportSigned(JsonWebToken<Interface>::EdDSA, edPriv);
+			auto hsToken = makeToken("hs", TimeInterval::seconds(60)).exportSigned(JsonWebToken<Interface>::HS256, secret);
+
+			// HMAC signed with public key as secret, signed with unknown key, expired and from other issuer
+			auto confusedToken = makeToken("rsa", TimeInterval::seconds(60)).exportSigned(JsonWebToken<Interface>::HS256, StringView(PUBLIC_KEY));
+			auto unknownToken = makeToken("unknown", TimeInterval::seconds(60)).exportSigned(JsonWebToken<Interface>::HS256, secret);
+			auto expired = makeToken("hs", TimeInterval());
+			expired.payload.setInteger(Time::now().toSeconds() - 60, "exp");
+			auto expiredToken = expired.exportSigned(JsonWebToken<Interface>::HS256, secret);
+			auto issuerToken = makeToken("hs", TimeInterval::seconds(60), "other").exportSigned(JsonWebToken<Interface>::HS256, secret);
+
+			auto tamperedToken = edToken;
+			tamperedToken[tamperedToken.size() - 3] = (tamperedToken[tamperedToken.size() - 3] == 'A') ? 'B' : 'A';
+
+			bool success = true;
+			for (size_t i = 0; i < 3; ++ i) {
+				if (verifier.verify(rsaToken).getString("sub") != "subject"
+						|| verifier.verify(edToken).getString("sub") != "subject"
+						|| verifier.verify(hsToken).getString("sub") != "subject") {
+					success = false;
+				}
+				if (verifier.verify(confusedToken) || verifier.verify(unknownToken) || verifier.verify(expiredToken)
+						|| verifier.verify(issuerToken) || verifier.verify(tamperedToken) || verifier.verify("garbage")) {
+					success = false;
+				}
+			}
+
+			auto stats = verifier.getStats();
+			if (stats.requests != 27 || stats.verified != 3 || stats.hits != 6 || stats.failed != 18 || verifier.getCacheSize() != 3) {
+				success = false;
+			}
+
+			// cached results are dropped with the key
+			verifier.removeKey("ed");
+			return success && verifier.getCacheSize() == 0 && !verifier.verify(edToken) && verifier.verify(rsaToken);
+		});
+
+		runTest(stream, "verifier benchmark", count, passed, [&] () -> bool {
+			static constexpr size_t UniqueTokens = 300;
+			static constexpr size_t Requests = 20000;
+			static constexpr size_t BaselineRequests = 1000;
+
+			crypto::PrivateKey edPriv;
+			edPriv.generate(crypto::KeyType::EDDSA_ED25519);
+
+			String edPem;
+			edPriv.exportPublic().exportPem([&] (const uint8_t *data, size_t len) {
+				edPem = String((const char *)data, len);
+			});
+
+			auto secret = StringView("hmac-secret");
+
+			// realistic mix: service tokens are mostly RS256, user sessions are EdDSA, internal calls uses HMAC
+			Vector<String> unique;
+			for (size_t i = 0; i < UniqueTokens; ++ i) {
+				auto tok = JsonWebToken<Interface>::make("issuer", "aud", TimeInterval::seconds(600), toString("user-", i));
+				switch (i % 10) {
+				case 0: case 1: case 2: case 3:
+					tok.header.setString("rsa", "kid");
+					unique.emplace_back(tok.exportSigned(JsonWebToken<Interface>::RS256, priv));
+					break;
+				case 4: case 5: case 6: case 7:
+					tok.header.setString("ed", "kid");
+					unique.emplace_back(tok.exportSigned(JsonWebToken<Interface>::EdDSA, edPriv));
+					break;
+				default:
+					tok.header.setString("hs", "kid");
+					unique.emplace_back(tok.exportSigned(JsonWebToken<Interface>::HS256, secret));
+					break;
+				}
+			}
+
+			// skewed distribution: most requests use small set of active tokens
+			std::vector<std::string> requests;
+			uint64_t seed = 0x5DEECE66D;
+			for (size_t i = 0; i < Requests; ++ i) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				auto r = double(seed >> 11) / double(1ULL << 53);
+				requests.emplace_back(unique[size_t(r * r * r * UniqueTokens)]);
+			}
+
+			auto setupKeys = [&] (JsonWebTokenVerifier &v) {
+				v.addKey("rsa", BytesView((const uint8_t *)PUBLIC_KEY, strlen(PUBLIC_KEY)));
+				v.addKey("ed", BytesView((const uint8_t *)edPem.data(), edPem.size()));
+				v.addSecret("hs", BytesView((const uint8_t *)secret.data(), secret.size()));
+			};
+
+			auto rate = [] (size_t n, TimeInterval t) {
+				return n * 1000000 / std::max(t.toMicros(), uint64_t(1));
+			};
+
+			// current approach: key is parsed for every token
+			size_t baselineValid = 0;
+			auto t = Time::now();
+			for (size_t i = 0; i < BaselineRequests; ++ i) {
+				JsonWebToken<Interface> tok(requests[i]);
+				bool valid = false;
+				if (tok.kid == "rsa") {
+					valid = tok.validate(StringView(PUBLIC_KEY));
+				} else if (tok.kid == "ed") {
+					valid = tok.validate(StringView(edPem));
+				} else {
+					valid = tok.validate(BytesView((const uint8_t *)secret.data(), secret.size()));
+				}
+				if (valid && tok.validatePayload()) {
+					++ baselineValid;
+				}
+			}
+			auto baselineTime = Time::now() - t;
+
+			JsonWebTokenVerifier::Config uncachedConfig;
+			uncachedConfig.cacheSize = 0;
+			JsonWebTokenVerifier uncached(move(uncachedConfig));
+			setupKeys(uncached);
+
+			size_t uncachedValid = 0;
+			t = Time::now();
+			for (size_t i = 0; i < BaselineRequests; ++ i) {
+				if (uncached.verify(requests[i])) {
+					++ uncachedValid;
+				}
+			}
+			auto uncachedTime = Time::now() - t;
+
+			JsonWebTokenVerifier verifier;
+			setupKeys(verifier);
+
+			size_t cachedValid = 0;
+			t = Time::now();
+			for (auto &it : requests) {
+				if (verifier.verify(it)) {
+					++ cachedValid;
+				}
+			}
+			auto cachedTime = Time::now() - t;
+
+			stream << "\t\tkey per token: " << rate(BaselineRequests, baselineTime) << " tokens/s; cached keys: "
+					<< rate(BaselineRequests, uncachedTime) << " tokens/s; cached results: " << rate(Requests, cachedTime)
+					<< " tokens/s (" << verifier.getStats().hits << " hits)\n\t";
+
+			bool success = baselineValid == BaselineRequests && uncachedValid == BaselineRequests && cachedValid == Requests;
+
+#if MODULE_COMMON_THREADS
+			JsonWebTokenVerifier batchVerifier;
+			setupKeys(batchVerifier);
+
+			auto queue = Rc<thread::TaskQueue>::alloc("JwtTest");
+			queue->spawnWorkers(thread::TaskQueue::Flags::None, maxOf<uint32_t>(), 4);
+
+			size_t batchValid = 0;
+			bool complete = false;
+			t = Time::now();
+			batchVerifier.verify(*queue, std::vector<std::string>(requests), [&] (std::vector<JsonWebTokenVerifier::Value> &&results) {
+				for (size_t i = 0; i < results.size(); ++ i) {
+					if (results[i] && results[i].getString("sub") == JsonWebToken<Interface>(requests[i]).payload.getString("sub")) {
+						++ batchValid;
+					}
+				}
+				complete = true;
+			});
+			while (!complete) {
+				queue->update();
+				std::this_thread::yield();
+			}
+			auto batchTime = Time::now() - t;
+			queue->cancelWorkers();
+
+			stream << "\t\tbatch, 4 workers: " << rate(Requests, batchTime) << " tokens/s\n\t";
+
+			success = success && batchValid == Requests;
+#endif
+
+			return success;
+		});
+
 		_desc = stream.str();
 		return count == passed;
 	}
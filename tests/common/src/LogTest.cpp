@@ -0,0 +1,324 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPLogRecord.h"
+#include "SPFilesystem.h"
+#include "Test.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace stappler::app::test {
+
+struct LogTest : Test {
+	LogTest() : Test("LogTest") { }
+
+	static constexpr size_t Threads = 16;
+
+	// sinks are called under log mutex, so counters does not require synchronization
+	static size_t s_received;
+	static size_t s_outOfOrder;
+	static std::array<int64_t, Threads> s_lastIndex;
+	static int s_fileFd;
+	static std::string s_lastText;
+
+	static void captureSink(const StringView &tag, log::CustomLog::Type t, log::CustomLog::VA &va) {
+		if (tag == "LogRecord" && t == log::CustomLog::Text) {
+			s_lastText = va.text.str<memory::StandartInterface>();
+		}
+	}
+
+	static void countingSink(const StringView &tag, log::CustomLog::Type t, log::CustomLog::VA &va) {
+		if (tag != "LogTest" || t != log::CustomLog::Text) {
+			return;
+		}
+
+		// record format: <thread>:<index>
+		StringView r(va.text);
+		auto thread = r.readInteger(10).get(0);
+		++ r;
+		auto idx = r.readInteger(10).get(0);
+		if (thread >= 0 && size_t(thread) < Threads) {
+			if (idx <= s_lastIndex[thread]) {
+				++ s_outOfOrder;
+			}
+			s_lastIndex[thread] = idx;
+		}
+		++ s_received;
+	}
+
+	// emulates unbuffered file sink: one syscall per record
+	static void fileSink(const StringView &tag, log::CustomLog::Type t, log::CustomLog::VA &va) {
+		char buf[512];
+		int size = snprintf(buf, sizeof(buf), "[%.*s] ", int(tag.size()), tag.data());
+		if (t == log::CustomLog::Text) {
+			size += snprintf(buf + size, sizeof(buf) - size, "%.*s\n", int(va.text.size()), va.text.data());
+		} else {
+			size += vsnprintf(buf + size, sizeof(buf) - size, va.format.format, va.format.args);
+			buf[size ++] = '\n';
+		}
+		::write(s_fileFd, buf, std::min(size_t(size), sizeof(buf)));
+	}
+
+	static void reset() {
+		s_received = 0;
+		s_outOfOrder = 0;
+		s_lastIndex.fill(-1);
+	}
+
+	static bool parseRecord(StringView r, std::array<int64_t, Threads> &last) {
+		auto thread = r.readInteger(10).get(0);
+		++ r;
+		auto idx = r.readInteger(10).get(0);
+		if (thread < 0 || size_t(thread) >= Threads || idx <= last[thread]) {
+			return false;
+		}
+		last[thread] = idx;
+		return true;
+	}
+
+	template <typename Callback>
+	static TimeInterval spawn(size_t nrecords, const Callback &cb) {
+		std::vector<std::thread> threads;
+		auto t = Time::now();
+		for (size_t i = 0; i < Threads; ++ i) {
+			threads.emplace_back([i, nrecords, &cb] {
+				for (size_t j = 0; j < nrecords; ++ j) {
+					cb(int(i), int(j));
+				}
+			});
+		}
+		for (auto &it : threads) {
+			it.join();
+		}
+		return Time::now() - t;
+	}
+
+	static TimeInterval spawn(size_t nrecords) {
+		std::vector<std::thread> threads;
+		auto t = Time::now();
+		for (size_t i = 0; i < Threads; ++ i) {
+			threads.emplace_back([i, nrecords] {
+				for (size_t j = 0; j < nrecords; ++ j) {
+					log::format("LogTest", "%d:%d", int(i), int(j));
+				}
+			});
+		}
+		for (auto &it : threads) {
+			it.join();
+		}
+		return Time::now() - t;
+	}
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "async delivery", count, passed, [&] {
+			static constexpr size_t Records = 10000;
+			reset();
+
+			log::CustomLog sink(&countingSink);
+			if (!log::enableAsync(log::AsyncConfig{1_MiB, 5})) {
+				return false;
+			}
+
+			spawn(Records);
+			log::flush();
+
+			auto stats = log::getAsyncStats();
+			log::disableAsync();
+
+			stream << "\t\treceived: " << s_received << "; dropped: " << stats.dropped << "\n\t";
+			return !log::isAsync() && s_outOfOrder == 0 && s_received + stats.dropped == Threads * Records
+					&& (stats.dropped > 0 || s_received == Threads * Records);
+		});
+
+		runTest(stream, "overflow", count, passed, [&] {
+			static constexpr size_t Records = 2000;
+			reset();
+
+			log::CustomLog sink(&countingSink);
+
+			// flusher will not wake up on interval, small buffers are expected to be overflowed
+			auto before = log::getAsyncStats();
+			log::enableAsync(log::AsyncConfig{4_KiB, 10000});
+			spawn(Records);
+			log::disableAsync();
+
+			auto stats = log::getAsyncStats();
+			auto dropped = stats.dropped - before.dropped;
+			stream << "\t\treceived: " << s_received << "; dropped: " << dropped << "\n\t";
+			return dropped > 0 && s_outOfOrder == 0 && s_received + dropped == Threads * Records;
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Records = 20000;
+
+			auto tmp = filesystem::File::open_tmp("sp.log.test", false);
+			auto path = StringView(tmp.path()).str<Interface>();
+			tmp.close();
+
+			s_fileFd = ::open(path.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (s_fileFd < 0) {
+				return false;
+			}
+
+			log::CustomLog sink(&fileSink);
+
+			auto syncTime = spawn(Records);
+
+			auto before = log::getAsyncStats();
+			log::enableAsync(log::AsyncConfig{1_MiB, 20});
+			auto asyncTime = spawn(Records);
+			auto t = Time::now();
+			log::disableAsync();
+			auto flushTime = Time::now() - t;
+			auto stats = log::getAsyncStats();
+
+			::close(s_fileFd);
+			s_fileFd = -1;
+			filesystem::remove(path);
+
+			auto total = Threads * Records;
+			stream << "\t\tsync: " << total * 1'000'000 / std::max(syncTime.toMicros(), uint64_t(1)) << " calls/sec;"
+					<< " async: " << total * 1'000'000 / std::max(asyncTime.toMicros(), uint64_t(1)) << " calls/sec"
+					<< " (final flush: " << flushTime.toMicros() << " us, dropped: " << stats.dropped - before.dropped << ")\n\t";
+			return true;
+		});
+
+		runTest(stream, "record format", count, passed, [&] {
+			log::CustomLog sink(&captureSink);
+
+			log::record("LogRecord"_meta, "int {} uint {} double {} bool {} char {} str {} ptr {}"_meta,
+					-42, 42u, 0.5, true, 'c', StringView("view"), (const void *)0x10);
+			auto a = s_lastText;
+
+			log::record("LogRecord"_meta, "{}{} and {{}} {"_meta, "const", std::string(" string"), int64_t(minOf<int64_t>()));
+			auto b = s_lastText;
+
+			log::record("LogRecord"_meta, "no arguments"_meta);
+			auto c = s_lastText;
+
+			return a == "int -42 uint 42 double 0.5 bool true char c str view ptr 0x10"
+					&& b == "const string and {-9223372036854775808} {"
+					&& c == "no arguments";
+		});
+
+		runTest(stream, "binary log", count, passed, [&] {
+			static constexpr size_t Records = 5000;
+
+			auto tmp = filesystem::File::open_tmp("sp.log.binary", false);
+			auto path = StringView(tmp.path()).str<Interface>();
+			tmp.close();
+
+			auto before = log::getAsyncStats();
+			log::enableAsync(log::AsyncConfig{4_MiB, 20});
+			if (!log::setBinaryLog(path)) {
+				log::disableAsync();
+				return false;
+			}
+
+			size_t textSize = 0;
+			spawn(Records, [] (int i, int j) {
+				log::record("LogTest"_meta, "{}:{} value {} from {}"_meta, i, j, j * 0.25, StringView("binary log test"));
+			});
+			log::text("LogTest", "text record");
+			for (size_t i = 0; i < Threads; ++ i) {
+				for (size_t j = 0; j < Records; ++ j) {
+					textSize += toString("[LogTest] ", i, ":", j, " value ", j * 0.25, " from binary log test\n").size();
+				}
+			}
+
+			log::disableAsync();
+			log::setBinaryLog(StringView());
+			auto dropped = log::getAsyncStats().dropped - before.dropped;
+
+			size_t nrecords = 0;
+			size_t ntext = 0;
+			bool valid = true;
+			std::array<int64_t, Threads> last; last.fill(-1);
+
+			auto data = filesystem::readIntoMemory<Interface>(path);
+			auto success = log::readBinaryLog(data, [&] (StringView tag, StringView text) {
+				if (tag == "LogTest" && text == "text record") {
+					++ ntext;
+				} else if (tag == "LogTest") {
+					if (!parseRecord(text, last) || !text.ends_with(" from binary log test")) {
+						valid = false;
+					}
+					++ nrecords;
+				}
+			});
+			filesystem::remove(path);
+
+			stream << "\t\tbinary: " << data.size() << " bytes; text: " << textSize << " bytes; dropped: " << dropped << "\n\t";
+			return success && valid && ntext == 1 && nrecords + dropped == Threads * Records;
+		});
+
+		runTest(stream, "record benchmark", count, passed, [&] {
+			static constexpr size_t Records = 20000;
+
+			auto tmp = filesystem::File::open_tmp("sp.log.binary", false);
+			auto path = StringView(tmp.path()).str<Interface>();
+			tmp.close();
+
+			log::enableAsync(log::AsyncConfig{4_MiB, 20});
+			log::setBinaryLog(path);
+
+			auto before = log::getAsyncStats();
+			auto formatTime = spawn(Records, [] (int i, int j) {
+				log::format("LogTest", "%d:%d value %f from %s", i, j, j * 0.25, "benchmark");
+			});
+			auto recordTime = spawn(Records, [] (int i, int j) {
+				log::record("LogTest"_meta, "{}:{} value {} from {}"_meta, i, j, j * 0.25, "benchmark");
+			});
+
+			log::disableAsync();
+			log::setBinaryLog(StringView());
+			filesystem::remove(path);
+
+			auto stats = log::getAsyncStats();
+			auto total = Threads * Records;
+			stream << "\t\tformat: " << formatTime.toMicros() * 1000 / total << " ns/call;"
+					<< " record: " << recordTime.toMicros() * 1000 / total << " ns/call"
+					<< " (dropped: " << stats.dropped - before.dropped << ")\n\t";
+			return true;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _LogTest;
+
+size_t LogTest::s_received = 0;
+size_t LogTest::s_outOfOrder = 0;
+std::array<int64_t, LogTest::Threads> LogTest::s_lastIndex;
+int LogTest::s_fileFd = -1;
+std::string LogTest::s_lastText;
+
+}
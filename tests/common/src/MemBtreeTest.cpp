@@ -0,0 +1,227 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include <random>
+#include "Test.h"
+
+#if MODULE_COMMON_DATA
+#include "SPData.h"
+#endif
+
+namespace stappler::app::test {
+
+struct MemBtreeTest : MemPoolTest {
+	MemBtreeTest() : MemPoolTest("MemBtreeTest") { }
+
+	virtual bool run(pool_t *pool) {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "random ops test", count, passed, [&] {
+			std::mt19937_64 gen(1);
+			std::map<int64_t, int64_t> ref;
+			memory::btree_map<int64_t, int64_t> data;
+
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto k = int64_t(gen() % 20000);
+				switch (gen() % 3) {
+				case 0:
+				case 1:
+					ref[k] = int64_t(i);
+					data[k] = int64_t(i);
+					break;
+				case 2:
+					if (ref.erase(k) != data.erase(k)) {
+						return false;
+					}
+					break;
+				}
+			}
+
+			if (ref.size() != data.size() || !std::equal(ref.begin(), ref.end(), data.begin(), data.end(),
+					[] (auto &l, auto &r) { return l.first == r.first && l.second == r.second; })) {
+				return false;
+			}
+
+			// backward iteration
+			auto rit = ref.rbegin();
+			for (auto it = data.rbegin(); it != data.rend(); ++ it, ++ rit) {
+				if (it->first != rit->first) {
+					return false;
+				}
+			}
+
+			for (int64_t k = -1; k < 20001; ++ k) {
+				auto l1 = ref.lower_bound(k);
+				auto l2 = data.lower_bound(k);
+				auto u1 = ref.upper_bound(k);
+				auto u2 = data.upper_bound(k);
+				if ((l1 == ref.end()) != (l2 == data.end()) || (l1 != ref.end() && l1->first != l2->first)
+						|| (u1 == ref.end()) != (u2 == data.end()) || (u1 != ref.end() && u1->first != u2->first)
+						|| ref.count(k) != data.count(k)) {
+					return false;
+				}
+			}
+			return true;
+		});
+
+		runTest(stream, "erase test", count, passed, [&] {
+			memory::btree_set<int64_t> data;
+			for (int64_t i = 0; i < 10000; ++ i) {
+				data.emplace(i);
+			}
+
+			// erase every odd value with iterators, then drain range
+			auto it = data.begin();
+			while (it != data.end()) {
+				if (*it % 2) {
+					it = data.erase(it);
+				} else {
+					++ it;
+				}
+			}
+			if (data.size() != 5000 || *data.begin() != 0 || *data.rbegin() != 9998) {
+				return false;
+			}
+
+			data.erase(data.lower_bound(1000), data.lower_bound(9000));
+			int64_t prev = -1;
+			for (auto &v : data) {
+				if (v <= prev || v % 2 || (v >= 1000 && v < 9000)) {
+					return false;
+				}
+				prev = v;
+			}
+			auto size = data.size();
+			while (!data.empty()) {
+				data.erase(data.begin());
+			}
+			return size == 1000 && data.allocated() == 0;
+		});
+
+		runTest(stream, "string test", count, passed, [&] {
+			memory::btree_map<String, String> data;
+			for (size_t i = 0; i < 1000; ++ i) {
+				data.emplace(mem_pool::toString("key-", i), mem_pool::toString("value-", i));
+			}
+
+			auto copy = data;
+			data.emplace("key-1", "replaced");
+			auto it = data.find(StringView("key-1"));
+			auto moved = std::move(copy);
+
+			return it != data.end() && it->second == "replaced" && data.count(StringView("key-1000")) == 0
+					&& moved.size() == 1000 && moved.at("key-1") == "value-1" && copy.empty()
+					&& data.try_emplace("key-2", "value").second == false;
+		});
+
+#if MODULE_COMMON_DATA
+		runTest(stream, "data test", count, passed, [&] {
+			StringView json(R"({"b":[1,2,{"key":"value"}],"a":true,"c":{"z":1,"y":2}})");
+			auto val = data::json::read<memory::PoolBtreeInterface>(json);
+			auto cbor = data::write<memory::PoolBtreeInterface>(val, data::EncodeFormat::Cbor);
+			auto val2 = data::cbor::read<memory::PoolBtreeInterface>(cbor);
+			auto ret = data::toString(val2);
+
+			return val == val2 && ret == R"({"a":true,"b":[1,2,{"key":"value"}],"c":{"y":2,"z":1}})";
+		});
+
+		runTest(stream, "data interface", count, passed, [&] {
+			StringView json(R"({"b":[1,2.5,{"key":"value"}],"a":true,"c":{"z":1,"y":"str"}})");
+			auto val = data::json::read<memory::PoolBtreeInterface>(json);
+
+			// conversion between interfaces
+			auto pool = val.convert<memory::PoolInterface>();
+			auto standart = val.convert<memory::StandartInterface>();
+			auto fromPool = pool.convert<memory::PoolBtreeInterface>();
+			auto fromStd = standart.convert<memory::StandartInterface>().convert<memory::PoolBtreeInterface>();
+
+			// generic decoding with compressed data
+			auto lz4 = data::write<memory::PoolBtreeInterface>(val, data::EncodeFormat(data::EncodeFormat::Cbor, data::EncodeFormat::LZ4HCCompression));
+			auto fromLz4 = data::read<memory::PoolBtreeInterface>(lz4);
+
+			bool encrypted = true;
+#if MODULE_COMMON_CRYPTO
+			StringView key("0123456789abcdef0123456789abcdef");
+			auto enc = data::write<memory::PoolBtreeInterface>(val,
+					data::EncodeFormat(data::EncodeFormat::Cbor, data::EncodeFormat::LZ4HCCompression, data::EncodeFormat::Encrypted, key));
+			encrypted = data::read<memory::PoolBtreeInterface>(enc, key) == val;
+#endif
+
+			auto str = data::toString(val);
+			return StringView(data::toString(pool)) == StringView(str) && StringView(data::toString(standart)) == StringView(str)
+					&& fromPool == val && fromStd == val && fromLz4 == val && encrypted;
+		});
+#endif
+
+		runTest(stream, "iteration benchmark", count, passed, [&] {
+			// same amount of visited nodes for every size
+			static constexpr size_t Total = 10000000;
+
+			bool success = true;
+			for (size_t size : { 1000, 10000, 100000, 1000000 }) {
+				std::mt19937_64 gen(size);
+				memory::map<int64_t, int64_t> map;
+				memory::btree_map<int64_t, int64_t> btree;
+				for (size_t i = 0; i < size; ++ i) {
+					auto v = int64_t(gen());
+					map.emplace(v, v);
+					btree.emplace(v, v);
+				}
+
+				auto iterate = [&] (auto &data) {
+					int64_t sum = 0;
+					auto t = Time::now();
+					for (size_t j = 0; j < Total / size; ++ j) {
+						for (auto &it : data) {
+							sum += it.second;
+						}
+					}
+					stream << (Time::now() - t).toMicros() * 1000 / Total << " ns/node ";
+					return sum;
+				};
+
+				stream << "\t\t" << size << ": map: ";
+				auto s1 = iterate(map);
+				stream << "btree: ";
+				auto s2 = iterate(btree);
+				stream << "(memory: " << map.size() * (sizeof(memory::rbtree::Node<Pair<const int64_t, int64_t>>))
+						<< " vs " << btree.allocated() << " bytes)\n";
+				if (s1 != s2) {
+					success = false;
+				}
+			}
+			stream << "\t";
+			return success;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _MemBtreeTest;
+
+}
@@ -0,0 +1,192 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include <random>
+#include "Test.h"
+
+namespace stappler::app::test {
+
+struct MemHashMapTest : MemPoolTest {
+	MemHashMapTest() : MemPoolTest("MemHashMapTest") { }
+
+	virtual bool run(pool_t *pool) {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "random ops test", count, passed, [&] {
+			memory::unordered_map<int64_t, int64_t> map;
+			std::unordered_map<int64_t, int64_t> ref;
+
+			std::mt19937_64 gen(42);
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto key = int64_t(gen() % 5000);
+				switch (gen() % 3) {
+				case 0:
+				case 1:
+					map[key] = int64_t(i);
+					ref[key] = int64_t(i);
+					break;
+				case 2:
+					if (map.erase(key) != ref.erase(key)) {
+						return false;
+					}
+					break;
+				}
+			}
+
+			if (map.size() != ref.size()) {
+				return false;
+			}
+
+			size_t iterated = 0;
+			for (auto &it : map) {
+				auto iit = ref.find(it.first);
+				if (iit == ref.end() || iit->second != it.second) {
+					return false;
+				}
+				++ iterated;
+			}
+			return iterated == ref.size();
+		});
+
+		runTest(stream, "string test", count, passed, [&] {
+			memory::unordered_map<String, String> map;
+			for (size_t i = 0; i < 1000; ++ i) {
+				map.emplace(mem_pool::toString("key-", i), mem_pool::toString("value-", i));
+			}
+
+			// emplace replaces existing value like memory::map
+			map.emplace(String("key-10"), String("replaced"));
+
+			auto copy = map;
+			auto moved = std::move(copy);
+
+			for (size_t i = 0; i < 1000; i += 2) {
+				map.erase(mem_pool::toString("key-", i));
+			}
+
+			if (map.size() != 500 || moved.size() != 1000 || !copy.empty() || moved.at("key-10") != "replaced") {
+				return false;
+			}
+
+			for (size_t i = 1; i < 1000; i += 2) {
+				auto it = map.find(mem_pool::toString("key-", i));
+				if (it == map.end() || (i != 10 && it->second != mem_pool::toString("value-", i))) {
+					return false;
+				}
+			}
+
+			map.erase(map.begin(), map.end());
+			return map.empty() && moved != map && map.capacity() > 0;
+		});
+
+		runTest(stream, "set test", count, passed, [&] {
+			memory::unordered_set<String> set;
+			set.emplace("One");
+			set.emplace("Two");
+			set.emplace("Three");
+			set.emplace("Two");
+
+			memory::unordered_set<int> ints{1, 2, 3, 4, 5};
+			ints.erase(3);
+
+			return set.size() == 3 && set.contains("Three") && !set.contains("Four")
+					&& ints.size() == 4 && !ints.contains(3) && ints.contains(5);
+		});
+
+		runTest(stream, "interface test", count, passed, [&] {
+			memory::PoolInterface::HashMapType<String, int> poolMap;
+			memory::StandartInterface::HashMapType<std::string, int> stdMap;
+			poolMap.emplace("key", 1);
+			stdMap.emplace("key", 1);
+
+			mem_pool::HashSet<int64_t> set;
+			set.emplace(int64_t(1));
+			return poolMap.at("key") == stdMap.at("key") && set.contains(1);
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Count = 100000;
+
+			Vector<String> strings;
+			Vector<int64_t> ints;
+			std::mt19937_64 gen(1);
+			for (size_t i = 0; i < Count; ++ i) {
+				strings.emplace_back(mem_pool::toString("benchmark-key-", gen()));
+				ints.emplace_back(int64_t(gen()));
+			}
+
+			auto bench = [&] (StringView name, auto &container, auto &keys) {
+				size_t found = 0;
+				auto t = Time::now();
+				for (auto &it : keys) {
+					container.emplace(it, 1);
+				}
+				auto insertTime = Time::now() - t;
+
+				t = Time::now();
+				for (size_t j = 0; j < 4; ++ j) {
+					for (auto &it : keys) {
+						found += container.find(it) != container.end() ? 1 : 0;
+					}
+				}
+				auto findTime = Time::now() - t;
+
+				stream << "\t\t" << name << ": insert: " << insertTime.toMicros() * 1000 / Count << " ns/op;"
+						<< " find: " << findTime.toMicros() * 1000 / (Count * 4) << " ns/op\n";
+				return found == Count * 4;
+			};
+
+			bool success = true;
+			do {
+				memory::unordered_map<int64_t, int> hashMap;
+				memory::map<int64_t, int> treeMap;
+				std::unordered_map<int64_t, int> stdMap;
+				success = bench("int memory::unordered_map", hashMap, ints) && success;
+				success = bench("int memory::map", treeMap, ints) && success;
+				success = bench("int std::unordered_map", stdMap, ints) && success;
+			} while (0);
+
+			do {
+				memory::unordered_map<String, int> hashMap;
+				memory::map<String, int> treeMap;
+				std::unordered_map<String, int> stdMap;
+				success = bench("string memory::unordered_map", hashMap, strings) && success;
+				success = bench("string memory::map", treeMap, strings) && success;
+				success = bench("string std::unordered_map", stdMap, strings) && success;
+			} while (0);
+
+			stream << "\t";
+			return success;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _MemHashMapTest;
+
+}
@@ -24,6 +24,8 @@ THE SOFTWARE.
 **/
 
 #include "SPCommon.h"
+#include "SPTime.h"
+#include <random>
 #include "Test.h"
 
 namespace stappler::app::test {
@@ -268,6 +270,152 @@ struct MemMapTest : MemPoolTest {
 			return data.find(&vec) != data.end() && data.find(&vec2) != data.end();
 		});
 
+		runTest(stream, "slab test", count, passed, [&] {
+			memory::map<int64_t, int64_t> data;
+			data.set_memory_slab(true);
+			for (int64_t i = 0; i < 1000; ++ i) {
+				data.emplace(i, i * 2);
+			}
+
+			// sequential nodes should be allocated from the same slabs
+			size_t adjacent = 0;
+			const void *prev = nullptr;
+			for (auto &it : data) {
+				if (prev && (const uint8_t *)&it - (const uint8_t *)prev < 256) {
+					++ adjacent;
+				}
+				prev = &it;
+			}
+
+			for (int64_t i = 0; i < 1000; i += 2) {
+				data.erase(i);
+			}
+
+			auto cap = data.capacity();
+			data.clear();
+			data.shrink_to_fit();
+
+			return adjacent > 900 && cap >= 1000 && data.capacity() == 0 && data.memory_slab();
+		});
+
+		runTest(stream, "compact test", count, passed, [&] {
+			memory::map<String, int64_t> data;
+			for (int64_t i = 0; i < 1000; ++ i) {
+				data.emplace(mem_pool::toString((i * 7919) % 1000), i);
+			}
+			for (int64_t i = 0; i < 1000; i += 3) {
+				data.erase(mem_pool::toString(i));
+			}
+
+			auto copy = data;
+			data.compact();
+
+			// nodes are placed in iteration order
+			const uint8_t *prev = nullptr;
+			for (auto &it : data) {
+				if (prev && (const uint8_t *)&it <= prev) {
+					return false;
+				}
+				prev = (const uint8_t *)&it;
+			}
+
+			if (copy != data || data.capacity() != data.size()) {
+				return false;
+			}
+
+			// tree should remain valid for modifications
+			for (int64_t i = 0; i < 1000; ++ i) {
+				data.emplace(mem_pool::toString(i), i);
+			}
+			for (int64_t i = 0; i < 1000; i += 2) {
+				data.erase(mem_pool::toString(i));
+			}
+			return data.size() == 500 && data.find("999") != data.end() && data.find("998") == data.end();
+		});
+
+		runTest(stream, "assign_sorted test", count, passed, [&] {
+			Vector<Pair<int64_t, int64_t>> sorted;
+			for (int64_t i = 0; i < 1023; ++ i) {
+				sorted.emplace_back(i, i);
+			}
+
+			memory::map<int64_t, int64_t> data;
+			data.assign_sorted(sorted.begin(), sorted.end());
+			if (data.size() != 1023 || data.begin()->first != 0 || data.rbegin()->first != 1022) {
+				return false;
+			}
+
+			int64_t idx = 0;
+			for (auto &it : data) {
+				if (it.first != idx ++) {
+					return false;
+				}
+			}
+
+			for (int64_t i = 0; i < 1023; i += 2) {
+				data.erase(i);
+			}
+			data.emplace(-1, -1);
+
+			// unsorted input with duplicates
+			memory::set<int64_t> set;
+			Vector<int64_t> unsorted{5, 3, 3, 9, 1, 5};
+			set.assign_sorted(unsorted.begin(), unsorted.end());
+
+			return data.size() == 512 && data.begin()->first == -1 && set.size() == 4 && *set.begin() == 1 && *set.rbegin() == 9;
+		});
+
+		runTest(stream, "iteration benchmark", count, passed, [&] {
+			static constexpr size_t Count = 200000;
+			static constexpr size_t Passes = 10;
+
+			std::mt19937_64 gen(1);
+			memory::map<int64_t, int64_t> data;
+			for (size_t i = 0; i < Count; ++ i) {
+				auto v = int64_t(gen());
+				data.emplace(v, v);
+			}
+
+			auto iterate = [&] {
+				int64_t sum = 0;
+				auto t = Time::now();
+				for (size_t j = 0; j < Passes; ++ j) {
+					for (auto &it : data) {
+						sum += it.second;
+					}
+				}
+				stream << (Time::now() - t).toMicros() * 1000 / (Count * Passes) << " ns/node ";
+				return sum;
+			};
+
+			stream << "scattered: ";
+			auto s1 = iterate();
+
+			auto t = Time::now();
+			data.compact();
+			auto compactTime = Time::now() - t;
+
+			stream << "compacted: ";
+			auto s2 = iterate();
+
+			Vector<Pair<int64_t, int64_t>> sorted(data.begin(), data.end());
+			t = Time::now();
+			memory::map<int64_t, int64_t> bulk;
+			bulk.assign_sorted(sorted.begin(), sorted.end());
+			auto bulkTime = Time::now() - t;
+
+			t = Time::now();
+			memory::map<int64_t, int64_t> inserted;
+			for (auto &it : sorted) {
+				inserted.emplace(it.first, it.second);
+			}
+			auto insertTime = Time::now() - t;
+
+			stream << "compact: " << compactTime.toMicros() << " us; assign_sorted: " << bulkTime.toMicros()
+					<< " us; emplace: " << insertTime.toMicros() << " us";
+			return s1 == s2 && bulk == inserted;
+		});
+
 		_desc = stream.str();
 
 		return count == passed;
@@ -25,6 +25,7 @@ THE SOFTWARE.
 
 #include "SPCommon.h"
 #include "SPString.h"
+#include "SPTime.h"
 #include "Test.h"
 
 namespace stappler::app::test {
@@ -69,6 +70,91 @@ struct MemVectorTest : MemPoolTest {
 			return true;
 		});
 
+		runTest(stream, "relocation test", count, passed, [&] {
+			Vector<Pair<String, Vector<String>>> vec;
+			for (size_t i = 0; i < 100; ++ i) {
+				vec.emplace_back(mem_pool::toString("long key string ", i), Vector<String>(1, mem_pool::toString("value ", i)));
+			}
+			vec.emplace(vec.begin(), "first", Vector<String>());
+			vec.erase(vec.begin() + 50);
+
+			return memory::is_trivially_relocatable<Pair<String, Vector<String>>>::value
+					&& !memory::is_trivially_relocatable<std::string>::value
+					&& vec.size() == 100 && vec.front().first == "first" && vec[49].first == "long key string 48"
+					&& vec[50].first == "long key string 50" && vec.back().second.front() == "value 99";
+		});
+
+		runTest(stream, "small_vector test", count, passed, [&] {
+			memory::small_vector<Pair<StringView, StringView>, 4> vec;
+			vec.emplace_back("a", "1");
+			vec.emplace_back("b", "2");
+			vec.emplace_back("c", "3");
+			vec.emplace_back("d", "4");
+			auto isInline = vec.is_inline() && vec.capacity() == 4;
+
+			// argument refers to element, that will be relocated
+			vec.emplace_back(vec.front());
+			vec.insert(vec.begin() + 1, pair(StringView("x"), StringView("0")));
+			vec.erase(vec.begin() + 2);
+
+			auto copy = vec;
+			auto moved = std::move(copy);
+			moved.pop_back();
+			moved.pop_back();
+			moved.shrink_to_fit();
+
+			return isInline && !vec.is_inline() && vec.size() == 5 && vec[1].first == "x" && vec[2].first == "c"
+					&& vec.back().first == "a" && copy.empty() && moved.is_inline() && moved.size() == 3
+					&& moved.back().first == "c";
+		});
+
+		runTest(stream, "small_vector<String> test", count, passed, [&] {
+			memory::small_vector<String, 2> vec;
+			mem_std::SmallVector<StringView, 2> stdVec;
+			for (size_t i = 0; i < 10; ++ i) {
+				vec.emplace_back(mem_pool::toString("string value ", i));
+				stdVec.emplace_back(vec.back());
+			}
+			vec.resize(3);
+			memory::small_vector<String, 2> other(std::move(vec));
+			other.swap(vec);
+
+			return vec.size() == 3 && other.empty() && vec[2] == "string value 2" && stdVec.size() == 10
+					&& stdVec[9] == "string value 9";
+		});
+
+		runTest(stream, "small_vector benchmark", count, passed, [&] {
+			static constexpr size_t Count = 100000;
+			StringView key("Content-Type");
+			StringView value("text/html");
+
+			size_t total1 = 0;
+			auto t = Time::now();
+			for (size_t i = 0; i < Count; ++ i) {
+				Vector<Pair<StringView, StringView>> vec;
+				for (size_t j = 0; j < 6; ++ j) {
+					vec.emplace_back(key, value);
+				}
+				total1 += vec.size();
+			}
+			auto vectorTime = Time::now() - t;
+
+			size_t total2 = 0;
+			t = Time::now();
+			for (size_t i = 0; i < Count; ++ i) {
+				memory::small_vector<Pair<StringView, StringView>, 8> vec;
+				for (size_t j = 0; j < 6; ++ j) {
+					vec.emplace_back(key, value);
+				}
+				total2 += vec.size();
+			}
+			auto smallTime = Time::now() - t;
+
+			stream << "Vector: " << vectorTime.toMicros() * 1000 / Count << " ns; small_vector: "
+					<< smallTime.toMicros() * 1000 / Count << " ns";
+			return total1 == total2;
+		});
+
 		_desc = stream.str();
 
 		return count == passed;
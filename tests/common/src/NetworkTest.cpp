@@ -26,9 +26,321 @@
 #if MODULE_COMMON_NETWORK
 
 #include "SPNetworkHandle.h"
+#include "SPNetworkAsyncClient.h"
+
+#include <curl/curl.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
 
 namespace stappler::app::test {
 
+// Minimal HTTP/1.1 keep-alive server on loopback, responds to `GET /<id>` with `response-<id>`,
+// and to `GET /data` with predefined data
+//
+// In HTTP/2 mode server expects prior knowledge (h2c) connections and responds to every request
+// with `h2-response-<stream>`; it handles only frames, used by curl for simple GET requests, and
+// does not decode request headers
+struct LocalHttpServer {
+	using Clock = std::chrono::steady_clock;
+
+	struct Connection {
+		int fd = -1;
+		String input;
+		bool preface = false;
+	};
+
+	bool start() {
+		_listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		int one = 1;
+		::setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		if (::bind(_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(_listenFd, 1024) != 0) {
+			return false;
+		}
+
+		socklen_t len = sizeof(addr);
+		::getsockname(_listenFd, (struct sockaddr *)&addr, &len);
+		_port = ntohs(addr.sin_port);
+
+		_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+		_eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		struct epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.ptr = nullptr;
+		::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _listenFd, &ev);
+		ev.data.ptr = this;
+		::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _eventFd, &ev);
+
+		_thread = std::thread([this] { run(); });
+		return true;
+	}
+
+	void stop() {
+		uint64_t value = 1;
+		if (::write(_eventFd, &value, sizeof(value)) == sizeof(value)) {
+			_thread.join();
+		}
+		for (auto &it : _connections) {
+			::close(it->fd);
+			delete it;
+		}
+		_connections.clear();
+		_delayed.clear();
+		::close(_listenFd);
+		::close(_eventFd);
+		::close(_epollFd);
+	}
+
+	void run() {
+		std::array<struct epoll_event, 64> events;
+		while (true) {
+			int timeout = -1;
+			if (!_delayed.empty()) {
+				timeout = std::max(int(std::chrono::ceil<std::chrono::milliseconds>(_delayed.begin()->first - Clock::now()).count()), 0);
+			}
+
+			auto n = ::epoll_wait(_epollFd, events.data(), events.size(), timeout);
+			for (int i = 0; i < n; ++ i) {
+				if (events[i].data.ptr == this) {
+					return;
+				} else if (events[i].data.ptr == nullptr) {
+					int fd = -1;
+					while ((fd = ::accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+						++ _accepted;
+						auto conn = new Connection{fd};
+						_connections.emplace(conn);
+						struct epoll_event ev;
+						ev.events = EPOLLIN;
+						ev.data.ptr = conn;
+						::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev);
+					}
+				} else {
+					auto conn = (Connection *)events[i].data.ptr;
+					if (!read(conn)) {
+						close(conn);
+					}
+				}
+			}
+
+			auto now = Clock::now();
+			while (!_delayed.empty() && _delayed.begin()->first <= now) {
+				auto conn = _delayed.begin()->second.first;
+				auto resp = move(_delayed.begin()->second.second);
+				_delayed.erase(_delayed.begin());
+				-- _outstanding;
+				if (!send(conn, resp)) {
+					close(conn);
+				}
+			}
+		}
+	}
+
+	void close(Connection *conn) {
+		for (auto it = _delayed.begin(); it != _delayed.end();) {
+			if (it->second.first == conn) {
+				-- _outstanding;
+				it = _delayed.erase(it);
+			} else {
+				++ it;
+			}
+		}
+		::epoll_ctl(_epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+		::close(conn->fd);
+		_connections.erase(conn);
+		delete conn;
+	}
+
+	bool read(Connection *conn) {
+		char buf[4_KiB];
+		while (true) {
+			auto r = ::recv(conn->fd, buf, sizeof(buf), 0);
+			if (r > 0) {
+				conn->input.append(buf, r);
+			} else if (r == 0) {
+				return false;
+			} else {
+				break;
+			}
+		}
+
+		if (_http2) {
+			return readHttp2(conn);
+		}
+
+		size_t pos = 0;
+		while ((pos = conn->input.find("\r\n\r\n")) != String::npos) {
+			StringView req(conn->input.data(), pos);
+			req.skipString("GET /");
+			auto id = req.readUntil<StringView::Chars<' '>>();
+			String resp;
+			if (_failures > 0) {
+				-- _failures;
+				resp = String("HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\nX-Attempt: failed\r\nContent-Length: 11\r\n\r\nunavailable");
+			} else if (id == "data") {
+				resp = toString("HTTP/1.1 200 OK\r\nContent-Type: ", _dataType, "\r\nContent-Length: ", _data.size(), "\r\n\r\n");
+				resp.append((const char *)_data.data(), _data.size());
+			} else {
+				auto body = toString("response-", id);
+				resp = toString("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: ", body.size(), "\r\n\r\n", body);
+			}
+			conn->input.erase(0, pos + 4);
+			if (!respond(conn, move(resp))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool readHttp2(Connection *conn) {
+		static constexpr StringView Preface("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+
+		if (!conn->preface) {
+			if (conn->input.size() < Preface.size()) {
+				return true;
+			}
+			if (StringView(conn->input).sub(0, Preface.size()) != Preface) {
+				return false;
+			}
+			conn->input.erase(0, Preface.size());
+			conn->preface = true;
+
+			// SETTINGS_MAX_CONCURRENT_STREAMS = 100
+			const char settings[] = { 0x00, 0x03, 0x00, 0x00, 0x00, 0x64 };
+			if (!send(conn, makeFrame(0x4, 0, 0, StringView(settings, sizeof(settings))))) {
+				return false;
+			}
+		}
+
+		while (conn->input.size() >= 9) {
+			auto h = (const uint8_t *)conn->input.data();
+			size_t len = (size_t(h[0]) << 16) | (size_t(h[1]) << 8) | size_t(h[2]);
+			auto type = h[3];
+			auto flags = h[4];
+			uint32_t stream = ((uint32_t(h[5]) & 0x7F) << 24) | (uint32_t(h[6]) << 16) | (uint32_t(h[7]) << 8) | uint32_t(h[8]);
+			if (conn->input.size() < 9 + len) {
+				break;
+			}
+
+			StringView payload(conn->input.data() + 9, len);
+			bool success = true;
+			switch (type) {
+			case 0x4: // SETTINGS
+				if ((flags & 0x1) == 0) {
+					success = send(conn, makeFrame(0x4, 0x1, 0, StringView()));
+				}
+				break;
+			case 0x6: // PING
+				if ((flags & 0x1) == 0) {
+					success = send(conn, makeFrame(0x6, 0x1, 0, payload));
+				}
+				break;
+			case 0x1: // HEADERS, END_STREAM for requests without body
+				if (flags & 0x1) {
+					auto body = toString("h2-response-", stream);
+					auto length = toString(body.size());
+
+					// `:status: 200` from static table, `content-length` as literal with indexed name
+					String block;
+					block.push_back(char(0x88));
+					block.push_back(char(0x0F));
+					block.push_back(char(0x0D));
+					block.push_back(char(length.size()));
+					block.append(length);
+
+					auto resp = makeFrame(0x1, 0x4, stream, block);
+					resp.append(makeFrame(0x0, 0x1, stream, body));
+					success = respond(conn, move(resp));
+				}
+				break;
+			default:
+				break;
+			}
+
+			conn->input.erase(0, 9 + len);
+			if (!success) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	String makeFrame(uint8_t type, uint8_t flags, uint32_t stream, StringView payload) {
+		String ret;
+		ret.reserve(9 + payload.size());
+		ret.push_back(char((payload.size() >> 16) & 0xFF));
+		ret.push_back(char((payload.size() >> 8) & 0xFF));
+		ret.push_back(char(payload.size() & 0xFF));
+		ret.push_back(char(type));
+		ret.push_back(char(flags));
+		ret.push_back(char((stream >> 24) & 0x7F));
+		ret.push_back(char((stream >> 16) & 0xFF));
+		ret.push_back(char((stream >> 8) & 0xFF));
+		ret.push_back(char(stream & 0xFF));
+		ret.append(payload.data(), payload.size());
+		return ret;
+	}
+
+	bool respond(Connection *conn, String &&resp) {
+		++ _requests;
+		if (_delay.count() == 0) {
+			return send(conn, resp);
+		}
+
+		// equal delays keep order of responses within connection
+		_delayed.emplace(Clock::now() + _delay, pair(conn, move(resp)));
+		_maxOutstanding = std::max(_maxOutstanding.load(), ++ _outstanding);
+		return true;
+	}
+
+	bool send(Connection *conn, StringView resp) {
+		size_t offset = 0;
+		while (offset < resp.size()) {
+			auto w = ::send(conn->fd, resp.data() + offset, resp.size() - offset, MSG_NOSIGNAL);
+			if (w < 0) {
+				if (errno == EAGAIN) {
+					continue;
+				}
+				return false;
+			}
+			offset += w;
+		}
+		return true;
+	}
+
+	uint16_t _port = 0;
+	int _listenFd = -1;
+	int _epollFd = -1;
+	int _eventFd = -1;
+	std::thread _thread;
+	std::set<Connection *> _connections;
+	std::multimap<Clock::time_point, Pair<Connection *, String>> _delayed;
+	std::atomic<size_t> _accepted = 0;
+	std::atomic<size_t> _requests = 0;
+	std::atomic<size_t> _outstanding = 0; // delayed responses, not yet sent
+	std::atomic<size_t> _maxOutstanding = 0;
+
+	// should be set before start
+	bool _http2 = false;
+	std::chrono::milliseconds _delay = std::chrono::milliseconds(0);
+
+	// number of next requests to respond with 503
+	std::atomic<size_t> _failures = 0;
+
+	// response for `GET /data`
+	Bytes _data;
+	String _dataType;
+};
+
 struct NetworkTest : Test {
 	NetworkTest() : Test("NetworkTest") { }
 
@@ -54,6 +366,492 @@ struct NetworkTest : Test {
 			return ret;
 		});
 
+		runTest(stream, "async client", count, passed, [&] {
+			static constexpr size_t Threads = 4;
+			static constexpr size_t PerThread = 1000;
+			static constexpr size_t Total = Threads * PerThread;
+
+			LocalHttpServer server;
+			if (!server.start()) {
+				return false;
+			}
+
+			auto queue = Rc<thread::TaskQueue>::alloc("NetworkTest");
+			queue->spawnWorkers(thread::TaskQueue::Flags::Cancelable, maxOf<uint32_t>(), 2);
+
+			auto client = Rc<network::AsyncClient>::alloc();
+			network::AsyncClient::Config cfg;
+			cfg.maxHostConnections = 8;
+			client->init(cfg, queue);
+
+			std::vector<String> bodies; bodies.resize(Total + 100);
+			std::atomic<size_t> succeeded = 0;
+			std::atomic<size_t> matched = 0;
+
+			auto submit = [&] (size_t id) {
+				network::AsyncClient::Handle h;
+				h.init(network::Method::Get, toString("http://127.0.0.1:", server._port, "/", id));
+				h.setReceiveCallback([&, id] (char *data, size_t size) -> size_t {
+					bodies[id].append(data, size);
+					return size;
+				});
+				client->submit(move(h), [&, id] (network::AsyncClient::Handle &h, bool success) {
+					if (success && h.getResponseCode() == 200) {
+						++ succeeded;
+					}
+					if (bodies[id] == toString("response-", id)) {
+						++ matched;
+					}
+				});
+			};
+
+			auto t = Time::now();
+
+			// requests are submitted from several threads
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < Threads; ++ i) {
+				threads.emplace_back([&, i] {
+					for (size_t j = 0; j < PerThread; ++ j) {
+						submit(i * PerThread + j);
+					}
+				});
+			}
+			for (auto &it : threads) {
+				it.join();
+			}
+
+			client->wait();
+			auto dt = Time::now() - t;
+			auto connections = server._accepted.load();
+
+			// next batch should reuse connections from the previous one
+			for (size_t i = Total; i < Total + 100; ++ i) {
+				submit(i);
+			}
+			client->wait();
+			queue->waitForAll();
+
+			auto stats = client->getStats();
+			stream << "\t\t" << Total << " requests: " << dt.toMicros() << " mks, "
+					<< Total * 1000000 / std::max(uint64_t(1), dt.toMicros()) << " requests/s; connections: "
+					<< connections << " -> " << server._accepted.load() << "\n\t";
+
+			client->cancel();
+			queue->cancelWorkers();
+			server.stop();
+
+			return succeeded == Total + 100 && matched == Total + 100 && stats.completed == Total + 100
+					&& stats.failed == 0 && connections <= cfg.maxHostConnections
+					&& server._accepted.load() == connections;
+		});
+
+		runTest(stream, "share context", count, passed, [&] {
+			static constexpr size_t Threads = 4;
+			static constexpr size_t PerThread = 250;
+			static constexpr size_t Total = Threads * PerThread;
+
+			LocalHttpServer server;
+			if (!server.start()) {
+				return false;
+			}
+
+			auto run = [&] (network::ShareContext *share, size_t offset) {
+				std::atomic<size_t> matched = 0;
+				std::vector<std::thread> threads;
+				for (size_t i = 0; i < Threads; ++ i) {
+					threads.emplace_back([&, i] {
+						for (size_t j = 0; j < PerThread; ++ j) {
+							auto id = offset + i * PerThread + j;
+							String body;
+							network::Handle<memory::StandartInterface> h;
+							h.init(network::Method::Get, toString("http://127.0.0.1:", server._port, "/", id));
+							if (share) {
+								h.setShareContext(share);
+							} else {
+								h.setReuse(false);
+							}
+							h.setReceiveCallback([&] (char *data, size_t size) -> size_t {
+								body.append(data, size);
+								return size;
+							});
+							if (h.perform() && h.getResponseCode() == 200 && body == toString("response-", id)) {
+								++ matched;
+							}
+						}
+					});
+				}
+				for (auto &it : threads) {
+					it.join();
+				}
+				return matched.load();
+			};
+
+			// independent handles without sharing, every request opens new connection
+			auto t = Time::now();
+			auto coldMatched = run(nullptr, 0);
+			auto coldTime = Time::now() - t;
+			auto coldConnections = server._accepted.load();
+
+			auto share = Rc<network::ShareContext>::alloc();
+
+			t = Time::now();
+			auto sharedMatched = run(share, Total);
+			auto sharedTime = Time::now() - t;
+			auto sharedConnections = server._accepted.load() - coldConnections;
+
+			auto stats = share->getStats();
+			stream << "\t\t" << Total << " requests: cold: " << coldTime.toMicros() << " mks, "
+					<< coldConnections << " connections; shared: " << sharedTime.toMicros() << " mks, "
+					<< sharedConnections << " connections, reuse rate: " << stats.getReuseRate()
+					<< ", handle hits: " << stats.handleHits << "/" << stats.handleHits + stats.handleMisses << "\n\t";
+
+			server.stop();
+
+			return coldMatched == Total && sharedMatched == Total
+					&& stats.requests == Total && stats.failed == 0
+					&& stats.newConnections == sharedConnections
+					&& stats.reusedConnections + sharedConnections == Total
+					&& sharedConnections <= Threads * 2 && stats.idleHandles > 0;
+		});
+
+		runTest(stream, "receive value", count, passed, [&] {
+			LocalHttpServer server;
+			if (!server.start()) {
+				return false;
+			}
+
+			Value source;
+			auto &items = source.emplace("items");
+			for (size_t i = 0; i < 10000; ++ i) {
+				auto &it = items.emplace();
+				it.setInteger(i, "id");
+				it.setString(toString("item-", i), "name");
+				it.setDouble(i / 7.0, "weight");
+				it.setBool(i % 3 == 0, "flag");
+			}
+
+			auto receive = [&] (BytesView data, StringView type, data::DataFormat fmt) {
+				server._data = data.bytes<Interface>();
+				server._dataType = type.str<Interface>();
+
+				network::Handle<Interface> h;
+				h.init(network::Method::Get, toString("http://127.0.0.1:", server._port, "/data"));
+				h.setReceiveValue(fmt);
+				if (!h.perform() || h.getResponseCode() != 200) {
+					return Value(false);
+				}
+				return h.extractReceivedValue();
+			};
+
+			auto json = data::write<Interface>(source, data::EncodeFormat::Json);
+			auto cbor = data::write<Interface>(source, data::EncodeFormat::Cbor);
+			auto expected = data::read<Interface>(json);
+
+			auto t = Time::now();
+			auto jsonValue = receive(BytesView((const uint8_t *)json.data(), json.size()), "application/json", data::DataFormat::Unknown);
+			auto jsonTime = Time::now() - t;
+
+			t = Time::now();
+			auto cborValue = receive(cbor, "application/cbor", data::DataFormat::Unknown);
+			auto cborTime = Time::now() - t;
+
+			// format from data, when content type is not informative
+			auto detectedValue = receive(cbor, "application/octet-stream", data::DataFormat::Unknown);
+
+			// malformed data does not break transfer, but value is not produced
+			auto html = StringView("<html><body>Not found</body></html>");
+			auto htmlValue = receive(BytesView((const uint8_t *)html.data(), html.size()), "text/html", data::DataFormat::Unknown);
+
+			stream << "\t\tjson: " << json.size() << " bytes, " << jsonTime.toMicros() << " mks; cbor: "
+					<< cbor.size() << " bytes, " << cborTime.toMicros() << " mks\n\t";
+
+			server.stop();
+
+			return jsonValue == expected && cborValue == source && detectedValue == source && htmlValue.isNull();
+		});
+
+		runTest(stream, "host limits", count, passed, [&] {
+			static constexpr size_t Total = 40;
+
+			LocalHttpServer server;
+			server._delay = std::chrono::milliseconds(20);
+			if (!server.start()) {
+				return false;
+			}
+
+			auto client = Rc<network::AsyncClient>::alloc();
+			network::AsyncClient::Config cfg;
+			cfg.maxHostRequests = 4;
+			client->init(cfg);
+
+			std::vector<String> bodies; bodies.resize(Total);
+			std::atomic<size_t> succeeded = 0;
+
+			auto t = Time::now();
+			for (size_t i = 0; i < Total; ++ i) {
+				network::AsyncClient::Handle h;
+				h.init(network::Method::Get, toString("http://127.0.0.1:", server._port, "/", i));
+				h.setReceiveCallback([&, i] (char *data, size_t size) -> size_t {
+					bodies[i].append(data, size);
+					return size;
+				});
+				client->submit(move(h), [&, i] (network::AsyncClient::Handle &h, bool success) {
+					if (success && h.getResponseCode() == 200 && bodies[i] == toString("response-", i)) {
+						++ succeeded;
+					}
+				});
+			}
+			client->wait();
+			auto dt = Time::now() - t;
+
+			auto hosts = client->getHostStats();
+			auto &stats = hosts[network::ShareContext::getHostKey(toString("http://127.0.0.1:", server._port))];
+
+			stream << "\t\t" << Total << " requests: " << dt.toMicros() << " mks; peak: "
+					<< server._maxOutstanding.load() << " on server, " << stats.maxActive << " in client; latency: p50 "
+					<< stats.latency.getPercentile(0.5f).toMicros() << " mks, p99 " << stats.latency.getPercentile(0.99f).toMicros()
+					<< " mks, avg " << stats.latency.getAverage().toMicros() << " mks\n\t";
+
+			client->cancel();
+			server.stop();
+
+			// requests over limit are queued, so later requests accumulate queueing time
+			return succeeded == Total && server._maxOutstanding.load() <= cfg.maxHostRequests
+					&& stats.maxActive == cfg.maxHostRequests && stats.requests == Total && stats.failed == 0
+					&& stats.latency.count == Total && stats.latency.getPercentile(0.99f) > TimeInterval::milliseconds(100)
+					&& dt > TimeInterval::milliseconds(Total / cfg.maxHostRequests * 20);
+		});
+
+		runTest(stream, "retry", count, passed, [&] {
+			LocalHttpServer server;
+			auto json = StringView("{\"status\":\"ok\"}");
+			server._data = BytesView((const uint8_t *)json.data(), json.size()).bytes<Interface>();
+			server._dataType = "application/json";
+			if (!server.start()) {
+				return false;
+			}
+
+			auto client = Rc<network::AsyncClient>::alloc();
+			network::AsyncClient::Config cfg;
+			cfg.retry.maxRetries = 3;
+			cfg.retry.delay = TimeInterval::milliseconds(10);
+			client->init(cfg);
+
+			struct Result {
+				String body;
+				long responseCode = 0;
+				long errorCode = 0;
+				bool success = false;
+			};
+
+			auto perform = [&] (network::Method method, StringView url) {
+				Result ret;
+				network::AsyncClient::Handle h;
+				h.init(method, url);
+				h.setSilent(true);
+				if (method == network::Method::Post) {
+					h.setSendData(StringView(""));
+				}
+				h.setReceiveCallback([&] (char *data, size_t size) -> size_t {
+					ret.body.append(data, size);
+					return size;
+				});
+				client->submit(move(h), [&] (network::AsyncClient::Handle &h, bool success) {
+					ret.responseCode = h.getResponseCode();
+					ret.errorCode = h.getErrorCode();
+					ret.success = success;
+				});
+				client->wait();
+				return ret;
+			};
+
+			auto url = toString("http://127.0.0.1:", server._port, "/");
+
+			// bodies of failed attempts should not reach receive callback
+			server._failures = 2;
+			auto recovered = perform(network::Method::Get, toString(url, 1));
+			auto recoveredRequests = server._requests.load();
+
+			// last failed response is delivered as is
+			server._failures = 5;
+			auto exhausted = perform(network::Method::Get, toString(url, 2));
+			server._failures = 0;
+
+			// POST is not idempotent
+			server._failures = 1;
+			auto post = perform(network::Method::Post, toString(url, 3));
+			server._failures = 0;
+
+			auto serverRequests = server._requests.load();
+			auto hosts = client->getHostStats();
+			auto serverStats = hosts[network::ShareContext::getHostKey(url)];
+
+			// headers and content type of failed attempts should not reach recovered response
+			Value value;
+			String contentType;
+			String attempt = "none";
+			do {
+				server._failures = 2;
+				network::AsyncClient::Handle h;
+				h.init(network::Method::Get, toString(url, "data"));
+				h.setSilent(true);
+				h.setReceiveValue(data::DataFormat::Unknown);
+				client->submit(move(h), [&] (network::AsyncClient::Handle &h, bool success) {
+					if (success && h.getResponseCode() == 200) {
+						contentType = h.getResponseContentType().str<Interface>();
+						attempt = h.getReceivedHeaderString("X-Attempt").str<Interface>();
+						value = h.extractReceivedValue();
+					}
+				});
+				client->wait();
+			} while (0);
+
+			server.stop();
+
+			// connection refused on closed port
+			int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			struct sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			socklen_t len = sizeof(addr);
+			::bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+			::getsockname(fd, (struct sockaddr *)&addr, &len);
+			::close(fd);
+
+			auto closedUrl = toString("http://127.0.0.1:", ntohs(addr.sin_port), "/");
+			auto t = Time::now();
+			auto refused = perform(network::Method::Get, closedUrl);
+			auto dt = Time::now() - t;
+
+			hosts = client->getHostStats();
+			auto &refusedStats = hosts[network::ShareContext::getHostKey(closedUrl)];
+
+			stream << "\t\tretries: " << serverStats.retries << " for " << serverRequests << " server requests; connection refused: "
+					<< refusedStats.retries << " retries, " << dt.toMicros() << " mks\n\t";
+
+			client->cancel();
+
+			// minimal backoff with jitter 0.5: 5 + 10 + 20 ms
+			return recovered.success && recovered.responseCode == 200 && recovered.body == "response-1" && recoveredRequests == 3
+					&& !exhausted.success && exhausted.responseCode == 503 && exhausted.body == "unavailable"
+					&& !post.success && post.responseCode == 503 && serverRequests == 3 + 4 + 1
+					&& serverStats.retries == 2 + 3 && serverStats.requests == 3 && serverStats.failed == 2
+					&& !refused.success && refused.errorCode != 0 && refusedStats.retries == 3 && refusedStats.failed == 1
+					&& dt >= TimeInterval::milliseconds(35)
+					&& contentType == "application/json" && attempt.empty() && value.getString("status") == "ok";
+		});
+
+		runTest(stream, "coalescing", count, passed, [&] {
+			static constexpr size_t Total = 20;
+
+			LocalHttpServer server;
+			server._delay = std::chrono::milliseconds(50);
+			if (!server.start()) {
+				return false;
+			}
+
+			auto client = Rc<network::AsyncClient>::alloc();
+			network::AsyncClient::Config cfg;
+			cfg.coalesce = true;
+			client->init(cfg);
+
+			std::vector<String> bodies; bodies.resize(Total + 1);
+			std::atomic<size_t> succeeded = 0;
+
+			auto url = toString("http://127.0.0.1:", server._port, "/same");
+			auto submit = [&] (size_t id, bool header) {
+				network::AsyncClient::Handle h;
+				h.init(network::Method::Get, url);
+				if (header) {
+					h.addHeader("X-Variant", "1");
+				}
+				h.setReceiveCallback([&, id] (char *data, size_t size) -> size_t {
+					bodies[id].append(data, size);
+					return size;
+				});
+				client->submit(move(h), [&, id] (network::AsyncClient::Handle &h, bool success) {
+					if (success && h.getResponseCode() == 200 && bodies[id] == "response-same"
+							&& h.getReceivedHeaderString("Content-Type") == "text/plain") {
+						++ succeeded;
+					}
+				});
+			};
+
+			for (size_t i = 0; i < Total; ++ i) {
+				submit(i, false);
+			}
+
+			// request with different headers is performed separately
+			submit(Total, true);
+			client->wait();
+
+			auto requests = server._requests.load();
+			auto hosts = client->getHostStats();
+			auto &stats = hosts[network::ShareContext::getHostKey(url)];
+
+			stream << "\t\t" << Total + 1 << " requests: " << requests << " transfers, " << stats.coalesced << " coalesced\n\t";
+
+			client->cancel();
+			server.stop();
+
+			return succeeded == Total + 1 && requests == 2 && stats.coalesced == Total - 1 && stats.requests == Total + 1;
+		});
+
+		runTest(stream, "http2 multiplexing", count, passed, [&] {
+			static constexpr size_t Total = 100;
+
+			LocalHttpServer server;
+			server._http2 = true;
+			server._delay = std::chrono::milliseconds(20);
+			if (!server.start()) {
+				return false;
+			}
+
+			auto client = Rc<network::AsyncClient>::alloc();
+			network::AsyncClient::Config cfg;
+			cfg.http2PriorKnowledge = true;
+			client->init(cfg);
+
+			std::vector<String> bodies; bodies.resize(Total);
+			std::atomic<size_t> succeeded = 0;
+
+			auto t = Time::now();
+			for (size_t i = 0; i < Total; ++ i) {
+				network::AsyncClient::Handle h;
+				h.init(network::Method::Get, toString("http://127.0.0.1:", server._port, "/", i));
+				h.setReceiveCallback([&, i] (char *data, size_t size) -> size_t {
+					bodies[i].append(data, size);
+					return size;
+				});
+				client->submit(move(h), [&, i] (network::AsyncClient::Handle &h, bool success) {
+					if (success && h.getResponseCode() == 200 && StringView(bodies[i]).is("h2-response-")) {
+						++ succeeded;
+					}
+				});
+			}
+			client->wait();
+			auto dt = Time::now() - t;
+
+			auto version = curl_version_info(CURLVERSION_NOW);
+
+			stream << "\t\t" << Total << " requests: " << dt.toMicros() << " mks; connections: " << server._accepted.load()
+					<< "; peak streams: " << server._maxOutstanding.load() << "; libcurl " << version->version << "\n\t";
+
+			client->cancel();
+			server.stop();
+
+			if (version->version_num < 0x080000) {
+				// client disables multiplexing and reuse of prior knowledge connections for libcurl 7.x
+				stream << "\t\tmultiplexing is not available with libcurl 7.x, connection per request\n\t";
+				return succeeded == Total && server._requests.load() == Total && server._accepted.load() == Total;
+			}
+
+			// all requests are multiplexed over single connection
+			return succeeded == Total && server._requests.load() == Total && server._accepted.load() == 1
+					&& server._maxOutstanding.load() > 1;
+		});
+
 		_desc = stream.str();
 		return count == passed;
 	}
@@ -0,0 +1,236 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPString.h"
+#include "SPValid.h"
+#include "Test.h"
+
+#if MODULE_COMMON_THREADS
+#include "SPThreadTaskQueue.h"
+#endif
+
+namespace stappler::app::test {
+
+struct PasswordTest : Test {
+	PasswordTest() : Test("PasswordTest") { }
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "blake2b", count, passed, [&] {
+			// test vectors from RFC 7693 and reference implementation
+			auto abc = base16::encode<Interface>(string::Blake2b().update(StringView("abc")).final());
+			auto empty = base16::encode<Interface>(string::Blake2b().final());
+
+			// multiblock input should not depend on how it is split
+			String data(1000, 'x');
+			auto full = string::Blake2b().update(data).final();
+			string::Blake2b ctx;
+			for (size_t i = 0; i < data.size(); i += 128) {
+				ctx.update((const uint8_t *)data.data() + i, std::min(size_t(128), data.size() - i));
+			}
+
+			uint8_t shortHash[32];
+			string::Blake2b(32).update(StringView("abc")).final(shortHash);
+
+			return abc == "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+						"7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923"
+					&& empty == "786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419"
+						"d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce"
+					&& ctx.final() == full
+					&& base16::encode<Interface>(BytesView(shortHash, 32))
+						== "bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319";
+		});
+
+		runTest(stream, "argon2id", count, passed, [&] {
+			// test vector from RFC 9106, section 5.3
+			uint8_t password[32], salt[16], secret[8], ad[12];
+			memset(password, 0x01, sizeof(password));
+			memset(salt, 0x02, sizeof(salt));
+			memset(secret, 0x03, sizeof(secret));
+			memset(ad, 0x04, sizeof(ad));
+
+			crypto::Argon2Params params;
+			params.memory = 32;
+			params.iterations = 3;
+			params.lanes = 4;
+
+			uint8_t tag[32];
+			uint8_t threadedTag[32];
+			if (!crypto::argon2id(tag, 32, BytesView(password, 32), BytesView(salt, 16), params,
+					BytesView(secret, 8), BytesView(ad, 12))) {
+				return false;
+			}
+
+			// result should not depend on number of threads
+			params.threads = 4;
+			if (!crypto::argon2id(threadedTag, 32, BytesView(password, 32), BytesView(salt, 16), params,
+					BytesView(secret, 8), BytesView(ad, 12))) {
+				return false;
+			}
+
+			// invalid parameters
+			params.memory = 16;
+			if (crypto::argon2id(threadedTag, 32, BytesView(password, 32), BytesView(salt, 16), params)) {
+				return false;
+			}
+
+			return base16::encode<Interface>(BytesView(tag, 32))
+					== "0d640df58d78766c08c037a34a8b53c9d01ef0452d75b65eb52520e96b01e659"
+				&& memcmp(tag, threadedTag, 32) == 0;
+		});
+
+		runTest(stream, "password", count, passed, [&] {
+			valid::PasswordParams params;
+			params.memory = 1024;
+			params.iterations = 1;
+			params.lanes = 2;
+
+			auto passwd = valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", params);
+			auto defaultPasswd = valid::makePassword<Interface>("Pa$$w0rd", "SecretKey");
+
+			return passwd.size() == 60 && passwd != valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", params)
+					&& valid::validatePassord("Pa$$w0rd", passwd, "SecretKey")
+					&& !valid::validatePassord("Pa$$w0rd1", passwd, "SecretKey")
+					&& !valid::validatePassord("Pa$$w0rd", passwd, "OtherKey")
+					&& valid::validatePassord("Pa$$w0rd", defaultPasswd, "SecretKey")
+					&& !valid::isPasswordUpgradeRequired(passwd, params)
+					&& valid::isPasswordUpgradeRequired(passwd)
+					&& !valid::isPasswordUpgradeRequired(defaultPasswd)
+					&& valid::makePassword<Interface>("", "SecretKey").empty();
+		});
+
+		runTest(stream, "password cost bounds", count, passed, [&] {
+			valid::PasswordParams params;
+			params.memory = 1024;
+			params.iterations = 1;
+
+			// cost parameters from crafted hash should be rejected before hashing
+			auto passwd = valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", params);
+			auto hugeMemory = passwd;
+			memset(hugeMemory.data() + 4, 0xFF, 4);
+			auto hugeIterations = passwd;
+			memset(hugeIterations.data() + 8, 0xFF, 4);
+
+			params.memory = 0xFFFF'FFFF;
+			return valid::validatePassord("Pa$$w0rd", passwd, "SecretKey")
+					&& !valid::validatePassord("Pa$$w0rd", hugeMemory, "SecretKey")
+					&& !valid::validatePassord("Pa$$w0rd", hugeIterations, "SecretKey")
+					&& valid::isPasswordUpgradeRequired(hugeMemory)
+					&& valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", params).empty();
+		});
+
+		runTest(stream, "legacy password", count, passed, [&] {
+			// Serenity/2 protocol: version code, random bytes, SHA-512 of them, key and salted password
+			Bytes passwd; passwd.resize(16 + string::Sha512::Length);
+			passwd[0] = 0; passwd[1] = 1;
+			valid::makeRandomBytes(passwd.data() + 2, 14);
+
+			auto source = string::Sha512::make(StringView("Pa$$w0rd"), "Serenity Password Salt");
+			string::Sha512().update(passwd.data(), 16).update(StringView("SecretKey")).update(source).final(passwd.data() + 16);
+
+			return valid::validatePassord("Pa$$w0rd", passwd, "SecretKey")
+					&& !valid::validatePassord("Pa$$w0rd1", passwd, "SecretKey")
+					&& valid::isPasswordUpgradeRequired(passwd);
+		});
+
+#if MODULE_COMMON_THREADS
+		runTest(stream, "async validation", count, passed, [&] {
+			valid::PasswordParams params;
+			params.memory = 1024;
+			params.iterations = 1;
+
+			auto passwd = valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", params);
+
+			auto queue = Rc<thread::TaskQueue>::alloc("PasswordTest");
+			queue->spawnWorkers(thread::TaskQueue::Flags::None, maxOf<uint32_t>(), 4);
+
+			static constexpr size_t Requests = 16;
+			size_t complete = 0;
+			size_t valid = 0;
+			for (size_t i = 0; i < Requests; ++ i) {
+				valid::validatePassord(*queue, (i % 2) ? "Pa$$w0rd" : "wrong", passwd, "SecretKey", [&] (bool result) {
+					if (result) {
+						++ valid;
+					}
+					++ complete;
+				});
+			}
+
+			while (complete < Requests) {
+				queue->update();
+				std::this_thread::yield();
+			}
+			queue->cancelWorkers();
+
+			return valid == Requests / 2;
+		});
+#endif
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			struct Cost {
+				uint32_t memory;
+				uint32_t iterations;
+				uint32_t lanes;
+				uint32_t threads;
+			};
+
+			Cost costs[] = {
+				Cost{4 * 1024, 1, 1, 1},
+				Cost{19 * 1024, 2, 1, 1}, // default
+				Cost{64 * 1024, 1, 1, 1},
+				Cost{64 * 1024, 1, 4, 4},
+			};
+
+			auto t = Time::now();
+			for (size_t i = 0; i < 100; ++ i) {
+				valid::validatePassord("Pa$$w0rd", valid::makePassword<Interface>("Pa$$w0rd", "SecretKey", valid::PasswordParams{8, 1, 1, 1}), "SecretKey");
+			}
+			stream << "\t\tminimal cost: " << (Time::now() - t).toMicros() / 200 << " mcs/hash\n";
+
+			bool success = true;
+			for (auto &it : costs) {
+				valid::PasswordParams params{it.memory, it.iterations, it.lanes, it.threads};
+				uint8_t tag[32];
+
+				t = Time::now();
+				success = crypto::argon2id(tag, 32, StringView("Pa$$w0rd"), StringView("0123456789abcdef"), params) && success;
+
+				stream << "\t\tm=" << it.memory / 1024 << " MiB, t=" << it.iterations << ", p=" << it.lanes
+						<< " (" << it.threads << " threads): " << (Time::now() - t).toMillis() << " ms\n";
+			}
+			stream << "\t";
+			return success;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _PasswordTest;
+
+}
@@ -0,0 +1,151 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPRef.h"
+#include "SPThreadTaskQueue.h"
+#include "Test.h"
+
+namespace stappler::app::test {
+
+struct RefTest : Test {
+	RefTest() : Test("RefTest") { }
+
+	struct Counted : public mem_std::Ref {
+		static std::atomic<size_t> s_destroyed;
+
+		virtual ~Counted() { ++ s_destroyed; }
+	};
+
+#if SP_REF_DEBUG
+	struct Tracked : public mem_std::Ref {
+		virtual bool isRetainTrackerEnabled() const override { return true; }
+	};
+#endif
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "concurrent counter", count, passed, [&] {
+			Counted::s_destroyed = 0;
+
+			auto ref = Rc<Counted>::alloc();
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < 8; ++ i) {
+				threads.emplace_back([ref] {
+					for (size_t j = 0; j < 100000; ++ j) {
+						Rc<Counted> tmp(ref);
+						Rc<Counted> tmp2(move(tmp));
+					}
+				});
+			}
+			for (auto &it : threads) {
+				it.join();
+			}
+
+			auto refcount = ref->getReferenceCount();
+			ref = nullptr;
+			return refcount == 1 && Counted::s_destroyed == 1;
+		});
+
+#if SP_REF_DEBUG
+		runTest(stream, "retain tracker", count, passed, [&] {
+			auto ref = Rc<Tracked>::alloc();
+			auto before = memleak::getTrackerStats();
+
+			std::vector<Rc<Tracked>> refs;
+			for (size_t i = 0; i < 3; ++ i) {
+				refs.emplace_back(ref);
+			}
+
+			size_t entries = 0;
+			size_t frames = 0;
+			ref->foreachBacktrace([&] (uint64_t id, Time t, const std::vector<std::string> &bt) {
+				++ entries;
+				frames += bt.size();
+			});
+
+			refs.pop_back();
+
+			size_t remains = 0;
+			ref->foreachBacktrace([&] (uint64_t id, Time t, const std::vector<std::string> &bt) {
+				++ remains;
+			});
+
+			refs.clear();
+			auto after = memleak::getTrackerStats();
+
+			stream << "\t\tframes: " << frames << "\n\t";
+			return entries == 3 && remains == 2 && after.tracked == before.tracked;
+		});
+#endif
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Copies = 10'000'000;
+			static constexpr size_t Tasks = 200'000;
+
+			auto ref = Rc<Counted>::alloc();
+			auto t = Time::now();
+			for (size_t i = 0; i < Copies; ++ i) {
+				Rc<Counted> tmp(ref);
+			}
+			auto copyTime = Time::now() - t;
+
+			auto queue = Rc<thread::TaskQueue>::alloc("RefTest");
+			queue->spawnWorkers(thread::TaskQueue::Flags::Cancelable, maxOf<uint32_t>(), 2);
+
+			std::atomic<size_t> executed = 0;
+			t = Time::now();
+			for (size_t i = 0; i < Tasks; ++ i) {
+				queue->perform(Rc<thread::Task>::create([&] (const thread::Task &) {
+					++ executed;
+					return true;
+				}));
+			}
+			while (executed.load() < Tasks) {
+				queue->update();
+				std::this_thread::yield();
+			}
+			queue->waitForAll();
+			queue->update();
+			auto taskTime = Time::now() - t;
+			queue->cancelWorkers();
+
+			stream << "\t\tSP_REF_DEBUG: " << (SP_REF_DEBUG ? "on" : "off") << ";"
+					<< " Rc copy: " << double(copyTime.toMicros()) * 1000.0 / Copies << " ns;"
+					<< " task churn: " << taskTime.toMicros() * 1000 / Tasks << " ns/task\n\t";
+			return executed == Tasks;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _RefTest;
+
+std::atomic<size_t> RefTest::Counted::s_destroyed = 0;
+
+}
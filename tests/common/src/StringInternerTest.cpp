@@ -0,0 +1,170 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPStringInterner.h"
+#include "Test.h"
+
+#if MODULE_COMMON_DATA
+#include "SPData.h"
+#endif
+
+namespace stappler::app::test {
+
+struct StringInternerTest : MemPoolTest {
+	StringInternerTest() : MemPoolTest("StringInternerTest") { }
+
+	virtual bool run(pool_t *pool) {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "identity test", count, passed, [&] {
+			string::StringInterner interner;
+			auto a = interner.intern(StringView("content-type"));
+			auto b = interner.intern(String("content-type"));
+			auto c = interner.intern(StringView("content-length"));
+			auto e1 = interner.intern(StringView());
+			auto e2 = interner.intern(StringView(""));
+
+			return a.data() == b.data() && a == "content-type" && a.data()[a.size()] == 0
+					&& c.data() != a.data() && c == "content-length"
+					&& e1.data() == e2.data() && e1.empty()
+					&& interner.find("content-length").data() == c.data()
+					&& interner.find("content-encoding").empty()
+					&& interner.size() == 3;
+		});
+
+		runTest(stream, "growth test", count, passed, [&] {
+			string::PoolInterner interner(pool);
+			Vector<StringView> views;
+			for (size_t i = 0; i < 10000; ++ i) {
+				views.emplace_back(interner.intern(toString("key-", i)));
+			}
+
+			// large strings uses dedicated chunks
+			String large(10_KiB, 'x');
+			auto l = interner.intern(large);
+
+			for (size_t i = 0; i < 10000; ++ i) {
+				if (interner.intern(toString("key-", i)).data() != views[i].data() || views[i] != toString("key-", i)) {
+					return false;
+				}
+			}
+			return interner.size() == 10001 && interner.intern(large).data() == l.data() && l == large;
+		});
+
+		runTest(stream, "concurrent test", count, passed, [&] {
+			string::StringInterner interner;
+			std::array<Vector<StringView>, 8> results;
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t < results.size(); ++ t) {
+				threads.emplace_back([&, t] {
+					for (size_t i = 0; i < 4096; ++ i) {
+						// every thread starts from different key, so insertions race
+						auto idx = (i + t * 512) % 4096;
+						results[t].emplace_back(interner.intern(toString("segment/", idx)));
+					}
+				});
+			}
+			for (auto &it : threads) {
+				it.join();
+			}
+
+			for (size_t t = 0; t < results.size(); ++ t) {
+				for (size_t i = 0; i < 4096; ++ i) {
+					auto idx = (i + t * 512) % 4096;
+					if (interner.find(toString("segment/", idx)).data() != results[t][i].data()) {
+						return false;
+					}
+				}
+			}
+			return interner.size() == 4096 && interner.getStats().requests == 8 * 4096;
+		});
+
+#if MODULE_COMMON_DATA
+		runTest(stream, "decoder test", count, passed, [&] {
+			string::PoolInterner interner(pool);
+			StringView json(R"({"array":[{"very-long-dictionary-key":1},{"very-long-dictionary-key":2}],"key":"value"})");
+			auto val = data::json::read<memory::PoolInterface>(json, false, &interner);
+			auto cbor = data::write<memory::PoolInterface>(val, data::EncodeFormat::Cbor);
+			auto val2 = data::cbor::read<memory::PoolInterface>(cbor, &interner);
+
+			auto &d1 = val.getValue("array").getValue(0).asDict();
+			auto &d2 = val.getValue("array").getValue(1).asDict();
+			auto &d3 = val2.getValue("array").getValue(1).asDict();
+
+			return val == val2 && interner.size() == 3
+					&& d1.begin()->first.data() == d2.begin()->first.data()
+					&& d1.begin()->first.data() == d3.begin()->first.data()
+					&& d1.begin()->first.is_weak();
+		});
+#endif
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			// emulate repeated keys: 1000 unique keys, each used 200 times
+			static constexpr size_t Unique = 1000;
+			static constexpr size_t Repeats = 200;
+
+			Vector<String> keys;
+			for (size_t i = 0; i < Unique; ++ i) {
+				keys.emplace_back(mem_pool::toString("X-Custom-Header-Name-", i));
+			}
+
+			string::StringInterner interner;
+			auto t = Time::now();
+			for (size_t j = 0; j < Repeats; ++ j) {
+				for (auto &it : keys) {
+					interner.intern(it);
+				}
+			}
+			auto internTime = Time::now() - t;
+
+			t = Time::now();
+			size_t allocated = 0;
+			for (size_t j = 0; j < Repeats; ++ j) {
+				for (auto &it : keys) {
+					auto str = new String(it);
+					allocated += str->capacity() + 1;
+					delete str;
+				}
+			}
+			auto copyTime = Time::now() - t;
+
+			auto stats = interner.getStats();
+			stream << "\t\tintern: " << internTime.toMicros() * 1000 / (Unique * Repeats) << " ns/call;"
+					<< " copy: " << copyTime.toMicros() * 1000 / (Unique * Repeats) << " ns/call\n"
+					<< "\t\tcopies: " << allocated << " bytes; interned: " << stats.allocatedBytes << " bytes ("
+					<< stats.storedBytes << " bytes of strings);"
+					<< " requested: " << stats.requestedBytes << " bytes\n\t";
+			return stats.strings == Unique && stats.requests == Unique * Repeats;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _StringInternerTest;
+
+}
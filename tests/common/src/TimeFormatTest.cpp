@@ -0,0 +1,183 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "Test.h"
+
+#include <random>
+
+namespace stappler::app::test {
+
+struct TimeFormatTest : Test {
+	TimeFormatTest() : Test("TimeFormatTest") { }
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		std::mt19937_64 rnd(0x7133);
+
+		// [1970, ~2242] with microseconds
+		auto randomTime = [&] {
+			return Time::microseconds(rnd() % (uint64_t(1) << 53));
+		};
+
+		runTest(stream, "civil conversion", count, passed, [&] {
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto t = randomTime();
+				sp_time_exp_t xt(t);
+				auto tm = t.asGmt();
+				if (xt.tm_sec != tm.tm_sec || xt.tm_min != tm.tm_min || xt.tm_hour != tm.tm_hour
+						|| xt.tm_mday != tm.tm_mday || xt.tm_mon != tm.tm_mon || xt.tm_year != tm.tm_year
+						|| xt.tm_wday != tm.tm_wday || xt.tm_yday != tm.tm_yday || xt.tm_usec != int32_t(t.toMicros() % 1000000)) {
+					stream << "\t\tfailed: " << t.toMicros() << "\n\t";
+					return false;
+				}
+			}
+			return true;
+		});
+
+		runTest(stream, "format", count, passed, [&] {
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto t = randomTime();
+				auto http = t.toHttp<Interface>();
+				auto iso = t.toIso8601<Interface>(3);
+
+				auto frac = toString(".", (t.toMicros() % 1000000) / 100000, (t.toMicros() % 100000) / 10000, (t.toMicros() % 10000) / 1000);
+				if (http != t.toFormat<Interface>("%a, %d %b %Y %H:%M:%S GMT")
+						|| iso != toString(t.toFormat<Interface>("%Y-%m-%dT%H:%M:%S"), frac, "Z")) {
+					stream << "\t\tfailed: " << t.toMicros() << " " << http << " " << iso << "\n\t";
+					return false;
+				}
+			}
+
+			// cached and uncached results for the same second
+			auto t = Time::seconds(1'000'000'000);
+			auto a = t.toHttp<Interface>();
+			auto b = (t + TimeInterval::seconds(1)).toHttp<Interface>();
+			auto c = (t + TimeInterval::microseconds(500'000)).toHttp<Interface>();
+			return a == "Sun, 09 Sep 2001 01:46:40 GMT" && b == "Sun, 09 Sep 2001 01:46:41 GMT" && c == a
+					&& t.toIso8601<Interface>() == "2001-09-09T01:46:40Z"
+					&& Time::microseconds(999'999).toIso8601<Interface>(3) == "1970-01-01T00:00:00.999Z";
+		});
+
+		runTest(stream, "parse", count, passed, [&] {
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto t = randomTime();
+				if (Time::fromHttp(t.toHttp<Interface>()).toSeconds() != t.toSeconds()
+						|| Time::fromHttp(t.toIso8601<Interface>(6)) != t) {
+					stream << "\t\tfailed: " << t.toMicros() << "\n\t";
+					return false;
+				}
+			}
+
+			auto base = Time::fromHttp("2011-04-27T21:34:00Z");
+			return base
+					&& Time::fromHttp("2011-04-28T06:34:00+09:00") == base
+					&& Time::fromHttp("2011-04-27T19:34:00-0200") == base
+					&& Time::fromHttp("2011-04-27T21:34:00") == base
+					&& Time::fromHttp("2011-04-27T21:34:00.5Z") == base + TimeInterval::milliseconds(500)
+					&& Time::fromHttp("Wed, 27 Apr 2011 21:34:00 GMT") == base
+					&& Time::fromHttp("Wednesday, 27-Apr-11 21:34:00 GMT") == base
+					&& Time::fromHttp("  Wed, 27 Apr 2011 21:34:00 GMT") == base
+					&& !Time::fromHttp("2023-02-29T00:00:00Z")
+					&& !Time::fromHttp("Wed, 31 Apr 2011 21:34:00 GMT")
+					&& !Time::fromHttp("Wed, 27 Abc 2011 21:34:00 GMT");
+		});
+
+		runTest(stream, "coarse clock", count, passed, [&] {
+			auto a = Time::now(Time::RealtimeCoarse);
+			auto b = Time::now();
+			return (a > b ? a - b : b - a) < TimeInterval::milliseconds(100);
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Count = 1'000'000;
+
+			std::vector<Time> times; times.reserve(Count);
+			for (size_t i = 0; i < Count; ++ i) {
+				times.emplace_back(randomTime());
+			}
+
+			char buf[256];
+			size_t checksum = 0;
+
+			auto measure = [&] (const auto &fn) {
+				auto t = Time::now();
+				for (size_t i = 0; i < Count; ++ i) {
+					checksum += fn(i);
+				}
+				return (Time::now() - t).toMicros() * 1000 / Count;
+			};
+
+			auto now = Time::now();
+			auto cached = measure([&] (size_t i) { return now.encodeRfc822(buf); });
+			auto uncached = measure([&] (size_t i) { return times[i].encodeRfc822(buf); });
+			auto strf = measure([&] (size_t i) {
+				auto tm = times[i].asGmt();
+				return strftime(buf, 256, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+			});
+			auto legacy = measure([&] (size_t i) {
+				// decomposition with gmtime, as it was before
+				auto tm = times[i].asGmt();
+				sp_time_exp_t xt;
+				xt.tm_sec = tm.tm_sec; xt.tm_min = tm.tm_min; xt.tm_hour = tm.tm_hour;
+				xt.tm_mday = tm.tm_mday; xt.tm_mon = tm.tm_mon; xt.tm_year = tm.tm_year; xt.tm_wday = tm.tm_wday;
+				xt.encodeRfc822(buf);
+				return size_t(29);
+			});
+
+			std::vector<std::array<char, 32>> http; http.resize(Count);
+			std::vector<std::array<char, 32>> iso; iso.resize(Count);
+			for (size_t i = 0; i < Count; ++ i) {
+				times[i].encodeRfc822(http[i].data());
+				times[i].encodeIso8601(iso[i].data(), 6);
+			}
+
+			auto parseHttp = measure([&] (size_t i) { return Time::fromHttp(StringView(http[i].data(), 29)).toMicros(); });
+			auto parseIso = measure([&] (size_t i) { return Time::fromHttp(StringView(iso[i].data(), 27)).toMicros(); });
+			auto parseGeneric = measure([&] (size_t i) {
+				sp_time_exp_t xt;
+				xt.read(StringView(http[i].data(), 29));
+				return size_t(xt.gmt_geti());
+			});
+
+			auto clock = measure([&] (size_t i) { return Time::now().toMicros(); });
+			auto coarse = measure([&] (size_t i) { return Time::now(Time::RealtimeCoarse).toMicros(); });
+
+			stream << "\t\ttoHttp: cached " << cached << " ns; uncached " << uncached << " ns; "
+					<< "gmtime+encode " << legacy << " ns; strftime " << strf << " ns\n"
+					<< "\t\tfromHttp: rfc1123 " << parseHttp << " ns; iso8601 " << parseIso << " ns; generic " << parseGeneric << " ns\n"
+					<< "\t\tnow: " << clock << " ns; coarse: " << coarse << " ns (" << checksum % 10 << ")\n\t";
+			return true;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _TimeFormatTest;
+
+}
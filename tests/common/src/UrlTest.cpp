@@ -0,0 +1,160 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPString.h"
+#include "SPUrl.h"
+#include "Test.h"
+
+#if MODULE_COMMON_IDN
+#include "SPIdn.h"
+#endif
+
+namespace stappler::app::test {
+
+struct UrlTest : Test {
+	UrlTest() : Test("UrlTest") { }
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "idn tld", count, passed, [&] {
+			return UrlView::isValidIdnTld("рф") && UrlView::isValidIdnTld("中文网") && UrlView::isValidIdnTld("삼성")
+					&& !UrlView::isValidIdnTld("рфф") && !UrlView::isValidIdnTld("") && !UrlView::isValidIdnTld("com")
+					&& UrlView(StringView("https://пример.рф/path")).host == "пример.рф";
+		});
+
+		runTest(stream, "public suffix", count, passed, [&] {
+			std::pair<StringView, StringView> tests[] = {
+				pair("www.example.com", "example.com"),
+				pair("example.com", "example.com"),
+				pair("com", ""),
+				pair("www.example.co.uk", "example.co.uk"),
+				pair("WWW.Example.CO.UK", "Example.CO.UK"),
+				pair("co.uk", ""),
+				pair("a.b.example.co.jp", "example.co.jp"),
+				pair("user.github.io", "user.github.io"),
+				pair("github.io", ""),
+				pair("www.test.ck", "www.test.ck"),
+				pair("test.ck", ""),
+				pair("www.ck", "www.ck"),
+				pair("a.city.kobe.jp", "city.kobe.jp"),
+				pair("a.b.kobe.jp", "a.b.kobe.jp"),
+				pair("пример.рф", "пример.рф"),
+				pair("shop.example.com.pl", "example.com.pl"),
+				pair("www.example.co.id", "example.co.id"),
+				pair("www.example.com.vn", "example.com.vn"),
+				pair("www.example.公司.cn", "example.公司.cn"),
+				pair("www.example.xn--55qx5d.cn", "example.xn--55qx5d.cn"),
+				pair("a.b.example.s3.amazonaws.com", "example.s3.amazonaws.com"),
+				pair("www.example.com.", "example.com"),
+				pair("127.0.0.1", ""),
+				pair("[::1]", ""),
+				pair("", ""),
+			};
+
+			bool success = true;
+			for (auto &it : tests) {
+				auto domain = UrlView::getRegistrableDomain(it.first);
+				if (domain != it.second) {
+					stream << "\t\t" << it.first << ": " << domain << " (expected: " << it.second << ")\n";
+					success = false;
+				}
+			}
+
+			return success && UrlView::getPublicSuffix("www.example.co.uk") == "co.uk"
+					&& UrlView::getPublicSuffix("test.ck") == "test.ck"
+					&& UrlView::getPublicSuffix("www.ck") == "ck"
+					&& UrlView::getPublicSuffix("example.com") == "com";
+		});
+
+#if MODULE_COMMON_IDN
+		runTest(stream, "idn ascii", count, passed, [&] {
+			return idn::toAscii<Interface>("WWW.Example.COM") == "www.example.com"
+					&& idn::toAscii<Interface>("example.com.") == "example.com."
+					&& idn::toAscii<Interface>("пример.рф") == "xn--e1afmkfd.xn--p1ai"
+					&& idn::toAscii<Interface>("XN--E1AFMKFD.xn--p1ai") == "xn--e1afmkfd.xn--p1ai"
+					&& idn::toUnicode<Interface>("xn--e1afmkfd.xn--p1ai") == "пример.рф"
+					&& idn::toUnicode<Interface>("Www.Example.com") == "www.example.com";
+		});
+#endif
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Iterations = 100000;
+
+			StringView hosts[] = {
+				"www.example.com", "static.cdn.example.co.uk", "user.github.io", "пример.рф", "shop.example.中文网"
+			};
+
+			size_t valid = 0;
+			auto t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				auto &host = hosts[i % 5];
+				if (!UrlView::getRegistrableDomain(host).empty()) {
+					++ valid;
+				}
+			}
+			auto suffixTime = Time::now() - t;
+
+			t = Time::now();
+			size_t tlds = 0;
+			for (size_t i = 0; i < Iterations; ++ i) {
+				if (UrlView::isValidIdnTld((i % 2) ? StringView("中文网") : StringView("삼성"))) {
+					++ tlds;
+				}
+			}
+			auto tldTime = Time::now() - t;
+
+			stream << "\t\tregistrable domain: " << suffixTime.toMicros() * 1000 / Iterations << " ns/host;"
+					<< " idn tld: " << tldTime.toMicros() * 1000 / Iterations << " ns/lookup\n";
+
+#if MODULE_COMMON_IDN
+			t = Time::now();
+			for (size_t i = 0; i < Iterations; ++ i) {
+				idn::toAscii<Interface>(hosts[i % 3]);
+			}
+			auto asciiTime = Time::now() - t;
+
+			t = Time::now();
+			for (size_t i = 0; i < Iterations / 10; ++ i) {
+				idn::toAscii<Interface>(hosts[3]);
+			}
+			auto idnTime = Time::now() - t;
+
+			stream << "\t\ttoAscii: " << asciiTime.toMicros() * 1000 / Iterations << " ns/host (ascii);"
+					<< " " << idnTime.toMicros() * 10000 / Iterations << " ns/host (idn)\n";
+#endif
+			stream << "\t";
+			return valid == Iterations && tlds == Iterations;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _UrlTest;
+
+}
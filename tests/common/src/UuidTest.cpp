@@ -0,0 +1,215 @@
+/**
+Copyright (c) 2023 Roman Katuntsev <sbkarr@stappler.org>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**/
+
+#include "SPCommon.h"
+#include "SPTime.h"
+#include "SPRandom.h"
+#include "SPValid.h"
+#include "Test.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace stappler::app::test {
+
+struct UuidTest : Test {
+	UuidTest() : Test("UuidTest") { }
+
+	virtual bool run() override {
+		StringStream stream;
+		size_t count = 0;
+		size_t passed = 0;
+		stream << "\n";
+
+		runTest(stream, "chacha20 block", count, passed, [&] {
+			// RFC 8439, 2.3.2
+			uint8_t key[32];
+			for (size_t i = 0; i < 32; ++ i) {
+				key[i] = uint8_t(i);
+			}
+			const uint8_t nonce[12] = { 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00 };
+			uint8_t out[64];
+			random::chacha20Block(out, key, 1, nonce);
+
+			return base16::encode<Interface>(BytesView(out, 64)) ==
+					"10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+					"d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e";
+		});
+
+		runTest(stream, "random bytes", count, passed, [&] {
+			std::array<size_t, 256> hist;
+			hist.fill(0);
+
+			Bytes buf; buf.resize(256_KiB);
+			random::fill(buf.data(), buf.size());
+			for (auto &it : buf) {
+				++ hist[it];
+			}
+
+			// expected 1024 per value, deviation is ~32
+			for (auto &it : hist) {
+				if (it < 800 || it > 1250) {
+					return false;
+				}
+			}
+
+			auto a = valid::makeRandomBytes<Interface>(32);
+			auto b = valid::makeRandomBytes<Interface>(32);
+			return a.size() == 32 && a != b && random::next64() != random::next64();
+		});
+
+		runTest(stream, "random fork", count, passed, [&] {
+			uint64_t parent[2];
+			random::next64(); // make sure state is buffered
+			int fd[2];
+			if (::pipe(fd) != 0) {
+				return false;
+			}
+			auto pid = ::fork();
+			if (pid == 0) {
+				uint64_t val = random::next64();
+				auto r = ::write(fd[1], &val, sizeof(val));
+				::_exit(r == sizeof(val) ? 0 : 1);
+			}
+			parent[0] = random::next64();
+			::waitpid(pid, nullptr, 0);
+			auto r = ::read(fd[0], &parent[1], sizeof(uint64_t));
+			::close(fd[0]);
+			::close(fd[1]);
+			return r == sizeof(uint64_t) && parent[0] != parent[1];
+		});
+
+		runTest(stream, "uuid versions", count, passed, [&] {
+			for (size_t i = 0; i < 1000; ++ i) {
+				auto v4 = memory::uuid::generateV4();
+				auto v7 = memory::uuid::generateV7();
+				if ((v4.data()[6] >> 4) != 4 || (v4.data()[8] & 0xC0) != 0x80
+						|| (v7.data()[6] >> 4) != 7 || (v7.data()[8] & 0xC0) != 0x80) {
+					return false;
+				}
+			}
+
+			auto v7 = memory::uuid::generateV7().array();
+			uint64_t ms = 0;
+			for (size_t i = 0; i < 6; ++ i) {
+				ms = (ms << 8) | v7[i];
+			}
+			auto now = Time::now().toMillis();
+			return ms <= now && ms + 1000 > now;
+		});
+
+		runTest(stream, "uuid v7 ordering", count, passed, [&] {
+			auto prev = memory::uuid::generateV7().array();
+			for (size_t i = 0; i < 100000; ++ i) {
+				auto next = memory::uuid::generateV7().array();
+				if (memcmp(prev.data(), next.data(), 16) >= 0) {
+					return false;
+				}
+				prev = next;
+			}
+			return true;
+		});
+
+		runTest(stream, "uuid format", count, passed, [&] {
+			for (size_t i = 0; i < 1000; ++ i) {
+				auto u = memory::uuid::generateV4();
+				auto &d = u._uuid;
+
+				char expected[memory::uuid::FormattedLength + 1];
+				::snprintf(expected, sizeof(expected), "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+					d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8], d[9], d[10], d[11], d[12], d[13], d[14], d[15]);
+
+				auto str = u.str<String>();
+				if (str != StringView(expected)) {
+					return false;
+				}
+
+				memory::uuid::uuid_t parsed;
+				if (!memory::uuid::parse(parsed, StringView(str)) || parsed != d
+						|| !memory::uuid::parse(parsed, string::toupper<Interface>(str).data()) || parsed != d) {
+					return false;
+				}
+			}
+			return true;
+		});
+
+		runTest(stream, "uuid invalid", count, passed, [&] {
+			memory::uuid::uuid_t d;
+			d.fill(0xFF);
+			return !memory::uuid::parse(d, StringView("1b4e28ba-2fa1-11d2-883f-0016d3cca42"))
+					&& !memory::uuid::parse(d, StringView("1b4e28ba-2fa1-11d2-883f-0016d3cca4270"))
+					&& !memory::uuid::parse(d, StringView("1b4e28ba-2fa1-11d2-883f+0016d3cca427"))
+					&& !memory::uuid::parse(d, StringView("1b4e28ba-2fa1-11d2-883f-0016d3cca42g"))
+					&& !memory::uuid::parse(d, "1b4e28ba-2fa1-11d2-883f-0016d3cca427 ")
+					&& !memory::uuid::parse(d, "")
+					&& d[0] == 0xFF
+					&& memory::uuid::parse(d, "1b4e28ba-2fa1-11d2-883f-0016d3cca427")
+					&& memory::uuid(StringView("1b4e28ba-2fa1-11d2-883f-0016d3cca427 trailing").sub(0, 36)).str<String>()
+						== "1b4e28ba-2fa1-11d2-883f-0016d3cca427";
+		});
+
+		runTest(stream, "benchmark", count, passed, [&] {
+			static constexpr size_t Count = 200000;
+
+			auto measure = [&] (StringView name, const Callback<void()> &cb) {
+				auto t = Time::now();
+				cb();
+				auto dt = std::max(uint64_t(1), (Time::now() - t).toMicros());
+				stream << "\t\t" << name << ": " << Count * 1000000 / dt << " /s\n";
+			};
+
+			uint8_t acc = 0;
+			measure("generate", [&] {
+				for (size_t i = 0; i < Count; ++ i) { acc ^= memory::uuid::generate().data()[15]; }
+			});
+			measure("generateV4", [&] {
+				for (size_t i = 0; i < Count; ++ i) { acc ^= memory::uuid::generateV4().data()[15]; }
+			});
+			measure("generateV7", [&] {
+				for (size_t i = 0; i < Count; ++ i) { acc ^= memory::uuid::generateV7().data()[15]; }
+			});
+
+			auto u = memory::uuid::generateV4();
+			char buf[memory::uuid::FormattedLength + 1] = { 0 };
+			measure("format", [&] {
+				for (size_t i = 0; i < Count; ++ i) { u._uuid[15] = uint8_t(i); memory::uuid::format(buf, u._uuid); acc ^= buf[35]; }
+			});
+			measure("parse", [&] {
+				memory::uuid::uuid_t d;
+				for (size_t i = 0; i < Count; ++ i) { memory::uuid::parse(d, StringView(buf, 36)); acc ^= d[15]; }
+			});
+
+			Bytes data; data.resize(16_MiB);
+			auto t = Time::now();
+			random::fill(data.data(), data.size());
+			auto dt = std::max(uint64_t(1), (Time::now() - t).toMicros());
+			stream << "\t\trandom: " << data.size() / dt << " MB/s (" << int(acc) << ")\n\t";
+			return true;
+		});
+
+		_desc = stream.str();
+
+		return count == passed;
+	}
+} _UuidTest;
+
+}